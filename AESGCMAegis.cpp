@@ -0,0 +1,184 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMAegis.h"
+
+#include <sodium.h>
+#include <cstring>
+
+AESGCMAegis::AESGCMAegis() {
+    memset(key, 0, sizeof(key));
+}
+
+AESGCMAegis::~AESGCMAegis() {
+    sodium_memzero(key, sizeof(key));
+}
+
+void AESGCMAegis::init(const unsigned char key[key_length]) {
+    memcpy(this->key, key, key_length);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "AESGCMKernel.h"
+
+namespace {
+
+struct AegisState {
+    __m128i s0, s1, s2, s3, s4, s5;
+};
+
+KERNEL static inline void update(AegisState &s, __m128i m) {
+    __m128i t = s.s5;
+    s.s5 = _mm_aesenc_si128(s.s4, s.s5);
+    s.s4 = _mm_aesenc_si128(s.s3, s.s4);
+    s.s3 = _mm_aesenc_si128(s.s2, s.s3);
+    s.s2 = _mm_aesenc_si128(s.s1, s.s2);
+    s.s1 = _mm_aesenc_si128(s.s0, s.s1);
+    s.s0 = _mm_aesenc_si128(t, _mm_xor_si128(s.s0, m));
+}
+
+KERNEL static inline __m128i keystream(const AegisState &s) {
+    return _mm_xor_si128(_mm_xor_si128(s.s1, s.s4),
+            _mm_xor_si128(s.s5, _mm_and_si128(s.s2, s.s3)));
+}
+
+KERNEL static void initialize(AegisState &s, const unsigned char *key,
+        const unsigned char *nonce) {
+    const __m128i c0 = _mm_set_epi8(0x62, 0x79, 0xe9, 0x90, 0x59, 0x37, 0x22, 0x15,
+            0x0d, 0x08, 0x05, 0x03, 0x02, 0x01, 0x01, 0x00);
+    const __m128i c1 = _mm_set_epi8(0xdd, 0x28, 0xb5, 0x73, 0x42, 0x31, 0x11, 0x20,
+            0xf1, 0x2f, 0xc2, 0x6d, 0x55, 0x18, 0x3d, 0xdb);
+    __m128i k0 = _mm_loadu_si128((const __m128i *)key);
+    __m128i k1 = _mm_loadu_si128((const __m128i *)(key + 16));
+    __m128i k0n0 = _mm_xor_si128(k0, _mm_loadu_si128((const __m128i *)nonce));
+    __m128i k1n1 = _mm_xor_si128(k1, _mm_loadu_si128((const __m128i *)(nonce + 16)));
+
+    s.s0 = k0n0;
+    s.s1 = k1n1;
+    s.s2 = c1;
+    s.s3 = c0;
+    s.s4 = _mm_xor_si128(k0, c0);
+    s.s5 = _mm_xor_si128(k1, c1);
+    for (int i = 0; i < 4; i++) {
+        update(s, k0);
+        update(s, k1);
+        update(s, k0n0);
+        update(s, k1n1);
+    }
+}
+
+KERNEL static void absorb(AegisState &s, const unsigned char *ad, size_t ad_length) {
+    size_t i = 0;
+    for (; i + 16 <= ad_length; i += 16) {
+        update(s, _mm_loadu_si128((const __m128i *)(ad + i)));
+    }
+    if (i < ad_length) {
+        update(s, loadPartial(ad + i, ad_length - i));
+    }
+}
+
+KERNEL static void finalize(AegisState &s, size_t ad_length, size_t length,
+        unsigned char tag[AESGCMAegis::tag_length]) {
+    __m128i t = _mm_xor_si128(s.s3, _mm_set_epi64x((long long)length * 8,
+            (long long)ad_length * 8));
+    for (int i = 0; i < 7; i++) {
+        update(s, t);
+    }
+    _mm_storeu_si128((__m128i *)tag, _mm_xor_si128(_mm_xor_si128(s.s0, s.s1), s.s2));
+    _mm_storeu_si128((__m128i *)(tag + 16), _mm_xor_si128(_mm_xor_si128(s.s3, s.s4), s.s5));
+}
+
+}
+
+KERNEL void AESGCMAegis::encrypt(unsigned char *out, const unsigned char *in, size_t length,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char nonce[nonce_length],
+        unsigned char tag[tag_length]) const {
+    AegisState s;
+    initialize(s, key, nonce);
+    absorb(s, ad, ad_length);
+
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i m = _mm_loadu_si128((const __m128i *)(in + i));
+        _mm_storeu_si128((__m128i *)(out + i), _mm_xor_si128(m, keystream(s)));
+        update(s, m);
+    }
+    if (i < length) {
+        __m128i m = loadPartial(in + i, length - i);
+        storePartial(out + i, _mm_xor_si128(m, keystream(s)), length - i);
+        update(s, m);
+    }
+    finalize(s, ad_length, length, tag);
+}
+
+KERNEL int AESGCMAegis::decrypt(unsigned char *out, const unsigned char *in, size_t length,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char nonce[nonce_length],
+        const unsigned char tag[tag_length]) const {
+    AegisState s;
+    initialize(s, key, nonce);
+    absorb(s, ad, ad_length);
+
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i m = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(in + i)), keystream(s));
+        _mm_storeu_si128((__m128i *)(out + i), m);
+        update(s, m);
+    }
+    if (i < length) {
+        // The keystream past the end of the ciphertext must not be absorbed
+        // with the message, so the plaintext block is truncated first.
+        CRYPTO_ALIGN(16) unsigned char block[16] = {0};
+        _mm_store_si128((__m128i *)block,
+                _mm_xor_si128(loadPartial(in + i, length - i), keystream(s)));
+        memset(block + (length - i), 0, 16 - (length - i));
+        memcpy(out + i, block, length - i);
+        update(s, _mm_load_si128((const __m128i *)block));
+        sodium_memzero(block, sizeof(block));
+    }
+
+    CRYPTO_ALIGN(16) unsigned char computed[tag_length];
+    finalize(s, ad_length, length, computed);
+    int result = sodium_memcmp(computed, tag, tag_length);
+    if (result != 0) {
+        sodium_memzero(out, length);
+    }
+    return result;
+}
+
+#else
+
+void AESGCMAegis::encrypt(unsigned char *out, const unsigned char *in, size_t length,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char nonce[nonce_length],
+        unsigned char tag[tag_length]) const {
+}
+
+int AESGCMAegis::decrypt(unsigned char *out, const unsigned char *in, size_t length,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char nonce[nonce_length],
+        const unsigned char tag[tag_length]) const {
+    return -1;
+}
+
+#endif
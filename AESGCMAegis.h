@@ -0,0 +1,65 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef AESGCMAEGIS_H_INCLUDED
+#define AESGCMAEGIS_H_INCLUDED
+
+#include <sodium.h>
+
+#include <stddef.h>
+
+// AESGCMAegis implements the AEGIS-256 authenticated cipher
+// (draft-irtf-cfrg-aegis-aead) with AES-NI, using the 256-bit tag that
+// libsodium 1.0.19 and later use for crypto_aead_aegis256. Each 16 byte
+// block costs six independent AES rounds and no GHASH multiplication.
+//
+// It may only be used once AESGCMMultiBuffer::isAvailable() has returned
+// true; elsewhere encrypt does nothing and decrypt always fails.
+class AESGCMAegis {
+    public:
+        static const size_t key_length = 32;
+        static const size_t nonce_length = 32;
+        static const size_t tag_length = 32;
+
+        AESGCMAegis();
+        ~AESGCMAegis();
+
+        void init(const unsigned char key[key_length]);
+
+        // Encrypts length bytes of in to out, which may be in, and writes
+        // the tag.
+        void encrypt(unsigned char *out, const unsigned char *in, size_t length,
+                const unsigned char *ad, size_t ad_length,
+                const unsigned char nonce[nonce_length],
+                unsigned char tag[tag_length]) const;
+
+        // Decrypts length bytes of in to out and verifies tag. Returns 0 if
+        // verified, or -1 otherwise in which case out is zeroed.
+        int decrypt(unsigned char *out, const unsigned char *in, size_t length,
+                const unsigned char *ad, size_t ad_length,
+                const unsigned char nonce[nonce_length],
+                const unsigned char tag[tag_length]) const;
+
+    private:
+        CRYPTO_ALIGN(16) unsigned char key[key_length];
+};
+
+#endif /* AESGCMAEGIS_H_INCLUDED */
@@ -0,0 +1,74 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef AESGCMALGORITHM_H_INCLUDED
+#define AESGCMALGORITHM_H_INCLUDED
+
+#include <stddef.h>
+
+// AESGCMAlgorithm names the AEAD algorithms a value may be encrypted with.
+// The ID of an algorithm is stored in the AESGCMHeader of values encrypted
+// with any but aes256gcm, so must never change:
+//
+//   aes256gcm          0  AES-256-GCM, 12 byte nonce and 16 byte tag. Values
+//                         without an algorithm ID.
+//   aegis256           1  AEGIS-256 (AESGCMAegis), 32 byte nonce and tag.
+//                         Requires AES-NI.
+//   xchacha20poly1305  2  libsodium's XChaCha20-Poly1305-IETF, 24 byte nonce
+//                         and 16 byte tag.
+//
+// Each key has its own subkey for each algorithm, see AESGCMKey.
+class AESGCMAlgorithm {
+    public:
+        enum Type {
+            AES256GCM,
+            AEGIS256,
+            XCHACHA20POLY1305
+        };
+
+        static const unsigned char count = 3;
+
+        // The longest nonce and tag of any algorithm.
+        static const size_t max_nonce_length = 32;
+        static const size_t max_tag_length = 32;
+
+        static size_t nonceLength(Type algorithm) {
+            return algorithm == AEGIS256 ? 32 : algorithm == XCHACHA20POLY1305 ? 24 : 12;
+        }
+
+        static size_t tagLength(Type algorithm) {
+            return algorithm == AEGIS256 ? 32 : 16;
+        }
+
+        // The number of bytes added to a plaintext, other than the header.
+        static size_t overhead(Type algorithm) {
+            return nonceLength(algorithm) + tagLength(algorithm);
+        }
+
+        // Returns the name of algorithm, as above.
+        static const char *name(Type algorithm);
+
+        // Sets algorithm to the algorithm called name. Returns false if there
+        // is none.
+        static bool parse(const char *name, Type &algorithm);
+};
+
+#endif /* AESGCMALGORITHM_H_INCLUDED */
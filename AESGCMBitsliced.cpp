@@ -0,0 +1,611 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMBitsliced.h"
+
+#include <sodium.h>
+#include <cstring>
+
+static inline uint32_t load32le(const unsigned char *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void store32le(unsigned char *p, uint32_t x) {
+    p[0] = (unsigned char)x;
+    p[1] = (unsigned char)(x >> 8);
+    p[2] = (unsigned char)(x >> 16);
+    p[3] = (unsigned char)(x >> 24);
+}
+
+static inline uint64_t load64be(const unsigned char *p) {
+    uint64_t x = 0;
+    for (int i = 0; i < 8; i++) {
+        x = (x << 8) | p[i];
+    }
+    return x;
+}
+
+static inline void store64be(unsigned char *p, uint64_t x) {
+    for (int i = 7; i >= 0; i--) {
+        p[i] = (unsigned char)x;
+        x >>= 8;
+    }
+}
+
+// The AES S-box applied to each of the 64 bytes held in q, as the circuit of
+// Boyar and Peralta.
+static void sbox(uint64_t *q) {
+    uint64_t x0, x1, x2, x3, x4, x5, x6, x7;
+    uint64_t y1, y2, y3, y4, y5, y6, y7, y8, y9, y10, y11;
+    uint64_t y12, y13, y14, y15, y16, y17, y18, y19, y20, y21;
+    uint64_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9, z10, z11;
+    uint64_t z12, z13, z14, z15, z16, z17;
+    uint64_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11;
+    uint64_t t12, t13, t14, t15, t16, t17, t18, t19, t20, t21, t22, t23;
+    uint64_t t24, t25, t26, t27, t28, t29, t30, t31, t32, t33, t34, t35;
+    uint64_t t36, t37, t38, t39, t40, t41, t42, t43, t44, t45, t46, t47;
+    uint64_t t48, t49, t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+    uint64_t t60, t61, t62, t63, t64, t65, t66, t67;
+    uint64_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+    x0 = q[7];
+    x1 = q[6];
+    x2 = q[5];
+    x3 = q[4];
+    x4 = q[3];
+    x5 = q[2];
+    x6 = q[1];
+    x7 = q[0];
+
+    // Top linear transformation.
+    y14 = x3 ^ x5;
+    y13 = x0 ^ x6;
+    y9 = x0 ^ x3;
+    y8 = x0 ^ x5;
+    t0 = x1 ^ x2;
+    y1 = t0 ^ x7;
+    y4 = y1 ^ x3;
+    y12 = y13 ^ y14;
+    y2 = y1 ^ x0;
+    y5 = y1 ^ x6;
+    y3 = y5 ^ y8;
+    t1 = x4 ^ y12;
+    y15 = t1 ^ x5;
+    y20 = t1 ^ x1;
+    y6 = y15 ^ x7;
+    y10 = y15 ^ t0;
+    y11 = y20 ^ y9;
+    y7 = x7 ^ y11;
+    y17 = y10 ^ y11;
+    y19 = y10 ^ y8;
+    y16 = t0 ^ y11;
+    y21 = y13 ^ y16;
+    y18 = x0 ^ y16;
+
+    // Non-linear section.
+    t2 = y12 & y15;
+    t3 = y3 & y6;
+    t4 = t3 ^ t2;
+    t5 = y4 & x7;
+    t6 = t5 ^ t2;
+    t7 = y13 & y16;
+    t8 = y5 & y1;
+    t9 = t8 ^ t7;
+    t10 = y2 & y7;
+    t11 = t10 ^ t7;
+    t12 = y9 & y11;
+    t13 = y14 & y17;
+    t14 = t13 ^ t12;
+    t15 = y8 & y10;
+    t16 = t15 ^ t12;
+    t17 = t4 ^ t14;
+    t18 = t6 ^ t16;
+    t19 = t9 ^ t14;
+    t20 = t11 ^ t16;
+    t21 = t17 ^ y20;
+    t22 = t18 ^ y19;
+    t23 = t19 ^ y21;
+    t24 = t20 ^ y18;
+
+    t25 = t21 ^ t22;
+    t26 = t21 & t23;
+    t27 = t24 ^ t26;
+    t28 = t25 & t27;
+    t29 = t28 ^ t22;
+    t30 = t23 ^ t24;
+    t31 = t22 ^ t26;
+    t32 = t31 & t30;
+    t33 = t32 ^ t24;
+    t34 = t23 ^ t33;
+    t35 = t27 ^ t33;
+    t36 = t24 & t35;
+    t37 = t36 ^ t34;
+    t38 = t27 ^ t36;
+    t39 = t29 & t38;
+    t40 = t25 ^ t39;
+
+    t41 = t40 ^ t37;
+    t42 = t29 ^ t33;
+    t43 = t29 ^ t40;
+    t44 = t33 ^ t37;
+    t45 = t42 ^ t41;
+    z0 = t44 & y15;
+    z1 = t37 & y6;
+    z2 = t33 & x7;
+    z3 = t43 & y16;
+    z4 = t40 & y1;
+    z5 = t29 & y7;
+    z6 = t42 & y11;
+    z7 = t45 & y17;
+    z8 = t41 & y10;
+    z9 = t44 & y12;
+    z10 = t37 & y3;
+    z11 = t33 & y4;
+    z12 = t43 & y13;
+    z13 = t40 & y5;
+    z14 = t29 & y2;
+    z15 = t42 & y9;
+    z16 = t45 & y14;
+    z17 = t41 & y8;
+
+    // Bottom linear transformation.
+    t46 = z15 ^ z16;
+    t47 = z10 ^ z11;
+    t48 = z5 ^ z13;
+    t49 = z9 ^ z10;
+    t50 = z2 ^ z12;
+    t51 = z2 ^ z5;
+    t52 = z7 ^ z8;
+    t53 = z0 ^ z3;
+    t54 = z6 ^ z7;
+    t55 = z16 ^ z17;
+    t56 = z12 ^ t48;
+    t57 = t50 ^ t53;
+    t58 = z4 ^ t46;
+    t59 = z3 ^ t54;
+    t60 = t46 ^ t57;
+    t61 = z14 ^ t57;
+    t62 = t52 ^ t58;
+    t63 = t49 ^ t58;
+    t64 = z4 ^ t59;
+    t65 = t61 ^ t62;
+    t66 = z1 ^ t63;
+    s0 = t59 ^ t63;
+    s6 = t56 ^ ~t62;
+    s7 = t48 ^ ~t60;
+    t67 = t64 ^ t65;
+    s3 = t53 ^ t66;
+    s4 = t51 ^ t66;
+    s5 = t47 ^ t65;
+    s1 = t64 ^ ~s3;
+    s2 = t55 ^ ~t67;
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+#define SWAPN(cl, ch, s, x, y) do { \
+        uint64_t a = (x), b = (y); \
+        (x) = (a & (uint64_t)(cl)) | ((b & (uint64_t)(cl)) << (s)); \
+        (y) = ((a & (uint64_t)(ch)) >> (s)) | (b & (uint64_t)(ch)); \
+    } while (0)
+
+#define SWAP2(x, y) SWAPN(0x5555555555555555ULL, 0xAAAAAAAAAAAAAAAAULL, 1, x, y)
+#define SWAP4(x, y) SWAPN(0x3333333333333333ULL, 0xCCCCCCCCCCCCCCCCULL, 2, x, y)
+#define SWAP8(x, y) SWAPN(0x0F0F0F0F0F0F0F0FULL, 0xF0F0F0F0F0F0F0F0ULL, 4, x, y)
+
+// Transposes q between the interleaved and bitsliced representations; it is
+// its own inverse.
+static void ortho(uint64_t *q) {
+    SWAP2(q[0], q[1]);
+    SWAP2(q[2], q[3]);
+    SWAP2(q[4], q[5]);
+    SWAP2(q[6], q[7]);
+
+    SWAP4(q[0], q[2]);
+    SWAP4(q[1], q[3]);
+    SWAP4(q[4], q[6]);
+    SWAP4(q[5], q[7]);
+
+    SWAP8(q[0], q[4]);
+    SWAP8(q[1], q[5]);
+    SWAP8(q[2], q[6]);
+    SWAP8(q[3], q[7]);
+}
+
+#undef SWAP8
+#undef SWAP4
+#undef SWAP2
+#undef SWAPN
+
+// Spreads the four little-endian words of a block over two words, leaving
+// room for three other blocks.
+static void interleaveIn(uint64_t *q0, uint64_t *q1, const uint32_t *w) {
+    uint64_t x0 = w[0], x1 = w[1], x2 = w[2], x3 = w[3];
+    x0 |= (x0 << 16);
+    x1 |= (x1 << 16);
+    x2 |= (x2 << 16);
+    x3 |= (x3 << 16);
+    x0 &= 0x0000FFFF0000FFFFULL;
+    x1 &= 0x0000FFFF0000FFFFULL;
+    x2 &= 0x0000FFFF0000FFFFULL;
+    x3 &= 0x0000FFFF0000FFFFULL;
+    x0 |= (x0 << 8);
+    x1 |= (x1 << 8);
+    x2 |= (x2 << 8);
+    x3 |= (x3 << 8);
+    x0 &= 0x00FF00FF00FF00FFULL;
+    x1 &= 0x00FF00FF00FF00FFULL;
+    x2 &= 0x00FF00FF00FF00FFULL;
+    x3 &= 0x00FF00FF00FF00FFULL;
+    *q0 = x0 | (x2 << 8);
+    *q1 = x1 | (x3 << 8);
+}
+
+// The inverse of interleaveIn.
+static void interleaveOut(uint32_t *w, uint64_t q0, uint64_t q1) {
+    uint64_t x0 = q0 & 0x00FF00FF00FF00FFULL;
+    uint64_t x1 = q1 & 0x00FF00FF00FF00FFULL;
+    uint64_t x2 = (q0 >> 8) & 0x00FF00FF00FF00FFULL;
+    uint64_t x3 = (q1 >> 8) & 0x00FF00FF00FF00FFULL;
+    x0 |= (x0 >> 8);
+    x1 |= (x1 >> 8);
+    x2 |= (x2 >> 8);
+    x3 |= (x3 >> 8);
+    x0 &= 0x0000FFFF0000FFFFULL;
+    x1 &= 0x0000FFFF0000FFFFULL;
+    x2 &= 0x0000FFFF0000FFFFULL;
+    x3 &= 0x0000FFFF0000FFFFULL;
+    w[0] = (uint32_t)x0 | (uint32_t)(x0 >> 16);
+    w[1] = (uint32_t)x1 | (uint32_t)(x1 >> 16);
+    w[2] = (uint32_t)x2 | (uint32_t)(x2 >> 16);
+    w[3] = (uint32_t)x3 | (uint32_t)(x3 >> 16);
+}
+
+static uint32_t subWord(uint32_t x) {
+    uint64_t q[8] = {0};
+    q[0] = x;
+    ortho(q);
+    sbox(q);
+    ortho(q);
+    return (uint32_t)q[0];
+}
+
+static inline void addRoundKey(uint64_t *q, const uint64_t *sk) {
+    for (int i = 0; i < 8; i++) {
+        q[i] ^= sk[i];
+    }
+}
+
+static inline void shiftRows(uint64_t *q) {
+    for (int i = 0; i < 8; i++) {
+        uint64_t x = q[i];
+        q[i] = (x & 0x000000000000FFFFULL)
+            | ((x & 0x00000000FFF00000ULL) >> 4)
+            | ((x & 0x00000000000F0000ULL) << 12)
+            | ((x & 0x0000FF0000000000ULL) >> 8)
+            | ((x & 0x000000FF00000000ULL) << 8)
+            | ((x & 0xF000000000000000ULL) >> 12)
+            | ((x & 0x0FFF000000000000ULL) << 4);
+    }
+}
+
+static inline uint64_t rotr32(uint64_t x) {
+    return (x << 32) | (x >> 32);
+}
+
+static inline void mixColumns(uint64_t *q) {
+    uint64_t q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    uint64_t q4 = q[4], q5 = q[5], q6 = q[6], q7 = q[7];
+    uint64_t r0 = (q0 >> 16) | (q0 << 48);
+    uint64_t r1 = (q1 >> 16) | (q1 << 48);
+    uint64_t r2 = (q2 >> 16) | (q2 << 48);
+    uint64_t r3 = (q3 >> 16) | (q3 << 48);
+    uint64_t r4 = (q4 >> 16) | (q4 << 48);
+    uint64_t r5 = (q5 >> 16) | (q5 << 48);
+    uint64_t r6 = (q6 >> 16) | (q6 << 48);
+    uint64_t r7 = (q7 >> 16) | (q7 << 48);
+
+    q[0] = q7 ^ r7 ^ r0 ^ rotr32(q0 ^ r0);
+    q[1] = q0 ^ r0 ^ q7 ^ r7 ^ r1 ^ rotr32(q1 ^ r1);
+    q[2] = q1 ^ r1 ^ r2 ^ rotr32(q2 ^ r2);
+    q[3] = q2 ^ r2 ^ q7 ^ r7 ^ r3 ^ rotr32(q3 ^ r3);
+    q[4] = q3 ^ r3 ^ q7 ^ r7 ^ r4 ^ rotr32(q4 ^ r4);
+    q[5] = q4 ^ r4 ^ r5 ^ rotr32(q5 ^ r5);
+    q[6] = q5 ^ r5 ^ r6 ^ rotr32(q6 ^ r6);
+    q[7] = q6 ^ r6 ^ r7 ^ rotr32(q7 ^ r7);
+}
+
+// Encrypts the four bitsliced blocks in q.
+static void encryptBitsliced(const uint64_t *round_keys, uint64_t *q) {
+    addRoundKey(q, round_keys);
+    for (int round = 1; round < 14; round++) {
+        sbox(q);
+        shiftRows(q);
+        mixColumns(q);
+        addRoundKey(q, round_keys + round * 8);
+    }
+    sbox(q);
+    shiftRows(q);
+    addRoundKey(q, round_keys + 14 * 8);
+}
+
+// Encrypts up to four blocks in place.
+static void encryptBlocks(const uint64_t *round_keys, unsigned char blocks[4][16]) {
+    uint32_t w[16];
+    uint64_t q[8];
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            w[i * 4 + j] = load32le(blocks[i] + j * 4);
+        }
+        interleaveIn(&q[i], &q[i + 4], w + i * 4);
+    }
+    ortho(q);
+    encryptBitsliced(round_keys, q);
+    ortho(q);
+    for (int i = 0; i < 4; i++) {
+        interleaveOut(w + i * 4, q[i], q[i + 4]);
+        for (int j = 0; j < 4; j++) {
+            store32le(blocks[i] + j * 4, w[i * 4 + j]);
+        }
+    }
+}
+
+// Carry-less multiplication of the low 64 bits of x and y, keeping the low
+// 64 bits of the product. Every fourth bit of each operand is multiplied at
+// a time so that carries fall into the holes between them.
+static inline uint64_t bmul64(uint64_t x, uint64_t y) {
+    uint64_t x0 = x & 0x1111111111111111ULL;
+    uint64_t x1 = x & 0x2222222222222222ULL;
+    uint64_t x2 = x & 0x4444444444444444ULL;
+    uint64_t x3 = x & 0x8888888888888888ULL;
+    uint64_t y0 = y & 0x1111111111111111ULL;
+    uint64_t y1 = y & 0x2222222222222222ULL;
+    uint64_t y2 = y & 0x4444444444444444ULL;
+    uint64_t y3 = y & 0x8888888888888888ULL;
+    uint64_t z0 = (x0 * y0) ^ (x1 * y3) ^ (x2 * y2) ^ (x3 * y1);
+    uint64_t z1 = (x0 * y1) ^ (x1 * y0) ^ (x2 * y3) ^ (x3 * y2);
+    uint64_t z2 = (x0 * y2) ^ (x1 * y1) ^ (x2 * y0) ^ (x3 * y3);
+    uint64_t z3 = (x0 * y3) ^ (x1 * y2) ^ (x2 * y1) ^ (x3 * y0);
+    z0 &= 0x1111111111111111ULL;
+    z1 &= 0x2222222222222222ULL;
+    z2 &= 0x4444444444444444ULL;
+    z3 &= 0x8888888888888888ULL;
+    return z0 | z1 | z2 | z3;
+}
+
+// Reverses the bits of x.
+static inline uint64_t rev64(uint64_t x) {
+    x = ((x & 0x5555555555555555ULL) << 1) | ((x >> 1) & 0x5555555555555555ULL);
+    x = ((x & 0x3333333333333333ULL) << 2) | ((x >> 2) & 0x3333333333333333ULL);
+    x = ((x & 0x0F0F0F0F0F0F0F0FULL) << 4) | ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL);
+    x = ((x & 0x00FF00FF00FF00FFULL) << 8) | ((x >> 8) & 0x00FF00FF00FF00FFULL);
+    x = ((x & 0x0000FFFF0000FFFFULL) << 16) | ((x >> 16) & 0x0000FFFF0000FFFFULL);
+    return (x << 32) | (x >> 32);
+}
+
+// GHASHState absorbs 16-byte blocks, the last of a message zero padded.
+struct GHASHState {
+    uint64_t y0, y1; // low and high halves of Y
+    uint64_t h0, h1, h2, h0r, h1r, h2r;
+
+    GHASHState(const uint64_t h[2]): y0(0), y1(0) {
+        h1 = h[0];
+        h0 = h[1];
+        h0r = rev64(h0);
+        h1r = rev64(h1);
+        h2 = h0 ^ h1;
+        h2r = h0r ^ h1r;
+    }
+
+    // Computes Y = (Y + X) * H, with the Karatsuba multiplication done both
+    // on the bits as given and reversed to recover the high halves.
+    void block(const unsigned char *x) {
+        y1 ^= load64be(x);
+        y0 ^= load64be(x + 8);
+
+        uint64_t y0r = rev64(y0);
+        uint64_t y1r = rev64(y1);
+        uint64_t y2 = y0 ^ y1;
+        uint64_t y2r = y0r ^ y1r;
+
+        uint64_t z0 = bmul64(y0, h0);
+        uint64_t z1 = bmul64(y1, h1);
+        uint64_t z2 = bmul64(y2, h2);
+        uint64_t z0h = bmul64(y0r, h0r);
+        uint64_t z1h = bmul64(y1r, h1r);
+        uint64_t z2h = bmul64(y2r, h2r);
+        z2 ^= z0 ^ z1;
+        z2h ^= z0h ^ z1h;
+        z0h = rev64(z0h) >> 1;
+        z1h = rev64(z1h) >> 1;
+        z2h = rev64(z2h) >> 1;
+
+        uint64_t v0 = z0;
+        uint64_t v1 = z0h ^ z2;
+        uint64_t v2 = z1 ^ z2h;
+        uint64_t v3 = z1h;
+
+        v3 = (v3 << 1) | (v2 >> 63);
+        v2 = (v2 << 1) | (v1 >> 63);
+        v1 = (v1 << 1) | (v0 >> 63);
+        v0 = (v0 << 1);
+
+        v2 ^= v0 ^ (v0 >> 1) ^ (v0 >> 2) ^ (v0 >> 7);
+        v1 ^= (v0 << 63) ^ (v0 << 62) ^ (v0 << 57);
+        v3 ^= v1 ^ (v1 >> 1) ^ (v1 >> 2) ^ (v1 >> 7);
+        v2 ^= (v1 << 63) ^ (v1 << 62) ^ (v1 << 57);
+
+        y0 = v2;
+        y1 = v3;
+    }
+
+    void update(const unsigned char *data, size_t length) {
+        for (; length >= 16; data += 16, length -= 16) {
+            block(data);
+        }
+        if (length > 0) {
+            unsigned char last[16] = {0};
+            memcpy(last, data, length);
+            block(last);
+        }
+    }
+};
+
+AESGCMBitsliced::AESGCMBitsliced() {
+    memset(round_keys, 0, sizeof(round_keys));
+    memset(h, 0, sizeof(h));
+}
+
+AESGCMBitsliced::~AESGCMBitsliced() {
+    sodium_memzero(round_keys, sizeof(round_keys));
+    sodium_memzero(h, sizeof(h));
+}
+
+void AESGCMBitsliced::init(const unsigned char key[crypto_aead_aes256gcm_KEYBYTES]) {
+    static const unsigned char rcon[] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40};
+
+    // The standard AES256 key schedule, with S-box lookups bitsliced.
+    uint32_t schedule[60];
+    for (int i = 0; i < 8; i++) {
+        schedule[i] = load32le(key + i * 4);
+    }
+    uint32_t tmp = schedule[7];
+    for (int i = 8, j = 0, k = 0; i < 60; i++) {
+        if (j == 0) {
+            tmp = (tmp << 24) | (tmp >> 8);
+            tmp = subWord(tmp) ^ rcon[k];
+        } else if (j == 4) {
+            tmp = subWord(tmp);
+        }
+        tmp ^= schedule[i - 8];
+        schedule[i] = tmp;
+        if (++j == 8) {
+            j = 0;
+            k++;
+        }
+    }
+
+    // Each round key is bitsliced and repeated for each of the four blocks.
+    for (int i = 0; i < 15; i++) {
+        uint64_t q[8];
+        interleaveIn(&q[0], &q[4], schedule + i * 4);
+        q[1] = q[2] = q[3] = q[0];
+        q[5] = q[6] = q[7] = q[4];
+        ortho(q);
+        for (int j = 0; j < 8; j++) {
+            round_keys[i * 8 + j] = q[j];
+        }
+    }
+    sodium_memzero(schedule, sizeof(schedule));
+
+    unsigned char blocks[4][16] = {{0}};
+    encryptBlocks(round_keys, blocks);
+    h[0] = load64be(blocks[0]);
+    h[1] = load64be(blocks[0] + 8);
+}
+
+void AESGCMBitsliced::ghash(unsigned char y[16],
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char *ciphertext, size_t length) const {
+    GHASHState state(h);
+    state.update(ad, ad_length);
+    state.update(ciphertext, length);
+
+    unsigned char lengths[16];
+    store64be(lengths, (uint64_t)ad_length * 8);
+    store64be(lengths + 8, (uint64_t)length * 8);
+    state.block(lengths);
+
+    store64be(y, state.y1);
+    store64be(y + 8, state.y0);
+}
+
+void AESGCMBitsliced::ctr(const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES],
+        const unsigned char *in, unsigned char *out, size_t length,
+        unsigned char mask[16]) const {
+    // J0 is counter block 1 and masks the tag; the keystream starts at 2.
+    uint32_t counter = 1;
+    bool first = true;
+    unsigned char blocks[4][16];
+    while (first || length > 0) {
+        for (int i = 0; i < 4; i++) {
+            memcpy(blocks[i], nonce, crypto_aead_aes256gcm_NPUBBYTES);
+            uint32_t c = counter + i;
+            blocks[i][12] = (unsigned char)(c >> 24);
+            blocks[i][13] = (unsigned char)(c >> 16);
+            blocks[i][14] = (unsigned char)(c >> 8);
+            blocks[i][15] = (unsigned char)c;
+        }
+        encryptBlocks(round_keys, blocks);
+
+        int i = 0;
+        if (first) {
+            memcpy(mask, blocks[0], 16);
+            first = false;
+            i = 1;
+        }
+        for (; i < 4 && length > 0; i++) {
+            size_t n = length < 16 ? length : 16;
+            for (size_t j = 0; j < n; j++) {
+                out[j] = in[j] ^ blocks[i][j];
+            }
+            in += n;
+            out += n;
+            length -= n;
+        }
+        counter += 4;
+    }
+    sodium_memzero(blocks, sizeof(blocks));
+}
+
+void AESGCMBitsliced::encrypt(unsigned char *out, const unsigned char *in, size_t length,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES]) const {
+    unsigned char mask[16], tag[16];
+    ctr(nonce, in, out, length, mask);
+    ghash(tag, ad, ad_length, out, length);
+    for (int i = 0; i < 16; i++) {
+        out[length + i] = tag[i] ^ mask[i];
+    }
+}
+
+int AESGCMBitsliced::decrypt(unsigned char *out, const unsigned char *in, size_t length,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES]) const {
+    unsigned char mask[16], tag[16];
+    ghash(tag, ad, ad_length, in, length);
+    ctr(nonce, in, out, length, mask);
+    for (int i = 0; i < 16; i++) {
+        tag[i] ^= mask[i];
+    }
+    if (crypto_verify_16(tag, in + length) != 0) {
+        sodium_memzero(out, length);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef AESGCMBITSLICED_H_INCLUDED
+#define AESGCMBITSLICED_H_INCLUDED
+
+#include <sodium.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+// AESGCMBitsliced implements AES256-GCM in portable C++ for CPUs without
+// AES-NI. AES is bitsliced, four blocks at a time in eight 64-bit words, and
+// GHASH uses integer multiplications with holes between the bits of each
+// operand, so neither has table lookups or branches which depend on the key
+// or data (the constant-time designs of BearSSL's aes_ct64 and ghash_ctmul64).
+// Results are byte-for-byte identical to libsodium's AES256-GCM.
+class AESGCMBitsliced {
+    public:
+        AESGCMBitsliced();
+        ~AESGCMBitsliced();
+
+        // Expands the key. Must be called before encrypt or decrypt.
+        void init(const unsigned char key[crypto_aead_aes256gcm_KEYBYTES]);
+
+        // Encrypts length bytes of in to out, followed by the tag, as
+        // crypto_aead_aes256gcm_encrypt_afternm.
+        void encrypt(unsigned char *out, const unsigned char *in, size_t length,
+                const unsigned char *ad, size_t ad_length,
+                const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES]) const;
+
+        // Verifies and decrypts in, length bytes of ciphertext followed by
+        // the tag, to out, as crypto_aead_aes256gcm_decrypt_afternm. Returns 0
+        // if verified, or -1 otherwise in which case out is zeroed.
+        int decrypt(unsigned char *out, const unsigned char *in, size_t length,
+                const unsigned char *ad, size_t ad_length,
+                const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES]) const;
+
+    private:
+        // Bitsliced round keys, eight words for each of the 15 rounds.
+        uint64_t round_keys[120];
+        // The GHASH key, high half first.
+        uint64_t h[2];
+
+        // Returns the unmasked GHASH of ad and ciphertext.
+        void ghash(unsigned char y[16],
+                const unsigned char *ad, size_t ad_length,
+                const unsigned char *ciphertext, size_t length) const;
+
+        // XORs the keystream starting at counter block 2 into in, writing to
+        // out, and writes the encrypted J0 to mask.
+        void ctr(const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES],
+                const unsigned char *in, unsigned char *out, size_t length,
+                unsigned char mask[16]) const;
+};
+
+#endif /* AESGCMBITSLICED_H_INCLUDED */
@@ -0,0 +1,267 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMCompression.h"
+
+#include <stdint.h>
+#include <string.h>
+
+// Constants of the LZ4 block format. The last match must start at least
+// mf_limit bytes before the end of the block, and the last last_literals
+// bytes are always literals.
+static const size_t min_match = 4;
+static const size_t last_literals = 5;
+static const size_t mf_limit = 12;
+static const size_t max_offset = 65535;
+
+// The hash table has at most 2^max_hash_bits entries, and at least enough for
+// one per byte of input.
+static const unsigned int min_hash_bits = 8;
+static const unsigned int max_hash_bits = 12;
+
+// Searches without a match between steps of one more byte.
+static const unsigned int skip_trigger = 6;
+
+static inline uint32_t read32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline unsigned int hash32(uint32_t v, unsigned int bits) {
+    return (v * 2654435761U) >> (32 - bits);
+}
+
+// Writes the extension bytes of a literal or match length field, given the
+// length less the 15 stored in the token.
+static unsigned char *writeLength(unsigned char *op, size_t length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (unsigned char)length;
+    return op;
+}
+
+// Writes a sequence of literals followed by a match, or by nothing if
+// match_length is 0 (the last sequence). Returns the end of the sequence, or
+// NULL if it might not fit before end.
+static unsigned char *writeSequence(unsigned char *op, const unsigned char *end,
+        const unsigned char *literals, size_t literal_length,
+        size_t offset, size_t match_length) {
+    size_t needed = 1 + literal_length / 255 + 1 + literal_length;
+    if (match_length > 0) {
+        needed += 2 + match_length / 255 + 1;
+    }
+    if ((size_t)(end - op) < needed) {
+        return NULL;
+    }
+
+    unsigned char *token = op++;
+    *token = (unsigned char)((literal_length < 15 ? literal_length : 15) << 4);
+    if (literal_length >= 15) {
+        op = writeLength(op, literal_length - 15);
+    }
+    memcpy(op, literals, literal_length);
+    op += literal_length;
+
+    if (match_length > 0) {
+        *op++ = (unsigned char)offset;
+        *op++ = (unsigned char)(offset >> 8);
+        size_t length = match_length - min_match;
+        *token |= (unsigned char)(length < 15 ? length : 15);
+        if (length >= 15) {
+            op = writeLength(op, length - 15);
+        }
+    }
+    return op;
+}
+
+// Reads the plaintext length prefix of a payload into out_length, and its
+// length into prefix_length. Returns false if it is malformed.
+static bool readLength(const unsigned char *in, size_t length,
+        size_t &out_length, size_t &prefix_length) {
+    size_t n = 0;
+    for (size_t i = 0; i < 5 && i < length; i++) {
+        n |= (size_t)(in[i] & 0x7f) << (7 * i);
+        if ((in[i] & 0x80) == 0) {
+            out_length = n;
+            prefix_length = i + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Reads the extension bytes of a length field starting at in[ip], adding
+// them to field. Returns false if the payload ends first.
+static bool readLengthExtension(const unsigned char *in, size_t length, size_t &ip,
+        size_t &field) {
+    unsigned char b;
+    do {
+        if (ip >= length) {
+            return false;
+        }
+        b = in[ip++];
+        field += b;
+    } while (b == 255);
+    return true;
+}
+
+size_t AESGCMCompression::compress(const unsigned char *in, size_t length,
+        unsigned char *out, size_t capacity) {
+    if (length < min_length) {
+        return 0;
+    }
+
+    unsigned char *op = out;
+    const unsigned char *end = out + capacity;
+    size_t n = length;
+    do {
+        if (op == end) {
+            return 0;
+        }
+        unsigned char b = n & 0x7f;
+        n >>= 7;
+        *op++ = b | (n != 0 ? 0x80 : 0);
+    } while (n != 0);
+
+    unsigned int bits = min_hash_bits;
+    while (bits < max_hash_bits && ((size_t)1 << bits) < length) {
+        bits++;
+    }
+    uint32_t table[1 << max_hash_bits];
+    memset(table, 0, sizeof(table[0]) << bits);
+
+    // Matches start at or before match_start_limit and end at or before
+    // match_end_limit.
+    const size_t match_start_limit = length - mf_limit;
+    const size_t match_end_limit = length - last_literals;
+
+    size_t anchor = 0;
+    size_t ip = 1;
+    unsigned int searches = 1 << skip_trigger;
+    while (ip <= match_start_limit) {
+        uint32_t sequence = read32(in + ip);
+        unsigned int h = hash32(sequence, bits);
+        size_t ref = table[h];
+        table[h] = (uint32_t)ip;
+        if (ip - ref > max_offset || read32(in + ref) != sequence) {
+            ip += searches++ >> skip_trigger;
+            continue;
+        }
+        searches = 1 << skip_trigger;
+
+        while (ip > anchor && ref > 0 && in[ip - 1] == in[ref - 1]) {
+            ip--;
+            ref--;
+        }
+        size_t match_length = min_match;
+        while (ip + match_length < match_end_limit &&
+                in[ip + match_length] == in[ref + match_length]) {
+            match_length++;
+        }
+
+        op = writeSequence(op, end, in + anchor, ip - anchor, ip - ref, match_length);
+        if (op == NULL) {
+            return 0;
+        }
+        ip += match_length;
+        anchor = ip;
+
+        if (ip <= match_start_limit) {
+            table[hash32(read32(in + ip - 2), bits)] = (uint32_t)(ip - 2);
+        }
+    }
+
+    op = writeSequence(op, end, in + anchor, length - anchor, 0, 0);
+    if (op == NULL) {
+        return 0;
+    }
+    return op - out;
+}
+
+bool AESGCMCompression::decompressedLength(const unsigned char *in, size_t length,
+        size_t &out_length) {
+    size_t prefix_length;
+    return readLength(in, length, out_length, prefix_length);
+}
+
+bool AESGCMCompression::decompress(const unsigned char *in, size_t length,
+        unsigned char *out, size_t out_length) {
+    size_t expected_length, ip;
+    if (!readLength(in, length, expected_length, ip) || expected_length != out_length) {
+        return false;
+    }
+
+    size_t op = 0;
+    for (;;) {
+        if (ip >= length) {
+            return false;
+        }
+        unsigned char token = in[ip++];
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !readLengthExtension(in, length, ip, literal_length)) {
+            return false;
+        }
+        if (literal_length > length - ip || literal_length > out_length - op) {
+            return false;
+        }
+        memcpy(out + op, in + ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+
+        // The last sequence has no match.
+        if (ip == length) {
+            return op == out_length;
+        }
+
+        if (length - ip < 2) {
+            return false;
+        }
+        size_t offset = in[ip] | ((size_t)in[ip + 1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) {
+            return false;
+        }
+
+        size_t match_length = token & 15;
+        if (match_length == 15 && !readLengthExtension(in, length, ip, match_length)) {
+            return false;
+        }
+        match_length += min_match;
+        if (match_length > out_length - op) {
+            return false;
+        }
+
+        // A match may overlap the bytes it produces.
+        const unsigned char *match = out + op - offset;
+        if (offset >= match_length) {
+            memcpy(out + op, match, match_length);
+        } else {
+            for (size_t i = 0; i < match_length; i++) {
+                out[op + i] = match[i];
+            }
+        }
+        op += match_length;
+    }
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef AESGCMCOMPRESSION_H_INCLUDED
+#define AESGCMCOMPRESSION_H_INCLUDED
+
+#include <stddef.h>
+
+// AESGCMCompression compresses plaintexts before they are encrypted, since
+// ciphertext cannot be compressed by Vertica's encodings. A compressed
+// payload is the length of the plaintext (LEB128, at most 5 bytes) followed
+// by an LZ4 block (see lz4_Block_format.md in the LZ4 distribution), which
+// the reference LZ4_decompress_safe decompresses. The compressor is a greedy
+// single-pass matcher whose hash table is sized to the input, so short values
+// are cheap to try.
+class AESGCMCompression {
+    public:
+        // Plaintexts shorter than this are never compressed.
+        static const size_t min_length = 32;
+
+        // Compresses length bytes of in to out, which has room for capacity
+        // bytes. Returns the length of the payload, or 0 if it would not fit
+        // in capacity (in particular, if it is not shorter than the
+        // plaintext when capacity is less than length) or length is less than
+        // min_length.
+        static size_t compress(const unsigned char *in, size_t length,
+                unsigned char *out, size_t capacity);
+
+        // Reads the length of the plaintext of a payload of length bytes.
+        // Returns false if the payload is malformed.
+        static bool decompressedLength(const unsigned char *in, size_t length,
+                size_t &out_length);
+
+        // Decompresses a payload of length bytes to out, which has room for
+        // exactly its decompressedLength. Returns false if the payload is
+        // malformed.
+        static bool decompress(const unsigned char *in, size_t length,
+                unsigned char *out, size_t out_length);
+};
+
+#endif /* AESGCMCOMPRESSION_H_INCLUDED */
@@ -19,9 +19,14 @@
 // THE SOFTWARE.
 
 #include "AESGCMFunction.h"
+#include "AESGCMEncoding.h"
+#include "AESGCMNativeType.h"
+#include "AESGCMThreadPool.h"
 
 #include <Vertica.h>
 #include <sodium.h>
+#include <cstring>
+#include <vector>
 
 using namespace Vertica;
 
@@ -31,12 +36,414 @@ using namespace Vertica;
 //
 // Note that the nonce for decryption is supplied as a 96 bit (12 byte) prefix
 // to the ciphertext. The result will thus be 28 bytes shorter (12
-// byte nonce + 16 byte associated data tag).
+// byte nonce + 16 byte associated data tag). Values with an AESGCMHeader are
+// decrypted with the keyring key it identifies and are a further 3 bytes
+// shorter. Values whose header marks them compressed are decompressed; it is
+// an error if the plaintext is longer than the result column type allows,
+// which can only happen if the value was cast to a shorter type than
+// AESGCMEncrypt's result. Values whose header names another AESGCMAlgorithm
+// are decrypted with it, one at a time.
+//
+// With THREADS_PARAM, large blocks are split into ranges of rows which are
+// decrypted into scratch on AESGCMThreadPool threads, and copied to their rows
+// once the whole block is decrypted.
 //
 // The result column type is always a VARCHAR(X), where given an input column
 // VARBINARY(Y), X = Y - 28. See AESGCMDecryptFactory.
 class AESGCMDecrypt: public AESGCMFunction {
+    private:
+        // PendingRow is a row of the block waiting on a batch to be
+        // decrypted. NULL rows are queued as well so that rows are written in
+        // order once the batch is flushed.
+        struct PendingRow {
+            const unsigned char *value; // NULL for a NULL row
+            size_t value_length;
+            const unsigned char *ad;
+            size_t ad_length;
+            size_t message; // index into batch
+        };
+
+        static const size_t max_pending = 4 * AESGCMMultiBuffer::max_messages;
+
+        PendingRow pending[max_pending];
+        size_t pending_size;
+
+        // Batched values are decrypted into scratch and copied to their row
+        // once verified, since whether a value has a header (and so the
+        // length of its plaintext) is only known after verification.
+        AESGCMMessage batch[AESGCMMultiBuffer::max_messages];
+        size_t batch_size;
+        const AESGCMKey *batch_key;
+        unsigned char scratch[AESGCMMultiBuffer::max_messages][AESGCMMultiBuffer::max_length];
+
+        // Compressed plaintexts decrypted by decryptRow are moved here to be
+        // decompressed into their row.
+        std::vector<unsigned char> compressed_scratch;
+
+    protected:
+        // Reports an error if a value of value_length bytes is too short to
+        // be decrypted.
+        void checkValueLength(size_t value_length) const {
+            if (value_length < (size_t)overhead) {
+                vt_report_error(0,
+                        "Ciphertext in column '%s' is too short (%zu) expected at least %zu",
+                        column_name.c_str(),
+                        value_length,
+                        overhead);
+            }
+        }
+
+        // Decrypts value, which is at least overhead bytes long, into out as
+        // decryptValue does, reporting an error if it fails to verify.
+        // Returns the length of the plaintext and sets flags to the flags of
+        // its header.
+        size_t decryptValueOrFail(const unsigned char *value, size_t value_length,
+                const unsigned char *ad, size_t ad_length,
+                unsigned char *out, unsigned char &flags) {
+            size_t plaintext_length = 0;
+            int result;
+            {
+                AESGCMSampleStopwatch crypto(&counters);
+                result = decryptValue(value, value_length, ad, ad_length,
+                        out, plaintext_length, ad_scratch, &flags);
+            }
+            if (result != 0) {
+                counters.auth_failures++;
+                vt_report_error(0, "Failed to verify ciphertext in column '%s'", column_name.c_str());
+            }
+            return plaintext_length;
+        }
+
+        // Sets value to the value of the current row, which is not NULL. It
+        // must remain valid until the end of the block.
+        virtual void readValue(BlockReader &arg_reader,
+                const unsigned char *&value, size_t &value_length) {
+            VString nonce_and_ciphertext = arg_reader.getStringRef(0);
+            value = (unsigned char *)nonce_and_ciphertext.data();
+            value_length = nonce_and_ciphertext.length();
+        }
+
+        // Writes NULL to the current row.
+        virtual void writeNull(BlockWriter &res_writer) {
+            res_writer.getStringRef().setNull();
+        }
+
+        // Writes length bytes of plaintext, decrypted from a value with the
+        // given header flags, to the current row, decompressing it if it was
+        // compressed.
+        virtual void writePlaintext(const unsigned char *plaintext, size_t length,
+                unsigned char flags, BlockWriter &res_writer) {
+            VString &result = res_writer.getStringRef();
+            if (flags & AESGCMHeader::COMPRESSED) {
+                size_t decompressed_length = decompressedLength(plaintext, length);
+                result.alloc(decompressed_length);
+                decompress(plaintext, length, (unsigned char *)result.data(), decompressed_length);
+                length = decompressed_length;
+            } else {
+                result.alloc(length);
+                memcpy((unsigned char *)result.data(), plaintext, length);
+            }
+            counters.bytes_out += length;
+        }
+
+        // Decrypts value into the current row, reporting an error if it
+        // fails.
+        virtual void decryptRow(const unsigned char *value, size_t value_length,
+                const unsigned char *ad, size_t ad_length,
+                BlockWriter &res_writer) {
+            checkValueLength(value_length);
+
+            // Allocate for the longest interpretation of the value, then
+            // trim to the plaintext actually written.
+            VString &plaintext = res_writer.getStringRef();
+            plaintext.alloc(value_length - overhead);
+
+            unsigned char flags = 0;
+            size_t plaintext_length = decryptValueOrFail(value, value_length, ad, ad_length,
+                    (unsigned char *)plaintext.data(), flags);
+
+            if (flags & AESGCMHeader::COMPRESSED) {
+                compressed_scratch.assign((unsigned char *)plaintext.data(),
+                        (unsigned char *)plaintext.data() + plaintext_length);
+                writePlaintext(&compressed_scratch[0], plaintext_length, flags, res_writer);
+                return;
+            }
+
+            plaintext.alloc(plaintext_length);
+            counters.bytes_out += plaintext_length;
+        }
+
+    private:
+        // Queues value for batched decryption. Returns false if the value is
+        // not eligible, in which case it must be decrypted with decryptRow.
+        bool queue(const unsigned char *value, size_t value_length,
+                const unsigned char *ad, size_t ad_length,
+                BlockWriter &res_writer) {
+            AESGCMHeader header;
+            size_t header_length = header.decode(value, value_length);
+            const AESGCMKey *key = header_length > 0 ? findKey(header) : keyring->legacyKey();
+            if (key == NULL || (header.flags & AESGCMHeader::ALGORITHM) ||
+                    value_length < header_length + overhead ||
+                    value_length - header_length - overhead > multi_buffer_length) {
+                return false;
+            }
+
+            if (batch_size > 0 && key != batch_key) {
+                flush(res_writer);
+            }
+            batch_key = key;
+
+            size_t length = value_length - header_length - overhead;
+            const unsigned char *nonce = value + header_length;
+
+            AESGCMMessage &message = batch[batch_size];
+            message.nonce = nonce;
+            message.in = nonce + crypto_aead_aes256gcm_NPUBBYTES;
+            message.length = length;
+            message.ad_prefix = value;
+            message.ad_prefix_length = header_length;
+            message.ad = ad;
+            message.ad_length = ad_length;
+            message.out = scratch[batch_size];
+            message.tag = (unsigned char *)message.in + length;
+
+            PendingRow &row = pending[pending_size++];
+            row.value = value;
+            row.value_length = value_length;
+            row.ad = ad;
+            row.ad_length = ad_length;
+            row.message = batch_size++;
+
+            if (batch_size == AESGCMMultiBuffer::max_messages || pending_size == max_pending) {
+                flush(res_writer);
+            }
+            return true;
+        }
+
+        // Queues a NULL row behind any pending rows.
+        void queueNull(BlockWriter &res_writer) {
+            PendingRow &row = pending[pending_size++];
+            row.value = NULL;
+            if (pending_size == max_pending) {
+                flush(res_writer);
+            }
+        }
+
+        // Decrypts the pending batch and writes the pending rows.
+        void flush(BlockWriter &res_writer) {
+            if (batch_size > 0) {
+                AESGCMStopwatch crypto(&counters.crypto_ns);
+                batch_key->multi_buffer.decrypt(batch, batch_size);
+            }
+
+            for (size_t i = 0; i < pending_size; i++) {
+                const PendingRow &row = pending[i];
+                if (row.value == NULL) {
+                    // Decrypting NULL returns NULL.
+                    writeNull(res_writer);
+                } else if (batch[row.message].result == 0) {
+                    const AESGCMMessage &message = batch[row.message];
+                    writePlaintext(message.out, message.length, messageFlags(message), res_writer);
+                } else {
+                    // The value may be headerless but look like it has a
+                    // header, or be encrypted with a key other than the one
+                    // tried.
+                    decryptRow(row.value, row.value_length, row.ad, row.ad_length, res_writer);
+                }
+                res_writer.next();
+            }
+
+            pending_size = 0;
+            batch_size = 0;
+        }
+
+        // DecryptRow is a row of the block to be decrypted into scratch.
+        struct DecryptRow {
+            const unsigned char *value; // NULL for a NULL row
+            size_t value_length;
+            const unsigned char *ad;
+            size_t ad_length;
+            size_t offset; // of the plaintext in plaintexts
+            size_t length; // of the plaintext, once decrypted
+            int result; // 0 once decrypted and verified
+            unsigned char flags; // of the header, once decrypted
+        };
+
+        std::vector<DecryptRow> rows;
+
+        // Plaintexts are decrypted here and copied to their rows once the
+        // whole block is decrypted, since whether a value has a header (and
+        // so the length of its plaintext) is only known after verification.
+        std::vector<unsigned char> plaintexts;
+
+        // Decrypts messages for their rows, falling back to decryptValue
+        // for those which fail to verify. They may be headerless but look
+        // like they have a header.
+        void decryptMessages(const AESGCMKey *key, AESGCMMessage *messages,
+                DecryptRow **message_rows, size_t message_count,
+                std::vector<unsigned char> &scratch) {
+            key->multi_buffer.decrypt(messages, message_count);
+            for (size_t i = 0; i < message_count; i++) {
+                DecryptRow &row = *message_rows[i];
+                if (messages[i].result == 0) {
+                    row.length = messages[i].length;
+                    row.flags = messageFlags(messages[i]);
+                    row.result = 0;
+                } else {
+                    row.result = decryptValue(row.value, row.value_length, row.ad, row.ad_length,
+                            &plaintexts[row.offset], row.length, scratch, &row.flags);
+                }
+            }
+        }
+
+        // Decrypts rows [begin, end), which may be run on any thread given
+        // its own scratch. Short values are decrypted together in batches of
+        // values using the same key, as in queue.
+        void decryptRows(size_t begin, size_t end, std::vector<unsigned char> &scratch) {
+            AESGCMMessage messages[AESGCMMultiBuffer::max_messages];
+            DecryptRow *message_rows[AESGCMMultiBuffer::max_messages];
+            size_t message_count = 0;
+            const AESGCMKey *messages_key = NULL;
+
+            for (size_t i = begin; i < end; i++) {
+                DecryptRow &row = rows[i];
+                if (row.value == NULL) {
+                    continue;
+                }
+
+                AESGCMHeader header;
+                size_t header_length = header.decode(row.value, row.value_length);
+                const AESGCMKey *key = header_length > 0 ? findKey(header) : keyring->legacyKey();
+                if (!use_multi_buffer || key == NULL || (header.flags & AESGCMHeader::ALGORITHM) ||
+                        row.value_length < header_length + overhead ||
+                        row.value_length - header_length - overhead > multi_buffer_length) {
+                    row.result = decryptValue(row.value, row.value_length, row.ad, row.ad_length,
+                            &plaintexts[row.offset], row.length, scratch, &row.flags);
+                    continue;
+                }
+
+                if (message_count > 0 && key != messages_key) {
+                    decryptMessages(messages_key, messages, message_rows, message_count, scratch);
+                    message_count = 0;
+                }
+                messages_key = key;
+
+                size_t length = row.value_length - header_length - overhead;
+                const unsigned char *nonce = row.value + header_length;
+
+                AESGCMMessage &message = messages[message_count];
+                message.nonce = nonce;
+                message.in = nonce + crypto_aead_aes256gcm_NPUBBYTES;
+                message.length = length;
+                message.ad_prefix = row.value;
+                message.ad_prefix_length = header_length;
+                message.ad = row.ad;
+                message.ad_length = row.ad_length;
+                message.out = &plaintexts[row.offset];
+                message.tag = (unsigned char *)message.in + length;
+                message_rows[message_count++] = &row;
+
+                if (message_count == AESGCMMultiBuffer::max_messages) {
+                    decryptMessages(messages_key, messages, message_rows, message_count, scratch);
+                    message_count = 0;
+                }
+            }
+
+            if (message_count > 0) {
+                decryptMessages(messages_key, messages, message_rows, message_count, scratch);
+            }
+        }
+
+        // Runs decryptRows over one of the ranges of a block on a pool
+        // thread.
+        struct RangeTask {
+            AESGCMDecrypt *self;
+            size_t total;
+            size_t count;
+        };
+
+        static void decryptRange(void *arg, size_t index) {
+            const RangeTask *task = (const RangeTask *)arg;
+            AESGCMDecrypt *self = task->self;
+            std::vector<unsigned char> scratch;
+            self->decryptRows(
+                    rangeBegin(self->rows, task->total, index, task->count),
+                    rangeBegin(self->rows, task->total, index + 1, task->count),
+                    scratch);
+        }
+
+        // Decrypts the rows of a block, of total bytes of plaintext at most,
+        // splitting them into ranges for that many threads, and writes them.
+        void decryptBlock(BlockWriter &res_writer, size_t total, size_t ranges) {
+            plaintexts.resize(total + 1);
+
+            {
+                AESGCMStopwatch crypto(&counters.crypto_ns);
+                if (ranges > 1) {
+                    RangeTask task = {this, total, ranges};
+                    AESGCMThreadPool::run(decryptRange, &task, ranges);
+                } else {
+                    decryptRows(0, rows.size(), ad_scratch);
+                }
+            }
+
+            for (size_t i = 0; i < rows.size(); i++) {
+                const DecryptRow &row = rows[i];
+                if (row.value == NULL) {
+                    // Decrypting NULL returns NULL.
+                    writeNull(res_writer);
+                } else if (row.result != 0) {
+                    counters.auth_failures++;
+                    vt_report_error(0, "Failed to verify ciphertext in column '%s'", column_name.c_str());
+                } else {
+                    writePlaintext(&plaintexts[row.offset], row.length, row.flags, res_writer);
+                }
+                res_writer.next();
+            }
+
+            rows.clear();
+        }
+
+        // Decrypts a block with THREADS_PARAM. Rows are decrypted and
+        // written once the whole block has been read.
+        void processBlockInRanges(BlockReader &arg_reader, BlockWriter &res_writer) {
+            rows.clear();
+            size_t total = 0;
+
+            do {
+                DecryptRow row = {NULL, 0, NULL, 0, total, 0, -1, 0};
+
+                counters.rows++;
+                if (arg_reader.isNull(0)) {
+                    counters.null_rows++;
+                } else {
+                    readValue(arg_reader, row.value, row.value_length);
+                    counters.bytes_in += row.value_length;
+                    checkValueLength(row.value_length);
+
+                    if (arg_reader.getNumCols() > 1 && !arg_reader.isNull(1)) {
+                        VString ad = arg_reader.getStringRef(1);
+                        if (ad.length() > 0) {
+                            row.ad = (unsigned char *)ad.data();
+                            row.ad_length = ad.length();
+                        }
+                    }
+
+                    // Room for the longest interpretation of the value.
+                    total += row.value_length - overhead;
+                }
+
+                rows.push_back(row);
+            } while (arg_reader.next());
+
+            decryptBlock(res_writer, total, parallelRanges(total));
+        }
+
     public:
+        AESGCMDecrypt(): pending_size(0), batch_size(0), batch_key(NULL) {
+            stats_name = "AESGCM_Decrypt";
+        }
+
         virtual void processBlock(ServerInterface &srvInterface,
                 BlockReader &arg_reader,
                 BlockWriter &res_writer) {
@@ -45,15 +452,38 @@ class AESGCMDecrypt: public AESGCMFunction {
                         arg_reader.getNumCols());
             }
 
+            AESGCMStopwatch process(&counters.process_ns);
+            counters.blocks++;
+
+            if (threads > 1) {
+                processBlockInRanges(arg_reader, res_writer);
+                return;
+            }
+
+            // Short values are queued and decrypted together once the batch
+            // is full. The input strings of a block remain valid for the
+            // duration of processBlock.
+            pending_size = 0;
+            batch_size = 0;
+
             do {
+                counters.rows++;
                 if (arg_reader.isNull(0)) {
-                    // Decrypting NULL returns NULL.
-                    res_writer.getStringRef().setNull();
-                    res_writer.next();
+                    counters.null_rows++;
+                    if (pending_size > 0) {
+                        queueNull(res_writer);
+                    } else {
+                        // Decrypting NULL returns NULL.
+                        writeNull(res_writer);
+                        res_writer.next();
+                    }
                     continue;
                 }
 
-                VString nonce_and_ciphertext = arg_reader.getStringRef(0);
+                const unsigned char *value = NULL;
+                size_t value_length = 0;
+                readValue(arg_reader, value, value_length);
+                counters.bytes_in += value_length;
 
                 const unsigned char *associated_data = NULL;
                 size_t associated_data_length = 0;
@@ -65,41 +495,18 @@ class AESGCMDecrypt: public AESGCMFunction {
                     }
                 }
 
-                VString &plaintext = res_writer.getStringRef();
-
-                if (nonce_and_ciphertext.length() < overhead) {
-                    vt_report_error(0,
-                            "Ciphertext in column '%s' is too short (%zu) expected at least %zu",
-                            column_name.c_str(),
-                            nonce_and_ciphertext.length(),
-                            overhead);
-                }
-
-                plaintext.alloc(nonce_and_ciphertext.length() - overhead);
-
-                long long unsigned int plaintext_length = 0;
-
-                const unsigned char *nonce = (unsigned char *)nonce_and_ciphertext.data();
-                const unsigned char *ciphertext =
-                    (unsigned char *)nonce_and_ciphertext.data() + crypto_aead_aes256gcm_NPUBBYTES;
-                size_t ciphertext_length =
-                    nonce_and_ciphertext.length() - crypto_aead_aes256gcm_NPUBBYTES;
-
-                int decrypt_res = crypto_aead_aes256gcm_decrypt_afternm(
-                        (unsigned char *)plaintext.data(), &plaintext_length,
-                        NULL, // unused, always NULL
-                        ciphertext, ciphertext_length,
-                        associated_data, associated_data_length,
-                        nonce, &crypto_ctx);
-
-                if (decrypt_res == -1) {
-                    vt_report_error(0, "Failed to verify ciphertext in column '%s'", column_name.c_str());
-                } else if (decrypt_res != 0) {
-                    vt_report_error(0, "Error encountered during decryption of column '%s'", column_name.c_str());
+                if (use_multi_buffer && queue(value, value_length,
+                            associated_data, associated_data_length, res_writer)) {
+                    continue;
                 }
 
+                flush(res_writer);
+                decryptRow(value, value_length, associated_data, associated_data_length,
+                        res_writer);
                 res_writer.next();
             } while (arg_reader.next());
+
+            flush(res_writer);
         }
 };
 
@@ -166,3 +573,371 @@ class AESGCMDecryptWithVarbinaryADFactory: public AESGCMDecryptFactory {
 };
 
 RegisterFactory(AESGCMDecryptWithVarbinaryADFactory);
+
+// AESGCMDecryptNative provides the typed decrypt functions, AESGCM_DecryptInt,
+// AESGCM_DecryptFloat, AESGCM_DecryptDate, AESGCM_DecryptTimestamp and
+// AESGCM_DecryptNumeric, which decrypt values written by the native type
+// overloads of AESGCMEncrypt (see AESGCMEncryptNative) back into their type.
+// Values are decrypted exactly as AESGCMDecrypt does, batches and threads
+// included, and only the writing of the result differs. It is an error if
+// the plaintext is not the fixed-width representation of the type (see
+// AESGCMNativeType).
+//
+// The precision and scale of a NUMERIC result are given by PRECISION_PARAM
+// and SCALE_PARAM (default 37 and 15, as for NUMERIC in SQL). It is an error
+// if a value has a different scale or a greater precision; a value of lower
+// precision, even with fewer words, is widened.
+class AESGCMDecryptNative: public AESGCMDecrypt {
+    private:
+        AESGCMNativeType type;
+
+        // Values decrypted by decryptRow are written here first, since the
+        // result is not a string.
+        std::vector<unsigned char> plaintext_scratch;
+
+    protected:
+        virtual void writeNull(BlockWriter &res_writer) {
+            type.writeNull(res_writer);
+        }
+
+        virtual void writePlaintext(const unsigned char *plaintext, size_t length,
+                unsigned char flags, BlockWriter &res_writer) {
+            if ((flags & (AESGCMHeader::COMPRESSED | AESGCMHeader::ROW)) ||
+                    !type.isPlaintext(plaintext, length)) {
+                if (type.type == AESGCMNativeType::NUMERIC) {
+                    vt_report_error(0, "Plaintext in column '%s' is not NUMERIC (length %zu)",
+                            column_name.c_str(), length);
+                }
+                vt_report_error(0,
+                        "Plaintext in column '%s' is not %s (length %zu expected %zu)",
+                        column_name.c_str(),
+                        AESGCMNativeType::name(type.type),
+                        length,
+                        type.length());
+            }
+            if (!type.write(plaintext, length, res_writer)) {
+                vt_report_error(0,
+                        "Plaintext in column '%s' does not fit NUMERIC(%d,%d); set the precision and scale it was encrypted with",
+                        column_name.c_str(),
+                        type.precision,
+                        type.scale);
+            }
+            counters.bytes_out += length;
+        }
+
+        virtual void decryptRow(const unsigned char *value, size_t value_length,
+                const unsigned char *ad, size_t ad_length,
+                BlockWriter &res_writer) {
+            checkValueLength(value_length);
+            plaintext_scratch.resize(value_length - overhead + 1);
+            unsigned char flags = 0;
+            size_t length = decryptValueOrFail(value, value_length, ad, ad_length,
+                    &plaintext_scratch[0], flags);
+            writePlaintext(&plaintext_scratch[0], length, flags, res_writer);
+        }
+
+    public:
+        explicit AESGCMDecryptNative(AESGCMNativeType::Type type): type(type) {
+            static const char *const names[] = {
+                "AESGCM_DecryptInt",
+                "AESGCM_DecryptFloat",
+                "AESGCM_DecryptDate",
+                "AESGCM_DecryptTimestamp",
+                "AESGCM_DecryptNumeric"
+            };
+            stats_name = names[type];
+        }
+
+        // Returns the result type of the function, reporting an error if
+        // PRECISION_PARAM or SCALE_PARAM is out of range.
+        static AESGCMNativeType resultType(AESGCMNativeType::Type type,
+                ServerInterface &srvInterface) {
+            if (type != AESGCMNativeType::NUMERIC) {
+                return AESGCMNativeType(type);
+            }
+
+            ParamReader paramReader = srvInterface.getParamReader();
+            vint precision = 37, scale = 15;
+            if (paramReader.containsParameter(PRECISION_PARAM)) {
+                precision = paramReader.getIntRef(PRECISION_PARAM);
+            }
+            if (paramReader.containsParameter(SCALE_PARAM)) {
+                scale = paramReader.getIntRef(SCALE_PARAM);
+            }
+            if (precision < 1 || precision > AESGCMNativeType::max_precision) {
+                vt_report_error(0, "Parameter \"" PRECISION_PARAM "\" must be between 1 and %d",
+                        AESGCMNativeType::max_precision);
+            }
+            if (scale < 0 || scale > precision) {
+                vt_report_error(0, "Parameter \"" SCALE_PARAM "\" must be between 0 and the precision");
+            }
+            return AESGCMNativeType(type, precision, scale);
+        }
+
+        virtual void setup(ServerInterface &srvInterface, const SizedColumnTypes &argTypes) {
+            AESGCMDecrypt::setup(srvInterface, argTypes);
+            type = resultType(type.type, srvInterface);
+        }
+};
+
+// Exposes a scalar function taking as input VARBINARY and producing a value
+// of native type T. See AESGCMDecryptNative.
+template <AESGCMNativeType::Type T>
+class AESGCMDecryptNativeFactory: public AESGCMFunctionFactory {
+    public:
+        AESGCMDecryptNativeFactory() {
+            // As AESGCMDecryptFactory.
+            vol = STABLE;
+        }
+
+        virtual void getParameterType(ServerInterface &srvInterface,
+                SizedColumnTypes &parameterTypes) {
+            AESGCMFunctionFactory::getParameterType(srvInterface, parameterTypes);
+            if (T != AESGCMNativeType::NUMERIC) {
+                return;
+            }
+
+            static const SizedColumnTypes::Properties precision_props(
+                    true, // Visible
+                    false, // Required
+                    false, // Can be NULL
+                    "Precision the NUMERIC values were encrypted with (default 37)." // Comment
+                );
+            parameterTypes.addInt(PRECISION_PARAM, precision_props);
+
+            static const SizedColumnTypes::Properties scale_props(
+                    true, // Visible
+                    false, // Required
+                    false, // Can be NULL
+                    "Scale the NUMERIC values were encrypted with (default 15)." // Comment
+                );
+            parameterTypes.addInt(SCALE_PARAM, scale_props);
+        }
+
+        virtual ScalarFunction *createScalarFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMDecryptNative, T);
+        }
+
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarbinary();
+            AESGCMNativeType::addType(T, returnType);
+        }
+
+        virtual void getReturnType(ServerInterface &server,
+                const SizedColumnTypes &argTypes,
+                SizedColumnTypes &returnType) {
+            AESGCMDecryptNative::resultType(T, server).addType(returnType);
+        }
+};
+
+// Exposes a scalar function taking as input VARBINARY as well as VARCHAR
+// associated data and producing a value of native type T. See
+// AESGCMDecryptNative.
+template <AESGCMNativeType::Type T>
+class AESGCMDecryptNativeWithVarcharADFactory: public AESGCMDecryptNativeFactory<T> {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarbinary();
+            argTypes.addVarchar();
+            AESGCMNativeType::addType(T, returnType);
+        }
+};
+
+// Exposes a scalar function taking as input VARBINARY as well as VARBINARY
+// associated data and producing a value of native type T. See
+// AESGCMDecryptNative.
+template <AESGCMNativeType::Type T>
+class AESGCMDecryptNativeWithVarbinaryADFactory: public AESGCMDecryptNativeFactory<T> {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarbinary();
+            argTypes.addVarbinary();
+            AESGCMNativeType::addType(T, returnType);
+        }
+};
+
+typedef AESGCMDecryptNativeFactory<AESGCMNativeType::INTEGER> AESGCMDecryptIntFactory;
+typedef AESGCMDecryptNativeWithVarcharADFactory<AESGCMNativeType::INTEGER> AESGCMDecryptIntWithVarcharADFactory;
+typedef AESGCMDecryptNativeWithVarbinaryADFactory<AESGCMNativeType::INTEGER> AESGCMDecryptIntWithVarbinaryADFactory;
+RegisterFactory(AESGCMDecryptIntFactory);
+RegisterFactory(AESGCMDecryptIntWithVarcharADFactory);
+RegisterFactory(AESGCMDecryptIntWithVarbinaryADFactory);
+
+typedef AESGCMDecryptNativeFactory<AESGCMNativeType::FLOAT> AESGCMDecryptFloatFactory;
+typedef AESGCMDecryptNativeWithVarcharADFactory<AESGCMNativeType::FLOAT> AESGCMDecryptFloatWithVarcharADFactory;
+typedef AESGCMDecryptNativeWithVarbinaryADFactory<AESGCMNativeType::FLOAT> AESGCMDecryptFloatWithVarbinaryADFactory;
+RegisterFactory(AESGCMDecryptFloatFactory);
+RegisterFactory(AESGCMDecryptFloatWithVarcharADFactory);
+RegisterFactory(AESGCMDecryptFloatWithVarbinaryADFactory);
+
+typedef AESGCMDecryptNativeFactory<AESGCMNativeType::DATE> AESGCMDecryptDateFactory;
+typedef AESGCMDecryptNativeWithVarcharADFactory<AESGCMNativeType::DATE> AESGCMDecryptDateWithVarcharADFactory;
+typedef AESGCMDecryptNativeWithVarbinaryADFactory<AESGCMNativeType::DATE> AESGCMDecryptDateWithVarbinaryADFactory;
+RegisterFactory(AESGCMDecryptDateFactory);
+RegisterFactory(AESGCMDecryptDateWithVarcharADFactory);
+RegisterFactory(AESGCMDecryptDateWithVarbinaryADFactory);
+
+typedef AESGCMDecryptNativeFactory<AESGCMNativeType::TIMESTAMP> AESGCMDecryptTimestampFactory;
+typedef AESGCMDecryptNativeWithVarcharADFactory<AESGCMNativeType::TIMESTAMP> AESGCMDecryptTimestampWithVarcharADFactory;
+typedef AESGCMDecryptNativeWithVarbinaryADFactory<AESGCMNativeType::TIMESTAMP> AESGCMDecryptTimestampWithVarbinaryADFactory;
+RegisterFactory(AESGCMDecryptTimestampFactory);
+RegisterFactory(AESGCMDecryptTimestampWithVarcharADFactory);
+RegisterFactory(AESGCMDecryptTimestampWithVarbinaryADFactory);
+
+typedef AESGCMDecryptNativeFactory<AESGCMNativeType::NUMERIC> AESGCMDecryptNumericFactory;
+typedef AESGCMDecryptNativeWithVarcharADFactory<AESGCMNativeType::NUMERIC> AESGCMDecryptNumericWithVarcharADFactory;
+typedef AESGCMDecryptNativeWithVarbinaryADFactory<AESGCMNativeType::NUMERIC> AESGCMDecryptNumericWithVarbinaryADFactory;
+RegisterFactory(AESGCMDecryptNumericFactory);
+RegisterFactory(AESGCMDecryptNumericWithVarcharADFactory);
+RegisterFactory(AESGCMDecryptNumericWithVarbinaryADFactory);
+
+// AESGCMDecryptEncoded provides AESGCM_DecryptBase64 and AESGCM_DecryptHex,
+// the counterparts to AESGCMEncryptEncoded, which take a value as Base64 or
+// hexadecimal text (see AESGCMEncoding) in a VARCHAR and decrypt it as
+// AESGCMDecrypt does. Each value is decoded as its row is read, into chunks
+// which are kept for the block since batched rows are decrypted later. It is
+// an error if the text is not valid.
+class AESGCMDecryptEncoded: public AESGCMDecrypt {
+    private:
+        AESGCMEncoding::Type encoding;
+
+        // Decoded values are not moved once written, so a chunk is only
+        // grown while it is empty.
+        static const size_t chunk_size = 256 * 1024;
+
+        std::vector<std::vector<unsigned char> > chunks;
+        size_t chunk;
+        size_t chunk_used;
+
+        // Returns room for length bytes which remains valid until the end of
+        // the block.
+        unsigned char *allocate(size_t length) {
+            for (;;) {
+                if (chunk == chunks.size()) {
+                    chunks.push_back(std::vector<unsigned char>(chunk_size));
+                }
+                std::vector<unsigned char> &c = chunks[chunk];
+                if (chunk_used == 0 && c.size() < length) {
+                    c.resize(length);
+                }
+                if (chunk_used + length <= c.size()) {
+                    unsigned char *p = &c[chunk_used];
+                    chunk_used += length;
+                    return p;
+                }
+                chunk++;
+                chunk_used = 0;
+            }
+        }
+
+    protected:
+        virtual void readValue(BlockReader &arg_reader,
+                const unsigned char *&value, size_t &value_length) {
+            VString text = arg_reader.getStringRef(0);
+            unsigned char *out = allocate(
+                    AESGCMEncoding::maxDecodedLength(encoding, text.length()) + 1);
+            if (!AESGCMEncoding::decode(encoding, text.data(), text.length(), out, value_length)) {
+                vt_report_error(0, "Ciphertext in column '%s' is not valid %s",
+                        column_name.c_str(),
+                        encoding == AESGCMEncoding::BASE64 ? "Base64" : "hexadecimal");
+            }
+            value = out;
+        }
+
+    public:
+        explicit AESGCMDecryptEncoded(AESGCMEncoding::Type type):
+            encoding(type), chunk(0), chunk_used(0) {
+            stats_name = type == AESGCMEncoding::BASE64 ?
+                "AESGCM_DecryptBase64" : "AESGCM_DecryptHex";
+        }
+
+        virtual void processBlock(ServerInterface &srvInterface,
+                BlockReader &arg_reader,
+                BlockWriter &res_writer) {
+            chunk = 0;
+            chunk_used = 0;
+            AESGCMDecrypt::processBlock(srvInterface, arg_reader, res_writer);
+        }
+};
+
+// Exposes a scalar function taking as input VARCHAR text of encoding E and
+// producing VARCHAR. See AESGCMDecryptEncoded.
+template <AESGCMEncoding::Type E>
+class AESGCMDecryptEncodedFactory: public AESGCMFunctionFactory {
+    public:
+        AESGCMDecryptEncodedFactory() {
+            // As AESGCMDecryptFactory.
+            vol = STABLE;
+        }
+
+        virtual ScalarFunction *createScalarFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMDecryptEncoded, E);
+        }
+
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarchar();
+            returnType.addVarchar();
+        }
+
+        virtual void getReturnType(ServerInterface &server,
+                const SizedColumnTypes &argTypes,
+                SizedColumnTypes &returnType) {
+            const VerticaType &t = argTypes.getColumnType(0);
+            int length = AESGCMEncoding::maxDecodedLength(E, t.getStringLength()) -
+                AESGCMDecryptEncoded::overhead;
+            // Length of a string in a return type must be greater than zero.
+            returnType.addVarchar(length > 0 ? length : 1);
+        }
+};
+
+// Exposes a scalar function taking as input VARCHAR text of encoding E as
+// well as VARCHAR associated data and producing VARCHAR. See
+// AESGCMDecryptEncoded.
+template <AESGCMEncoding::Type E>
+class AESGCMDecryptEncodedWithVarcharADFactory: public AESGCMDecryptEncodedFactory<E> {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarchar();
+            argTypes.addVarchar();
+            returnType.addVarchar();
+        }
+};
+
+// Exposes a scalar function taking as input VARCHAR text of encoding E as
+// well as VARBINARY associated data and producing VARCHAR. See
+// AESGCMDecryptEncoded.
+template <AESGCMEncoding::Type E>
+class AESGCMDecryptEncodedWithVarbinaryADFactory: public AESGCMDecryptEncodedFactory<E> {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarchar();
+            argTypes.addVarbinary();
+            returnType.addVarchar();
+        }
+};
+
+typedef AESGCMDecryptEncodedFactory<AESGCMEncoding::BASE64> AESGCMDecryptBase64Factory;
+typedef AESGCMDecryptEncodedWithVarcharADFactory<AESGCMEncoding::BASE64> AESGCMDecryptBase64WithVarcharADFactory;
+typedef AESGCMDecryptEncodedWithVarbinaryADFactory<AESGCMEncoding::BASE64> AESGCMDecryptBase64WithVarbinaryADFactory;
+RegisterFactory(AESGCMDecryptBase64Factory);
+RegisterFactory(AESGCMDecryptBase64WithVarcharADFactory);
+RegisterFactory(AESGCMDecryptBase64WithVarbinaryADFactory);
+
+typedef AESGCMDecryptEncodedFactory<AESGCMEncoding::HEX> AESGCMDecryptHexFactory;
+typedef AESGCMDecryptEncodedWithVarcharADFactory<AESGCMEncoding::HEX> AESGCMDecryptHexWithVarcharADFactory;
+typedef AESGCMDecryptEncodedWithVarbinaryADFactory<AESGCMEncoding::HEX> AESGCMDecryptHexWithVarbinaryADFactory;
+RegisterFactory(AESGCMDecryptHexFactory);
+RegisterFactory(AESGCMDecryptHexWithVarcharADFactory);
+RegisterFactory(AESGCMDecryptHexWithVarbinaryADFactory);
@@ -0,0 +1,432 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMFunction.h"
+
+#include <Vertica.h>
+#include <sodium.h>
+#include <cstring>
+#include <vector>
+
+using namespace Vertica;
+
+// AESGCMDecryptCompare provides Vertica Scalar Functions which decrypt values
+// written by AESGCMEncrypt and compare the plaintext with a second VARCHAR
+// argument, the pattern, returning BOOLEAN. They are equivalent to comparing
+// the result of AESGCMDecrypt, but the plaintext is decrypted into scratch
+// space owned by the instance rather than into a result string.
+//
+// The plaintext of a value is 28 bytes shorter than the value, or 31 bytes
+// if it has an AESGCMHeader (more if it names another AESGCMAlgorithm).
+// Values whose length rules out a match return false without being decrypted
+// (for compressed values, once the length of the plaintext has been
+// decrypted). Otherwise, as with AESGCMDecrypt, a value which fails
+// verification is an error. Short values are decrypted together in batches
+// when the CPU supports it, see AESGCMMultiBuffer.
+//
+// Subclasses define the comparison, see AESGCMDecryptEquals and
+// AESGCMDecryptStartsWith.
+class AESGCMDecryptCompare: public AESGCMFunction {
+    private:
+        // PendingRow is a row of the block waiting on a batch to be
+        // decrypted. Rows whose result is already known are queued as well
+        // so that rows are written in order once the batch is flushed.
+        struct PendingRow {
+            const unsigned char *value;
+            size_t value_length;
+            const unsigned char *ad;
+            size_t ad_length;
+            const unsigned char *pattern;
+            size_t pattern_length;
+            int message; // index into batch, or -1 if result is known
+            vbool result;
+        };
+
+        static const size_t max_pending = 4 * AESGCMMultiBuffer::max_messages;
+
+        PendingRow pending[max_pending];
+        size_t pending_size;
+
+        AESGCMMessage batch[AESGCMMultiBuffer::max_messages];
+        size_t batch_size;
+        const AESGCMKey *batch_key;
+        unsigned char scratch[AESGCMMultiBuffer::max_messages][AESGCMMultiBuffer::max_length];
+
+        // Decryption output for values which are not batched.
+        std::vector<unsigned char> plaintext_scratch;
+
+        // Decompression output for compressed values.
+        std::vector<unsigned char> decompressed_scratch;
+
+        // Compares length bytes of plaintext, decrypted from a value with
+        // the given header flags, with pattern, decompressing it first if it
+        // was compressed.
+        bool comparePlaintext(const unsigned char *plaintext, size_t length, unsigned char flags,
+                const unsigned char *pattern, size_t pattern_length) {
+            if (!(flags & AESGCMHeader::COMPRESSED)) {
+                return matches(plaintext, length, pattern, pattern_length);
+            }
+
+            size_t decompressed_length = decompressedLength(plaintext, length);
+            if (!mayMatch(decompressed_length, pattern_length)) {
+                return false;
+            }
+            decompressed_scratch.resize(decompressed_length + 1);
+            decompress(plaintext, length, &decompressed_scratch[0], decompressed_length);
+            return matches(&decompressed_scratch[0], decompressed_length, pattern, pattern_length);
+        }
+
+        // Decrypts value and compares it with pattern, reporting an error if
+        // the value fails to verify.
+        bool compareRow(const unsigned char *value, size_t value_length,
+                const unsigned char *ad, size_t ad_length,
+                const unsigned char *pattern, size_t pattern_length) {
+            size_t plaintext_length = 0;
+            unsigned char flags = 0;
+            plaintext_scratch.resize(value_length - overhead + 1);
+            if (decryptValue(value, value_length, ad, ad_length,
+                        &plaintext_scratch[0], plaintext_length, ad_scratch, &flags) != 0) {
+                vt_report_error(0, "Failed to verify ciphertext in column '%s'", column_name.c_str());
+            }
+            return comparePlaintext(&plaintext_scratch[0], plaintext_length, flags,
+                    pattern, pattern_length);
+        }
+
+        // Returns the result of a row with a non-NULL value which is at
+        // least overhead bytes long, or queues it for batched decryption.
+        void queue(const unsigned char *value, size_t value_length,
+                const unsigned char *ad, size_t ad_length,
+                const unsigned char *pattern, size_t pattern_length,
+                BlockWriter &res_writer) {
+            int message = -1;
+            vbool result = vbool_false;
+
+            AESGCMHeader header;
+            size_t header_length = header.decode(value, value_length);
+            const AESGCMKey *key = header_length > 0 ? findKey(header) : keyring->legacyKey();
+            size_t value_overhead = AESGCMAlgorithm::overhead((AESGCMAlgorithm::Type)header.algorithm);
+            if (key == NULL || value_length < header_length + value_overhead) {
+                // Only the headerless interpretation is possible.
+                key = keyring->legacyKey();
+                header_length = 0;
+                value_overhead = overhead;
+            }
+
+            // The length of a compressed plaintext is only known once it is
+            // decrypted. Only AES-GCM values are batched.
+            size_t length = value_length - header_length - value_overhead;
+            bool compressed = header_length > 0 && (header.flags & AESGCMHeader::COMPRESSED);
+            bool gcm = header_length == 0 || !(header.flags & AESGCMHeader::ALGORITHM);
+            if (use_multi_buffer && gcm && length <= multi_buffer_length &&
+                    (compressed || mayMatch(length, pattern_length))) {
+                if (batch_size > 0 && key != batch_key) {
+                    flush(res_writer);
+                }
+                batch_key = key;
+
+                const unsigned char *nonce = value + header_length;
+                AESGCMMessage &m = batch[batch_size];
+                m.nonce = nonce;
+                m.in = nonce + crypto_aead_aes256gcm_NPUBBYTES;
+                m.length = length;
+                m.ad_prefix = value;
+                m.ad_prefix_length = header_length;
+                m.ad = ad;
+                m.ad_length = ad_length;
+                m.out = scratch[batch_size];
+                m.tag = (unsigned char *)m.in + length;
+                message = batch_size++;
+            } else if (compressed || mayMatch(length, pattern_length) ||
+                    (header_length > 0 && mayMatch(value_length - overhead, pattern_length))) {
+                flush(res_writer);
+                result = compareRow(value, value_length, ad, ad_length,
+                        pattern, pattern_length) ? vbool_true : vbool_false;
+            }
+
+            queueResult(value, value_length, ad, ad_length, pattern, pattern_length,
+                    message, result, res_writer);
+        }
+
+        // Queues a row behind any pending rows.
+        void queueResult(const unsigned char *value, size_t value_length,
+                const unsigned char *ad, size_t ad_length,
+                const unsigned char *pattern, size_t pattern_length,
+                int message, vbool result,
+                BlockWriter &res_writer) {
+            PendingRow &row = pending[pending_size++];
+            row.value = value;
+            row.value_length = value_length;
+            row.ad = ad;
+            row.ad_length = ad_length;
+            row.pattern = pattern;
+            row.pattern_length = pattern_length;
+            row.message = message;
+            row.result = result;
+
+            if (batch_size == AESGCMMultiBuffer::max_messages || pending_size == max_pending) {
+                flush(res_writer);
+            }
+        }
+
+        // Decrypts the pending batch and writes the pending rows.
+        void flush(BlockWriter &res_writer) {
+            if (batch_size > 0) {
+                batch_key->multi_buffer.decrypt(batch, batch_size);
+            }
+
+            for (size_t i = 0; i < pending_size; i++) {
+                const PendingRow &row = pending[i];
+                vbool result = row.result;
+                if (row.message >= 0) {
+                    const AESGCMMessage &message = batch[row.message];
+                    if (message.result == 0) {
+                        result = comparePlaintext(message.out, message.length,
+                                messageFlags(message),
+                                row.pattern, row.pattern_length) ? vbool_true : vbool_false;
+                    } else {
+                        // The value may be headerless but look like it has
+                        // a header, or be encrypted with a key other than
+                        // the one tried.
+                        result = compareRow(row.value, row.value_length, row.ad, row.ad_length,
+                                row.pattern, row.pattern_length) ? vbool_true : vbool_false;
+                    }
+                }
+                res_writer.setBool(result);
+                res_writer.next();
+            }
+
+            pending_size = 0;
+            batch_size = 0;
+        }
+
+    protected:
+        // Returns whether a plaintext of plaintext_length bytes could match a
+        // pattern of pattern_length bytes.
+        virtual bool mayMatch(size_t plaintext_length, size_t pattern_length) const = 0;
+
+        // Returns whether plaintext matches pattern.
+        virtual bool matches(const unsigned char *plaintext, size_t plaintext_length,
+                const unsigned char *pattern, size_t pattern_length) const = 0;
+
+    public:
+        AESGCMDecryptCompare(): pending_size(0), batch_size(0), batch_key(NULL) {
+            // The pattern precedes the associated data.
+            ad_column = 2;
+        }
+
+        virtual void processBlock(ServerInterface &srvInterface,
+                BlockReader &arg_reader,
+                BlockWriter &res_writer) {
+            if (arg_reader.getNumCols() < 2 || arg_reader.getNumCols() > 3) {
+                vt_report_error(0, "Function accepts either 2 or 3 arguments, but %zu provided",
+                        arg_reader.getNumCols());
+            }
+
+            // Values are queued and decrypted together once the batch is
+            // full. The input strings of a block remain valid for the
+            // duration of processBlock.
+            pending_size = 0;
+            batch_size = 0;
+
+            do {
+                if (arg_reader.isNull(0) || arg_reader.isNull(1)) {
+                    // Comparing with NULL returns NULL.
+                    queueResult(NULL, 0, NULL, 0, NULL, 0, -1, vbool_null, res_writer);
+                    continue;
+                }
+
+                VString nonce_and_ciphertext = arg_reader.getStringRef(0);
+                const unsigned char *value = (unsigned char *)nonce_and_ciphertext.data();
+                size_t value_length = nonce_and_ciphertext.length();
+
+                if (value_length < (size_t)overhead) {
+                    vt_report_error(0,
+                            "Ciphertext in column '%s' is too short (%zu) expected at least %zu",
+                            column_name.c_str(),
+                            value_length,
+                            overhead);
+                }
+
+                VString pattern = arg_reader.getStringRef(1);
+
+                const unsigned char *associated_data = NULL;
+                size_t associated_data_length = 0;
+                if (arg_reader.getNumCols() > 2 && !arg_reader.isNull(2)) {
+                    VString ad = arg_reader.getStringRef(2);
+                    associated_data_length = ad.length();
+                    if (associated_data_length > 0) {
+                        associated_data = (unsigned char *)ad.data();
+                    }
+                }
+
+                queue(value, value_length, associated_data, associated_data_length,
+                        (const unsigned char *)pattern.data(), pattern.length(), res_writer);
+            } while (arg_reader.next());
+
+            flush(res_writer);
+        }
+};
+
+// AESGCMDecryptEquals returns whether the plaintext of a value equals the
+// pattern.
+class AESGCMDecryptEquals: public AESGCMDecryptCompare {
+    protected:
+        virtual bool mayMatch(size_t plaintext_length, size_t pattern_length) const {
+            return plaintext_length == pattern_length;
+        }
+
+        virtual bool matches(const unsigned char *plaintext, size_t plaintext_length,
+                const unsigned char *pattern, size_t pattern_length) const {
+            return plaintext_length == pattern_length &&
+                (pattern_length == 0 || memcmp(plaintext, pattern, pattern_length) == 0);
+        }
+};
+
+// AESGCMDecryptStartsWith returns whether the plaintext of a value starts
+// with the pattern.
+class AESGCMDecryptStartsWith: public AESGCMDecryptCompare {
+    protected:
+        virtual bool mayMatch(size_t plaintext_length, size_t pattern_length) const {
+            return plaintext_length >= pattern_length;
+        }
+
+        virtual bool matches(const unsigned char *plaintext, size_t plaintext_length,
+                const unsigned char *pattern, size_t pattern_length) const {
+            return plaintext_length >= pattern_length &&
+                (pattern_length == 0 || memcmp(plaintext, pattern, pattern_length) == 0);
+        }
+};
+
+// AESGCMDecryptCompareFactory provides the volatility and types common to the
+// factories of AESGCMDecryptCompare subclasses.
+class AESGCMDecryptCompareFactory: public AESGCMFunctionFactory {
+    public:
+        AESGCMDecryptCompareFactory() {
+            // For some given arguments, the results yielded are the same for
+            // the duration of the statement. For example the encryption keys
+            // could change between statements.
+            vol = STABLE;
+        }
+
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarbinary();
+            argTypes.addVarchar();
+            returnType.addBool();
+        }
+
+        virtual void getReturnType(ServerInterface &server,
+                const SizedColumnTypes &argTypes,
+                SizedColumnTypes &returnType) {
+            returnType.addBool();
+        }
+};
+
+// Exposes a scalar function taking as input VARBINARY and a VARCHAR pattern
+// and producing BOOLEAN. See AESGCMDecryptEquals.
+class AESGCMDecryptEqualsFactory: public AESGCMDecryptCompareFactory {
+    public:
+        virtual ScalarFunction *createScalarFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMDecryptEquals);
+        }
+};
+
+RegisterFactory(AESGCMDecryptEqualsFactory);
+
+// Exposes a scalar function taking as input VARBINARY, a VARCHAR pattern as
+// well as VARCHAR associated data and producing BOOLEAN. See
+// AESGCMDecryptEquals.
+class AESGCMDecryptEqualsWithVarcharADFactory: public AESGCMDecryptEqualsFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarbinary();
+            argTypes.addVarchar();
+            argTypes.addVarchar();
+            returnType.addBool();
+        }
+};
+
+RegisterFactory(AESGCMDecryptEqualsWithVarcharADFactory);
+
+// Exposes a scalar function taking as input VARBINARY, a VARCHAR pattern as
+// well as VARBINARY associated data and producing BOOLEAN. See
+// AESGCMDecryptEquals.
+class AESGCMDecryptEqualsWithVarbinaryADFactory: public AESGCMDecryptEqualsFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarbinary();
+            argTypes.addVarchar();
+            argTypes.addVarbinary();
+            returnType.addBool();
+        }
+};
+
+RegisterFactory(AESGCMDecryptEqualsWithVarbinaryADFactory);
+
+// Exposes a scalar function taking as input VARBINARY and a VARCHAR pattern
+// and producing BOOLEAN. See AESGCMDecryptStartsWith.
+class AESGCMDecryptStartsWithFactory: public AESGCMDecryptCompareFactory {
+    public:
+        virtual ScalarFunction *createScalarFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMDecryptStartsWith);
+        }
+};
+
+RegisterFactory(AESGCMDecryptStartsWithFactory);
+
+// Exposes a scalar function taking as input VARBINARY, a VARCHAR pattern as
+// well as VARCHAR associated data and producing BOOLEAN. See
+// AESGCMDecryptStartsWith.
+class AESGCMDecryptStartsWithWithVarcharADFactory: public AESGCMDecryptStartsWithFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarbinary();
+            argTypes.addVarchar();
+            argTypes.addVarchar();
+            returnType.addBool();
+        }
+};
+
+RegisterFactory(AESGCMDecryptStartsWithWithVarcharADFactory);
+
+// Exposes a scalar function taking as input VARBINARY, a VARCHAR pattern as
+// well as VARBINARY associated data and producing BOOLEAN. See
+// AESGCMDecryptStartsWith.
+class AESGCMDecryptStartsWithWithVarbinaryADFactory: public AESGCMDecryptStartsWithFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarbinary();
+            argTypes.addVarchar();
+            argTypes.addVarbinary();
+            returnType.addBool();
+        }
+};
+
+RegisterFactory(AESGCMDecryptStartsWithWithVarbinaryADFactory);
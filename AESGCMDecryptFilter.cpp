@@ -0,0 +1,154 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMFilter.h"
+
+#include <Vertica.h>
+#include <sodium.h>
+#include <cstring>
+
+using namespace Vertica;
+
+// AESGCMDecryptFilter provides a Vertica UDFilter which decrypts and verifies
+// a byte stream written by AESGCMEncryptFilter, so that encrypted files can be
+// loaded with COPY ... FILTER. The segment size and key ID are read from the
+// stream header; the key must be in the keyring given by KEY_PATH_PARAM.
+//
+// Each segment is verified before its plaintext is passed on, and an error is
+// reported for the first segment which fails verification, or if the stream
+// is truncated.
+class AESGCMDecryptFilter: public AESGCMFilter {
+    private:
+        void readHeader() {
+            AESGCMStreamHeader stream_header;
+            if (!stream_header.decode(&buffer[0])) {
+                vt_report_error(0, "Input is not a stream encrypted by AESGCM_EncryptFilter");
+            }
+            if (stream_header.segment_size < 1 || stream_header.segment_size > max_segment_size) {
+                vt_report_error(0, "Encrypted stream has unsupported segment size %u",
+                        stream_header.segment_size);
+            }
+
+            key = keyring->find(stream_header.key_id);
+            if (key == NULL) {
+                vt_report_error(0, "Encrypted stream uses key ID %d which is not in the keyring",
+                        stream_header.key_id);
+            }
+
+            memcpy(header, &buffer[0], sizeof(header));
+            memcpy(nonce, stream_header.nonce, sizeof(nonce));
+            segment_size = stream_header.segment_size;
+            buffer.resize(segment_size + crypto_aead_aes256gcm_ABYTES);
+        }
+
+        // Verifies and decrypts a segment of length bytes, including the tag.
+        void decryptSegment(const unsigned char *in, size_t length, bool last,
+                DataBuffer &output) {
+            unsigned char ad[AESGCMStreamHeader::length + 1];
+            segmentAssociatedData(last, ad);
+
+            unsigned char *out = reserve(output, length - crypto_aead_aes256gcm_ABYTES);
+            if (key->decrypt(engine,
+                        out,
+                        in, length,
+                        ad, sizeof(ad),
+                        nonce) != 0) {
+                vt_report_error(0, "Failed to verify segment %llu of encrypted stream",
+                        (unsigned long long)segment_index);
+            }
+
+            sodium_increment(nonce, crypto_aead_aes256gcm_NPUBBYTES);
+            segment_index++;
+        }
+
+    public:
+        virtual void setup(ServerInterface &srvInterface) {
+            AESGCMFilter::setup(srvInterface);
+            buffer.resize(AESGCMStreamHeader::length);
+        }
+
+        virtual StreamState process(ServerInterface &srvInterface,
+                DataBuffer &input,
+                InputState input_state,
+                DataBuffer &output) {
+            for (;;) {
+                if (!drain(output)) {
+                    return OUTPUT_NEEDED;
+                }
+                if (done) {
+                    return DONE;
+                }
+
+                if (!header_done) {
+                    if (collect(input, AESGCMStreamHeader::length)) {
+                        readHeader();
+                        buffered = 0;
+                        header_done = true;
+                        continue;
+                    }
+                    if (input_state == END_OF_FILE) {
+                        vt_report_error(0, "Encrypted stream is truncated");
+                    }
+                    return INPUT_NEEDED;
+                }
+
+                // Full length segments are never the last of a stream.
+                size_t encoded_size = segment_size + crypto_aead_aes256gcm_ABYTES;
+
+                // Decrypt whole segments straight from the input buffer.
+                if (buffered == 0 && input.size - input.offset >= encoded_size) {
+                    decryptSegment((unsigned char *)input.buf + input.offset, encoded_size,
+                            false, output);
+                    input.offset += encoded_size;
+                    continue;
+                }
+
+                if (collect(input, encoded_size)) {
+                    decryptSegment(&buffer[0], encoded_size, false, output);
+                    buffered = 0;
+                    continue;
+                }
+
+                if (input_state == END_OF_FILE) {
+                    if (buffered < crypto_aead_aes256gcm_ABYTES) {
+                        vt_report_error(0, "Encrypted stream is truncated");
+                    }
+                    decryptSegment(&buffer[0], buffered, true, output);
+                    buffered = 0;
+                    done = true;
+                    continue;
+                }
+
+                return INPUT_NEEDED;
+            }
+        }
+};
+
+// Exposes AESGCMDecryptFilter, e.g. for COPY ... FILTER.
+class AESGCMDecryptFilterFactory: public AESGCMFilterFactory {
+    public:
+        virtual UDFilter *prepare(ServerInterface &srvInterface,
+                PlanContext &planCtxt) {
+            return vt_createFuncObj(srvInterface.allocator, AESGCMDecryptFilter);
+        }
+};
+
+RegisterFactory(AESGCMDecryptFilterFactory);
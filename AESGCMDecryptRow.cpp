@@ -0,0 +1,386 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMFunction.h"
+#include "AESGCMKeyCache.h"
+#include "AESGCMRowFormat.h"
+#include "AESGCMStats.h"
+
+#include <Vertica.h>
+#include <sodium.h>
+
+#include <cctype>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace Vertica;
+
+// AESGCMDecryptRow provides a Vertica transform function which decrypts
+// values written by AESGCMEncryptRow and returns the packed columns, one
+// output row per input row:
+//
+//   SELECT AESGCM_DecryptRow(pii USING PARAMETERS key='/path/to/key.hex',
+//           columns='name VARCHAR(100), ssn VARCHAR(11), age INTEGER')
+//       OVER (PARTITION AUTO) FROM customers;
+//
+// COLUMNS_PARAM declares the packed fields in order, each as a name and one
+// of VARCHAR(n), VARBINARY(n), INTEGER, FLOAT or BOOLEAN, which must match
+// the type the field was packed as (a VARCHAR or VARBINARY field may be
+// declared as either). A field declared as - is skipped, and fields after the
+// last one declared are ignored, so a subset of the columns can be returned.
+//
+// It is an error if a value fails to verify, was not written by
+// AESGCMEncryptRow, or has a field which does not fit its declared type. A
+// NULL value returns a row of NULLs.
+class AESGCMDecryptRow: public TransformFunction {
+    public:
+        // Column is an output column declared by COLUMNS_PARAM.
+        struct Column {
+            std::string name;
+            AESGCMRowFormat::Type type;
+            bool binary; // VARBINARY rather than VARCHAR
+            size_t length; // of a VARCHAR or VARBINARY
+            size_t field; // index of the packed field
+        };
+
+        // Parses COLUMNS_PARAM into columns, reporting an error if it is
+        // missing or malformed.
+        static void parseColumns(ServerInterface &srvInterface, std::vector<Column> &columns) {
+            ParamReader paramReader = srvInterface.getParamReader();
+            if (!paramReader.containsParameter(COLUMNS_PARAM)) {
+                vt_report_error(0, "Required parameter \"" COLUMNS_PARAM "\" missing");
+            }
+            std::string spec = paramReader.getStringRef(COLUMNS_PARAM).str();
+
+            columns.clear();
+            size_t field = 0;
+            for (size_t begin = 0; begin <= spec.size(); field++) {
+                size_t end = spec.find(',', begin);
+                if (end == std::string::npos) {
+                    end = spec.size();
+                }
+                std::string entry = trim(spec.substr(begin, end - begin));
+                begin = end + 1;
+
+                if (entry == "-") {
+                    continue;
+                }
+
+                Column column;
+                column.field = field;
+                column.binary = false;
+                column.length = 0;
+                size_t space = entry.find_first_of(" \t");
+                if (space == std::string::npos || !parseType(trim(entry.substr(space)), column)) {
+                    vt_report_error(0,
+                            "Parameter \"" COLUMNS_PARAM "\" field %zu must be - or a name and one of VARCHAR(n), VARBINARY(n), INTEGER, FLOAT or BOOLEAN",
+                            field + 1);
+                }
+                column.name = entry.substr(0, space);
+                columns.push_back(column);
+            }
+
+            if (columns.empty()) {
+                vt_report_error(0, "Parameter \"" COLUMNS_PARAM "\" must declare at least 1 column");
+            }
+        }
+
+    private:
+        const AESGCMKeyring *keyring;
+        std::string key_path;
+        AESGCMEngine::Type engine;
+        AESGCMCounters counters;
+
+        std::vector<Column> columns;
+
+        // The number of packed fields a value must have.
+        size_t min_fields;
+
+        std::vector<unsigned char> plaintext_scratch;
+        std::vector<unsigned char> ad_scratch;
+
+        static std::string trim(const std::string &s) {
+            size_t begin = s.find_first_not_of(" \t\n");
+            if (begin == std::string::npos) {
+                return "";
+            }
+            return s.substr(begin, s.find_last_not_of(" \t\n") - begin + 1);
+        }
+
+        // Sets the type of column from a type name, returning false if it is
+        // not one of the supported types.
+        static bool parseType(const std::string &name, Column &column) {
+            std::string type;
+            for (size_t i = 0; i < name.size(); i++) {
+                if (!isspace((unsigned char)name[i])) {
+                    type += toupper((unsigned char)name[i]);
+                }
+            }
+
+            if (type == "INTEGER" || type == "INT") {
+                column.type = AESGCMRowFormat::INTEGER;
+                return true;
+            }
+            if (type == "FLOAT") {
+                column.type = AESGCMRowFormat::FLOAT;
+                return true;
+            }
+            if (type == "BOOLEAN") {
+                column.type = AESGCMRowFormat::BOOLEAN;
+                return true;
+            }
+
+            size_t paren = type.find('(');
+            if (paren == std::string::npos || type[type.size() - 1] != ')') {
+                return false;
+            }
+            std::string base = type.substr(0, paren);
+            if (base != "VARCHAR" && base != "VARBINARY") {
+                return false;
+            }
+            std::string digits = type.substr(paren + 1, type.size() - paren - 2);
+            char *end = NULL;
+            long length = strtol(digits.c_str(), &end, 10);
+            if (digits.empty() || *end != '\0' || length < 1 || length > VERTICA_VARCHAR_MAX) {
+                return false;
+            }
+            column.type = AESGCMRowFormat::STRING;
+            column.binary = base == "VARBINARY";
+            column.length = length;
+            return true;
+        }
+
+        static void writeNull(PartitionWriter &output_writer, size_t i, const Column &column) {
+            switch (column.type) {
+                case AESGCMRowFormat::STRING:
+                    output_writer.getStringRef(i).setNull();
+                    break;
+                case AESGCMRowFormat::INTEGER:
+                    output_writer.setInt(i, vint_null);
+                    break;
+                case AESGCMRowFormat::FLOAT:
+                    output_writer.setFloat(i, vfloat_null);
+                    break;
+                case AESGCMRowFormat::BOOLEAN:
+                    output_writer.setBool(i, vbool_null);
+                    break;
+            }
+        }
+
+        // Writes the packed fields of a row of plaintext to the output
+        // columns, reporting an error if they do not match.
+        void writeRow(const unsigned char *plaintext, size_t length,
+                PartitionWriter &output_writer) {
+            AESGCMRowFormat::Reader reader(plaintext, length);
+            size_t fields = 0;
+            if (!reader.count(fields)) {
+                vt_report_error(0, "Failed to unpack row");
+            }
+            if (fields < min_fields) {
+                vt_report_error(0, "Row has %zu fields, expected at least %zu",
+                        fields, min_fields);
+            }
+
+            AESGCMRowFormat::Field field;
+            size_t next_field = 0;
+            for (size_t i = 0; i < columns.size(); i++) {
+                const Column &column = columns[i];
+                while (next_field <= column.field) {
+                    if (!reader.next(field)) {
+                        vt_report_error(0, "Failed to unpack row");
+                    }
+                    next_field++;
+                }
+
+                if (field.type != column.type) {
+                    vt_report_error(0, "Field %zu of the row does not have the type declared for '%s'",
+                            column.field + 1, column.name.c_str());
+                }
+                if (field.is_null) {
+                    writeNull(output_writer, i, column);
+                    continue;
+                }
+
+                switch (column.type) {
+                    case AESGCMRowFormat::STRING:
+                        if (field.length > column.length) {
+                            vt_report_error(0,
+                                    "Field %zu of the row is too long (%zu) for '%s', expected at most %zu",
+                                    column.field + 1, field.length, column.name.c_str(),
+                                    column.length);
+                        }
+                        output_writer.getStringRef(i).copy((const char *)field.data, field.length);
+                        break;
+                    case AESGCMRowFormat::INTEGER:
+                        output_writer.setInt(i, field.integer);
+                        break;
+                    case AESGCMRowFormat::FLOAT:
+                        output_writer.setFloat(i, field.real);
+                        break;
+                    case AESGCMRowFormat::BOOLEAN:
+                        output_writer.setBool(i, field.integer ? vbool_true : vbool_false);
+                        break;
+                }
+            }
+        }
+
+    public:
+        AESGCMDecryptRow(): keyring(NULL), engine(AESGCMEngine::BITSLICED), min_fields(0) {}
+
+        virtual void setup(ServerInterface &srvInterface, const SizedColumnTypes &argTypes) {
+            keyring = AESGCMFunction::acquireKeyring(srvInterface);
+            key_path = srvInterface.getParamReader().getStringRef(KEY_PATH_PARAM).str();
+            engine = AESGCMFunction::selectEngine(srvInterface);
+            parseColumns(srvInterface, columns);
+            min_fields = columns.back().field + 1;
+        }
+
+        virtual void destroy(ServerInterface &srvInterface, const SizedColumnTypes &argTypes) {
+            if (counters.blocks > 0) {
+                AESGCMStats::record("AESGCM_DecryptRow", key_path, counters);
+            }
+            AESGCMKeyCache::release(keyring);
+            keyring = NULL;
+        }
+
+        virtual void processPartition(ServerInterface &srvInterface,
+                PartitionReader &input_reader,
+                PartitionWriter &output_writer) {
+            AESGCMStopwatch process(&counters.process_ns);
+            counters.blocks++;
+
+            do {
+                counters.rows++;
+                if (input_reader.isNull(0)) {
+                    counters.null_rows++;
+                    for (size_t i = 0; i < columns.size(); i++) {
+                        writeNull(output_writer, i, columns[i]);
+                    }
+                    output_writer.next();
+                    continue;
+                }
+
+                VString nonce_and_ciphertext = input_reader.getStringRef(0);
+                const unsigned char *value = (const unsigned char *)nonce_and_ciphertext.data();
+                size_t value_length = nonce_and_ciphertext.length();
+                if (value_length < (size_t)AESGCMFunction::overhead) {
+                    vt_report_error(0, "Ciphertext is too short (%zu) expected at least %zu",
+                            value_length, (size_t)AESGCMFunction::overhead);
+                }
+
+                size_t length = 0;
+                unsigned char flags = 0;
+                plaintext_scratch.resize(value_length - AESGCMFunction::overhead + 1);
+                int result;
+                {
+                    AESGCMSampleStopwatch crypto(&counters);
+                    result = AESGCMFunction::decryptValue(keyring, engine, value, value_length,
+                            NULL, 0, &plaintext_scratch[0], length, ad_scratch, &flags);
+                }
+                if (result != 0) {
+                    counters.auth_failures++;
+                    vt_report_error(0, "Failed to verify ciphertext");
+                }
+                if (!(flags & AESGCMHeader::ROW)) {
+                    vt_report_error(0, "Ciphertext was not written by AESGCM_EncryptRow");
+                }
+                counters.bytes_in += value_length;
+                counters.bytes_out += length;
+
+                writeRow(&plaintext_scratch[0], length, output_writer);
+                sodium_memzero(&plaintext_scratch[0], length);
+
+                output_writer.next();
+            } while (input_reader.next());
+        }
+};
+
+// Exposes a transform function taking as input VARBINARY and producing the
+// columns declared by COLUMNS_PARAM. See AESGCMDecryptRow.
+class AESGCMDecryptRowFactory: public TransformFunctionFactory {
+    public:
+        AESGCMDecryptRowFactory() {
+            // As AESGCMDecryptFactory, keys could change between statements.
+            vol = STABLE;
+        }
+
+        virtual TransformFunction *createTransformFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMDecryptRow);
+        }
+
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarbinary();
+            returnType.addAny();
+        }
+
+        virtual void getReturnType(ServerInterface &server,
+                const SizedColumnTypes &argTypes,
+                SizedColumnTypes &returnType) {
+            std::vector<AESGCMDecryptRow::Column> columns;
+            AESGCMDecryptRow::parseColumns(server, columns);
+            for (size_t i = 0; i < columns.size(); i++) {
+                const AESGCMDecryptRow::Column &column = columns[i];
+                switch (column.type) {
+                    case AESGCMRowFormat::STRING:
+                        if (column.binary) {
+                            returnType.addVarbinary(column.length, column.name);
+                        } else {
+                            returnType.addVarchar(column.length, column.name);
+                        }
+                        break;
+                    case AESGCMRowFormat::INTEGER:
+                        returnType.addInt(column.name);
+                        break;
+                    case AESGCMRowFormat::FLOAT:
+                        returnType.addFloat(column.name);
+                        break;
+                    case AESGCMRowFormat::BOOLEAN:
+                        returnType.addBool(column.name);
+                        break;
+                }
+            }
+        }
+
+        virtual void getParameterType(ServerInterface &srvInterface,
+                SizedColumnTypes &parameterTypes) {
+            AESGCMFunctionFactory::addKeyParameter(parameterTypes);
+            AESGCMFunctionFactory::addEngineParameter(parameterTypes);
+
+            static const SizedColumnTypes::Properties columns_props(
+                    true, // Visible
+                    true, // Required
+                    false, // Can be NULL
+                    "Declares the packed columns in order as name and type, or - to skip one." // Comment
+                );
+            parameterTypes.addVarchar(VERTICA_VARCHAR_MAX, COLUMNS_PARAM, columns_props);
+        }
+
+        virtual void getPerInstanceResources(ServerInterface &srvInterface,
+                VResources &res) {
+            // As AESGCMFunctionFactory, the key file is opened at most once.
+            res.nFileHandles += 1;
+        }
+};
+
+RegisterFactory(AESGCMDecryptRowFactory);
@@ -0,0 +1,341 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMFunction.h"
+
+#include <Vertica.h>
+#include <sodium.h>
+#include <cstring>
+
+using namespace Vertica;
+
+// AESGCMDeterministic is the base of the scalar functions for deterministic
+// encryption, AESGCMEncryptDeterministic and AESGCMDecryptDeterministic.
+// Values are encrypted with AES-256-GCM-SIV (see AESGCMSIV) under a fixed
+// nonce, so that the same plaintext and associated data always produce the
+// same ciphertext under a given key. Encrypted columns can then be joined,
+// grouped and compared for equality without decrypting them, at the cost of
+// revealing which values are equal. Nothing else about the plaintext is
+// revealed, and the ciphertext remains authenticated.
+//
+// The ciphertext is the encrypted plaintext followed by the 16 byte tag. As
+// with AESGCMEncrypt, a keyring with key IDs prefixes it with a 3 byte
+// AESGCMHeader, which is authenticated as a prefix of the associated data.
+// Since equality only holds under a single key, rotating the encryption key
+// of a keyring changes the ciphertext of every value encrypted afterwards.
+class AESGCMDeterministic: public AESGCMFunction {
+    public:
+        // The number of bytes added to the length of the plaintext, excluding
+        // any header.
+        static const size_t overhead = AESGCMSIV::tag_length;
+
+        virtual void setup(ServerInterface &srvInterface, const SizedColumnTypes &argTypes) {
+            AESGCMFunction::setup(srvInterface, argTypes);
+            if (!AESGCMMultiBuffer::isAvailable()) {
+                vt_report_error(0, "System support required for AES256-GCM-SIV is unavailable");
+            }
+        }
+};
+
+// Encrypts VARCHAR values deterministically, see AESGCMDeterministic.
+//
+// The result column type is always a VARBINARY(X), where given an input column
+// VARCHAR(Y), X = Y + 16, or Y + 19 with a keyring. See
+// AESGCMEncryptDeterministicFactory.
+class AESGCMEncryptDeterministic: public AESGCMDeterministic {
+    public:
+        virtual void processBlock(ServerInterface &srvInterface,
+                BlockReader &arg_reader,
+                BlockWriter &res_writer) {
+            if (arg_reader.getNumCols() < 1 || arg_reader.getNumCols() > 2) {
+                vt_report_error(0, "Function accepts either 1 or 2 arguments, but %zu provided",
+                        arg_reader.getNumCols());
+            }
+
+            const AESGCMKey *key = keyring->encryptionKey();
+            AESGCMHeader header;
+            if (keyring->hasKeyIds()) {
+                header.flags |= AESGCMHeader::KEY_ID;
+                header.key_id = keyring->encryptionKeyId();
+            }
+            unsigned char header_bytes[AESGCMHeader::max_length];
+            size_t header_length = header.encode(header_bytes);
+
+            do {
+                if (arg_reader.isNull(0)) {
+                    // Encrypting NULL returns NULL.
+                    res_writer.getStringRef().setNull();
+                    res_writer.next();
+                    continue;
+                }
+
+                VString plaintext = arg_reader.getStringRef(0);
+
+                const unsigned char *associated_data = NULL;
+                size_t associated_data_length = 0;
+                if (arg_reader.getNumCols() > 1 && !arg_reader.isNull(1)) {
+                    VString ad = arg_reader.getStringRef(1);
+                    associated_data_length = ad.length();
+                    if (associated_data_length > 0) {
+                        associated_data = (unsigned char *)ad.data();
+                    }
+                }
+
+                VString &ciphertext = res_writer.getStringRef();
+
+                ciphertext.alloc(header_length + plaintext.length() + overhead);
+
+                unsigned char *out = (unsigned char *)ciphertext.data();
+                memcpy(out, header_bytes, header_length);
+                key->deterministic.encrypt(
+                        header_bytes, header_length,
+                        associated_data, associated_data_length,
+                        (const unsigned char *)plaintext.data(), plaintext.length(),
+                        out + header_length, out + header_length + plaintext.length());
+
+                res_writer.next();
+            } while (arg_reader.next());
+        }
+};
+
+// Decrypts values encrypted by AESGCMEncryptDeterministic.
+//
+// The result column type is always a VARCHAR(X), where given an input column
+// VARBINARY(Y), X = Y - 16. See AESGCMDecryptDeterministicFactory.
+class AESGCMDecryptDeterministic: public AESGCMDeterministic {
+    private:
+        // Decrypts value into out, which must have room for value_length -
+        // overhead bytes, as decryptValue does for AESGCMEncrypt values.
+        // Returns 0 and sets out_length if the value was verified, or -1
+        // otherwise.
+        int decryptDeterministicValue(const unsigned char *value, size_t value_length,
+                const unsigned char *ad, size_t ad_length,
+                unsigned char *out, size_t &out_length) const {
+            // Try the value as having a header first, and fall back to
+            // treating it as headerless: a headerless ciphertext may look
+            // like a header.
+            AESGCMHeader header;
+            size_t header_length = header.decode(value, value_length);
+            const AESGCMKey *key = header_length > 0 ? findKey(header) : NULL;
+            if (key != NULL && value_length >= header_length + overhead) {
+                out_length = value_length - header_length - overhead;
+                if (key->deterministic.decrypt(
+                            value, header_length,
+                            ad, ad_length,
+                            value + header_length, out_length,
+                            value + header_length + out_length, out) == 0) {
+                    return 0;
+                }
+            }
+
+            out_length = value_length - overhead;
+            return keyring->legacyKey()->deterministic.decrypt(
+                    NULL, 0,
+                    ad, ad_length,
+                    value, out_length,
+                    value + out_length, out);
+        }
+
+    public:
+        virtual void processBlock(ServerInterface &srvInterface,
+                BlockReader &arg_reader,
+                BlockWriter &res_writer) {
+            if (arg_reader.getNumCols() < 1 || arg_reader.getNumCols() > 2) {
+                vt_report_error(0, "Function accepts either 1 or 2 arguments, but %zu provided",
+                        arg_reader.getNumCols());
+            }
+
+            do {
+                if (arg_reader.isNull(0)) {
+                    // Decrypting NULL returns NULL.
+                    res_writer.getStringRef().setNull();
+                    res_writer.next();
+                    continue;
+                }
+
+                VString ciphertext = arg_reader.getStringRef(0);
+                const unsigned char *value = (const unsigned char *)ciphertext.data();
+                size_t value_length = ciphertext.length();
+
+                if (value_length < overhead) {
+                    vt_report_error(0,
+                            "Ciphertext in column '%s' is too short (%zu) expected at least %zu",
+                            column_name.c_str(),
+                            value_length,
+                            overhead);
+                }
+
+                const unsigned char *associated_data = NULL;
+                size_t associated_data_length = 0;
+                if (arg_reader.getNumCols() > 1 && !arg_reader.isNull(1)) {
+                    VString ad = arg_reader.getStringRef(1);
+                    associated_data_length = ad.length();
+                    if (associated_data_length > 0) {
+                        associated_data = (unsigned char *)ad.data();
+                    }
+                }
+
+                // Allocate for the longest interpretation of the value, then
+                // trim to the plaintext actually written.
+                VString &plaintext = res_writer.getStringRef();
+                plaintext.alloc(value_length - overhead);
+
+                size_t plaintext_length = 0;
+                if (decryptDeterministicValue(value, value_length,
+                            associated_data, associated_data_length,
+                            (unsigned char *)plaintext.data(), plaintext_length) != 0) {
+                    vt_report_error(0, "Failed to verify ciphertext in column '%s'", column_name.c_str());
+                }
+
+                plaintext.alloc(plaintext_length);
+                res_writer.next();
+            } while (arg_reader.next());
+        }
+};
+
+// AESGCMDeterministicFactory provides the volatility and parameters common to
+// the deterministic functions. Only KEY_PATH_PARAM is accepted.
+class AESGCMDeterministicFactory: public AESGCMFunctionFactory {
+    public:
+        AESGCMDeterministicFactory() {
+            // The result depends only on the arguments (for a given key
+            // file), so Vertica may evaluate it once per distinct value.
+            vol = IMMUTABLE;
+        }
+
+        virtual void getParameterType(ServerInterface &srvInterface,
+                SizedColumnTypes &parameterTypes) {
+            addKeyParameter(parameterTypes);
+        }
+};
+
+// Exposes a scalar function taking as input VARCHAR and producing VARBINARY.
+// See AESGCMEncryptDeterministic.
+class AESGCMEncryptDeterministicFactory: public AESGCMDeterministicFactory {
+    public:
+        virtual ScalarFunction *createScalarFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMEncryptDeterministic);
+        }
+
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarchar();
+            returnType.addVarbinary();
+        }
+
+        virtual void getReturnType(ServerInterface &server,
+                const SizedColumnTypes &argTypes,
+                SizedColumnTypes &returnType) {
+            const VerticaType &t = argTypes.getColumnType(0);
+            returnType.addVarbinary(t.getStringLength() + AESGCMDeterministic::overhead +
+                    headerLength(server, 0));
+        }
+};
+
+RegisterFactory(AESGCMEncryptDeterministicFactory);
+
+// Exposes a scalar function taking as input VARCHAR as well as VARCHAR
+// associated data and producing VARBINARY. See AESGCMEncryptDeterministic.
+class AESGCMEncryptDeterministicWithVarcharADFactory: public AESGCMEncryptDeterministicFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarchar();
+            argTypes.addVarchar();
+            returnType.addVarbinary();
+        }
+};
+
+RegisterFactory(AESGCMEncryptDeterministicWithVarcharADFactory);
+
+// Exposes a scalar function taking as input VARCHAR as well as VARBINARY
+// associated data and producing VARBINARY. See AESGCMEncryptDeterministic.
+class AESGCMEncryptDeterministicWithVarbinaryADFactory: public AESGCMEncryptDeterministicFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarchar();
+            argTypes.addVarbinary();
+            returnType.addVarbinary();
+        }
+};
+
+RegisterFactory(AESGCMEncryptDeterministicWithVarbinaryADFactory);
+
+// Exposes a scalar function taking as input VARBINARY and producing VARCHAR.
+// See AESGCMDecryptDeterministic.
+class AESGCMDecryptDeterministicFactory: public AESGCMDeterministicFactory {
+    public:
+        virtual ScalarFunction *createScalarFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMDecryptDeterministic);
+        }
+
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarbinary();
+            returnType.addVarchar();
+        }
+
+        virtual void getReturnType(ServerInterface &server,
+                const SizedColumnTypes &argTypes,
+                SizedColumnTypes &returnType) {
+            const VerticaType &t = argTypes.getColumnType(0);
+            int length = t.getStringLength() - (int)AESGCMDeterministic::overhead;
+            // Length of a string in a return type must be greater than zero.
+            returnType.addVarchar(length > 0 ? length : 1);
+        }
+};
+
+RegisterFactory(AESGCMDecryptDeterministicFactory);
+
+// Exposes a scalar function taking as input VARBINARY as well as VARCHAR
+// associated data and producing VARCHAR. See AESGCMDecryptDeterministic.
+class AESGCMDecryptDeterministicWithVarcharADFactory: public AESGCMDecryptDeterministicFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarbinary();
+            argTypes.addVarchar();
+            returnType.addVarchar();
+        }
+};
+
+RegisterFactory(AESGCMDecryptDeterministicWithVarcharADFactory);
+
+// Exposes a scalar function taking as input VARBINARY as well as VARBINARY
+// associated data and producing VARCHAR. See AESGCMDecryptDeterministic.
+class AESGCMDecryptDeterministicWithVarbinaryADFactory: public AESGCMDecryptDeterministicFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarbinary();
+            argTypes.addVarbinary();
+            returnType.addVarchar();
+        }
+};
+
+RegisterFactory(AESGCMDecryptDeterministicWithVarbinaryADFactory);
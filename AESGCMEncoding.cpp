@@ -0,0 +1,369 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMEncoding.h"
+
+#include <cstring>
+#include <pthread.h>
+
+static const char base64_alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char hex_alphabet[] = "0123456789abcdef";
+
+// The value of each Base64 character, or 0xff if it is not one (including
+// the '=' padding).
+static unsigned char base64_values[256];
+
+// The value of each hexadecimal digit, or 0xff if it is not one.
+static unsigned char hex_values[256];
+
+static bool have_ssse3 = false;
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define SSSE3 __attribute__((target("ssse3")))
+
+static bool detectSSSE3() {
+    unsigned int eax, ebx, ecx, edx;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSSE3);
+}
+
+// Maps 16 6-bit indices to their Base64 characters: each range of the
+// alphabet is the index plus an offset, selected by a shuffle of a table
+// of offsets.
+SSSE3 static inline __m128i base64Characters(__m128i indices) {
+    const __m128i offsets = _mm_setr_epi8(
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+            '/' - 63, 'A', 0, 0);
+    // 0..51 become 0, 52..61 become 1..10, and 62 and 63 11 and 12, then
+    // 0..25 (upper case) are moved to 13.
+    __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+    return _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, range));
+}
+
+// Encodes 12 bytes of each 16 loaded from in to 16 characters.
+SSSE3 static size_t encodeBase64SSSE3(const unsigned char *in, size_t length, char *out) {
+    size_t done = 0;
+    for (; done + 16 <= length; done += 12) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + done));
+        // Each 32-bit lane gets bytes b1 b0 b2 b1 of its 3 bytes, so that
+        // each 6-bit index can be shifted into its own byte.
+        x = _mm_shuffle_epi8(x, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+        __m128i ac = _mm_mulhi_epu16(_mm_and_si128(x, _mm_set1_epi32(0x0fc0fc00)),
+                _mm_set1_epi32(0x04000040));
+        __m128i bd = _mm_mullo_epi16(_mm_and_si128(x, _mm_set1_epi32(0x003f03f0)),
+                _mm_set1_epi32(0x01000010));
+        // Loaded before the store, which may overwrite in when encoding in
+        // place.
+        _mm_storeu_si128((__m128i *)out, base64Characters(_mm_or_si128(ac, bd)));
+        out += 16;
+    }
+    return done;
+}
+
+// Decodes 16 characters at a time to 12 bytes, stopping before the last 4
+// characters (which may be padded) or at the first block which is not
+// valid. Returns the number of characters decoded.
+SSSE3 static size_t decodeBase64SSSE3(const char *in, size_t length, unsigned char *out) {
+    // A character is valid if the bits of its low and high nibbles in these
+    // tables have none in common.
+    const __m128i lo_table = _mm_setr_epi8(
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m128i hi_table = _mm_setr_epi8(
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    // The offset from each character to its value, by high nibble ('/'
+    // having its own).
+    const __m128i offsets = _mm_setr_epi8(
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+
+    size_t done = 0;
+    for (; done + 20 <= length; done += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + done));
+        __m128i hi = _mm_and_si128(_mm_srli_epi32(x, 4), nibble);
+        __m128i lo = _mm_and_si128(x, nibble);
+        __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(lo_table, lo),
+                _mm_shuffle_epi8(hi_table, hi));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, _mm_setzero_si128())) != 0xffff) {
+            break;
+        }
+        __m128i slash = _mm_cmpeq_epi8(x, _mm_set1_epi8('/'));
+        x = _mm_add_epi8(x, _mm_shuffle_epi8(offsets, _mm_add_epi8(slash, hi)));
+
+        // Pack the 6-bit values of each 4 characters into 3 bytes.
+        x = _mm_maddubs_epi16(x, _mm_set1_epi32(0x01400140));
+        x = _mm_madd_epi16(x, _mm_set1_epi32(0x00011000));
+        x = _mm_shuffle_epi8(x, _mm_setr_epi8(
+                    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        _mm_storel_epi64((__m128i *)out, x);
+        int last = _mm_cvtsi128_si32(_mm_srli_si128(x, 8));
+        memcpy(out + 8, &last, 4);
+        out += 12;
+    }
+    return done;
+}
+
+// Encodes 16 bytes at a time to 32 characters.
+SSSE3 static size_t encodeHexSSSE3(const unsigned char *in, size_t length, char *out) {
+    const __m128i digits = _mm_loadu_si128((const __m128i *)hex_alphabet);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+
+    size_t done = 0;
+    for (; done + 16 <= length; done += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + done));
+        __m128i hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(x, 4), nibble));
+        __m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(x, nibble));
+        _mm_storeu_si128((__m128i *)out, _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *)(out + 16), _mm_unpackhi_epi8(hi, lo));
+        out += 32;
+    }
+    return done;
+}
+
+// Decodes 16 characters at a time to 8 bytes, stopping at the first block
+// which is not valid. Returns the number of characters decoded.
+SSSE3 static size_t decodeHexSSSE3(const char *in, size_t length, unsigned char *out) {
+    size_t done = 0;
+    for (; done + 16 <= length; done += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + done));
+        // Digits and (either case of) letters as offsets from '0' and 'a',
+        // valid if they are at most 9 and 5.
+        __m128i digit = _mm_sub_epi8(x, _mm_set1_epi8('0'));
+        __m128i letter = _mm_sub_epi8(_mm_or_si128(x, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+        __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+        __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+        if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xffff) {
+            break;
+        }
+        __m128i values = _mm_or_si128(_mm_and_si128(is_digit, digit),
+                _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+
+        // Each pair of nibbles (high first) into a byte.
+        values = _mm_maddubs_epi16(values, _mm_set1_epi16(0x0110));
+        _mm_storel_epi64((__m128i *)out, _mm_packus_epi16(values, values));
+        out += 8;
+    }
+    return done;
+}
+
+#else
+
+static bool detectSSSE3() {
+    return false;
+}
+
+static size_t encodeBase64SSSE3(const unsigned char *in, size_t length, char *out) {
+    return 0;
+}
+
+static size_t decodeBase64SSSE3(const char *in, size_t length, unsigned char *out) {
+    return 0;
+}
+
+static size_t encodeHexSSSE3(const unsigned char *in, size_t length, char *out) {
+    return 0;
+}
+
+static size_t decodeHexSSSE3(const char *in, size_t length, unsigned char *out) {
+    return 0;
+}
+
+#endif
+
+static void initOnce() {
+    memset(base64_values, 0xff, sizeof(base64_values));
+    for (unsigned char i = 0; i < 64; i++) {
+        base64_values[(unsigned char)base64_alphabet[i]] = i;
+    }
+    memset(hex_values, 0xff, sizeof(hex_values));
+    for (unsigned char i = 0; i < 16; i++) {
+        hex_values[(unsigned char)hex_alphabet[i]] = i;
+    }
+    for (unsigned char i = 10; i < 16; i++) {
+        hex_values[(unsigned char)('A' + i - 10)] = i;
+    }
+    have_ssse3 = detectSSSE3();
+}
+
+// Encodes groups of 3 bytes to 4 characters, the last padded with '='.
+// Each group is read before it is written, so in may be the tail of out.
+static void encodeBase64(const unsigned char *in, size_t length, char *out) {
+    size_t i = 0;
+    for (; i + 3 <= length; i += 3) {
+        unsigned int group = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+        *out++ = base64_alphabet[group >> 18];
+        *out++ = base64_alphabet[(group >> 12) & 0x3f];
+        *out++ = base64_alphabet[(group >> 6) & 0x3f];
+        *out++ = base64_alphabet[group & 0x3f];
+    }
+    if (i < length) {
+        unsigned int group = in[i] << 16;
+        bool two = i + 1 < length;
+        if (two) {
+            group |= in[i + 1] << 8;
+        }
+        *out++ = base64_alphabet[group >> 18];
+        *out++ = base64_alphabet[(group >> 12) & 0x3f];
+        *out++ = two ? base64_alphabet[(group >> 6) & 0x3f] : '=';
+        *out++ = '=';
+    }
+}
+
+static bool decodeBase64(const char *in, size_t length, unsigned char *out, size_t &out_length) {
+    const unsigned char *text = (const unsigned char *)in;
+    unsigned char *start = out;
+    for (size_t i = 0; i < length; i += 4) {
+        unsigned int a = base64_values[text[i]];
+        unsigned int b = base64_values[text[i + 1]];
+        unsigned int c = base64_values[text[i + 2]];
+        unsigned int d = base64_values[text[i + 3]];
+        if ((a | b | c | d) <= 0x3f) {
+            unsigned int group = (a << 18) | (b << 12) | (c << 6) | d;
+            *out++ = group >> 16;
+            *out++ = group >> 8;
+            *out++ = group;
+            continue;
+        }
+
+        // Only the last group may be padded, to 1 or 2 bytes.
+        if (i + 4 != length || (a | b) > 0x3f || text[i + 3] != '=' ||
+                (c > 0x3f && text[i + 2] != '=')) {
+            return false;
+        }
+        unsigned int group = (a << 18) | (b << 12);
+        *out++ = group >> 16;
+        if (c <= 0x3f) {
+            group |= c << 6;
+            *out++ = group >> 8;
+        }
+    }
+    out_length = out - start;
+    return true;
+}
+
+// Each byte is read before its two characters are written, so in may be the
+// tail of out.
+static void encodeHex(const unsigned char *in, size_t length, char *out) {
+    for (size_t i = 0; i < length; i++) {
+        unsigned char byte = in[i];
+        *out++ = hex_alphabet[byte >> 4];
+        *out++ = hex_alphabet[byte & 0x0f];
+    }
+}
+
+static bool decodeHex(const char *in, size_t length, unsigned char *out) {
+    const unsigned char *text = (const unsigned char *)in;
+    for (size_t i = 0; i < length; i += 2) {
+        unsigned int hi = hex_values[text[i]], lo = hex_values[text[i + 1]];
+        if ((hi | lo) > 0x0f) {
+            return false;
+        }
+        *out++ = (hi << 4) | lo;
+    }
+    return true;
+}
+
+size_t AESGCMEncoding::encodedLength(Type encoding, size_t length) {
+    switch (encoding) {
+        case BASE64:
+            return (length + 2) / 3 * 4;
+        case HEX:
+            return length * 2;
+        default:
+            return length;
+    }
+}
+
+size_t AESGCMEncoding::maxDecodedLength(Type encoding, size_t length) {
+    switch (encoding) {
+        case BASE64:
+            return length / 4 * 3;
+        case HEX:
+            return length / 2;
+        default:
+            return length;
+    }
+}
+
+void AESGCMEncoding::encode(Type encoding, const unsigned char *in, size_t length,
+        char *out) {
+    pthread_once(&init_once, initOnce);
+    size_t done = 0;
+    switch (encoding) {
+        case BASE64:
+            if (have_ssse3) {
+                done = encodeBase64SSSE3(in, length, out);
+            }
+            encodeBase64(in + done, length - done, out + done / 3 * 4);
+            break;
+        case HEX:
+            if (have_ssse3) {
+                done = encodeHexSSSE3(in, length, out);
+            }
+            encodeHex(in + done, length - done, out + done * 2);
+            break;
+        default:
+            memmove(out, in, length);
+            break;
+    }
+}
+
+bool AESGCMEncoding::decode(Type encoding, const char *in, size_t length,
+        unsigned char *out, size_t &out_length) {
+    pthread_once(&init_once, initOnce);
+    size_t done = 0;
+    switch (encoding) {
+        case BASE64:
+            if (length % 4 != 0) {
+                return false;
+            }
+            if (have_ssse3) {
+                done = decodeBase64SSSE3(in, length, out);
+            }
+            if (!decodeBase64(in + done, length - done, out + done / 4 * 3, out_length)) {
+                return false;
+            }
+            out_length += done / 4 * 3;
+            return true;
+        case HEX:
+            if (length % 2 != 0) {
+                return false;
+            }
+            if (have_ssse3) {
+                done = decodeHexSSSE3(in, length, out);
+            }
+            out_length = length / 2;
+            return decodeHex(in + done, length - done, out + done / 2);
+        default:
+            memcpy(out, in, length);
+            out_length = length;
+            return true;
+    }
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef AESGCMENCODING_H_INCLUDED
+#define AESGCMENCODING_H_INCLUDED
+
+#include <stddef.h>
+
+// AESGCMEncoding converts values to and from text, for the encrypt and
+// decrypt functions which return or take their values as VARCHAR:
+//
+//   BINARY  the value as it is.
+//   BASE64  RFC 4648 Base64 with the standard alphabet and padding.
+//   HEX     lower case hexadecimal, as TO_HEX writes it (upper case is
+//           accepted when decoding).
+//
+// On x86 CPUs with SSSE3, 12 bytes are Base64 encoded (or 16 characters
+// decoded) and 16 bytes hex encoded (or 16 characters decoded) per
+// iteration, with scalar code for the tails and other CPUs.
+class AESGCMEncoding {
+    public:
+        enum Type {
+            BINARY,
+            BASE64,
+            HEX
+        };
+
+        // Returns the length of the text of a value of length bytes.
+        static size_t encodedLength(Type encoding, size_t length);
+
+        // Returns the length of the longest value the text of length
+        // characters may decode to.
+        static size_t maxDecodedLength(Type encoding, size_t length);
+
+        // Writes the text of length bytes of in to out, which has room for
+        // its encodedLength. in may be the tail of out, ending where the
+        // text does, so that a value can be encoded in place.
+        static void encode(Type encoding, const unsigned char *in, size_t length,
+                char *out);
+
+        // Decodes length characters of in to out, which has room for their
+        // maxDecodedLength, and sets out_length to the length of the value.
+        // Returns false if the text is not valid.
+        static bool decode(Type encoding, const char *in, size_t length,
+                unsigned char *out, size_t &out_length);
+};
+
+#endif /* AESGCMENCODING_H_INCLUDED */
@@ -19,10 +19,17 @@
 // THE SOFTWARE.
 
 #include "AESGCMFunction.h"
+#include "AESGCMCompression.h"
+#include "AESGCMEncoding.h"
+#include "AESGCMNativeType.h"
+#include "AESGCMNonce.h"
+#include "AESGCMRowFormat.h"
+#include "AESGCMThreadPool.h"
 
 #include <Vertica.h>
 #include <sodium.h>
 #include <cstring>
+#include <vector>
 
 using namespace Vertica;
 
@@ -30,16 +37,268 @@ using namespace Vertica;
 // stored in VARCHAR with 256-bit AES-GCM authenticated encryption with
 // associated data (AEAD). It is the counterpart to AESGCMDecrypt.
 //
-// A 96-bit (12 byte) nonce is generated at encryption time and prefixed to the
-// output ciphertext. The ciphertext is an additional 16 bytes longer than the
-// plaintext to account for the associated data tag. Thus the result ciphertext
-// is in total 28 bytes longer than the plaintext.
+// A 96-bit (12 byte) nonce is assigned at encryption time (see AESGCMNonce)
+// and prefixed to the output ciphertext. The ciphertext is an additional 16
+// bytes longer than the plaintext to account for the associated data tag.
+// Thus the result ciphertext is in total 28 bytes longer than the plaintext.
+//
+// When the key file is a keyring with key IDs (see AESGCMKeyring), the value
+// is encrypted with the newest key and prefixed with a 3 byte AESGCMHeader
+// identifying it, so the ciphertext is 31 bytes longer than the plaintext.
+//
+// With COMPRESS_PARAM set to lz4, each plaintext is compressed (see
+// AESGCMCompression) and the payload encrypted in place of the plaintext,
+// with the COMPRESSED flag set in the header, if that makes the value
+// shorter. Otherwise the value is written as it would be without it.
+//
+// With THREADS_PARAM, large blocks are split into ranges of rows which are
+// encrypted on AESGCMThreadPool threads. Nonces are still assigned in row
+// order, so each row has its own.
+//
+// With ALGORITHM_PARAM set to aegis256 or xchacha20poly1305 (see
+// AESGCMAlgorithm), values are encrypted with that algorithm instead and the
+// header names it. Its longer nonce is the 96-bit AESGCMNonce followed by
+// random bytes drawn once per instance. Such values are never batched.
 //
 // The result column type is always a VARBINARY(X), where given an input column
-// VARCHAR(Y), X = Y + 28. See AESGCMEncryptFactory.
+// VARCHAR(Y), X = Y + 28 plus room for any header the key file and parameters
+// call for (more with ALGORITHM_PARAM). See AESGCMEncryptFactory.
 class AESGCMEncrypt: public AESGCMFunction
 {
+    protected:
+        // EncryptRow is a row whose output has been allocated, and its header
+        // and nonce written, but which is yet to be encrypted. A compressed
+        // plaintext is stored in place of the ciphertext.
+        struct EncryptRow {
+            const unsigned char *plaintext;
+            size_t length;
+            const unsigned char *ad;
+            size_t ad_length;
+            unsigned char *out; // header || nonce || ciphertext || tag
+            size_t header_length;
+            size_t offset; // plaintext bytes in the block before this row
+        };
+
+        std::vector<EncryptRow> rows;
+
+        // The key values are encrypted with, set by beginBlock.
+        const AESGCMKey *key;
+
+        // Plaintexts are compressed when that makes them shorter.
+        bool compress;
+
+        // The algorithm values are encrypted with. Only AESGCMEncrypt
+        // itself accepts ALGORITHM_PARAM; its subclasses use AES256GCM.
+        AESGCMAlgorithm::Type algorithm;
+
+        // The bytes which follow the AESGCMNonce in the longer nonces of the
+        // other algorithms.
+        unsigned char nonce_suffix[AESGCMAlgorithm::max_nonce_length - crypto_aead_aes256gcm_NPUBBYTES];
+
+        // Values are encoded in place once encrypted, unless BINARY. See
+        // AESGCMEncryptEncoded.
+        AESGCMEncoding::Type encoding;
+
+        // Encodes a value of length bytes once it is encrypted. Its text
+        // ends where the value does.
+        void encodeValue(unsigned char *value, size_t length) const {
+            if (encoding != AESGCMEncoding::BINARY) {
+                AESGCMEncoding::encode(encoding, value, length,
+                        (char *)value + length - AESGCMEncoding::encodedLength(encoding, length));
+            }
+        }
+
+        // Encrypts a batch of messages with the block's key, then encodes
+        // their values while they are still in cache.
+        void encryptBatch(AESGCMMessage *batch, size_t batch_size) const {
+            key->multi_buffer.encrypt(batch, batch_size);
+            if (encoding == AESGCMEncoding::BINARY) {
+                return;
+            }
+            for (size_t i = 0; i < batch_size; i++) {
+                const AESGCMMessage &message = batch[i];
+                encodeValue((unsigned char *)message.ad_prefix, message.ad_prefix_length +
+                        crypto_aead_aes256gcm_NPUBBYTES + message.length +
+                        crypto_aead_aes256gcm_ABYTES);
+            }
+        }
+
+        // Encrypts row, or queues it in batch if it is short enough to be
+        // encrypted together with others. The batch is encrypted once full.
+        // Time spent encrypting is added to stats, unless it is NULL.
+        void encryptRow(const EncryptRow &row, AESGCMMessage *batch, size_t &batch_size,
+                std::vector<unsigned char> &scratch, AESGCMCounters *stats) const {
+            size_t header_length = row.header_length;
+            const unsigned char *nonce = row.out + header_length;
+            unsigned char *ciphertext = row.out + header_length +
+                AESGCMAlgorithm::nonceLength(algorithm);
+
+            if (use_multi_buffer && row.length <= multi_buffer_length) {
+                AESGCMMessage &message = batch[batch_size++];
+                message.nonce = nonce;
+                message.in = row.plaintext;
+                message.length = row.length;
+                message.ad_prefix = row.out;
+                message.ad_prefix_length = header_length;
+                message.ad = row.ad;
+                message.ad_length = row.ad_length;
+                message.out = ciphertext;
+                message.tag = ciphertext + row.length;
+
+                if (batch_size == AESGCMMultiBuffer::max_messages) {
+                    AESGCMStopwatch crypto(stats != NULL ? &stats->crypto_ns : NULL);
+                    encryptBatch(batch, batch_size);
+                    batch_size = 0;
+                }
+                return;
+            }
+
+            AESGCMSampleStopwatch crypto(stats);
+            key->encrypt(algorithm, engine,
+                    ciphertext,
+                    row.plaintext, row.length,
+                    prefixAssociatedData(scratch, row.out, header_length,
+                        row.ad, row.ad_length),
+                    header_length + row.ad_length,
+                    nonce);
+            encodeValue(row.out, header_length + AESGCMAlgorithm::overhead(algorithm) + row.length);
+        }
+
+        // Encrypts the queued rows [begin, end), which may be run on any
+        // thread given its own scratch.
+        void encryptRows(size_t begin, size_t end, std::vector<unsigned char> &scratch) const {
+            AESGCMMessage batch[AESGCMMultiBuffer::max_messages];
+            size_t batch_size = 0;
+
+            for (size_t i = begin; i < end; i++) {
+                encryptRow(rows[i], batch, batch_size, scratch, NULL);
+            }
+
+            if (batch_size > 0) {
+                encryptBatch(batch, batch_size);
+            }
+        }
+
+        // Runs encryptRows over one of the ranges of a block on a pool
+        // thread.
+        struct RangeTask {
+            const AESGCMEncrypt *self;
+            size_t total;
+            size_t count;
+        };
+
+        static void encryptRange(void *arg, size_t index) {
+            const RangeTask *task = (const RangeTask *)arg;
+            const AESGCMEncrypt *self = task->self;
+            std::vector<unsigned char> scratch;
+            self->encryptRows(
+                    rangeBegin(self->rows, task->total, index, task->count),
+                    rangeBegin(self->rows, task->total, index + 1, task->count),
+                    scratch);
+        }
+
+        // Selects the key for a block and writes the header of its values,
+        // with flags added, to header_bytes. Returns the length of the
+        // header.
+        size_t beginBlock(unsigned char flags,
+                unsigned char header_bytes[AESGCMHeader::max_algorithm_length]) {
+            key = keyring->encryptionKey();
+            AESGCMHeader header;
+            header.flags = flags;
+            if (keyring->hasKeyIds()) {
+                header.flags |= AESGCMHeader::KEY_ID;
+                header.key_id = keyring->encryptionKeyId();
+            }
+            if (algorithm != AESGCMAlgorithm::AES256GCM) {
+                header.flags |= AESGCMHeader::ALGORITHM;
+                header.algorithm = algorithm;
+            }
+            return header.encode(header_bytes);
+        }
+
+        // Queues a row whose output has been allocated, encrypting it right
+        // away unless the block is to be split across threads. total is the
+        // number of plaintext bytes queued so far.
+        void queueRow(const EncryptRow &row, AESGCMMessage *batch, size_t &batch_size,
+                size_t &total) {
+            if (threads > 1) {
+                rows.push_back(row);
+                total += row.length;
+            } else {
+                encryptRow(row, batch, batch_size, ad_scratch, &counters);
+            }
+        }
+
+        // Encrypts the last batch, and with threads every queued row, at the
+        // end of a block.
+        void endBlock(AESGCMMessage *batch, size_t batch_size, size_t total) {
+            AESGCMStopwatch crypto(&counters.crypto_ns);
+            if (batch_size > 0) {
+                encryptBatch(batch, batch_size);
+            }
+
+            size_t ranges = parallelRanges(total);
+            if (ranges > 1) {
+                RangeTask task = {this, total, ranges};
+                AESGCMThreadPool::run(encryptRange, &task, ranges);
+            } else {
+                encryptRows(0, rows.size(), ad_scratch);
+            }
+        }
+
     public:
+        AESGCMEncrypt(): key(NULL), compress(false), algorithm(AESGCMAlgorithm::AES256GCM),
+            encoding(AESGCMEncoding::BINARY) {
+            stats_name = "AESGCM_Encrypt";
+            memset(nonce_suffix, 0, sizeof(nonce_suffix));
+        }
+
+        // Returns the algorithm named by ALGORITHM_PARAM (AES256GCM if it is
+        // not set), reporting an error if the name is unknown or the CPU
+        // cannot run it.
+        static AESGCMAlgorithm::Type selectAlgorithm(ServerInterface &srvInterface) {
+            ParamReader paramReader = srvInterface.getParamReader();
+            if (!paramReader.containsParameter(ALGORITHM_PARAM)) {
+                return AESGCMAlgorithm::AES256GCM;
+            }
+            std::string name = paramReader.getStringRef(ALGORITHM_PARAM).str();
+            AESGCMAlgorithm::Type algorithm;
+            if (!AESGCMAlgorithm::parse(name.c_str(), algorithm)) {
+                vt_report_error(0, "Parameter \"" ALGORITHM_PARAM "\" must be one of aes256gcm, aegis256 or xchacha20poly1305");
+            }
+            sodium_init();
+            if (algorithm == AESGCMAlgorithm::AEGIS256 &&
+                    AESGCMEngine::detect() < AESGCMEngine::AESNI) {
+                vt_report_error(0, "Parameter \"" ALGORITHM_PARAM "\" aegis256 requires AES-NI");
+            }
+            return algorithm;
+        }
+
+        // Returns whether COMPRESS_PARAM is lz4, reporting an error if it is
+        // neither lz4 nor none.
+        static bool selectCompression(ServerInterface &srvInterface) {
+            ParamReader paramReader = srvInterface.getParamReader();
+            if (!paramReader.containsParameter(COMPRESS_PARAM)) {
+                return false;
+            }
+            std::string name = paramReader.getStringRef(COMPRESS_PARAM).str();
+            if (name != "lz4" && name != "none") {
+                vt_report_error(0, "Parameter \"" COMPRESS_PARAM "\" must be lz4 or none");
+            }
+            return name == "lz4";
+        }
+
+        virtual void setup(ServerInterface &srvInterface, const SizedColumnTypes &argTypes) {
+            AESGCMFunction::setup(srvInterface, argTypes);
+
+            compress = selectCompression(srvInterface);
+            algorithm = selectAlgorithm(srvInterface);
+            if (algorithm != AESGCMAlgorithm::AES256GCM) {
+                use_multi_buffer = false;
+                randombytes_buf(nonce_suffix, sizeof(nonce_suffix));
+            }
+        }
+
         virtual void processBlock(ServerInterface &srvInterface,
                 BlockReader &arg_reader,
                 BlockWriter &res_writer) {
@@ -48,13 +307,40 @@ class AESGCMEncrypt: public AESGCMFunction
                         arg_reader.getNumCols());
             }
 
-            // Generate a nonce to be reused for duration of this call. The
-            // nonce is incremented after each encrypt.
-            unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES];
-            randombytes_buf(nonce, sizeof(nonce));
+            // Reserve a nonce for each row of this call. The nonce is
+            // incremented after each encrypt, and any longer nonce ends with
+            // nonce_suffix.
+            unsigned char nonce[AESGCMAlgorithm::max_nonce_length];
+            AESGCMNonce::reserve(arg_reader.getNumRows(), nonce);
+            memcpy(nonce + crypto_aead_aes256gcm_NPUBBYTES, nonce_suffix, sizeof(nonce_suffix));
+            size_t nonce_length = AESGCMAlgorithm::nonceLength(algorithm);
+            size_t value_overhead = AESGCMAlgorithm::overhead(algorithm);
+
+            unsigned char header_bytes[AESGCMHeader::max_algorithm_length];
+            size_t header_length = beginBlock(0, header_bytes);
+
+            unsigned char compressed_header_bytes[AESGCMHeader::max_algorithm_length];
+            size_t compressed_header_length = beginBlock(AESGCMHeader::COMPRESSED,
+                    compressed_header_bytes);
+
+            AESGCMStopwatch process(&counters.process_ns);
+            counters.blocks++;
+
+            // Short values are queued and encrypted together once the batch
+            // is full. With threads, every row is instead queued and the
+            // block is encrypted once it has been read. The input and output
+            // strings of a block remain valid for the duration of
+            // processBlock, so a queued value may be encrypted after its row
+            // has been written.
+            AESGCMMessage batch[AESGCMMultiBuffer::max_messages];
+            size_t batch_size = 0;
+            rows.clear();
+            size_t total = 0;
 
             do {
+                counters.rows++;
                 if (arg_reader.isNull(0)) {
+                    counters.null_rows++;
                     // Encrypting NULL returns NULL.
                     res_writer.getStringRef().setNull();
                     res_writer.next();
@@ -75,25 +361,49 @@ class AESGCMEncrypt: public AESGCMFunction
 
                 VString &nonce_and_ciphertext = res_writer.getStringRef();
 
-                nonce_and_ciphertext.alloc(plaintext.length() + overhead);
+                const unsigned char *in = (const unsigned char *)plaintext.data();
+                size_t length = plaintext.length();
+                const unsigned char *row_header_bytes = header_bytes;
+                size_t row_header_length = header_length;
+
+                if (compress && length >= AESGCMCompression::min_length) {
+                    // Compress into the ciphertext of the compressed value, to
+                    // be encrypted in place, keeping it only if the value
+                    // ends up shorter.
+                    nonce_and_ciphertext.alloc(compressed_header_length + length + value_overhead);
+                    unsigned char *payload = (unsigned char *)nonce_and_ciphertext.data() +
+                        compressed_header_length + nonce_length;
+                    size_t payload_length = AESGCMCompression::compress(in, length, payload,
+                            header_length + length - compressed_header_length - 1);
+                    if (payload_length > 0) {
+                        in = payload;
+                        length = payload_length;
+                        row_header_bytes = compressed_header_bytes;
+                        row_header_length = compressed_header_length;
+                    }
+                }
 
-                memcpy((unsigned char *)nonce_and_ciphertext.data(), nonce, sizeof(nonce));
+                nonce_and_ciphertext.alloc(row_header_length + length + value_overhead);
+                counters.bytes_in += plaintext.length();
+                counters.bytes_out += row_header_length + length + value_overhead;
 
-                long long unsigned int ciphertext_length = 0;
-                unsigned char *ciphertext =
-                    (unsigned char *)nonce_and_ciphertext.data() + crypto_aead_aes256gcm_NPUBBYTES;
+                unsigned char *out = (unsigned char *)nonce_and_ciphertext.data();
+                memcpy(out, row_header_bytes, row_header_length);
+                memcpy(out + row_header_length, nonce, nonce_length);
 
-                crypto_aead_aes256gcm_encrypt_afternm(
-                        ciphertext, &ciphertext_length,
-                        (const unsigned char *)plaintext.data(), plaintext.length(),
-                        associated_data, associated_data_length,
-                        NULL, // unused, always NULL
-                        nonce, &crypto_ctx);
+                EncryptRow row = {
+                    in, length,
+                    associated_data, associated_data_length,
+                    out, row_header_length, total
+                };
+                queueRow(row, batch, batch_size, total);
 
                 sodium_increment(nonce, crypto_aead_aes256gcm_NPUBBYTES);
 
                 res_writer.next();
             } while (arg_reader.next());
+
+            endBlock(batch, batch_size, total);
         }
 };
 
@@ -102,6 +412,27 @@ class AESGCMEncrypt: public AESGCMFunction
 class AESGCMEncryptFactory: public AESGCMFunctionFactory
 {
     public:
+        virtual void getParameterType(ServerInterface &srvInterface,
+                SizedColumnTypes &parameterTypes) {
+            AESGCMFunctionFactory::getParameterType(srvInterface, parameterTypes);
+
+            static const SizedColumnTypes::Properties compress_props(
+                    true, // Visible
+                    false, // Required
+                    false, // Can be NULL
+                    "Set to lz4 to compress values before encryption when that makes them shorter (default none)." // Comment
+                );
+            parameterTypes.addVarchar(16, COMPRESS_PARAM, compress_props);
+
+            static const SizedColumnTypes::Properties algorithm_props(
+                    true, // Visible
+                    false, // Required
+                    false, // Can be NULL
+                    "Set to aegis256 or xchacha20poly1305 to encrypt with that algorithm instead of AES-256-GCM (default aes256gcm)." // Comment
+                );
+            parameterTypes.addVarchar(32, ALGORITHM_PARAM, algorithm_props);
+        }
+
         AESGCMEncryptFactory() {
             // For some given arguments, the results yielded are unique for
             // the duration of the statement. The nonce generated should be
@@ -124,7 +455,16 @@ class AESGCMEncryptFactory: public AESGCMFunctionFactory
                 const SizedColumnTypes &argTypes,
                 SizedColumnTypes &returnType) {
             const VerticaType &t = argTypes.getColumnType(0);
-            returnType.addVarbinary(t.getStringLength() + AESGCMEncrypt::overhead);
+            AESGCMAlgorithm::Type algorithm = AESGCMEncrypt::selectAlgorithm(server);
+            unsigned char flags = 0;
+            if (AESGCMEncrypt::selectCompression(server)) {
+                flags |= AESGCMHeader::COMPRESSED;
+            }
+            if (algorithm != AESGCMAlgorithm::AES256GCM) {
+                flags |= AESGCMHeader::ALGORITHM;
+            }
+            returnType.addVarbinary(t.getStringLength() + AESGCMAlgorithm::overhead(algorithm) +
+                    headerLength(server, flags));
         }
 };
 
@@ -159,3 +499,576 @@ class AESGCMEncryptWithVarbinaryADFactory: public AESGCMEncryptFactory {
 };
 
 RegisterFactory(AESGCMEncryptWithVarbinaryADFactory);
+
+// AESGCMEncryptRow provides a Vertica Scalar Function which packs the values
+// of any number of columns into a single plaintext (see AESGCMRowFormat) and
+// encrypts it as AESGCMEncrypt does, so that a row of several sensitive
+// columns takes one nonce, one tag and one encryption rather than one per
+// column. Its header has the ROW flag set, which AESGCMDecryptRow requires.
+// AESGCMVerify and AESGCMReencrypt handle such values as any other.
+//
+// VARCHAR, CHAR, VARBINARY, BINARY, INTEGER, FLOAT and BOOLEAN columns can be
+// packed; other types must be cast, e.g. to VARCHAR. NULL values are packed
+// as such, so a row of NULLs still encrypts to a value. There is no
+// associated data argument, since every argument is a column.
+//
+// The result column type is a VARBINARY wide enough for the longest packed
+// row, see AESGCMEncryptRowFactory.
+class AESGCMEncryptRow: public AESGCMEncrypt
+{
+    private:
+        // The field type of each argument.
+        std::vector<AESGCMRowFormat::Type> types;
+
+        size_t max_row_length;
+
+        // Packs the arguments of the current row to out, which has room for
+        // max_row_length bytes. Returns the length of the packed row.
+        size_t packRow(BlockReader &arg_reader, unsigned char *out) const {
+            AESGCMRowFormat::Writer writer(out);
+            writer.count(types.size());
+            for (size_t i = 0; i < types.size(); i++) {
+                if (arg_reader.isNull(i)) {
+                    writer.null(types[i]);
+                    continue;
+                }
+                switch (types[i]) {
+                    case AESGCMRowFormat::STRING: {
+                        VString value = arg_reader.getStringRef(i);
+                        writer.string(value.data(), value.length());
+                        break;
+                    }
+                    case AESGCMRowFormat::INTEGER:
+                        writer.integer(arg_reader.getIntRef(i));
+                        break;
+                    case AESGCMRowFormat::FLOAT:
+                        writer.real(arg_reader.getFloatRef(i));
+                        break;
+                    case AESGCMRowFormat::BOOLEAN:
+                        writer.boolean(arg_reader.getBoolRef(i) == vbool_true);
+                        break;
+                }
+            }
+            return writer.length();
+        }
+
+    public:
+        AESGCMEncryptRow(): max_row_length(0) {
+            stats_name = "AESGCM_EncryptRow";
+        }
+
+        // Returns the longest packed row of arguments of argTypes, and adds
+        // their field types to types unless it is NULL. Reports an error if
+        // there are no arguments, one cannot be packed, or the result would
+        // be longer than a VARBINARY.
+        static size_t maxRowLength(const SizedColumnTypes &argTypes,
+                std::vector<AESGCMRowFormat::Type> *types) {
+            size_t count = argTypes.getColumnCount();
+            if (count == 0) {
+                vt_report_error(0, "Function requires at least 1 argument");
+            }
+
+            size_t length = AESGCMRowFormat::varintLength(count);
+            for (size_t i = 0; i < count; i++) {
+                const VerticaType &t = argTypes.getColumnType(i);
+                AESGCMRowFormat::Type type = AESGCMRowFormat::STRING;
+                size_t string_length = 0;
+                if (t.isStringType()) {
+                    type = AESGCMRowFormat::STRING;
+                    string_length = t.getStringLength();
+                } else if (t.isInt()) {
+                    type = AESGCMRowFormat::INTEGER;
+                } else if (t.isFloat()) {
+                    type = AESGCMRowFormat::FLOAT;
+                } else if (t.isBool()) {
+                    type = AESGCMRowFormat::BOOLEAN;
+                } else {
+                    vt_report_error(0, "Argument %zu ('%s') has an unsupported type; cast it to VARCHAR",
+                            i + 1, argTypes.getColumnName(i).c_str());
+                }
+                length += AESGCMRowFormat::maxFieldLength(type, string_length);
+                if (types != NULL) {
+                    types->push_back(type);
+                }
+            }
+
+            if (length + overhead + AESGCMHeader::max_length > VERTICA_VARCHAR_MAX) {
+                vt_report_error(0, "Packed row is too long (%zu) expected at most %zu",
+                        length,
+                        (size_t)(VERTICA_VARCHAR_MAX - overhead - AESGCMHeader::max_length));
+            }
+            return length;
+        }
+
+        virtual void setup(ServerInterface &srvInterface, const SizedColumnTypes &argTypes) {
+            // Every argument is a column to pack.
+            ad_column = argTypes.getColumnCount();
+            AESGCMEncrypt::setup(srvInterface, argTypes);
+
+            types.clear();
+            max_row_length = maxRowLength(argTypes, &types);
+        }
+
+        virtual void processBlock(ServerInterface &srvInterface,
+                BlockReader &arg_reader,
+                BlockWriter &res_writer) {
+            if (arg_reader.getNumCols() != types.size()) {
+                vt_report_error(0, "Function accepts %zu arguments, but %zu provided",
+                        types.size(), arg_reader.getNumCols());
+            }
+
+            unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES];
+            AESGCMNonce::reserve(arg_reader.getNumRows(), nonce);
+
+            unsigned char header_bytes[AESGCMHeader::max_length];
+            size_t header_length = beginBlock(AESGCMHeader::ROW, header_bytes);
+
+            AESGCMStopwatch process(&counters.process_ns);
+            counters.blocks++;
+
+            AESGCMMessage batch[AESGCMMultiBuffer::max_messages];
+            size_t batch_size = 0;
+            rows.clear();
+            size_t total = 0;
+
+            do {
+                counters.rows++;
+
+                // Pack into the ciphertext of the value, to be encrypted in
+                // place, then trim the value to the packed length.
+                VString &nonce_and_ciphertext = res_writer.getStringRef();
+                nonce_and_ciphertext.alloc(header_length + max_row_length + overhead);
+                unsigned char *out = (unsigned char *)nonce_and_ciphertext.data();
+                unsigned char *packed = out + header_length + crypto_aead_aes256gcm_NPUBBYTES;
+                size_t length = packRow(arg_reader, packed);
+
+                nonce_and_ciphertext.alloc(header_length + length + overhead);
+                counters.bytes_in += length;
+                counters.bytes_out += header_length + length + overhead;
+
+                memcpy(out, header_bytes, header_length);
+                memcpy(out + header_length, nonce, sizeof(nonce));
+
+                EncryptRow row = {
+                    packed, length,
+                    NULL, 0,
+                    out, header_length, total
+                };
+                queueRow(row, batch, batch_size, total);
+
+                sodium_increment(nonce, crypto_aead_aes256gcm_NPUBBYTES);
+
+                res_writer.next();
+            } while (arg_reader.next());
+
+            endBlock(batch, batch_size, total);
+        }
+};
+
+// Exposes a scalar function taking any number of arguments of the types
+// AESGCMEncryptRow can pack and producing VARBINARY. See AESGCMEncryptRow.
+class AESGCMEncryptRowFactory: public AESGCMFunctionFactory
+{
+    public:
+        AESGCMEncryptRowFactory() {
+            // As AESGCMEncryptFactory, a fresh nonce is generated for each
+            // row.
+            vol = VOLATILE;
+        }
+
+        virtual ScalarFunction *createScalarFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMEncryptRow);
+        }
+
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addAny();
+            returnType.addVarbinary();
+        }
+
+        virtual void getReturnType(ServerInterface &server,
+                const SizedColumnTypes &argTypes,
+                SizedColumnTypes &returnType) {
+            returnType.addVarbinary(AESGCMEncryptRow::maxRowLength(argTypes, NULL) +
+                    AESGCMEncryptRow::overhead + headerLength(server, AESGCMHeader::ROW));
+        }
+};
+
+RegisterFactory(AESGCMEncryptRowFactory);
+
+// AESGCMEncryptNative provides the overloads of AESGCMEncrypt for INTEGER,
+// FLOAT, DATE, TIMESTAMP and NUMERIC values. The fixed-width binary
+// representation of the value (see AESGCMNativeType) is encrypted as a
+// VARCHAR plaintext would be, rather than its text, so the ciphertext is as
+// short as it can be and no formatting or parsing is done per row. Values
+// are written to the output and encrypted in place.
+//
+// Such values are decrypted by the typed decrypt functions, see
+// AESGCMDecryptNative; AESGCMVerify and AESGCMReencrypt handle them as any
+// other.
+class AESGCMEncryptNative: public AESGCMEncrypt
+{
+    private:
+        AESGCMNativeType type;
+
+    public:
+        explicit AESGCMEncryptNative(AESGCMNativeType::Type type): type(type) {}
+
+        // Returns the native type of the value argument of argTypes.
+        static AESGCMNativeType argumentType(AESGCMNativeType::Type type,
+                const SizedColumnTypes &argTypes) {
+            const VerticaType &t = argTypes.getColumnType(0);
+            if (type == AESGCMNativeType::NUMERIC) {
+                return AESGCMNativeType(type, t.getNumericPrecision(), t.getNumericScale());
+            }
+            return AESGCMNativeType(type);
+        }
+
+        virtual void setup(ServerInterface &srvInterface, const SizedColumnTypes &argTypes) {
+            AESGCMEncrypt::setup(srvInterface, argTypes);
+            type = argumentType(type.type, argTypes);
+        }
+
+        virtual void processBlock(ServerInterface &srvInterface,
+                BlockReader &arg_reader,
+                BlockWriter &res_writer) {
+            if (arg_reader.getNumCols() < 1 || arg_reader.getNumCols() > 2) {
+                vt_report_error(0, "Function accepts either 1 or 2 arguments, but %zu provided",
+                        arg_reader.getNumCols());
+            }
+
+            unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES];
+            AESGCMNonce::reserve(arg_reader.getNumRows(), nonce);
+
+            unsigned char header_bytes[AESGCMHeader::max_length];
+            size_t header_length = beginBlock(0, header_bytes);
+
+            AESGCMStopwatch process(&counters.process_ns);
+            counters.blocks++;
+
+            AESGCMMessage batch[AESGCMMultiBuffer::max_messages];
+            size_t batch_size = 0;
+            rows.clear();
+            size_t total = 0;
+            size_t length = type.length();
+
+            do {
+                counters.rows++;
+                if (arg_reader.isNull(0)) {
+                    counters.null_rows++;
+                    // Encrypting NULL returns NULL.
+                    res_writer.getStringRef().setNull();
+                    res_writer.next();
+                    continue;
+                }
+
+                const unsigned char *associated_data = NULL;
+                size_t associated_data_length = 0;
+                if (arg_reader.getNumCols() > 1 && !arg_reader.isNull(1)) {
+                    VString ad = arg_reader.getStringRef(1);
+                    associated_data_length = ad.length();
+                    if (associated_data_length > 0) {
+                        associated_data = (unsigned char *)ad.data();
+                    }
+                }
+
+                // Write the value to the ciphertext, to be encrypted in
+                // place.
+                VString &nonce_and_ciphertext = res_writer.getStringRef();
+                nonce_and_ciphertext.alloc(header_length + length + overhead);
+                unsigned char *out = (unsigned char *)nonce_and_ciphertext.data();
+                unsigned char *plaintext = out + header_length + crypto_aead_aes256gcm_NPUBBYTES;
+                type.read(arg_reader, 0, plaintext);
+
+                counters.bytes_in += length;
+                counters.bytes_out += header_length + length + overhead;
+
+                memcpy(out, header_bytes, header_length);
+                memcpy(out + header_length, nonce, sizeof(nonce));
+
+                EncryptRow row = {
+                    plaintext, length,
+                    associated_data, associated_data_length,
+                    out, header_length, total
+                };
+                queueRow(row, batch, batch_size, total);
+
+                sodium_increment(nonce, crypto_aead_aes256gcm_NPUBBYTES);
+
+                res_writer.next();
+            } while (arg_reader.next());
+
+            endBlock(batch, batch_size, total);
+        }
+};
+
+// Exposes a scalar function taking as input a value of native type T and
+// producing VARBINARY. See AESGCMEncryptNative.
+template <AESGCMNativeType::Type T>
+class AESGCMEncryptNativeFactory: public AESGCMFunctionFactory
+{
+    public:
+        AESGCMEncryptNativeFactory() {
+            // As AESGCMEncryptFactory, a fresh nonce is generated for each
+            // row.
+            vol = VOLATILE;
+        }
+
+        virtual ScalarFunction *createScalarFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMEncryptNative, T);
+        }
+
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            AESGCMNativeType::addType(T, argTypes);
+            returnType.addVarbinary();
+        }
+
+        virtual void getReturnType(ServerInterface &server,
+                const SizedColumnTypes &argTypes,
+                SizedColumnTypes &returnType) {
+            returnType.addVarbinary(AESGCMEncryptNative::argumentType(T, argTypes).length() +
+                    AESGCMEncryptNative::overhead + headerLength(server, 0));
+        }
+};
+
+// Exposes a scalar function taking as input a value of native type T as well
+// as VARCHAR associated data and producing VARBINARY. See
+// AESGCMEncryptNative.
+template <AESGCMNativeType::Type T>
+class AESGCMEncryptNativeWithVarcharADFactory: public AESGCMEncryptNativeFactory<T> {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            AESGCMNativeType::addType(T, argTypes);
+            argTypes.addVarchar();
+            returnType.addVarbinary();
+        }
+};
+
+// Exposes a scalar function taking as input a value of native type T as well
+// as VARBINARY associated data and producing VARBINARY. See
+// AESGCMEncryptNative.
+template <AESGCMNativeType::Type T>
+class AESGCMEncryptNativeWithVarbinaryADFactory: public AESGCMEncryptNativeFactory<T> {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            AESGCMNativeType::addType(T, argTypes);
+            argTypes.addVarbinary();
+            returnType.addVarbinary();
+        }
+};
+
+typedef AESGCMEncryptNativeFactory<AESGCMNativeType::INTEGER> AESGCMEncryptIntFactory;
+typedef AESGCMEncryptNativeWithVarcharADFactory<AESGCMNativeType::INTEGER> AESGCMEncryptIntWithVarcharADFactory;
+typedef AESGCMEncryptNativeWithVarbinaryADFactory<AESGCMNativeType::INTEGER> AESGCMEncryptIntWithVarbinaryADFactory;
+RegisterFactory(AESGCMEncryptIntFactory);
+RegisterFactory(AESGCMEncryptIntWithVarcharADFactory);
+RegisterFactory(AESGCMEncryptIntWithVarbinaryADFactory);
+
+typedef AESGCMEncryptNativeFactory<AESGCMNativeType::FLOAT> AESGCMEncryptFloatFactory;
+typedef AESGCMEncryptNativeWithVarcharADFactory<AESGCMNativeType::FLOAT> AESGCMEncryptFloatWithVarcharADFactory;
+typedef AESGCMEncryptNativeWithVarbinaryADFactory<AESGCMNativeType::FLOAT> AESGCMEncryptFloatWithVarbinaryADFactory;
+RegisterFactory(AESGCMEncryptFloatFactory);
+RegisterFactory(AESGCMEncryptFloatWithVarcharADFactory);
+RegisterFactory(AESGCMEncryptFloatWithVarbinaryADFactory);
+
+typedef AESGCMEncryptNativeFactory<AESGCMNativeType::DATE> AESGCMEncryptDateFactory;
+typedef AESGCMEncryptNativeWithVarcharADFactory<AESGCMNativeType::DATE> AESGCMEncryptDateWithVarcharADFactory;
+typedef AESGCMEncryptNativeWithVarbinaryADFactory<AESGCMNativeType::DATE> AESGCMEncryptDateWithVarbinaryADFactory;
+RegisterFactory(AESGCMEncryptDateFactory);
+RegisterFactory(AESGCMEncryptDateWithVarcharADFactory);
+RegisterFactory(AESGCMEncryptDateWithVarbinaryADFactory);
+
+typedef AESGCMEncryptNativeFactory<AESGCMNativeType::TIMESTAMP> AESGCMEncryptTimestampFactory;
+typedef AESGCMEncryptNativeWithVarcharADFactory<AESGCMNativeType::TIMESTAMP> AESGCMEncryptTimestampWithVarcharADFactory;
+typedef AESGCMEncryptNativeWithVarbinaryADFactory<AESGCMNativeType::TIMESTAMP> AESGCMEncryptTimestampWithVarbinaryADFactory;
+RegisterFactory(AESGCMEncryptTimestampFactory);
+RegisterFactory(AESGCMEncryptTimestampWithVarcharADFactory);
+RegisterFactory(AESGCMEncryptTimestampWithVarbinaryADFactory);
+
+typedef AESGCMEncryptNativeFactory<AESGCMNativeType::NUMERIC> AESGCMEncryptNumericFactory;
+typedef AESGCMEncryptNativeWithVarcharADFactory<AESGCMNativeType::NUMERIC> AESGCMEncryptNumericWithVarcharADFactory;
+typedef AESGCMEncryptNativeWithVarbinaryADFactory<AESGCMNativeType::NUMERIC> AESGCMEncryptNumericWithVarbinaryADFactory;
+RegisterFactory(AESGCMEncryptNumericFactory);
+RegisterFactory(AESGCMEncryptNumericWithVarcharADFactory);
+RegisterFactory(AESGCMEncryptNumericWithVarbinaryADFactory);
+
+// AESGCMEncryptEncoded provides AESGCM_EncryptBase64 and AESGCM_EncryptHex,
+// which encrypt VARCHAR as AESGCMEncrypt does and return the value as Base64
+// or hexadecimal text (see AESGCMEncoding) in a VARCHAR, for consumers which
+// need text, without a separate encoding function in the plan. Each value is
+// written to the end of its text, encrypted there, and encoded in place right
+// after it is encrypted (as part of its batch when batched), so it is only
+// written once more and never copied. Values are not compressed.
+//
+// The text decodes to the value AESGCMEncrypt would have returned, so
+// FROM_HEX or a Base64 decoder and AESGCMDecrypt read it as well as
+// AESGCMDecryptEncoded does.
+class AESGCMEncryptEncoded: public AESGCMEncrypt
+{
+    public:
+        explicit AESGCMEncryptEncoded(AESGCMEncoding::Type type) {
+            encoding = type;
+            stats_name = type == AESGCMEncoding::BASE64 ?
+                "AESGCM_EncryptBase64" : "AESGCM_EncryptHex";
+        }
+
+        virtual void processBlock(ServerInterface &srvInterface,
+                BlockReader &arg_reader,
+                BlockWriter &res_writer) {
+            if (arg_reader.getNumCols() < 1 || arg_reader.getNumCols() > 2) {
+                vt_report_error(0, "Function accepts either 1 or 2 arguments, but %zu provided",
+                        arg_reader.getNumCols());
+            }
+
+            unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES];
+            AESGCMNonce::reserve(arg_reader.getNumRows(), nonce);
+
+            unsigned char header_bytes[AESGCMHeader::max_length];
+            size_t header_length = beginBlock(0, header_bytes);
+
+            AESGCMStopwatch process(&counters.process_ns);
+            counters.blocks++;
+
+            AESGCMMessage batch[AESGCMMultiBuffer::max_messages];
+            size_t batch_size = 0;
+            rows.clear();
+            size_t total = 0;
+
+            do {
+                counters.rows++;
+                if (arg_reader.isNull(0)) {
+                    counters.null_rows++;
+                    // Encrypting NULL returns NULL.
+                    res_writer.getStringRef().setNull();
+                    res_writer.next();
+                    continue;
+                }
+
+                VString plaintext = arg_reader.getStringRef(0);
+
+                const unsigned char *associated_data = NULL;
+                size_t associated_data_length = 0;
+                if (arg_reader.getNumCols() > 1 && !arg_reader.isNull(1)) {
+                    VString ad = arg_reader.getStringRef(1);
+                    associated_data_length = ad.length();
+                    if (associated_data_length > 0) {
+                        associated_data = (unsigned char *)ad.data();
+                    }
+                }
+
+                size_t length = plaintext.length();
+                size_t value_length = header_length + length + overhead;
+                size_t text_length = AESGCMEncoding::encodedLength(encoding, value_length);
+                if (text_length > VERTICA_VARCHAR_MAX) {
+                    vt_report_error(0, "Encoded ciphertext of column '%s' is too long (%zu) expected at most %d",
+                            column_name.c_str(), text_length, VERTICA_VARCHAR_MAX);
+                }
+
+                VString &text = res_writer.getStringRef();
+                text.alloc(text_length);
+                counters.bytes_in += length;
+                counters.bytes_out += text_length;
+
+                unsigned char *out = (unsigned char *)text.data() + text_length - value_length;
+                memcpy(out, header_bytes, header_length);
+                memcpy(out + header_length, nonce, sizeof(nonce));
+
+                EncryptRow row = {
+                    (const unsigned char *)plaintext.data(), length,
+                    associated_data, associated_data_length,
+                    out, header_length, total
+                };
+                queueRow(row, batch, batch_size, total);
+
+                sodium_increment(nonce, crypto_aead_aes256gcm_NPUBBYTES);
+
+                res_writer.next();
+            } while (arg_reader.next());
+
+            endBlock(batch, batch_size, total);
+        }
+};
+
+// Exposes a scalar function taking as input VARCHAR and producing VARCHAR
+// text of encoding E. See AESGCMEncryptEncoded.
+template <AESGCMEncoding::Type E>
+class AESGCMEncryptEncodedFactory: public AESGCMFunctionFactory
+{
+    public:
+        AESGCMEncryptEncodedFactory() {
+            // As AESGCMEncryptFactory, a fresh nonce is generated for each
+            // row.
+            vol = VOLATILE;
+        }
+
+        virtual ScalarFunction *createScalarFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMEncryptEncoded, E);
+        }
+
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarchar();
+            returnType.addVarchar();
+        }
+
+        virtual void getReturnType(ServerInterface &server,
+                const SizedColumnTypes &argTypes,
+                SizedColumnTypes &returnType) {
+            const VerticaType &t = argTypes.getColumnType(0);
+            size_t length = AESGCMEncoding::encodedLength(E, t.getStringLength() +
+                    AESGCMEncryptEncoded::overhead + headerLength(server, 0));
+            returnType.addVarchar(length < VERTICA_VARCHAR_MAX ? length : VERTICA_VARCHAR_MAX);
+        }
+};
+
+// Exposes a scalar function taking as input VARCHAR as well as VARCHAR
+// associated data and producing VARCHAR text of encoding E. See
+// AESGCMEncryptEncoded.
+template <AESGCMEncoding::Type E>
+class AESGCMEncryptEncodedWithVarcharADFactory: public AESGCMEncryptEncodedFactory<E> {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarchar();
+            argTypes.addVarchar();
+            returnType.addVarchar();
+        }
+};
+
+// Exposes a scalar function taking as input VARCHAR as well as VARBINARY
+// associated data and producing VARCHAR text of encoding E. See
+// AESGCMEncryptEncoded.
+template <AESGCMEncoding::Type E>
+class AESGCMEncryptEncodedWithVarbinaryADFactory: public AESGCMEncryptEncodedFactory<E> {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarchar();
+            argTypes.addVarbinary();
+            returnType.addVarchar();
+        }
+};
+
+typedef AESGCMEncryptEncodedFactory<AESGCMEncoding::BASE64> AESGCMEncryptBase64Factory;
+typedef AESGCMEncryptEncodedWithVarcharADFactory<AESGCMEncoding::BASE64> AESGCMEncryptBase64WithVarcharADFactory;
+typedef AESGCMEncryptEncodedWithVarbinaryADFactory<AESGCMEncoding::BASE64> AESGCMEncryptBase64WithVarbinaryADFactory;
+RegisterFactory(AESGCMEncryptBase64Factory);
+RegisterFactory(AESGCMEncryptBase64WithVarcharADFactory);
+RegisterFactory(AESGCMEncryptBase64WithVarbinaryADFactory);
+
+typedef AESGCMEncryptEncodedFactory<AESGCMEncoding::HEX> AESGCMEncryptHexFactory;
+typedef AESGCMEncryptEncodedWithVarcharADFactory<AESGCMEncoding::HEX> AESGCMEncryptHexWithVarcharADFactory;
+typedef AESGCMEncryptEncodedWithVarbinaryADFactory<AESGCMEncoding::HEX> AESGCMEncryptHexWithVarbinaryADFactory;
+RegisterFactory(AESGCMEncryptHexFactory);
+RegisterFactory(AESGCMEncryptHexWithVarcharADFactory);
+RegisterFactory(AESGCMEncryptHexWithVarbinaryADFactory);
@@ -0,0 +1,151 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMFilter.h"
+
+#include <Vertica.h>
+#include <sodium.h>
+#include <cstring>
+
+using namespace Vertica;
+
+// AESGCMEncryptFilter provides a Vertica UDFilter which encrypts a byte
+// stream with 256-bit AES-GCM, in authenticated segments of SEGMENT_SIZE_PARAM
+// bytes (see AESGCMStreamHeader). It is the counterpart to
+// AESGCMDecryptFilter.
+//
+// The stream is encrypted with the newest key of the keyring, and the key ID
+// is recorded in the stream header.
+class AESGCMEncryptFilter: public AESGCMFilter {
+    private:
+        // Encrypts a segment of length bytes (segment_size, except for the
+        // last segment) and writes it with its tag.
+        void encryptSegment(const unsigned char *in, size_t length, bool last,
+                DataBuffer &output) {
+            unsigned char ad[AESGCMStreamHeader::length + 1];
+            segmentAssociatedData(last, ad);
+
+            unsigned char *out = reserve(output, length + crypto_aead_aes256gcm_ABYTES);
+            key->encrypt(engine,
+                    out,
+                    in, length,
+                    ad, sizeof(ad),
+                    nonce);
+
+            sodium_increment(nonce, crypto_aead_aes256gcm_NPUBBYTES);
+            segment_index++;
+        }
+
+    public:
+        virtual void setup(ServerInterface &srvInterface) {
+            AESGCMFilter::setup(srvInterface);
+
+            segment_size = default_segment_size;
+            ParamReader paramReader = srvInterface.getParamReader();
+            if (paramReader.containsParameter(SEGMENT_SIZE_PARAM)) {
+                vint size = paramReader.getIntRef(SEGMENT_SIZE_PARAM);
+                if (size < 1 || size > (vint)max_segment_size) {
+                    vt_report_error(0, "Parameter \"" SEGMENT_SIZE_PARAM "\" must be between 1 and %zu",
+                            max_segment_size);
+                }
+                segment_size = size;
+            }
+            buffer.resize(segment_size);
+
+            key = keyring->encryptionKey();
+
+            AESGCMStreamHeader stream_header;
+            stream_header.key_id = keyring->encryptionKeyId();
+            stream_header.segment_size = segment_size;
+            randombytes_buf(stream_header.nonce, sizeof(stream_header.nonce));
+            stream_header.encode(header);
+            memcpy(nonce, stream_header.nonce, sizeof(nonce));
+        }
+
+        virtual StreamState process(ServerInterface &srvInterface,
+                DataBuffer &input,
+                InputState input_state,
+                DataBuffer &output) {
+            for (;;) {
+                if (!drain(output)) {
+                    return OUTPUT_NEEDED;
+                }
+                if (done) {
+                    return DONE;
+                }
+
+                if (!header_done) {
+                    memcpy(reserve(output, sizeof(header)), header, sizeof(header));
+                    header_done = true;
+                    continue;
+                }
+
+                // Encrypt whole segments straight from the input buffer.
+                if (buffered == 0 && input.size - input.offset >= segment_size) {
+                    encryptSegment((unsigned char *)input.buf + input.offset, segment_size,
+                            false, output);
+                    input.offset += segment_size;
+                    continue;
+                }
+
+                if (collect(input, segment_size)) {
+                    encryptSegment(&buffer[0], segment_size, false, output);
+                    buffered = 0;
+                    continue;
+                }
+
+                if (input_state == END_OF_FILE) {
+                    // The last segment is always shorter than segment_size,
+                    // and empty if the input is a multiple of it.
+                    encryptSegment(&buffer[0], buffered, true, output);
+                    buffered = 0;
+                    done = true;
+                    continue;
+                }
+
+                return INPUT_NEEDED;
+            }
+        }
+};
+
+// Exposes AESGCMEncryptFilter, e.g. for COPY ... FILTER.
+class AESGCMEncryptFilterFactory: public AESGCMFilterFactory {
+    public:
+        virtual UDFilter *prepare(ServerInterface &srvInterface,
+                PlanContext &planCtxt) {
+            return vt_createFuncObj(srvInterface.allocator, AESGCMEncryptFilter);
+        }
+
+        virtual void getParameterType(ServerInterface &srvInterface,
+                SizedColumnTypes &parameterTypes) {
+            AESGCMFilterFactory::getParameterType(srvInterface, parameterTypes);
+
+            static const SizedColumnTypes::Properties segment_size_props(
+                    true, // Visible
+                    false, // Required
+                    false, // Can be NULL
+                    "Number of plaintext bytes in each authenticated segment of the stream (default 65536)." // Comment
+                );
+            parameterTypes.addInt(SEGMENT_SIZE_PARAM, segment_size_props);
+        }
+};
+
+RegisterFactory(AESGCMEncryptFilterFactory);
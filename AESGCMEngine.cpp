@@ -0,0 +1,104 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMEngine.h"
+#include "AESGCMMultiBuffer.h"
+#include "AESGCMWide.h"
+
+#include <sodium.h>
+
+#include <cstring>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+static const char *const engine_names[] = {"bitsliced", "aesni", "vaes256", "vaes512"};
+
+static AESGCMEngine::Type detected = AESGCMEngine::BITSLICED;
+static pthread_once_t detect_once = PTHREAD_ONCE_INIT;
+
+#if AESGCM_WIDE
+
+// Returns the state components the OS saves on context switches (XCR0); the
+// wide registers may only be used when it saves them.
+static unsigned long long xgetbv() {
+    unsigned int eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+}
+
+static AESGCMEngine::Type detectWide() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE) ||
+            !__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return AESGCMEngine::AESNI;
+    }
+    if (!(ecx & bit_VAES) || !(ecx & bit_VPCLMULQDQ) || !(ebx & bit_AVX2)) {
+        return AESGCMEngine::AESNI;
+    }
+
+    unsigned long long xcr0 = xgetbv();
+    // SSE and AVX state, then opmask and both halves of the ZMM state.
+    if ((xcr0 & 0x06) != 0x06) {
+        return AESGCMEngine::AESNI;
+    }
+    if ((ebx & bit_AVX512F) && (ebx & bit_AVX512BW) && (xcr0 & 0xe6) == 0xe6) {
+        return AESGCMEngine::VAES512;
+    }
+    return AESGCMEngine::VAES256;
+}
+
+#else
+
+static AESGCMEngine::Type detectWide() {
+    return AESGCMEngine::AESNI;
+}
+
+#endif
+
+static void detectOnce() {
+    if (crypto_aead_aes256gcm_is_available() && AESGCMMultiBuffer::isAvailable()) {
+        detected = detectWide();
+    } else {
+        detected = AESGCMEngine::BITSLICED;
+    }
+}
+
+AESGCMEngine::Type AESGCMEngine::detect() {
+    pthread_once(&detect_once, detectOnce);
+    return detected;
+}
+
+const char *AESGCMEngine::name(Type engine) {
+    return engine_names[engine];
+}
+
+bool AESGCMEngine::parse(const char *name, Type &engine) {
+    for (size_t i = 0; i < sizeof(engine_names) / sizeof(engine_names[0]); i++) {
+        if (strcmp(name, engine_names[i]) == 0) {
+            engine = (Type)i;
+            return true;
+        }
+    }
+    return false;
+}
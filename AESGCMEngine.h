@@ -0,0 +1,61 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef AESGCMENGINE_H_INCLUDED
+#define AESGCMENGINE_H_INCLUDED
+
+// AESGCMEngine names the implementations of AES256-GCM used for single
+// values and stream segments, in order of preference, and detects the best
+// one the CPU supports:
+//
+//   bitsliced  AESGCMBitsliced, portable and constant-time, for CPUs without
+//              AES-NI.
+//   aesni      libsodium's AES-NI and PCLMULQDQ implementation.
+//   vaes256    AESGCMWide with 256-bit VAES and VPCLMULQDQ (AVX2).
+//   vaes512    AESGCMWide with 512-bit VAES and VPCLMULQDQ (AVX-512).
+//
+// Every engine produces identical output, so values encrypted with one can be
+// decrypted with any other. Batches of short values use AESGCMMultiBuffer
+// whenever the engine is at least aesni, with shorter values only with the
+// VAES engines (see AESGCMMultiBuffer::max_wide_length).
+class AESGCMEngine {
+    public:
+        enum Type {
+            BITSLICED,
+            AESNI,
+            VAES256,
+            VAES512
+        };
+
+        // Returns the best engine supported by the CPU (and the compiler).
+        // The CPU is only inspected on the first call. sodium_init() must
+        // have been called.
+        static Type detect();
+
+        // Returns the name of engine, as above.
+        static const char *name(Type engine);
+
+        // Sets engine to the engine called name. Returns false if there is
+        // none.
+        static bool parse(const char *name, Type &engine);
+};
+
+#endif /* AESGCMENGINE_H_INCLUDED */
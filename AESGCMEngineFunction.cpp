@@ -0,0 +1,92 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMEngine.h"
+#include "AESGCMFunction.h"
+
+#include <Vertica.h>
+
+#include <cstring>
+
+using namespace Vertica;
+
+// The length of the longest engine name.
+#define MAX_ENGINE_NAME 9
+
+// AESGCMEngineFunction provides a Vertica scalar function which returns the
+// name of the engine (see AESGCMEngine) the other functions use on the node
+// evaluating it, taking ENGINE_PARAM into account:
+//
+//   SELECT AESGCM_Engine();
+//   SELECT AESGCM_Engine() USING PARAMETERS engine='aesni';
+class AESGCMEngineFunction: public ScalarFunction {
+    private:
+        AESGCMEngine::Type engine;
+
+    public:
+        virtual void setup(ServerInterface &srvInterface, const SizedColumnTypes &argTypes) {
+            engine = AESGCMFunction::selectEngine(srvInterface);
+        }
+
+        virtual void processBlock(ServerInterface &srvInterface,
+                BlockReader &arg_reader,
+                BlockWriter &res_writer) {
+            const char *name = AESGCMEngine::name(engine);
+            do {
+                res_writer.getStringRef().copy(name, strlen(name));
+                res_writer.next();
+            } while (arg_reader.next());
+        }
+};
+
+// Exposes a scalar function taking no arguments and producing VARCHAR. See
+// AESGCMEngineFunction.
+class AESGCMEngineFactory: public ScalarFunctionFactory {
+    public:
+        AESGCMEngineFactory() {
+            // Nodes may have different CPUs, so the result depends on where
+            // the function is evaluated.
+            vol = VOLATILE;
+        }
+
+        virtual ScalarFunction *createScalarFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMEngineFunction);
+        }
+
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            returnType.addVarchar();
+        }
+
+        virtual void getReturnType(ServerInterface &server,
+                const SizedColumnTypes &argTypes,
+                SizedColumnTypes &returnType) {
+            returnType.addVarchar(MAX_ENGINE_NAME);
+        }
+
+        virtual void getParameterType(ServerInterface &srvInterface,
+                SizedColumnTypes &parameterTypes) {
+            AESGCMFunctionFactory::addEngineParameter(parameterTypes);
+        }
+};
+
+RegisterFactory(AESGCMEngineFactory);
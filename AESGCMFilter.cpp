@@ -0,0 +1,131 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMFilter.h"
+
+#include <cstring>
+
+using namespace Vertica;
+
+static const unsigned char stream_magic[4] = {'A', 'G', 'C', 'S'};
+
+void AESGCMStreamHeader::encode(unsigned char out[length]) const {
+    memcpy(out, stream_magic, sizeof(stream_magic));
+    out[4] = version;
+    out[5] = key_id;
+    out[6] = (unsigned char)(segment_size >> 24);
+    out[7] = (unsigned char)(segment_size >> 16);
+    out[8] = (unsigned char)(segment_size >> 8);
+    out[9] = (unsigned char)segment_size;
+    memcpy(out + 10, nonce, sizeof(nonce));
+}
+
+bool AESGCMStreamHeader::decode(const unsigned char in[length]) {
+    if (memcmp(in, stream_magic, sizeof(stream_magic)) != 0 || in[4] != version) {
+        return false;
+    }
+    key_id = in[5];
+    segment_size = ((uint32_t)in[6] << 24) | ((uint32_t)in[7] << 16) |
+        ((uint32_t)in[8] << 8) | (uint32_t)in[9];
+    memcpy(nonce, in + 10, sizeof(nonce));
+    return true;
+}
+
+void AESGCMFilter::setup(ServerInterface &srvInterface) {
+    keyring = AESGCMFunction::acquireKeyring(srvInterface);
+    engine = AESGCMFunction::selectEngine(srvInterface);
+    key = NULL;
+    header_done = false;
+    segment_index = 0;
+    segment_size = 0;
+    buffered = 0;
+    pending.clear();
+    pending_offset = 0;
+    done = false;
+}
+
+void AESGCMFilter::destroy(ServerInterface &srvInterface) {
+    AESGCMKeyCache::release(keyring);
+    keyring = NULL;
+    key = NULL;
+}
+
+bool AESGCMFilter::drain(DataBuffer &output) {
+    if (pending.empty()) {
+        return true;
+    }
+
+    size_t n = pending.size() - pending_offset;
+    if (n > output.size - output.offset) {
+        n = output.size - output.offset;
+    }
+    memcpy(output.buf + output.offset, &pending[0] + pending_offset, n);
+    output.offset += n;
+    pending_offset += n;
+
+    if (pending_offset < pending.size()) {
+        return false;
+    }
+    pending.clear();
+    pending_offset = 0;
+    return true;
+}
+
+unsigned char *AESGCMFilter::reserve(DataBuffer &output, size_t size) {
+    if (pending.empty() && output.size - output.offset >= size) {
+        unsigned char *out = (unsigned char *)output.buf + output.offset;
+        output.offset += size;
+        return out;
+    }
+    pending.resize(size);
+    pending_offset = 0;
+    return &pending[0];
+}
+
+bool AESGCMFilter::collect(DataBuffer &input, size_t size) {
+    size_t n = size - buffered;
+    if (n > input.size - input.offset) {
+        n = input.size - input.offset;
+    }
+    memcpy(&buffer[0] + buffered, input.buf + input.offset, n);
+    input.offset += n;
+    buffered += n;
+    return buffered == size;
+}
+
+void AESGCMFilter::segmentAssociatedData(bool last, unsigned char *ad) const {
+    memcpy(ad, header, sizeof(header));
+    ad[sizeof(header)] = last ? 1 : 0;
+}
+
+void AESGCMFilterFactory::getParameterType(ServerInterface &srvInterface,
+        SizedColumnTypes &parameterTypes) {
+    AESGCMFunctionFactory::addKeyParameter(parameterTypes);
+    AESGCMFunctionFactory::addEngineParameter(parameterTypes);
+}
+
+void AESGCMFilterFactory::getPerInstanceResources(ServerInterface &srvInterface,
+        VResources &res) {
+    // As for AESGCMFunction, at most a single file is opened to read the
+    // key. A partial segment is held for each of input and output.
+    res.nFileHandles += 1;
+    res.scratchMemory += 2 * (AESGCMFilter::max_segment_size + crypto_aead_aes256gcm_ABYTES);
+}
@@ -0,0 +1,131 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef AESGCMFILTER_H_INCLUDED
+#define AESGCMFILTER_H_INCLUDED
+
+#include "AESGCMFunction.h"
+
+#include <Vertica.h>
+#include <sodium.h>
+
+#include <stdint.h>
+#include <vector>
+
+#define SEGMENT_SIZE_PARAM "segment_size"
+
+// AESGCMStreamHeader is written once at the start of an encrypted stream:
+//
+//   magic "AGCS" (4 bytes) | version (1 byte) | key id (1 byte) |
+//   segment size (4 bytes, big-endian) | nonce (12 bytes)
+//
+// It is followed by the segments of the stream. Each segment is the
+// AES256-GCM encryption of segment size bytes of plaintext, followed by its
+// 16 byte tag. The last segment is shorter than segment size (possibly
+// empty), so every stream ends with exactly one short segment.
+//
+// The nonce of the first segment is the one in the header and is incremented
+// for each following segment. The associated data of each segment is the
+// header followed by a single byte which is 1 for the last segment and 0
+// otherwise, so segments cannot be reordered, truncated or moved between
+// streams without failing verification.
+struct AESGCMStreamHeader {
+    static const size_t length = 4 + 1 + 1 + 4 + crypto_aead_aes256gcm_NPUBBYTES;
+    static const unsigned char version = 1;
+
+    unsigned char key_id;
+    uint32_t segment_size;
+    unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES];
+
+    void encode(unsigned char out[length]) const;
+
+    // Returns false if in is not a header this version can read.
+    bool decode(const unsigned char in[length]);
+};
+
+// AESGCMFilter holds the state common to the streaming encryption and
+// decryption UDFilters (see AESGCMEncryptFilter and AESGCMDecryptFilter).
+// Input is collected into whole segments, and output which does not fit in
+// the output buffer is held until the next call to process, so memory use is
+// bounded by the segment size regardless of the length of the stream.
+// Whole segments are processed directly between the input and output buffers
+// when they allow it.
+class AESGCMFilter: public Vertica::UDFilter {
+    protected:
+        const AESGCMKeyring *keyring;
+        const AESGCMKey *key;
+        AESGCMEngine::Type engine;
+
+        // The encoded stream header, authenticated with every segment.
+        unsigned char header[AESGCMStreamHeader::length];
+        bool header_done;
+
+        // The nonce of the next segment.
+        unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES];
+        uint64_t segment_index;
+        size_t segment_size;
+
+        // A partial segment collected from input.
+        std::vector<unsigned char> buffer;
+        size_t buffered;
+
+        // Output waiting for room in the output buffer.
+        std::vector<unsigned char> pending;
+        size_t pending_offset;
+
+        bool done;
+
+        // Copies as much pending output as fits into output. Returns true if
+        // no pending output remains.
+        bool drain(Vertica::DataBuffer &output);
+
+        // Returns where the next size bytes of output should be written:
+        // directly to output when it has room, otherwise to pending.
+        unsigned char *reserve(Vertica::DataBuffer &output, size_t size);
+
+        // Collects input into buffer until it holds size bytes. Returns
+        // true if it does.
+        bool collect(Vertica::DataBuffer &input, size_t size);
+
+        // Writes the associated data of a segment to ad, which must have
+        // room for AESGCMStreamHeader::length + 1 bytes.
+        void segmentAssociatedData(bool last, unsigned char *ad) const;
+
+    public:
+        static const size_t default_segment_size = 64 * 1024;
+        static const size_t max_segment_size = 4 * 1024 * 1024;
+
+        AESGCMFilter(): keyring(NULL), key(NULL), engine(AESGCMEngine::BITSLICED) {}
+
+        virtual void setup(Vertica::ServerInterface &srvInterface);
+
+        virtual void destroy(Vertica::ServerInterface &srvInterface);
+};
+
+class AESGCMFilterFactory: public Vertica::FilterFactory {
+    public:
+        virtual void getParameterType(Vertica::ServerInterface &srvInterface,
+                Vertica::SizedColumnTypes &parameterTypes);
+        virtual void getPerInstanceResources(Vertica::ServerInterface &srvInterface,
+                Vertica::VResources &res);
+};
+
+#endif /* AESGCMFILTER_H_INCLUDED */
@@ -19,75 +19,261 @@
 // THE SOFTWARE.
 
 #include "AESGCMFunction.h"
+#include "AESGCMCompression.h"
+#include "AESGCMThreadPool.h"
 
-#include <fstream>
-#include <iomanip>
+#include <algorithm>
+#include <cstring>
 
 using namespace Vertica;
 
-// readKeyFile reads an AES256 key from the file stored at key_path from the
-// local filesystem. The key is expected to be stored as hexadecimal ASCII
-// (i.e. using only characters 0-9a-fA-F). The 256-bit value of the key is
-// stored in key_out. If a 256-bit key was successfully read, this function
-// returns true.  If there are any errors, key_out may be partially or
-// incorrectly set.
-bool readKeyFile(const std::string &key_path,
-    unsigned char key_out[crypto_aead_aes256gcm_KEYBYTES]) {
-    // Each "byte" of key is two bytes of hex.
-    // std::setw accounts for a NULL-terminating character.
-    static const size_t key_hex_length = (crypto_aead_aes256gcm_KEYBYTES * 2) + 1;
-    char key_hex[key_hex_length];
-    std::ifstream key_file(key_path.c_str());
-    return (key_file >> std::setw(key_hex_length) >> key_hex) &&
-        sodium_hex2bin(key_out, crypto_aead_aes256gcm_KEYBYTES, key_hex, key_hex_length,
-                NULL, NULL, NULL) == 0;
-}
-
 const long int AESGCMFunction::overhead = crypto_aead_aes256gcm_NPUBBYTES + crypto_aead_aes256gcm_ABYTES;
 
 void AESGCMFunction::setup(ServerInterface &srvInterface,
         const SizedColumnTypes &argTypes) {
-    if (argTypes.getColumnCount() < 1 || argTypes.getColumnCount() > 2) {
-        vt_report_error(0, "Function accepts either 1 or 2 arguments, but %zu provided",
-                argTypes.getColumnCount());
+    if (argTypes.getColumnCount() < ad_column || argTypes.getColumnCount() > ad_column + 1) {
+        vt_report_error(0, "Function accepts either %zu or %zu arguments, but %zu provided",
+                ad_column, ad_column + 1, argTypes.getColumnCount());
     }
 
-    column_name = argTypes.getColumnName(0);
+    column_name = argTypes.getColumnName(value_column);
+
+    const VerticaType &value_type = argTypes.getColumnType(value_column);
+    int32_t value_length = value_type.isStringType() ? value_type.getStringLength() : 0;
+    max_plaintext_length = value_length > overhead ? value_length - overhead : 0;
+
+    keyring = acquireKeyring(srvInterface);
+    engine = selectEngine(srvInterface);
 
     ParamReader paramReader = srvInterface.getParamReader();
-    if (!paramReader.containsParameter(KEY_PATH_PARAM)) {
-        vt_report_error(0, "Required parameter \"" KEY_PATH_PARAM  "\" missing");
+    key_path = paramReader.getStringRef(KEY_PATH_PARAM).str();
+    use_multi_buffer = engine >= AESGCMEngine::AESNI &&
+        !(paramReader.containsParameter(MULTI_BUFFER_PARAM) &&
+                paramReader.getBoolRef(MULTI_BUFFER_PARAM) == vbool_false);
+    multi_buffer_length = engine >= AESGCMEngine::VAES256 ?
+        AESGCMMultiBuffer::max_wide_length : AESGCMMultiBuffer::max_length;
+
+    threads = 1;
+    if (paramReader.containsParameter(THREADS_PARAM)) {
+        vint n = paramReader.getIntRef(THREADS_PARAM);
+        if (n < 1 || n > (vint)AESGCMThreadPool::max_threads) {
+            vt_report_error(0, "Parameter \"" THREADS_PARAM "\" must be between 1 and %zu",
+                    AESGCMThreadPool::max_threads);
+        }
+        threads = n;
     }
+}
 
-    std::string key_path = paramReader.getStringRef(KEY_PATH_PARAM).str();
-    unsigned char key[crypto_aead_aes256gcm_KEYBYTES];
+const AESGCMKeyring *AESGCMFunction::acquireKeyring(ServerInterface &srvInterface,
+        const char *param) {
+    ParamReader paramReader = srvInterface.getParamReader();
+    if (!paramReader.containsParameter(param)) {
+        vt_report_error(0, "Required parameter \"%s\" missing", param);
+    }
 
-    if (!readKeyFile(key_path, key)) {
+    std::string key_path = paramReader.getStringRef(param).str();
+
+    sodium_init();
+
+    const AESGCMKeyring *keyring = AESGCMKeyCache::acquire(key_path);
+    if (keyring == NULL) {
         vt_report_error(0, "Failed to read key from file: %s", key_path.c_str());
     }
+    return keyring;
+}
 
+AESGCMEngine::Type AESGCMFunction::selectEngine(ServerInterface &srvInterface) {
     sodium_init();
+    AESGCMEngine::Type engine = AESGCMEngine::detect();
+
+    ParamReader paramReader = srvInterface.getParamReader();
+    if (paramReader.containsParameter(ENGINE_PARAM)) {
+        std::string name = paramReader.getStringRef(ENGINE_PARAM).str();
+        AESGCMEngine::Type requested;
+        if (!AESGCMEngine::parse(name.c_str(), requested)) {
+            vt_report_error(0, "Parameter \"" ENGINE_PARAM "\" must be one of bitsliced, aesni, vaes256 or vaes512");
+        }
+        engine = std::min(engine, requested);
+    }
+    return engine;
+}
 
-    if (!crypto_aead_aes256gcm_is_available()) {
-        vt_report_error(0, "System support required for AES256-GCM is unavailable");
+void AESGCMFunction::destroy(ServerInterface &srvInterface,
+        const SizedColumnTypes &argTypes) {
+    if (stats_name != NULL && counters.blocks > 0) {
+        srvInterface.log("%s key=%s blocks=%llu rows=%llu null_rows=%llu"
+                " bytes_in=%llu bytes_out=%llu crypto_ns=%llu loop_ns=%llu"
+                " auth_failures=%llu",
+                stats_name, key_path.c_str(),
+                (unsigned long long)counters.blocks,
+                (unsigned long long)counters.rows,
+                (unsigned long long)counters.null_rows,
+                (unsigned long long)counters.bytes_in,
+                (unsigned long long)counters.bytes_out,
+                (unsigned long long)counters.cryptoNs(),
+                (unsigned long long)counters.loopNs(),
+                (unsigned long long)counters.auth_failures);
+        AESGCMStats::record(stats_name, key_path, counters);
     }
 
-    crypto_aead_aes256gcm_beforenm(&crypto_ctx, key);
+    AESGCMKeyCache::release(keyring);
+    keyring = NULL;
 }
 
-void AESGCMFunctionFactory::getParameterType(ServerInterface &srvInterface,
-        SizedColumnTypes &parameterTypes) {
+const unsigned char *AESGCMFunction::prefixAssociatedData(
+        std::vector<unsigned char> &scratch,
+        const unsigned char *prefix, size_t prefix_length,
+        const unsigned char *ad, size_t ad_length) {
+    if (prefix_length == 0) {
+        return ad;
+    }
+    scratch.resize(prefix_length + ad_length);
+    memcpy(&scratch[0], prefix, prefix_length);
+    if (ad_length > 0) {
+        memcpy(&scratch[prefix_length], ad, ad_length);
+    }
+    return &scratch[0];
+}
+
+int AESGCMFunction::decryptValue(const AESGCMKeyring *keyring, AESGCMEngine::Type engine,
+        const unsigned char *value, size_t value_length,
+        const unsigned char *ad, size_t ad_length,
+        unsigned char *out, size_t &out_length,
+        std::vector<unsigned char> &scratch,
+        unsigned char *flags) {
+    // Try the value as having a header first, and fall back to treating it
+    // as headerless: the nonce of a headerless value may look like a header.
+    AESGCMHeader header;
+    size_t header_length = header.decode(value, value_length);
+    const AESGCMKey *key = header_length > 0 ? findKey(keyring, header) : NULL;
+    AESGCMAlgorithm::Type algorithm = (AESGCMAlgorithm::Type)header.algorithm;
+    size_t nonce_length = AESGCMAlgorithm::nonceLength(algorithm);
+    size_t value_overhead = AESGCMAlgorithm::overhead(algorithm);
+    if (key != NULL && value_length >= header_length + value_overhead) {
+        const unsigned char *nonce = value + header_length;
+        if (key->decrypt(algorithm, engine,
+                    out,
+                    nonce + nonce_length,
+                    value_length - header_length - nonce_length,
+                    prefixAssociatedData(scratch, value, header_length, ad, ad_length),
+                    header_length + ad_length,
+                    nonce) == 0) {
+            out_length = value_length - header_length - value_overhead;
+            if (flags != NULL) {
+                *flags = header.flags;
+            }
+            return 0;
+        }
+    }
+
+    out_length = 0;
+    if (value_length < (size_t)overhead) {
+        return -1;
+    }
+    if (keyring->legacyKey()->decrypt(engine,
+                out,
+                value + crypto_aead_aes256gcm_NPUBBYTES,
+                value_length - crypto_aead_aes256gcm_NPUBBYTES,
+                ad, ad_length,
+                value) != 0) {
+        return -1;
+    }
+    out_length = value_length - overhead;
+    if (flags != NULL) {
+        *flags = 0;
+    }
+    return 0;
+}
+
+size_t AESGCMFunction::decompressedLength(const unsigned char *payload, size_t length) const {
+    size_t out_length = 0;
+    if (!AESGCMCompression::decompressedLength(payload, length, out_length)) {
+        vt_report_error(0, "Failed to decompress plaintext in column '%s'", column_name.c_str());
+    }
+    if (out_length > max_plaintext_length) {
+        vt_report_error(0,
+                "Decompressed plaintext in column '%s' is too long (%zu) expected at most %zu; cast the column to a longer VARBINARY",
+                column_name.c_str(),
+                out_length,
+                max_plaintext_length);
+    }
+    return out_length;
+}
+
+void AESGCMFunction::decompress(const unsigned char *payload, size_t length,
+        unsigned char *out, size_t out_length) const {
+    if (!AESGCMCompression::decompress(payload, length, out, out_length)) {
+        vt_report_error(0, "Failed to decompress plaintext in column '%s'", column_name.c_str());
+    }
+}
+
+size_t AESGCMFunction::parallelRanges(size_t total) const {
+    if (threads <= 1 || total < min_parallel_bytes) {
+        return 1;
+    }
+    return std::min(threads, AESGCMThreadPool::size());
+}
+
+void AESGCMFunctionFactory::addKeyParameter(SizedColumnTypes &parameterTypes) {
     static const SizedColumnTypes::Properties key_props(
             true, // Visible
             true, // Required
             false, // Can be NULL
-            "Specifies the path to a file containing a 256-bit AES key in hexadecimal representation." // Comment
+            "Specifies the path to a file containing a 256-bit AES key in hexadecimal representation, or a keyring of such keys with IDs." // Comment
         );
     parameterTypes.addVarchar(MAX_KEY_PATH, KEY_PATH_PARAM, key_props);
 }
 
+void AESGCMFunctionFactory::addEngineParameter(SizedColumnTypes &parameterTypes) {
+    static const SizedColumnTypes::Properties engine_props(
+            false, // Visible
+            false, // Required
+            false, // Can be NULL
+            "Limits the AES-GCM implementation to bitsliced, aesni, vaes256 or vaes512 (default: the best the CPU supports)." // Comment
+        );
+    parameterTypes.addVarchar(16, ENGINE_PARAM, engine_props);
+}
+
+void AESGCMFunctionFactory::addMultiBufferParameter(SizedColumnTypes &parameterTypes) {
+    static const SizedColumnTypes::Properties multi_buffer_props(
+            false, // Visible
+            false, // Required
+            false, // Can be NULL
+            "Set to false to disable batched processing of short values." // Comment
+        );
+    parameterTypes.addBool(MULTI_BUFFER_PARAM, multi_buffer_props);
+}
+
+size_t AESGCMFunctionFactory::headerLength(ServerInterface &srvInterface,
+        unsigned char flags, const char *param) {
+    const AESGCMKeyring *keyring = AESGCMFunction::acquireKeyring(srvInterface, param);
+    AESGCMHeader header;
+    header.flags = flags;
+    if (keyring->hasKeyIds()) {
+        header.flags |= AESGCMHeader::KEY_ID;
+    }
+    AESGCMKeyCache::release(keyring);
+    return header.length();
+}
+
+void AESGCMFunctionFactory::getParameterType(ServerInterface &srvInterface,
+        SizedColumnTypes &parameterTypes) {
+    addKeyParameter(parameterTypes);
+    addEngineParameter(parameterTypes);
+    addMultiBufferParameter(parameterTypes);
+
+    static const SizedColumnTypes::Properties threads_props(
+            true, // Visible
+            false, // Required
+            false, // Can be NULL
+            "Number of threads used to process each large block (default 1)." // Comment
+        );
+    parameterTypes.addInt(THREADS_PARAM, threads_props);
+}
+
 void AESGCMFunctionFactory::getPerInstanceResources(ServerInterface &srvInterface,
         VResources &res) {
-    // Each AESGCMFunction instance opens a single file to read the key.
+    // Each AESGCMFunction instance opens at most a single file to read the
+    // key, and only when it is not already cached.
     res.nFileHandles += 1;
 }
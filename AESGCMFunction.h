@@ -21,13 +21,21 @@
 #ifndef AESGCMFUNCTION_H_INCLUDED
 #define AESGCMFUNCTION_H_INCLUDED
 
+#include "AESGCMEngine.h"
+#include "AESGCMHeader.h"
+#include "AESGCMKeyCache.h"
+#include "AESGCMMultiBuffer.h"
+#include "AESGCMStats.h"
+
 #include <Vertica.h>
 #include <sodium.h>
 
 #include <string>
+#include <vector>
 #include <limits.h>
 
 #define VERTICA_VARCHAR_MAX 65000
+#define VERTICA_LONG_MAX 32000000
 #if defined(PATH_MAX)&&(PATH_MAX<=VERTICA_VARCHAR_MAX)
 #   define MAX_KEY_PATH PATH_MAX
 #else
@@ -35,22 +43,184 @@
 #endif
 
 #define KEY_PATH_PARAM "key"
+#define NEW_KEY_PATH_PARAM "new_key"
+#define MULTI_BUFFER_PARAM "multi_buffer"
+#define THREADS_PARAM "threads"
+#define ENGINE_PARAM "engine"
+#define COMPRESS_PARAM "compress"
+#define COLUMNS_PARAM "columns"
+#define PRECISION_PARAM "precision"
+#define SCALE_PARAM "scale"
+#define TENANT_KEYS_PARAM "tenant_keys"
+#define ALGORITHM_PARAM "algorithm"
 
 // AESGCMFunction encapsulates key reading functionality common to the
-// encryption and decryption scalar functions. The key is read from a file
-// specified by a function parameter (KEY_PATH_PARAM).
+// encryption and decryption scalar functions. The key, or keyring (see
+// AESGCMKeyring), is read from a file specified by a function parameter
+// (KEY_PATH_PARAM), through the process-wide AESGCMKeyCache.
 class AESGCMFunction: public Vertica::ScalarFunction {
     protected:
-        crypto_aead_aes256gcm_state crypto_ctx;
+        const AESGCMKeyring *keyring;
+        std::string key_path;
         std::string column_name;
 
+        // The name the counters of the instance are logged and recorded in
+        // AESGCMStats under on destroy, or NULL if they are not kept.
+        const char *stats_name;
+        AESGCMCounters counters;
+
+        // The implementation used for values which are not batched, see
+        // selectEngine.
+        AESGCMEngine::Type engine;
+
+        // Short values are encrypted and decrypted in batches when the engine
+        // is at least AES-NI (and MULTI_BUFFER_PARAM is not false), see
+        // AESGCMMultiBuffer.
+        bool use_multi_buffer;
+
+        // The longest plaintext batched when use_multi_buffer is set:
+        // AESGCMMultiBuffer::max_length, or max_wide_length with the VAES
+        // engines.
+        size_t multi_buffer_length;
+
+        // The number of threads used for blocks of at least
+        // min_parallel_bytes, see AESGCMThreadPool. 1 processes every block
+        // on the calling thread.
+        size_t threads;
+
+        // The longest plaintext of a value of the type of the value
+        // argument, when it is a value written by AESGCMEncrypt. Compressed
+        // plaintexts are decompressed only if they are no longer.
+        size_t max_plaintext_length;
+
+        // The index of the value argument, which is encrypted or decrypted.
+        size_t value_column;
+
+        // The index of the optional associated data argument, which follows
+        // the value and any other required arguments.
+        size_t ad_column;
+
+        // Storage for prefixAssociatedData when called from the thread
+        // calling processBlock.
+        std::vector<unsigned char> ad_scratch;
+
+        // Returns the key to decrypt a value with the given header, or NULL
+        // if the keyring has no such key.
+        const AESGCMKey *findKey(const AESGCMHeader &header) const {
+            return findKey(keyring, header);
+        }
+
+        // Returns prefix || ad, using scratch as storage. If there is no
+        // prefix ad is returned as is.
+        static const unsigned char *prefixAssociatedData(
+                std::vector<unsigned char> &scratch,
+                const unsigned char *prefix, size_t prefix_length,
+                const unsigned char *ad, size_t ad_length);
+
+        // Returns the AESGCMHeader flags of a verified message.
+        static unsigned char messageFlags(const AESGCMMessage &message) {
+            return message.ad_prefix_length > 0 ? message.ad_prefix[1] : 0;
+        }
+
+        // Decrypts value, as written by AESGCMEncrypt, into out which must
+        // have room for value_length - overhead bytes. Returns 0 and sets
+        // out_length, and flags if not NULL to the flags of its header (0 if
+        // it has none), if the value was verified, or -1 otherwise. Safe to
+        // call from any thread given its own scratch.
+        int decryptValue(const unsigned char *value, size_t value_length,
+                const unsigned char *ad, size_t ad_length,
+                unsigned char *out, size_t &out_length,
+                std::vector<unsigned char> &scratch,
+                unsigned char *flags = NULL) const {
+            return decryptValue(keyring, engine, value, value_length, ad, ad_length,
+                    out, out_length, scratch, flags);
+        }
+
+        // Returns the length of the plaintext of a compressed payload of
+        // length bytes, reporting an error if it is malformed or longer than
+        // max_plaintext_length.
+        size_t decompressedLength(const unsigned char *payload, size_t length) const;
+
+        // Decompresses a payload of length bytes to out, which has room for
+        // its decompressedLength of out_length bytes, reporting an error if
+        // it is malformed.
+        void decompress(const unsigned char *payload, size_t length,
+                unsigned char *out, size_t out_length) const;
+
+        // Returns the number of ranges to split a block of total input
+        // bytes into, one per thread, or 1 if it should be processed on the
+        // calling thread.
+        size_t parallelRanges(size_t total) const;
+
+        // Returns the first of rows in range index of count, where the
+        // ranges cover roughly equal numbers of bytes given the offset of
+        // each row (the number of input bytes before it). Range count
+        // begins after the last row.
+        template <class Row>
+        static size_t rangeBegin(const std::vector<Row> &rows, size_t total,
+                size_t index, size_t count) {
+            size_t begin = 0, end = rows.size();
+            size_t offset = total * index / count;
+            while (begin < end) {
+                size_t mid = begin + (end - begin) / 2;
+                if (rows[mid].offset < offset) {
+                    begin = mid + 1;
+                } else {
+                    end = mid;
+                }
+            }
+            return index >= count ? rows.size() : begin;
+        }
+
     public:
+        // Blocks with fewer input bytes are processed on the calling thread
+        // even if THREADS_PARAM is set.
+        static const size_t min_parallel_bytes = 256 * 1024;
+
         // The maximum number of bytes added to the length of the plaintext to
         // accomodate the public nonce and additional data tag.
         static const long int overhead;
 
+        AESGCMFunction(): keyring(NULL), stats_name(NULL), engine(AESGCMEngine::BITSLICED),
+            use_multi_buffer(false), multi_buffer_length(AESGCMMultiBuffer::max_length),
+            threads(1), max_plaintext_length(0),
+            value_column(0), ad_column(1) {}
+
+        // Returns the keyring named by the param parameter, reporting an
+        // error if the parameter is missing or the file cannot be read. The
+        // keyring must be passed to AESGCMKeyCache::release when no longer
+        // needed.
+        static const AESGCMKeyring *acquireKeyring(Vertica::ServerInterface &srvInterface,
+                const char *param = KEY_PATH_PARAM);
+
+        // Returns the best engine the CPU supports, or the engine named by
+        // ENGINE_PARAM if it is lower, reporting an error if the name is
+        // unknown.
+        static AESGCMEngine::Type selectEngine(Vertica::ServerInterface &srvInterface);
+
+        // Returns the key of keyring to decrypt a value with the given
+        // header, or NULL if it has no such key.
+        static const AESGCMKey *findKey(const AESGCMKeyring *keyring,
+                const AESGCMHeader &header) {
+            return (header.flags & AESGCMHeader::KEY_ID) ?
+                keyring->find(header.key_id) : keyring->legacyKey();
+        }
+
+        // As the decryptValue member, for functions which are not
+        // AESGCMFunctions (such as transform functions) given their keyring
+        // and engine.
+        static int decryptValue(const AESGCMKeyring *keyring, AESGCMEngine::Type engine,
+                const unsigned char *value, size_t value_length,
+                const unsigned char *ad, size_t ad_length,
+                unsigned char *out, size_t &out_length,
+                std::vector<unsigned char> &scratch,
+                unsigned char *flags = NULL);
+
         virtual void setup(Vertica::ServerInterface &srvInterface,
                 const Vertica::SizedColumnTypes &argTypes);
+
+        virtual void destroy(Vertica::ServerInterface &srvInterface,
+                const Vertica::SizedColumnTypes &argTypes);
 };
 
 // AESGCMFunctionFactory provides metainformation common to
@@ -58,6 +228,22 @@ class AESGCMFunction: public Vertica::ScalarFunction {
 // and parameter hints.
 class AESGCMFunctionFactory: public Vertica::ScalarFunctionFactory {
     public:
+        // Adds KEY_PATH_PARAM to parameterTypes.
+        static void addKeyParameter(Vertica::SizedColumnTypes &parameterTypes);
+
+        // Adds ENGINE_PARAM to parameterTypes.
+        static void addEngineParameter(Vertica::SizedColumnTypes &parameterTypes);
+
+        // Adds MULTI_BUFFER_PARAM to parameterTypes.
+        static void addMultiBufferParameter(Vertica::SizedColumnTypes &parameterTypes);
+
+        // Returns the length of the AESGCMHeader with the given flags, and
+        // KEY_ID if the keyring named by the param parameter has key IDs, or
+        // 0 if it needs none. Result types allow for a header only when a
+        // value can have one, so single-key values keep their length.
+        static size_t headerLength(Vertica::ServerInterface &srvInterface,
+                unsigned char flags, const char *param = KEY_PATH_PARAM);
+
         virtual void getParameterType(Vertica::ServerInterface &srvInterface,
                 Vertica::SizedColumnTypes &parameterTypes);
         virtual void getPerInstanceResources(Vertica::ServerInterface &srvInterface,
@@ -0,0 +1,122 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef AESGCMHEADER_H_INCLUDED
+#define AESGCMHEADER_H_INCLUDED
+
+#include "AESGCMAlgorithm.h"
+
+#include <stddef.h>
+
+#define AESGCM_HEADER_MAGIC 0xAE
+
+// AESGCMHeader is the optional header which precedes the nonce of a
+// ciphertext:
+//
+//   magic (1 byte) | flags (1 byte) | key id (1 byte, if KEY_ID is set) |
+//   algorithm (1 byte, if ALGORITHM is set)
+//
+// The nonce and tag lengths follow from the algorithm, see AESGCMAlgorithm.
+// Values without ALGORITHM are AES-256-GCM.
+// The header is authenticated as a prefix of the associated data.
+//
+// Values without a header start directly with the random nonce, so a value
+// which looks like it has a header may still be headerless. Decryption
+// therefore falls back to the headerless interpretation when the header
+// interpretation fails to verify.
+struct AESGCMHeader {
+    enum Flags {
+        // The value was encrypted with the keyring key given by key_id.
+        KEY_ID = 0x01,
+        // The plaintext was compressed before encryption, see
+        // AESGCMCompression.
+        COMPRESSED = 0x02,
+        // The plaintext is the columns of a row packed by AESGCMRowFormat,
+        // see AESGCMEncryptRow.
+        ROW = 0x04,
+        // The value was encrypted with the AESGCMAlgorithm given by
+        // algorithm.
+        ALGORITHM = 0x08
+    };
+
+    static const unsigned char known_flags = KEY_ID | COMPRESSED | ROW | ALGORITHM;
+
+    // The maximum encoded length of a header, and of one with ALGORITHM set
+    // (which only AESGCMEncrypt writes).
+    static const size_t max_length = 3;
+    static const size_t max_algorithm_length = 4;
+
+    unsigned char flags;
+    unsigned char key_id;
+    unsigned char algorithm;
+
+    AESGCMHeader(): flags(0), key_id(0), algorithm(AESGCMAlgorithm::AES256GCM) {}
+
+    // Returns the encoded length of the header, or 0 if no header is needed.
+    size_t length() const {
+        if (flags == 0) {
+            return 0;
+        }
+        return 2 + ((flags & KEY_ID) ? 1 : 0) + ((flags & ALGORITHM) ? 1 : 0);
+    }
+
+    // Writes the header to out, which must have room for length() bytes.
+    // Returns the number of bytes written.
+    size_t encode(unsigned char *out) const {
+        if (flags == 0) {
+            return 0;
+        }
+        size_t n = 0;
+        out[n++] = AESGCM_HEADER_MAGIC;
+        out[n++] = flags;
+        if (flags & KEY_ID) {
+            out[n++] = key_id;
+        }
+        if (flags & ALGORITHM) {
+            out[n++] = algorithm;
+        }
+        return n;
+    }
+
+    // Parses a header from the start of value. Returns the length of the
+    // header, or 0 if value does not start with a well-formed header
+    // (including one naming an unknown algorithm).
+    size_t decode(const unsigned char *value, size_t value_length) {
+        if (value_length < 2 || value[0] != AESGCM_HEADER_MAGIC ||
+                value[1] == 0 || (value[1] & ~known_flags) != 0) {
+            return 0;
+        }
+        flags = value[1];
+        size_t n = length();
+        if (value_length < n) {
+            flags = 0;
+            return 0;
+        }
+        key_id = (flags & KEY_ID) ? value[2] : 0;
+        algorithm = (flags & ALGORITHM) ? value[n - 1] : (unsigned char)AESGCMAlgorithm::AES256GCM;
+        if (algorithm >= AESGCMAlgorithm::count) {
+            flags = 0;
+            return 0;
+        }
+        return n;
+    }
+};
+
+#endif /* AESGCMHEADER_H_INCLUDED */
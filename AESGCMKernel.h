@@ -0,0 +1,281 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef AESGCMKERNEL_H_INCLUDED
+#define AESGCMKERNEL_H_INCLUDED
+
+// AESGCMKernel.h holds the AES-NI and PCLMULQDQ building blocks shared by
+// AESGCMMultiBuffer, AESGCMSIV and AESGCMWide. It is only included on x86, and its
+// functions may only be called once AESGCMMultiBuffer::isAvailable() has
+// returned true.
+
+#include <sodium.h>
+
+#include <cstring>
+#include <immintrin.h>
+#include <stddef.h>
+
+// The kernel is compiled for AES-NI and PCLMULQDQ regardless of the global
+// compiler flags. It is only called once isAvailable() has returned true.
+#define KERNEL __attribute__((target("aes,pclmul,ssse3,sse4.1")))
+
+KERNEL static inline __m128i bswap(__m128i x) {
+    return _mm_shuffle_epi8(x, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+// Loads a block of up to 16 bytes, zero padding the remainder.
+KERNEL static inline __m128i loadPartial(const unsigned char *p, size_t length) {
+    if (length >= 16) {
+        return _mm_loadu_si128((const __m128i *)p);
+    }
+    CRYPTO_ALIGN(16) unsigned char block[16] = {0};
+    memcpy(block, p, length);
+    return _mm_load_si128((const __m128i *)block);
+}
+
+KERNEL static inline void storePartial(unsigned char *p, __m128i x, size_t length) {
+    if (length >= 16) {
+        _mm_storeu_si128((__m128i *)p, x);
+        return;
+    }
+    CRYPTO_ALIGN(16) unsigned char block[16];
+    _mm_store_si128((__m128i *)block, x);
+    memcpy(p, block, length);
+}
+
+// AES256 key expansion, see the Intel AES-NI white paper.
+KERNEL static inline __m128i expandKeyA(__m128i key, __m128i assist) {
+    assist = _mm_shuffle_epi32(assist, 0xff);
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, assist);
+}
+
+KERNEL static inline __m128i expandKeyB(__m128i key, __m128i prev) {
+    __m128i assist = _mm_shuffle_epi32(_mm_aeskeygenassist_si128(prev, 0x00), 0xaa);
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, assist);
+}
+
+KERNEL static inline void expandKey(const unsigned char *key, __m128i rk[15]) {
+    rk[0] = _mm_loadu_si128((const __m128i *)key);
+    rk[1] = _mm_loadu_si128((const __m128i *)(key + 16));
+    rk[2] = expandKeyA(rk[0], _mm_aeskeygenassist_si128(rk[1], 0x01));
+    rk[3] = expandKeyB(rk[1], rk[2]);
+    rk[4] = expandKeyA(rk[2], _mm_aeskeygenassist_si128(rk[3], 0x02));
+    rk[5] = expandKeyB(rk[3], rk[4]);
+    rk[6] = expandKeyA(rk[4], _mm_aeskeygenassist_si128(rk[5], 0x04));
+    rk[7] = expandKeyB(rk[5], rk[6]);
+    rk[8] = expandKeyA(rk[6], _mm_aeskeygenassist_si128(rk[7], 0x08));
+    rk[9] = expandKeyB(rk[7], rk[8]);
+    rk[10] = expandKeyA(rk[8], _mm_aeskeygenassist_si128(rk[9], 0x10));
+    rk[11] = expandKeyB(rk[9], rk[10]);
+    rk[12] = expandKeyA(rk[10], _mm_aeskeygenassist_si128(rk[11], 0x20));
+    rk[13] = expandKeyB(rk[11], rk[12]);
+    rk[14] = expandKeyA(rk[12], _mm_aeskeygenassist_si128(rk[13], 0x40));
+}
+
+// Encrypts count blocks in place, eight at a time so that the latency of each
+// AESENC is hidden behind the others.
+KERNEL static inline void encryptBlocks(const __m128i *rk, __m128i *blocks, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i b0 = _mm_xor_si128(blocks[i + 0], rk[0]);
+        __m128i b1 = _mm_xor_si128(blocks[i + 1], rk[0]);
+        __m128i b2 = _mm_xor_si128(blocks[i + 2], rk[0]);
+        __m128i b3 = _mm_xor_si128(blocks[i + 3], rk[0]);
+        __m128i b4 = _mm_xor_si128(blocks[i + 4], rk[0]);
+        __m128i b5 = _mm_xor_si128(blocks[i + 5], rk[0]);
+        __m128i b6 = _mm_xor_si128(blocks[i + 6], rk[0]);
+        __m128i b7 = _mm_xor_si128(blocks[i + 7], rk[0]);
+        for (int r = 1; r < 14; r++) {
+            b0 = _mm_aesenc_si128(b0, rk[r]);
+            b1 = _mm_aesenc_si128(b1, rk[r]);
+            b2 = _mm_aesenc_si128(b2, rk[r]);
+            b3 = _mm_aesenc_si128(b3, rk[r]);
+            b4 = _mm_aesenc_si128(b4, rk[r]);
+            b5 = _mm_aesenc_si128(b5, rk[r]);
+            b6 = _mm_aesenc_si128(b6, rk[r]);
+            b7 = _mm_aesenc_si128(b7, rk[r]);
+        }
+        blocks[i + 0] = _mm_aesenclast_si128(b0, rk[14]);
+        blocks[i + 1] = _mm_aesenclast_si128(b1, rk[14]);
+        blocks[i + 2] = _mm_aesenclast_si128(b2, rk[14]);
+        blocks[i + 3] = _mm_aesenclast_si128(b3, rk[14]);
+        blocks[i + 4] = _mm_aesenclast_si128(b4, rk[14]);
+        blocks[i + 5] = _mm_aesenclast_si128(b5, rk[14]);
+        blocks[i + 6] = _mm_aesenclast_si128(b6, rk[14]);
+        blocks[i + 7] = _mm_aesenclast_si128(b7, rk[14]);
+    }
+    for (; i < count; i++) {
+        __m128i b = _mm_xor_si128(blocks[i], rk[0]);
+        for (int r = 1; r < 14; r++) {
+            b = _mm_aesenc_si128(b, rk[r]);
+        }
+        blocks[i] = _mm_aesenclast_si128(b, rk[14]);
+    }
+}
+
+// Accumulates the unreduced 256-bit carry-less product of a and b.
+KERNEL static inline void clmulAccumulate(__m128i a, __m128i b,
+        __m128i &lo, __m128i &mid, __m128i &hi) {
+    lo = _mm_xor_si128(lo, _mm_clmulepi64_si128(a, b, 0x00));
+    hi = _mm_xor_si128(hi, _mm_clmulepi64_si128(a, b, 0x11));
+    mid = _mm_xor_si128(mid, _mm_clmulepi64_si128(a, b, 0x01));
+    mid = _mm_xor_si128(mid, _mm_clmulepi64_si128(a, b, 0x10));
+}
+
+// Reduces an accumulated product modulo the GCM polynomial, in the
+// byte-reflected representation. See the Intel carry-less multiplication
+// white paper (Gueron and Kounavis).
+KERNEL static inline __m128i reduce(__m128i lo, __m128i mid, __m128i hi) {
+    lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+    hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+    // Shift the 256-bit product left by one bit.
+    __m128i lo_carry = _mm_srli_epi32(lo, 31);
+    __m128i hi_carry = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    __m128i cross = _mm_srli_si128(lo_carry, 12);
+    hi_carry = _mm_slli_si128(hi_carry, 4);
+    lo_carry = _mm_slli_si128(lo_carry, 4);
+    lo = _mm_or_si128(lo, lo_carry);
+    hi = _mm_or_si128(hi, hi_carry);
+    hi = _mm_or_si128(hi, cross);
+
+    // Reduce.
+    __m128i a = _mm_slli_epi32(lo, 31);
+    a = _mm_xor_si128(a, _mm_slli_epi32(lo, 30));
+    a = _mm_xor_si128(a, _mm_slli_epi32(lo, 25));
+    __m128i b = _mm_srli_si128(a, 4);
+    lo = _mm_xor_si128(lo, _mm_slli_si128(a, 12));
+    __m128i c = _mm_srli_epi32(lo, 1);
+    c = _mm_xor_si128(c, _mm_srli_epi32(lo, 2));
+    c = _mm_xor_si128(c, _mm_srli_epi32(lo, 7));
+    c = _mm_xor_si128(c, b);
+    lo = _mm_xor_si128(lo, c);
+    return _mm_xor_si128(hi, lo);
+}
+
+KERNEL static inline __m128i gfmul(__m128i a, __m128i b) {
+    __m128i lo = _mm_setzero_si128(), mid = _mm_setzero_si128(), hi = _mm_setzero_si128();
+    clmulAccumulate(a, b, lo, mid, hi);
+    return reduce(lo, mid, hi);
+}
+
+// XORs the keystream into in, writing to out.
+KERNEL static inline void applyKeystream(const __m128i *keystream, const unsigned char *in,
+        unsigned char *out, size_t length) {
+    for (; length >= 16; in += 16, out += 16, length -= 16, keystream++) {
+        _mm_storeu_si128((__m128i *)out,
+                _mm_xor_si128(*keystream, _mm_loadu_si128((const __m128i *)in)));
+    }
+    if (length > 0) {
+        storePartial(out, _mm_xor_si128(*keystream, loadPartial(in, length)), length);
+    }
+}
+
+// UniversalHash accumulates blocks, and folds every eight blocks into the
+// running hash with a single reduction:
+//   Y' = (Y + X1)H^n + X2H^(n-1) + ... + XnH
+//
+// The arithmetic is that of GHASH on byte-reflected blocks. POLYVAL, used by
+// AES-GCM-SIV, is the same computation on blocks as loaded, given H^1 through
+// H^8 derived from mulX_GHASH(ByteReverse(H)); see RFC 8452, Appendix A.
+template <bool Reflect>
+class UniversalHash {
+    private:
+        const __m128i *h; // H^1 through H^8
+        __m128i y;
+        __m128i pending[8];
+        size_t count;
+
+        KERNEL void fold() {
+            __m128i lo = _mm_setzero_si128(), mid = _mm_setzero_si128(), hi = _mm_setzero_si128();
+            pending[0] = _mm_xor_si128(pending[0], y);
+            for (size_t i = 0; i < count; i++) {
+                clmulAccumulate(pending[i], h[count - 1 - i], lo, mid, hi);
+            }
+            y = reduce(lo, mid, hi);
+            count = 0;
+        }
+
+        KERNEL static inline __m128i load(__m128i block) {
+            return Reflect ? bswap(block) : block;
+        }
+
+    public:
+        KERNEL UniversalHash(const __m128i *h): h(h), y(_mm_setzero_si128()), count(0) {}
+
+        KERNEL inline void update(__m128i reflected_block) {
+            pending[count++] = reflected_block;
+            if (count == 8) {
+                fold();
+            }
+        }
+
+        KERNEL void update(const unsigned char *data, size_t length) {
+            for (; length >= 16; data += 16, length -= 16) {
+                update(load(_mm_loadu_si128((const __m128i *)data)));
+            }
+            if (length > 0) {
+                update(load(loadPartial(data, length)));
+            }
+        }
+
+        // Absorbs prefix || data, where prefix is at most 16 bytes long.
+        KERNEL void update(const unsigned char *prefix, size_t prefix_length,
+                const unsigned char *data, size_t length) {
+            if (prefix_length == 0) {
+                update(data, length);
+                return;
+            }
+            CRYPTO_ALIGN(16) unsigned char block[16];
+            size_t head = 16 - prefix_length < length ? 16 - prefix_length : length;
+            memcpy(block, prefix, prefix_length);
+            memcpy(block + prefix_length, data, head);
+            update(block, prefix_length + head);
+            update(data + head, length - head);
+        }
+
+        // Returns the hash of the message after absorbing the length block.
+        // For GHASH this is the unmasked tag; for POLYVAL the S_s of RFC 8452
+        // before it is combined with the nonce.
+        KERNEL __m128i final(size_t ad_length, size_t length) {
+            if (Reflect) {
+                update(_mm_set_epi64x((long long)ad_length * 8, (long long)length * 8));
+            } else {
+                update(_mm_set_epi64x((long long)length * 8, (long long)ad_length * 8));
+            }
+            if (count > 0) {
+                fold();
+            }
+            return load(y);
+        }
+};
+
+typedef UniversalHash<true> GHASH;
+typedef UniversalHash<false> POLYVAL;
+
+#endif /* AESGCMKERNEL_H_INCLUDED */
@@ -0,0 +1,142 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "AESGCMKeyCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <pthread.h>
+#include <sys/stat.h>
+
+// KeyFileIdentity identifies the contents of a key file without reading it.
+struct KeyFileIdentity {
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    time_t mtime_sec;
+    long mtime_nsec;
+
+    explicit KeyFileIdentity(const struct stat &st)
+        : dev(st.st_dev), ino(st.st_ino), size(st.st_size),
+          mtime_sec(st.st_mtim.tv_sec), mtime_nsec(st.st_mtim.tv_nsec) {}
+
+    bool operator==(const KeyFileIdentity &other) const {
+        return dev == other.dev && ino == other.ino && size == other.size &&
+            mtime_sec == other.mtime_sec && mtime_nsec == other.mtime_nsec;
+    }
+};
+
+struct KeyCacheEntry {
+    AESGCMKeyring keyring;
+    KeyFileIdentity identity;
+    unsigned int refs;
+    // Set once the entry has been replaced by a newer version of the file. A
+    // stale entry is deleted when its last reference is released.
+    bool stale;
+
+    explicit KeyCacheEntry(const KeyFileIdentity &identity)
+        : identity(identity), refs(0), stale(false) {}
+};
+
+typedef std::map<std::string, KeyCacheEntry *> KeyCacheMap;
+
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static KeyCacheMap cache;
+
+// Holds cache_mutex for the lifetime of the object.
+class CacheLock {
+    public:
+        CacheLock() { pthread_mutex_lock(&cache_mutex); }
+        ~CacheLock() { pthread_mutex_unlock(&cache_mutex); }
+};
+
+// readKeyFile reads the keyring stored in the file at key_path from the local
+// filesystem into entry, which is allocated on success. The identity of the
+// entry is taken from the opened file so that it always describes the
+// contents which were read.
+static bool readKeyFile(const std::string &key_path, KeyCacheEntry *&entry) {
+    FILE *key_file = fopen(key_path.c_str(), "r");
+    if (key_file == NULL) {
+        return false;
+    }
+
+    struct stat st;
+    entry = NULL;
+    if (fstat(fileno(key_file), &st) == 0) {
+        entry = new KeyCacheEntry(KeyFileIdentity(st));
+        if (!entry->keyring.read(key_file)) {
+            delete entry;
+            entry = NULL;
+        }
+    }
+
+    fclose(key_file);
+    return entry != NULL;
+}
+
+const AESGCMKeyring *AESGCMKeyCache::acquire(const std::string &key_path) {
+    struct stat st;
+    if (stat(key_path.c_str(), &st) == 0) {
+        CacheLock lock;
+        KeyCacheMap::iterator it = cache.find(key_path);
+        if (it != cache.end() && it->second->identity == KeyFileIdentity(st)) {
+            it->second->refs++;
+            return &it->second->keyring;
+        }
+    }
+
+    // Read and expand the keys without holding the lock.
+    KeyCacheEntry *entry = NULL;
+    if (!readKeyFile(key_path, entry)) {
+        return NULL;
+    }
+    entry->refs = 1;
+
+    CacheLock lock;
+    KeyCacheMap::iterator it = cache.find(key_path);
+    if (it != cache.end()) {
+        KeyCacheEntry *old = it->second;
+        if (old->refs == 0) {
+            delete old;
+        } else {
+            old->stale = true;
+        }
+        it->second = entry;
+    } else {
+        cache[key_path] = entry;
+    }
+    return &entry->keyring;
+}
+
+void AESGCMKeyCache::release(const AESGCMKeyring *keyring) {
+    if (keyring == NULL) {
+        return;
+    }
+
+    // keyring is the first member of its entry.
+    KeyCacheEntry *entry =
+        reinterpret_cast<KeyCacheEntry *>(const_cast<AESGCMKeyring *>(keyring));
+
+    CacheLock lock;
+    if (--entry->refs == 0 && entry->stale) {
+        delete entry;
+    }
+}
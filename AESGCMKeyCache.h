@@ -0,0 +1,49 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef AESGCMKEYCACHE_H_INCLUDED
+#define AESGCMKEYCACHE_H_INCLUDED
+
+#include "AESGCMKeyring.h"
+
+#include <string>
+
+// AESGCMKeyCache is a process-wide, thread-safe cache of expanded keyrings
+// read from key files. Entries are identified by the key path together with the
+// device, inode, size and modification time of the file, so that a rotated key
+// file (replaced or rewritten in place) is read again rather than served from
+// the cache. On a hit no file is opened and no key expansion is performed.
+//
+// Entries are reference counted. A keyring returned by acquire remains valid
+// until it is passed to release, even if the key file is rotated in the
+// meantime.
+class AESGCMKeyCache {
+    public:
+        // Returns the expanded keyring stored in the file at key_path,
+        // reading it only if it is not already cached. Returns NULL if the
+        // file cannot be read or is malformed. sodium_init must have been
+        // called.
+        static const AESGCMKeyring *acquire(const std::string &key_path);
+
+        // Releases a keyring returned by acquire. NULL is ignored.
+        static void release(const AESGCMKeyring *keyring);
+};
+
+#endif /* AESGCMKEYCACHE_H_INCLUDED */
@@ -0,0 +1,277 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "AESGCMKeyring.h"
+
+#include <cstdlib>
+#include <cstring>
+
+const char AESGCMKey::deterministic_label[] = "AESGCM deterministic encryption";
+const char AESGCMKey::tenant_label[] = "AESGCM tenant subkeys";
+const char AESGCMKey::aegis_label[] = "AESGCM AEGIS-256";
+const char AESGCMKey::xchacha_label[] = "AESGCM XChaCha20-Poly1305";
+
+AESGCMKey::~AESGCMKey() {
+    sodium_memzero(&crypto_ctx, sizeof(crypto_ctx));
+    sodium_memzero(tenant_prk, sizeof(tenant_prk));
+    sodium_memzero(xchacha_key, sizeof(xchacha_key));
+}
+
+void AESGCMKey::init(const unsigned char key[crypto_aead_aes256gcm_KEYBYTES]) {
+    AESGCMEngine::Type best = AESGCMEngine::detect();
+    crypto_auth_hmacsha256(tenant_prk,
+            (const unsigned char *)tenant_label, strlen(tenant_label), key);
+    crypto_auth_hmacsha256(xchacha_key,
+            (const unsigned char *)xchacha_label, strlen(xchacha_label), key);
+    bitsliced.init(key);
+    if (best >= AESGCMEngine::VAES256) {
+        wide.init(key);
+    }
+    if (best >= AESGCMEngine::AESNI) {
+        crypto_aead_aes256gcm_beforenm(&crypto_ctx, key);
+        multi_buffer.init(key);
+
+        unsigned char key_generating_key[crypto_auth_hmacsha256_BYTES];
+        static const unsigned char nonce[AESGCMSIV::nonce_length] = {0};
+        crypto_auth_hmacsha256(key_generating_key,
+                (const unsigned char *)deterministic_label, strlen(deterministic_label), key);
+        deterministic.init(key_generating_key, nonce);
+        sodium_memzero(key_generating_key, sizeof(key_generating_key));
+
+        unsigned char aegis_key[AESGCMAegis::key_length];
+        crypto_auth_hmacsha256(aegis_key,
+                (const unsigned char *)aegis_label, strlen(aegis_label), key);
+        aegis.init(aegis_key);
+        sodium_memzero(aegis_key, sizeof(aegis_key));
+    }
+}
+
+void AESGCMKey::initGCM(const unsigned char key[crypto_aead_aes256gcm_KEYBYTES],
+        AESGCMEngine::Type engine) {
+    if (engine >= AESGCMEngine::VAES256) {
+        wide.init(key);
+    }
+    if (engine >= AESGCMEngine::AESNI) {
+        crypto_aead_aes256gcm_beforenm(&crypto_ctx, key);
+        multi_buffer.init(key);
+    } else {
+        bitsliced.init(key);
+    }
+}
+
+void AESGCMKey::encrypt(AESGCMEngine::Type engine, unsigned char *c,
+        const unsigned char *m, size_t mlen,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES]) const {
+    switch (engine) {
+        case AESGCMEngine::VAES512:
+            wide.encrypt(AESGCMWide::ZMM, c, m, mlen, ad, ad_length, nonce);
+            break;
+        case AESGCMEngine::VAES256:
+            wide.encrypt(AESGCMWide::YMM, c, m, mlen, ad, ad_length, nonce);
+            break;
+        case AESGCMEngine::AESNI:
+            crypto_aead_aes256gcm_encrypt_afternm(
+                    c, NULL,
+                    m, mlen,
+                    ad, ad_length,
+                    NULL, // unused, always NULL
+                    nonce, &crypto_ctx);
+            break;
+        case AESGCMEngine::BITSLICED:
+            bitsliced.encrypt(c, m, mlen, ad, ad_length, nonce);
+            break;
+    }
+}
+
+int AESGCMKey::decrypt(AESGCMEngine::Type engine, unsigned char *m,
+        const unsigned char *c, size_t clen,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES]) const {
+    if (clen < crypto_aead_aes256gcm_ABYTES) {
+        return -1;
+    }
+    size_t mlen = clen - crypto_aead_aes256gcm_ABYTES;
+    switch (engine) {
+        case AESGCMEngine::VAES512:
+            return wide.decrypt(AESGCMWide::ZMM, m, c, mlen, ad, ad_length, nonce);
+        case AESGCMEngine::VAES256:
+            return wide.decrypt(AESGCMWide::YMM, m, c, mlen, ad, ad_length, nonce);
+        case AESGCMEngine::AESNI:
+            return crypto_aead_aes256gcm_decrypt_afternm(
+                    m, NULL,
+                    NULL, // unused, always NULL
+                    c, clen,
+                    ad, ad_length,
+                    nonce, &crypto_ctx) == 0 ? 0 : -1;
+        case AESGCMEngine::BITSLICED:
+            return bitsliced.decrypt(m, c, mlen, ad, ad_length, nonce);
+    }
+    return -1;
+}
+
+void AESGCMKey::encrypt(AESGCMAlgorithm::Type algorithm, AESGCMEngine::Type engine,
+        unsigned char *c, const unsigned char *m, size_t mlen,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char *nonce) const {
+    switch (algorithm) {
+        case AESGCMAlgorithm::AES256GCM:
+            encrypt(engine, c, m, mlen, ad, ad_length, nonce);
+            break;
+        case AESGCMAlgorithm::AEGIS256:
+            aegis.encrypt(c, m, mlen, ad, ad_length, nonce, c + mlen);
+            break;
+        case AESGCMAlgorithm::XCHACHA20POLY1305:
+            crypto_aead_xchacha20poly1305_ietf_encrypt(
+                    c, NULL,
+                    m, mlen,
+                    ad, ad_length,
+                    NULL, // unused, always NULL
+                    nonce, xchacha_key);
+            break;
+    }
+}
+
+int AESGCMKey::decrypt(AESGCMAlgorithm::Type algorithm, AESGCMEngine::Type engine,
+        unsigned char *m, const unsigned char *c, size_t clen,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char *nonce) const {
+    switch (algorithm) {
+        case AESGCMAlgorithm::AES256GCM:
+            return decrypt(engine, m, c, clen, ad, ad_length, nonce);
+        case AESGCMAlgorithm::AEGIS256:
+            if (clen < AESGCMAegis::tag_length || AESGCMEngine::detect() < AESGCMEngine::AESNI) {
+                return -1;
+            }
+            return aegis.decrypt(m, c, clen - AESGCMAegis::tag_length, ad, ad_length,
+                    nonce, c + clen - AESGCMAegis::tag_length);
+        case AESGCMAlgorithm::XCHACHA20POLY1305:
+            return crypto_aead_xchacha20poly1305_ietf_decrypt(
+                    m, NULL,
+                    NULL, // unused, always NULL
+                    c, clen,
+                    ad, ad_length,
+                    nonce, xchacha_key) == 0 ? 0 : -1;
+    }
+    return -1;
+}
+
+void AESGCMKey::deriveTenantKey(const unsigned char *tenant_id, size_t tenant_id_length,
+        unsigned char subkey[crypto_aead_aes256gcm_KEYBYTES]) const {
+    // A single block of HKDF-Expand output: HMAC(PRK, info || 0x01).
+    static const unsigned char counter = 1;
+    crypto_auth_hmacsha256_state state;
+    crypto_auth_hmacsha256_init(&state, tenant_prk, sizeof(tenant_prk));
+    crypto_auth_hmacsha256_update(&state, tenant_id, tenant_id_length);
+    crypto_auth_hmacsha256_update(&state, &counter, 1);
+    crypto_auth_hmacsha256_final(&state, subkey);
+    sodium_memzero(&state, sizeof(state));
+}
+
+AESGCMKeyring::AESGCMKeyring()
+    : has_key_ids(false), encryption_key_id(0), legacy_key_id(0) {
+    memset(keys, 0, sizeof(keys));
+}
+
+AESGCMKeyring::~AESGCMKeyring() {
+    for (int i = 0; i < max_keys; i++) {
+        delete keys[i];
+    }
+}
+
+// parseKey decodes a 256-bit key stored as hexadecimal ASCII (i.e. using only
+// characters 0-9a-fA-F) into key_out. Returns true if exactly 256 bits were
+// decoded.
+static bool parseKey(const char *key_hex,
+        unsigned char key_out[crypto_aead_aes256gcm_KEYBYTES]) {
+    size_t key_length = 0;
+    return sodium_hex2bin(key_out, crypto_aead_aes256gcm_KEYBYTES, key_hex, strlen(key_hex),
+            NULL, &key_length, NULL) == 0 &&
+        key_length == crypto_aead_aes256gcm_KEYBYTES;
+}
+
+// parseKeyId parses a decimal key ID between 0 and 255.
+static bool parseKeyId(const char *s, unsigned char &key_id) {
+    char *end = NULL;
+    long id = strtol(s, &end, 10);
+    if (*s == '\0' || *end != '\0' || id < 0 || id >= AESGCMKeyring::max_keys) {
+        return false;
+    }
+    key_id = (unsigned char)id;
+    return true;
+}
+
+bool AESGCMKeyring::read(FILE *key_file) {
+    // Each "byte" of key is two bytes of hex, plus a NULL-terminating
+    // character. Longer lines are malformed.
+    char line[(crypto_aead_aes256gcm_KEYBYTES * 2) + 16];
+    char first[sizeof(line)], second[sizeof(line)], extra[sizeof(line)];
+    unsigned char key[crypto_aead_aes256gcm_KEYBYTES];
+    int key_count = 0;
+    bool ok = true;
+
+    while (ok && fgets(line, sizeof(line), key_file) != NULL) {
+        if (strchr(line, '\n') == NULL && !feof(key_file)) {
+            ok = false;
+            break;
+        }
+
+        int fields = sscanf(line, "%s %s %s", first, second, extra);
+        if (fields <= 0 || first[0] == '#') {
+            continue;
+        }
+
+        unsigned char key_id = 0;
+        if (fields == 1) {
+            // A single key without an ID.
+            ok = key_count == 0 && parseKey(first, key);
+            has_key_ids = false;
+        } else if (fields == 2) {
+            ok = (key_count == 0 || has_key_ids) &&
+                parseKeyId(first, key_id) &&
+                keys[key_id] == NULL &&
+                parseKey(second, key);
+            has_key_ids = true;
+        } else {
+            ok = false;
+        }
+
+        if (ok) {
+            keys[key_id] = new AESGCMKey();
+            keys[key_id]->init(key);
+            if (key_count == 0 || key_id > encryption_key_id) {
+                encryption_key_id = key_id;
+            }
+            if (key_count == 0 || key_id < legacy_key_id) {
+                legacy_key_id = key_id;
+            }
+            key_count++;
+        }
+    }
+
+    sodium_memzero(line, sizeof(line));
+    sodium_memzero(first, sizeof(first));
+    sodium_memzero(second, sizeof(second));
+    sodium_memzero(extra, sizeof(extra));
+    sodium_memzero(key, sizeof(key));
+
+    // A single key without an ID must be the only line.
+    return ok && key_count > 0 && (has_key_ids || key_count == 1);
+}
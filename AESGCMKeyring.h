@@ -0,0 +1,173 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef AESGCMKEYRING_H_INCLUDED
+#define AESGCMKEYRING_H_INCLUDED
+
+#include "AESGCMAegis.h"
+#include "AESGCMAlgorithm.h"
+#include "AESGCMBitsliced.h"
+#include "AESGCMEngine.h"
+#include "AESGCMMultiBuffer.h"
+#include "AESGCMSIV.h"
+#include "AESGCMWide.h"
+
+#include <sodium.h>
+
+#include <cstdio>
+
+// AESGCMKey holds the expanded forms of a single 256-bit key, ready for use by
+// each engine the CPU supports (see AESGCMEngine), by AESGCMMultiBuffer and
+// AESGCMSIV (when available), and by each other AESGCMAlgorithm.
+struct AESGCMKey {
+    crypto_aead_aes256gcm_state crypto_ctx;
+    AESGCMMultiBuffer multi_buffer;
+    AESGCMWide wide;
+    AESGCMBitsliced bitsliced;
+
+    // AES-256-GCM-SIV with the all-zero nonce, keyed with a key derived
+    // from this one (see deterministic_label), for deterministic encryption.
+    AESGCMSIV deterministic;
+
+    // The HMAC-SHA256 message which derives the key-generating key of
+    // deterministic from the key, so that it is independent of the key used
+    // for AES-GCM.
+    static const char deterministic_label[];
+
+    // The pseudorandom key from which the subkeys of tenants are expanded
+    // (see deriveTenantKey), derived from the key with the HMAC-SHA256
+    // message tenant_label.
+    unsigned char tenant_prk[crypto_auth_hmacsha256_BYTES];
+
+    static const char tenant_label[];
+
+    // AEGIS-256 (when AES-NI is available) and XChaCha20-Poly1305, keyed
+    // with keys derived from this one with the HMAC-SHA256 messages
+    // aegis_label and xchacha_label.
+    AESGCMAegis aegis;
+    unsigned char xchacha_key[crypto_aead_xchacha20poly1305_ietf_KEYBYTES];
+
+    static const char aegis_label[];
+    static const char xchacha_label[];
+
+    ~AESGCMKey();
+
+    // Expands key for every engine up to AESGCMEngine::detect(), into
+    // multi_buffer, deterministic and aegis when AES-NI is available, and
+    // derives the keys of the other algorithms.
+    void init(const unsigned char key[crypto_aead_aes256gcm_KEYBYTES]);
+
+    // Expands key for AES-GCM with engine only: into crypto_ctx and
+    // multi_buffer with AES-NI, wide as well with the VAES engines, and
+    // bitsliced otherwise. Only encrypt and decrypt of AES256GCM with engine
+    // (or multi_buffer, with AES-NI) may be used. Subkeys of tenants are
+    // expanded this way, as they are expanded often and used for nothing
+    // else.
+    void initGCM(const unsigned char key[crypto_aead_aes256gcm_KEYBYTES],
+            AESGCMEngine::Type engine);
+
+    // Encrypts mlen bytes of m to c, followed by the tag, with engine (at
+    // most AESGCMEngine::detect()), as crypto_aead_aes256gcm_encrypt_afternm.
+    void encrypt(AESGCMEngine::Type engine, unsigned char *c,
+            const unsigned char *m, size_t mlen,
+            const unsigned char *ad, size_t ad_length,
+            const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES]) const;
+
+    // Verifies and decrypts clen bytes of c, the ciphertext followed by the
+    // tag, to m with engine, as crypto_aead_aes256gcm_decrypt_afternm.
+    // Returns 0 if verified, or -1 otherwise.
+    int decrypt(AESGCMEngine::Type engine, unsigned char *m,
+            const unsigned char *c, size_t clen,
+            const unsigned char *ad, size_t ad_length,
+            const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES]) const;
+
+    // As encrypt and decrypt, with algorithm. The nonce is
+    // AESGCMAlgorithm::nonceLength(algorithm) bytes and the tag
+    // tagLength(algorithm) bytes; engine only applies to AES256GCM.
+    // Decryption with AEGIS256 fails without AES-NI.
+    void encrypt(AESGCMAlgorithm::Type algorithm, AESGCMEngine::Type engine,
+            unsigned char *c, const unsigned char *m, size_t mlen,
+            const unsigned char *ad, size_t ad_length,
+            const unsigned char *nonce) const;
+
+    int decrypt(AESGCMAlgorithm::Type algorithm, AESGCMEngine::Type engine,
+            unsigned char *m, const unsigned char *c, size_t clen,
+            const unsigned char *ad, size_t ad_length,
+            const unsigned char *nonce) const;
+
+    // Derives the subkey of the tenant with the given ID from this key, with
+    // HKDF-Expand (RFC 5869) of tenant_prk using the ID as info. Subkeys of
+    // distinct tenants are independent of each other and of this key.
+    void deriveTenantKey(const unsigned char *tenant_id, size_t tenant_id_length,
+            unsigned char subkey[crypto_aead_aes256gcm_KEYBYTES]) const;
+};
+
+// AESGCMKeyring is the set of keys read from a key file. A key file contains
+// either a single key, or one key per line preceded by a numeric key ID
+// (0-255):
+//
+//   # Comments and blank lines are ignored.
+//   1 4145533235364b65792d33324368617261637465727331323334353637383930
+//   2 0b1c2b5d4bd3c2e1ac0b3e1f8d2d63aa3b5a6d4b8e1a5f9c0d2e3f4a5b6c7d8e
+//
+// With a single key, values are encrypted without a header, as they always
+// have been. With key IDs, values are encrypted with the key with the highest
+// ID and prefixed with an AESGCMHeader naming it. Values without a header are
+// decrypted with the key with the lowest ID, which allows a key file to be
+// turned into a keyring by prefixing its key with an ID.
+//
+// Every key is expanded when the keyring is read, so that looking up the key
+// for a value is a single table access.
+class AESGCMKeyring {
+    public:
+        static const int max_keys = 256;
+
+        AESGCMKeyring();
+        ~AESGCMKeyring();
+
+        // Reads and expands the keys in key_file. Returns false if the file
+        // is malformed.
+        bool read(FILE *key_file);
+
+        // True if keys were given IDs, i.e. values are encrypted with a
+        // header.
+        bool hasKeyIds() const { return has_key_ids; }
+
+        // The key (and its ID) used for encryption.
+        const AESGCMKey *encryptionKey() const { return keys[encryption_key_id]; }
+        unsigned char encryptionKeyId() const { return encryption_key_id; }
+
+        // The key used to decrypt values without a header.
+        const AESGCMKey *legacyKey() const { return keys[legacy_key_id]; }
+
+        // Returns the key with the given ID, or NULL.
+        const AESGCMKey *find(unsigned char key_id) const { return keys[key_id]; }
+
+    private:
+        AESGCMKey *keys[max_keys];
+        bool has_key_ids;
+        unsigned char encryption_key_id;
+        unsigned char legacy_key_id;
+
+        AESGCMKeyring(const AESGCMKeyring &);
+        AESGCMKeyring &operator=(const AESGCMKeyring &);
+};
+
+#endif /* AESGCMKEYRING_H_INCLUDED */
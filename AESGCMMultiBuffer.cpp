@@ -0,0 +1,188 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "AESGCMMultiBuffer.h"
+
+#include <sodium.h>
+#include <cstring>
+
+AESGCMMultiBuffer::AESGCMMultiBuffer() {
+    memset(round_keys, 0, sizeof(round_keys));
+    memset(h_powers, 0, sizeof(h_powers));
+}
+
+AESGCMMultiBuffer::~AESGCMMultiBuffer() {
+    sodium_memzero(round_keys, sizeof(round_keys));
+    sodium_memzero(h_powers, sizeof(h_powers));
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "AESGCMKernel.h"
+
+#include <cpuid.h>
+
+// The number of counter blocks which may be generated for a single batch:
+// one for the tag mask and one per 16 bytes of each message.
+#define MAX_COUNTER_BLOCKS \
+    (AESGCMMultiBuffer::max_messages * (AESGCMMultiBuffer::max_length / 16 + 2))
+
+bool AESGCMMultiBuffer::isAvailable() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ecx & bit_AES) && (ecx & bit_PCLMUL) && (ecx & bit_SSSE3) && (ecx & bit_SSE4_1);
+}
+
+KERNEL void AESGCMMultiBuffer::init(const unsigned char key[crypto_aead_aes256gcm_KEYBYTES]) {
+    __m128i *rk = (__m128i *)round_keys;
+    expandKey(key, rk);
+
+    __m128i h = _mm_setzero_si128();
+    encryptBlocks(rk, &h, 1);
+    h = bswap(h);
+
+    __m128i *hp = (__m128i *)h_powers;
+    hp[0] = h;
+    for (int i = 1; i < 8; i++) {
+        hp[i] = gfmul(hp[i - 1], h);
+    }
+}
+
+// Fills blocks with the counter blocks for each message: J0 (used to mask the
+// tag) followed by one block for each 16 bytes of the message. The index of
+// each message's J0 is stored in offsets.
+KERNEL static size_t counterBlocks(const AESGCMMessage *messages, size_t count,
+        __m128i *blocks, size_t *offsets) {
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        CRYPTO_ALIGN(16) unsigned char j0[16] = {0};
+        memcpy(j0, messages[i].nonce, crypto_aead_aes256gcm_NPUBBYTES);
+        __m128i base = _mm_load_si128((const __m128i *)j0);
+
+        offsets[i] = n;
+        size_t nblocks = (messages[i].length + 15) / 16 + 1;
+        for (size_t c = 1; c <= nblocks; c++) {
+            blocks[n++] = _mm_insert_epi32(base, (int)__builtin_bswap32((unsigned int)c), 3);
+        }
+    }
+    return n;
+}
+
+
+KERNEL void AESGCMMultiBuffer::encrypt(AESGCMMessage *messages, size_t count) const {
+    const __m128i *rk = (const __m128i *)round_keys;
+    const __m128i *hp = (const __m128i *)h_powers;
+
+    __m128i blocks[MAX_COUNTER_BLOCKS];
+    size_t offsets[max_messages];
+    size_t n = counterBlocks(messages, count, blocks, offsets);
+    encryptBlocks(rk, blocks, n);
+
+    for (size_t i = 0; i < count; i++) {
+        AESGCMMessage &m = messages[i];
+        applyKeystream(&blocks[offsets[i] + 1], m.in, m.out, m.length);
+
+        GHASH ghash(hp);
+        ghash.update(m.ad_prefix, m.ad_prefix_length, m.ad, m.ad_length);
+        ghash.update(m.out, m.length);
+        __m128i tag = _mm_xor_si128(
+                ghash.final(m.ad_prefix_length + m.ad_length, m.length), blocks[offsets[i]]);
+        _mm_storeu_si128((__m128i *)m.tag, tag);
+    }
+}
+
+KERNEL void AESGCMMultiBuffer::decrypt(AESGCMMessage *messages, size_t count) const {
+    const __m128i *rk = (const __m128i *)round_keys;
+    const __m128i *hp = (const __m128i *)h_powers;
+
+    __m128i blocks[MAX_COUNTER_BLOCKS];
+    size_t offsets[max_messages];
+    size_t n = counterBlocks(messages, count, blocks, offsets);
+    encryptBlocks(rk, blocks, n);
+
+    for (size_t i = 0; i < count; i++) {
+        AESGCMMessage &m = messages[i];
+
+        GHASH ghash(hp);
+        ghash.update(m.ad_prefix, m.ad_prefix_length, m.ad, m.ad_length);
+        ghash.update(m.in, m.length);
+        __m128i tag = _mm_xor_si128(
+                ghash.final(m.ad_prefix_length + m.ad_length, m.length), blocks[offsets[i]]);
+        __m128i diff = _mm_xor_si128(tag, _mm_loadu_si128((const __m128i *)m.tag));
+
+        if (_mm_testz_si128(diff, diff)) {
+            applyKeystream(&blocks[offsets[i] + 1], m.in, m.out, m.length);
+            m.result = 0;
+        } else {
+            memset(m.out, 0, m.length);
+            m.result = -1;
+        }
+    }
+}
+
+KERNEL void AESGCMMultiBuffer::verify(AESGCMMessage *messages, size_t count) const {
+    const __m128i *rk = (const __m128i *)round_keys;
+    const __m128i *hp = (const __m128i *)h_powers;
+
+    // The tag mask of each message is its encrypted J0.
+    __m128i masks[max_messages];
+    for (size_t i = 0; i < count; i++) {
+        CRYPTO_ALIGN(16) unsigned char j0[16] = {0};
+        memcpy(j0, messages[i].nonce, crypto_aead_aes256gcm_NPUBBYTES);
+        j0[15] = 1;
+        masks[i] = _mm_load_si128((const __m128i *)j0);
+    }
+    encryptBlocks(rk, masks, count);
+
+    for (size_t i = 0; i < count; i++) {
+        AESGCMMessage &m = messages[i];
+
+        GHASH ghash(hp);
+        ghash.update(m.ad_prefix, m.ad_prefix_length, m.ad, m.ad_length);
+        ghash.update(m.in, m.length);
+        __m128i tag = _mm_xor_si128(
+                ghash.final(m.ad_prefix_length + m.ad_length, m.length), masks[i]);
+        __m128i diff = _mm_xor_si128(tag, _mm_loadu_si128((const __m128i *)m.tag));
+
+        m.result = _mm_testz_si128(diff, diff) ? 0 : -1;
+    }
+}
+
+#else
+
+bool AESGCMMultiBuffer::isAvailable() {
+    return false;
+}
+
+void AESGCMMultiBuffer::init(const unsigned char key[crypto_aead_aes256gcm_KEYBYTES]) {
+}
+
+void AESGCMMultiBuffer::encrypt(AESGCMMessage *messages, size_t count) const {
+}
+
+void AESGCMMultiBuffer::decrypt(AESGCMMessage *messages, size_t count) const {
+}
+
+void AESGCMMultiBuffer::verify(AESGCMMessage *messages, size_t count) const {
+}
+
+#endif
@@ -0,0 +1,96 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef AESGCMMULTIBUFFER_H_INCLUDED
+#define AESGCMMULTIBUFFER_H_INCLUDED
+
+#include <sodium.h>
+
+#include <stddef.h>
+
+// AESGCMMessage describes a single AES256-GCM message processed as part of a
+// batch by AESGCMMultiBuffer. The output layout matches libsodium's: the
+// ciphertext is the same length as the plaintext and is followed by the tag.
+struct AESGCMMessage {
+    const unsigned char *nonce; // crypto_aead_aes256gcm_NPUBBYTES
+    const unsigned char *in; // plaintext when encrypting, ciphertext when decrypting
+    size_t length; // length of in (and out), excluding the tag
+    const unsigned char *ad_prefix; // authenticated as if prepended to ad
+    size_t ad_prefix_length; // at most 16
+    const unsigned char *ad;
+    size_t ad_length;
+    unsigned char *out; // ciphertext when encrypting, plaintext when decrypting
+    unsigned char *tag; // written when encrypting, verified when decrypting
+    int result; // when decrypting or verifying, 0 if verified or -1 otherwise
+};
+
+// AESGCMMultiBuffer encrypts and decrypts batches of short, independent
+// AES256-GCM messages using AES-NI and PCLMULQDQ. The counter blocks of every
+// message in a batch are encrypted together so that the AES pipeline stays
+// full, and the GHASH of each message is computed with a single reduction per
+// eight blocks. Results are byte-for-byte identical to
+// crypto_aead_aes256gcm_encrypt_afternm and crypto_aead_aes256gcm_decrypt_afternm.
+//
+// For short messages this avoids the per-call setup cost which dominates the
+// single message libsodium functions. Longer messages should continue to use
+// libsodium.
+class AESGCMMultiBuffer {
+    public:
+        // The maximum number of messages in a batch.
+        static const size_t max_messages = 8;
+        // The maximum length of a message in a batch.
+        static const size_t max_length = 1024;
+        // The maximum length of a message worth batching when the engine is
+        // at least AESGCMEngine::VAES256. The single-value AESGCMWide path
+        // is faster for longer messages (see the microbench crossover table).
+        static const size_t max_wide_length = 128;
+
+        AESGCMMultiBuffer();
+        ~AESGCMMultiBuffer();
+
+        // Returns true if the CPU supports the instructions required. Must
+        // be checked before calling any other member function.
+        static bool isAvailable();
+
+        // Expands the key. Must be called before encrypt or decrypt.
+        void init(const unsigned char key[crypto_aead_aes256gcm_KEYBYTES]);
+
+        // Encrypts count (at most max_messages) messages, each at most
+        // max_length long.
+        void encrypt(AESGCMMessage *messages, size_t count) const;
+
+        // Decrypts count (at most max_messages) messages, each at most
+        // max_length long. The result of each message is set, and the output
+        // of messages which fail verification is zeroed.
+        void decrypt(AESGCMMessage *messages, size_t count) const;
+
+        // Verifies the tags of count (at most max_messages) messages of any
+        // length without decrypting them, setting the result of each. Only
+        // the tag mask is encrypted, and out is not used.
+        void verify(AESGCMMessage *messages, size_t count) const;
+
+    private:
+        // Expanded AES256 round keys.
+        CRYPTO_ALIGN(16) unsigned char round_keys[15][16];
+        // H^1 through H^8 in the byte-reflected form used for GHASH.
+        CRYPTO_ALIGN(16) unsigned char h_powers[8][16];
+};
+
+#endif /* AESGCMMULTIBUFFER_H_INCLUDED */
@@ -0,0 +1,220 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "AESGCMNativeType.h"
+
+#include <cstring>
+
+using namespace Vertica;
+
+static void put64(unsigned char *out, uint64_t v) {
+    for (size_t i = 0; i < sizeof(v); i++) {
+        out[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static uint64_t get64(const unsigned char *in) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < sizeof(v); i++) {
+        v |= (uint64_t)in[i] << (8 * i);
+    }
+    return v;
+}
+
+static void put16(unsigned char *out, uint16_t v) {
+    out[0] = (unsigned char)v;
+    out[1] = (unsigned char)(v >> 8);
+}
+
+static uint16_t get16(const unsigned char *in) {
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+const char *AESGCMNativeType::name(Type type) {
+    switch (type) {
+        case INTEGER:
+            return "INTEGER";
+        case FLOAT:
+            return "FLOAT";
+        case DATE:
+            return "DATE";
+        case TIMESTAMP:
+            return "TIMESTAMP";
+        case NUMERIC:
+            return "NUMERIC";
+    }
+    return "";
+}
+
+size_t AESGCMNativeType::length() const {
+    if (type == NUMERIC) {
+        return numericWords(precision) * sizeof(uint64_t) + 2 * sizeof(uint16_t);
+    }
+    return sizeof(uint64_t);
+}
+
+bool AESGCMNativeType::isPlaintext(const unsigned char *in, size_t length) const {
+    if (type != NUMERIC) {
+        return length == this->length();
+    }
+    if (length < 2 * sizeof(uint16_t)) {
+        return false;
+    }
+    int32_t value_precision = get16(in + length - 2 * sizeof(uint16_t));
+    return value_precision >= 1 && value_precision <= max_precision &&
+        length == numericWords(value_precision) * sizeof(uint64_t) + 2 * sizeof(uint16_t);
+}
+
+void AESGCMNativeType::read(BlockReader &reader, size_t column, unsigned char *out) const {
+    switch (type) {
+        case INTEGER:
+            put64(out, reader.getIntRef(column));
+            break;
+        case FLOAT: {
+            vfloat value = reader.getFloatRef(column);
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            put64(out, bits);
+            break;
+        }
+        case DATE:
+            put64(out, reader.getDateRef(column));
+            break;
+        case TIMESTAMP:
+            put64(out, reader.getTimestampRef(column));
+            break;
+        case NUMERIC: {
+            const VNumeric &value = reader.getNumericRef(column);
+            size_t words = numericWords(precision);
+            for (size_t i = 0; i < words; i++) {
+                put64(out + i * sizeof(uint64_t), value.words[i]);
+            }
+            put16(out + words * sizeof(uint64_t), (uint16_t)precision);
+            put16(out + words * sizeof(uint64_t) + sizeof(uint16_t), (uint16_t)scale);
+            break;
+        }
+    }
+}
+
+bool AESGCMNativeType::write(const unsigned char *in, size_t length,
+        BlockWriter &writer) const {
+    switch (type) {
+        case INTEGER:
+            writer.setInt((vint)get64(in));
+            break;
+        case FLOAT: {
+            uint64_t bits = get64(in);
+            vfloat value;
+            memcpy(&value, &bits, sizeof(value));
+            writer.setFloat(value);
+            break;
+        }
+        case DATE:
+            writer.setDate((DateADT)get64(in));
+            break;
+        case TIMESTAMP:
+            writer.setTimestamp((TimestampADT)get64(in));
+            break;
+        case NUMERIC: {
+            // The value has no more words than the result, as its precision
+            // is no greater; the extra words of the result are its sign.
+            const unsigned char *trailer = in + length - 2 * sizeof(uint16_t);
+            int32_t value_precision = get16(trailer);
+            int32_t value_scale = get16(trailer + sizeof(uint16_t));
+            if (value_scale != scale || value_precision > precision) {
+                return false;
+            }
+            size_t words = numericWords(precision);
+            size_t value_words = numericWords(value_precision);
+            size_t extra = words - value_words;
+            uint64_t sign = (get64(in) >> 63) ? ~(uint64_t)0 : 0;
+            VNumeric &value = writer.getNumericRef();
+            for (size_t i = 0; i < extra; i++) {
+                value.words[i] = sign;
+            }
+            for (size_t i = 0; i < value_words; i++) {
+                value.words[extra + i] = get64(in + i * sizeof(uint64_t));
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+void AESGCMNativeType::writeNull(BlockWriter &writer) const {
+    switch (type) {
+        case INTEGER:
+            writer.setInt(vint_null);
+            break;
+        case FLOAT:
+            writer.setFloat(vfloat_null);
+            break;
+        case DATE:
+            writer.setDate(vint_null);
+            break;
+        case TIMESTAMP:
+            writer.setTimestamp(vint_null);
+            break;
+        case NUMERIC:
+            writer.getNumericRef().setNull();
+            break;
+    }
+}
+
+void AESGCMNativeType::addType(Type type, ColumnTypes &types) {
+    switch (type) {
+        case INTEGER:
+            types.addInt();
+            break;
+        case FLOAT:
+            types.addFloat();
+            break;
+        case DATE:
+            types.addDate();
+            break;
+        case TIMESTAMP:
+            types.addTimestamp();
+            break;
+        case NUMERIC:
+            types.addNumeric();
+            break;
+    }
+}
+
+void AESGCMNativeType::addType(SizedColumnTypes &types) const {
+    switch (type) {
+        case INTEGER:
+            types.addInt();
+            break;
+        case FLOAT:
+            types.addFloat();
+            break;
+        case DATE:
+            types.addDate();
+            break;
+        case TIMESTAMP:
+            // Microseconds, as stored.
+            types.addTimestamp(6);
+            break;
+        case NUMERIC:
+            types.addNumeric(precision, scale);
+            break;
+    }
+}
@@ -0,0 +1,103 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef AESGCMNATIVETYPE_H_INCLUDED
+#define AESGCMNATIVETYPE_H_INCLUDED
+
+#include <Vertica.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+// AESGCMNativeType is the fixed-width plaintext AESGCMEncrypt encrypts for a
+// value of a native type, and the typed decrypt functions (AESGCM_DecryptInt
+// and so on) decrypt back into one:
+//
+//   INTEGER    64-bit two's complement, little endian
+//   FLOAT      IEEE 754 double, little endian
+//   DATE       days since 2000-01-01 as INTEGER
+//   TIMESTAMP  microseconds since 2000-01-01 00:00 as INTEGER
+//   NUMERIC    words | precision (16-bit) | scale (16-bit)
+//
+// where the words of a NUMERIC are the 64-bit words of Vertica's
+// representation, in its order (the most significant first), each little
+// endian. Its precision and scale are kept so that a value is never decrypted
+// into a type with a different scale, which would silently change its
+// magnitude, and so that its number of words is known when it is decrypted
+// into a NUMERIC of greater precision.
+class AESGCMNativeType {
+    public:
+        enum Type {
+            INTEGER,
+            FLOAT,
+            DATE,
+            TIMESTAMP,
+            NUMERIC
+        };
+
+        // Vertica's limit on the precision of a NUMERIC.
+        static const int32_t max_precision = 1024;
+
+        AESGCMNativeType(Type type, int32_t precision = 0, int32_t scale = 0)
+            : type(type), precision(precision), scale(scale) {}
+
+        // Returns the SQL name of type.
+        static const char *name(Type type);
+
+        // Returns the number of 64-bit words of a NUMERIC of precision.
+        static size_t numericWords(int32_t precision) {
+            return precision / 19 + 1;
+        }
+
+        // The length of the plaintext of a value. For a NUMERIC, that of a
+        // value of the precision of the type.
+        size_t length() const;
+
+        // Returns whether in, of length bytes, is the plaintext of a value of
+        // the type: length() bytes long, or for a NUMERIC as long as a value
+        // of the precision recorded in it.
+        bool isPlaintext(const unsigned char *in, size_t length) const;
+
+        // Reads the value in column of the current row of reader, which must
+        // not be NULL, to out, which has room for length bytes.
+        void read(Vertica::BlockReader &reader, size_t column, unsigned char *out) const;
+
+        // Writes the value whose plaintext of length bytes (see isPlaintext)
+        // is in to the current row of writer. A NUMERIC of lower precision is
+        // sign-extended. Returns false, writing nothing, if in is a NUMERIC
+        // whose scale differs or whose precision is greater.
+        bool write(const unsigned char *in, size_t length,
+                Vertica::BlockWriter &writer) const;
+
+        // Writes NULL to the current row of writer.
+        void writeNull(Vertica::BlockWriter &writer) const;
+
+        // Adds the type, without precision or scale, to types.
+        static void addType(Type type, Vertica::ColumnTypes &types);
+
+        // Adds the type to types.
+        void addType(Vertica::SizedColumnTypes &types) const;
+
+        Type type;
+        int32_t precision; // NUMERIC only
+        int32_t scale; // NUMERIC only
+};
+
+#endif /* AESGCMNATIVETYPE_H_INCLUDED */
@@ -0,0 +1,56 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "AESGCMNonce.h"
+
+#include <pthread.h>
+
+static unsigned char base[crypto_aead_aes256gcm_NPUBBYTES];
+// The number of nonces reserved after base.
+static uint64_t reserved = 0;
+static pthread_once_t seed_once = PTHREAD_ONCE_INIT;
+
+// Draws a new base. A forked child would otherwise reserve the same nonces as
+// its parent.
+static void reseed() {
+    randombytes_buf(base, sizeof(base));
+    reserved = 0;
+}
+
+static void seedOnce() {
+    reseed();
+    pthread_atfork(NULL, NULL, reseed);
+}
+
+void AESGCMNonce::reserve(size_t count, unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES]) {
+    pthread_once(&seed_once, seedOnce);
+    add(base, __sync_fetch_and_add(&reserved, (uint64_t)count), nonce);
+}
+
+void AESGCMNonce::add(const unsigned char first[crypto_aead_aes256gcm_NPUBBYTES], uint64_t n,
+        unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES]) {
+    unsigned int carry = 0;
+    for (size_t i = 0; i < crypto_aead_aes256gcm_NPUBBYTES; i++) {
+        carry += first[i] + (unsigned int)(n & 0xff);
+        nonce[i] = (unsigned char)carry;
+        carry >>= 8;
+        n >>= 8;
+    }
+}
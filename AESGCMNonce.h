@@ -0,0 +1,49 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef AESGCMNONCE_H_INCLUDED
+#define AESGCMNONCE_H_INCLUDED
+
+#include <sodium.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+// AESGCMNonce allocates the nonces of the values encrypted in a process. A
+// random 96-bit base is drawn on first use (and again in the child of a
+// fork), and each block reserves a range of consecutive nonces after it with
+// an atomic fetch-and-add, so there is no system call per block, and nonces
+// are unique across every thread and function instance of the process rather
+// than only likely to be.
+//
+// Nonces are 96-bit little endian integers, as incremented by
+// sodium_increment, so a caller reserving count nonces uses the first and
+// increments it after each value.
+class AESGCMNonce {
+    public:
+        // Reserves count nonces, writing the first to nonce.
+        static void reserve(size_t count, unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES]);
+
+        // Writes first + n to nonce, e.g. the nonce n values after first.
+        static void add(const unsigned char first[crypto_aead_aes256gcm_NPUBBYTES], uint64_t n,
+                unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES]);
+};
+
+#endif /* AESGCMNONCE_H_INCLUDED */
@@ -0,0 +1,424 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMFunction.h"
+#include "AESGCMNonce.h"
+
+#include <Vertica.h>
+#include <sodium.h>
+#include <cstring>
+#include <vector>
+
+using namespace Vertica;
+
+// AESGCMReencrypt provides a Vertica Scalar Function which decrypts values
+// written by AESGCMEncrypt and encrypts them again under another key, for key
+// rotation. It is equivalent to AESGCMEncrypt of the result of AESGCMDecrypt,
+// but both keyrings are held by a single instance and the plaintext never
+// leaves it: each value is decrypted into scratch space, encrypted from there
+// into the result, and the scratch is wiped.
+//
+// Values are decrypted with the keyring given by KEY_PATH_PARAM, and
+// encrypted with the encryption key of the keyring given by
+// NEW_KEY_PATH_PARAM, or of the same keyring if it is not given (e.g. once a
+// key has been added to it). Short values are decrypted and encrypted
+// together in batches when the CPU supports it, see AESGCMMultiBuffer.
+// Compressed values stay compressed and rows written by AESGCMEncryptRow stay
+// packed: the payload is encrypted again as it is, and the COMPRESSED and ROW
+// flags are carried over to the new header.
+//
+// The result column type is always a VARBINARY(X), where given an input column
+// VARBINARY(Y), X = Y + 3 if the new keyring has key IDs, allowing for a header
+// to be added, or X = Y otherwise: the header of a value is then never longer
+// than the one it had.
+class AESGCMReencrypt: public AESGCMFunction {
+    private:
+        // PendingRow is a row of the block waiting on a batch to be
+        // decrypted. NULL rows are queued as well so that rows are written in
+        // order once the batch is flushed.
+        struct PendingRow {
+            const unsigned char *value; // NULL for a NULL row
+            size_t value_length;
+            const unsigned char *ad;
+            size_t ad_length;
+            size_t message; // index into batch
+        };
+
+        static const size_t max_pending = 4 * AESGCMMultiBuffer::max_messages;
+
+        PendingRow pending[max_pending];
+        size_t pending_size;
+
+        // Batched values are decrypted into scratch, and encrypted from there
+        // once their result has been allocated.
+        AESGCMMessage batch[AESGCMMultiBuffer::max_messages];
+        size_t batch_size;
+        const AESGCMKey *batch_key;
+        unsigned char scratch[AESGCMMultiBuffer::max_messages][AESGCMMultiBuffer::max_length];
+
+        // Decryption output for values which are not batched.
+        std::vector<unsigned char> plaintext_scratch;
+
+        // The keyring given by NEW_KEY_PATH_PARAM, or NULL to encrypt with
+        // keyring.
+        const AESGCMKeyring *new_keyring;
+
+        // The key values are encrypted with, and the header naming it.
+        const AESGCMKey *new_key;
+        AESGCMHeader new_header;
+
+        // The nonce of the next value encrypted, incremented after each.
+        unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES];
+
+        // Allocates the result of a value with a plaintext of length bytes,
+        // decrypted from a value with the given header flags, and writes its
+        // header and nonce. Returns the start of the result, and sets
+        // header_length.
+        unsigned char *allocResult(VString &result, size_t length, unsigned char flags,
+                size_t &header_length) {
+            AESGCMHeader header = new_header;
+            header.flags |= flags & (AESGCMHeader::COMPRESSED | AESGCMHeader::ROW);
+            header_length = header.length();
+            result.alloc(header_length + length + overhead);
+
+            unsigned char *out = (unsigned char *)result.data();
+            header.encode(out);
+            memcpy(out + header_length, nonce, sizeof(nonce));
+            sodium_increment(nonce, sizeof(nonce));
+            return out;
+        }
+
+        // Decrypts value and encrypts it into result, reporting an error if
+        // the value fails to verify.
+        void reencryptRow(const unsigned char *value, size_t value_length,
+                const unsigned char *ad, size_t ad_length,
+                VString &result) {
+            if (value_length < (size_t)overhead) {
+                vt_report_error(0,
+                        "Ciphertext in column '%s' is too short (%zu) expected at least %zu",
+                        column_name.c_str(),
+                        value_length,
+                        overhead);
+            }
+
+            size_t length = 0;
+            unsigned char flags = 0;
+            plaintext_scratch.resize(value_length - overhead + 1);
+            if (decryptValue(value, value_length, ad, ad_length,
+                        &plaintext_scratch[0], length, ad_scratch, &flags) != 0) {
+                vt_report_error(0, "Failed to verify ciphertext in column '%s'", column_name.c_str());
+            }
+
+            size_t header_length = 0;
+            unsigned char *out = allocResult(result, length, flags, header_length);
+            new_key->encrypt(engine,
+                    out + header_length + crypto_aead_aes256gcm_NPUBBYTES,
+                    &plaintext_scratch[0], length,
+                    prefixAssociatedData(ad_scratch, out, header_length, ad, ad_length),
+                    header_length + ad_length,
+                    out + header_length);
+
+            sodium_memzero(&plaintext_scratch[0], length);
+        }
+
+        // Queues value for batched decryption. Returns false if the value is
+        // not eligible, in which case it must be re-encrypted with
+        // reencryptRow.
+        bool queue(const unsigned char *value, size_t value_length,
+                const unsigned char *ad, size_t ad_length,
+                BlockWriter &res_writer) {
+            AESGCMHeader header;
+            size_t value_header_length = header.decode(value, value_length);
+            const AESGCMKey *key = value_header_length > 0 ? findKey(header) : keyring->legacyKey();
+            if (key == NULL || (header.flags & AESGCMHeader::ALGORITHM) ||
+                    value_length < value_header_length + overhead ||
+                    value_length - value_header_length - overhead > multi_buffer_length) {
+                return false;
+            }
+
+            if (batch_size > 0 && key != batch_key) {
+                flush(res_writer);
+            }
+            batch_key = key;
+
+            size_t length = value_length - value_header_length - overhead;
+            const unsigned char *value_nonce = value + value_header_length;
+
+            AESGCMMessage &message = batch[batch_size];
+            message.nonce = value_nonce;
+            message.in = value_nonce + crypto_aead_aes256gcm_NPUBBYTES;
+            message.length = length;
+            message.ad_prefix = value;
+            message.ad_prefix_length = value_header_length;
+            message.ad = ad;
+            message.ad_length = ad_length;
+            message.out = scratch[batch_size];
+            message.tag = (unsigned char *)message.in + length;
+
+            PendingRow &row = pending[pending_size++];
+            row.value = value;
+            row.value_length = value_length;
+            row.ad = ad;
+            row.ad_length = ad_length;
+            row.message = batch_size++;
+
+            if (batch_size == AESGCMMultiBuffer::max_messages || pending_size == max_pending) {
+                flush(res_writer);
+            }
+            return true;
+        }
+
+        // Queues a NULL row behind any pending rows.
+        void queueNull(BlockWriter &res_writer) {
+            PendingRow &row = pending[pending_size++];
+            row.value = NULL;
+            if (pending_size == max_pending) {
+                flush(res_writer);
+            }
+        }
+
+        // Decrypts the pending batch, writes the pending rows and encrypts
+        // the batch into them.
+        void flush(BlockWriter &res_writer) {
+            AESGCMMessage encrypt_batch[AESGCMMultiBuffer::max_messages];
+            size_t encrypt_size = 0;
+
+            if (batch_size > 0) {
+                batch_key->multi_buffer.decrypt(batch, batch_size);
+            }
+
+            for (size_t i = 0; i < pending_size; i++) {
+                const PendingRow &row = pending[i];
+                VString &result = res_writer.getStringRef();
+                if (row.value == NULL) {
+                    // Re-encrypting NULL returns NULL.
+                    result.setNull();
+                } else if (batch[row.message].result == 0) {
+                    const AESGCMMessage &decrypted = batch[row.message];
+                    size_t header_length = 0;
+                    unsigned char *out = allocResult(result, decrypted.length,
+                            messageFlags(decrypted), header_length);
+
+                    AESGCMMessage &message = encrypt_batch[encrypt_size++];
+                    message.nonce = out + header_length;
+                    message.in = decrypted.out;
+                    message.length = decrypted.length;
+                    message.ad_prefix = out;
+                    message.ad_prefix_length = header_length;
+                    message.ad = row.ad;
+                    message.ad_length = row.ad_length;
+                    message.out = out + header_length + crypto_aead_aes256gcm_NPUBBYTES;
+                    message.tag = message.out + decrypted.length;
+                } else {
+                    // The value may be headerless but look like it has a
+                    // header, or be encrypted with a key other than the one
+                    // tried.
+                    reencryptRow(row.value, row.value_length, row.ad, row.ad_length, result);
+                }
+                res_writer.next();
+            }
+
+            if (encrypt_size > 0) {
+                new_key->multi_buffer.encrypt(encrypt_batch, encrypt_size);
+            }
+            for (size_t i = 0; i < batch_size; i++) {
+                sodium_memzero(scratch[i], batch[i].length);
+            }
+
+            pending_size = 0;
+            batch_size = 0;
+        }
+
+    public:
+        AESGCMReencrypt(): pending_size(0), batch_size(0), batch_key(NULL),
+            new_keyring(NULL), new_key(NULL) {}
+
+        virtual void setup(ServerInterface &srvInterface, const SizedColumnTypes &argTypes) {
+            AESGCMFunction::setup(srvInterface, argTypes);
+
+            if (srvInterface.getParamReader().containsParameter(NEW_KEY_PATH_PARAM)) {
+                new_keyring = acquireKeyring(srvInterface, NEW_KEY_PATH_PARAM);
+            }
+
+            const AESGCMKeyring *encryption_keyring = new_keyring != NULL ? new_keyring : keyring;
+            new_key = encryption_keyring->encryptionKey();
+            new_header = AESGCMHeader();
+            if (encryption_keyring->hasKeyIds()) {
+                new_header.flags |= AESGCMHeader::KEY_ID;
+                new_header.key_id = encryption_keyring->encryptionKeyId();
+            }
+        }
+
+        virtual void destroy(ServerInterface &srvInterface, const SizedColumnTypes &argTypes) {
+            sodium_memzero(scratch, sizeof(scratch));
+            if (!plaintext_scratch.empty()) {
+                sodium_memzero(&plaintext_scratch[0], plaintext_scratch.size());
+            }
+
+            if (new_keyring != NULL) {
+                AESGCMKeyCache::release(new_keyring);
+                new_keyring = NULL;
+            }
+            AESGCMFunction::destroy(srvInterface, argTypes);
+        }
+
+        virtual void processBlock(ServerInterface &srvInterface,
+                BlockReader &arg_reader,
+                BlockWriter &res_writer) {
+            if (arg_reader.getNumCols() < 1 || arg_reader.getNumCols() > 2) {
+                vt_report_error(0, "Function accepts either 1 or 2 arguments, but %zu provided",
+                        arg_reader.getNumCols());
+            }
+
+            // Reserve a nonce for each row of this call. The nonce is
+            // incremented after each encrypt.
+            AESGCMNonce::reserve(arg_reader.getNumRows(), nonce);
+
+            // Short values are queued and re-encrypted together once the
+            // batch is full. The input and output strings of a block remain
+            // valid for the duration of processBlock.
+            pending_size = 0;
+            batch_size = 0;
+
+            do {
+                if (arg_reader.isNull(0)) {
+                    if (pending_size > 0) {
+                        queueNull(res_writer);
+                    } else {
+                        // Re-encrypting NULL returns NULL.
+                        res_writer.getStringRef().setNull();
+                        res_writer.next();
+                    }
+                    continue;
+                }
+
+                VString nonce_and_ciphertext = arg_reader.getStringRef(0);
+                const unsigned char *value = (unsigned char *)nonce_and_ciphertext.data();
+                size_t value_length = nonce_and_ciphertext.length();
+
+                const unsigned char *associated_data = NULL;
+                size_t associated_data_length = 0;
+                if (arg_reader.getNumCols() > 1 && !arg_reader.isNull(1)) {
+                    VString ad = arg_reader.getStringRef(1);
+                    associated_data_length = ad.length();
+                    if (associated_data_length > 0) {
+                        associated_data = (unsigned char *)ad.data();
+                    }
+                }
+
+                if (use_multi_buffer && queue(value, value_length,
+                            associated_data, associated_data_length, res_writer)) {
+                    continue;
+                }
+
+                flush(res_writer);
+                reencryptRow(value, value_length, associated_data, associated_data_length,
+                        res_writer.getStringRef());
+                res_writer.next();
+            } while (arg_reader.next());
+
+            flush(res_writer);
+        }
+};
+
+// Exposes a scalar function taking as input VARBINARY and producing VARBINARY.
+// See AESGCMReencrypt.
+class AESGCMReencryptFactory: public AESGCMFunctionFactory {
+    public:
+        AESGCMReencryptFactory() {
+            // For some given arguments, the results yielded are unique for
+            // the duration of the statement. The nonce generated should be
+            // different each invocation within a statement.
+            vol = VOLATILE;
+        }
+
+        virtual ScalarFunction *createScalarFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMReencrypt);
+        }
+
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarbinary();
+            returnType.addVarbinary();
+        }
+
+        virtual void getReturnType(ServerInterface &server,
+                const SizedColumnTypes &argTypes,
+                SizedColumnTypes &returnType) {
+            const VerticaType &t = argTypes.getColumnType(0);
+            ParamReader paramReader = server.getParamReader();
+            const char *param = paramReader.containsParameter(NEW_KEY_PATH_PARAM) ?
+                NEW_KEY_PATH_PARAM : KEY_PATH_PARAM;
+            returnType.addVarbinary(t.getStringLength() + headerLength(server, 0, param));
+        }
+
+        virtual void getParameterType(ServerInterface &srvInterface,
+                SizedColumnTypes &parameterTypes) {
+            AESGCMFunctionFactory::getParameterType(srvInterface, parameterTypes);
+
+            static const SizedColumnTypes::Properties new_key_props(
+                    true, // Visible
+                    false, // Required
+                    false, // Can be NULL
+                    "Specifies the path to the key or keyring to encrypt with, if other than the one decrypted with." // Comment
+                );
+            parameterTypes.addVarchar(MAX_KEY_PATH, NEW_KEY_PATH_PARAM, new_key_props);
+        }
+
+        virtual void getPerInstanceResources(ServerInterface &srvInterface,
+                VResources &res) {
+            // One file for each of the two keys.
+            res.nFileHandles += 2;
+        }
+};
+
+RegisterFactory(AESGCMReencryptFactory);
+
+// Exposes a scalar function taking as input VARBINARY as well as VARCHAR
+// associated data and producing VARBINARY. See AESGCMReencrypt.
+class AESGCMReencryptWithVarcharADFactory: public AESGCMReencryptFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarbinary();
+            argTypes.addVarchar();
+            returnType.addVarbinary();
+        }
+};
+
+RegisterFactory(AESGCMReencryptWithVarcharADFactory);
+
+// Exposes a scalar function taking as input VARBINARY as well as VARBINARY
+// associated data and producing VARBINARY. See AESGCMReencrypt.
+class AESGCMReencryptWithVarbinaryADFactory: public AESGCMReencryptFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarbinary();
+            argTypes.addVarbinary();
+            returnType.addVarbinary();
+        }
+};
+
+RegisterFactory(AESGCMReencryptWithVarbinaryADFactory);
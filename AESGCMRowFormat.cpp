@@ -0,0 +1,149 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "AESGCMRowFormat.h"
+
+#include <cstring>
+
+size_t AESGCMRowFormat::maxFieldLength(Type type, size_t string_length) {
+    switch (type) {
+        case STRING:
+            return 1 + varintLength(string_length) + string_length;
+        case INTEGER:
+            return 1 + varintLength(~(uint64_t)0);
+        case FLOAT:
+            return 1 + sizeof(uint64_t);
+        case BOOLEAN:
+            return 2;
+    }
+    return 0;
+}
+
+void AESGCMRowFormat::Writer::putVarint(uint64_t v) {
+    while (v >= 0x80) {
+        out[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (unsigned char)v;
+}
+
+void AESGCMRowFormat::Writer::string(const void *data, size_t length) {
+    out[n++] = STRING;
+    putVarint(length);
+    if (length > 0) {
+        memcpy(out + n, data, length);
+        n += length;
+    }
+}
+
+void AESGCMRowFormat::Writer::integer(int64_t value) {
+    out[n++] = INTEGER;
+    putVarint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+void AESGCMRowFormat::Writer::real(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    out[n++] = FLOAT;
+    for (size_t i = 0; i < sizeof(bits); i++) {
+        out[n++] = (unsigned char)(bits >> (8 * i));
+    }
+}
+
+void AESGCMRowFormat::Writer::boolean(bool value) {
+    out[n++] = BOOLEAN;
+    out[n++] = value ? 1 : 0;
+}
+
+bool AESGCMRowFormat::Reader::getVarint(uint64_t &v) {
+    v = 0;
+    for (unsigned int shift = 0; shift < 64 && n < length; shift += 7) {
+        unsigned char b = in[n++];
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AESGCMRowFormat::Reader::count(size_t &fields) {
+    uint64_t v;
+    // Every field takes at least its tag byte.
+    if (!getVarint(v) || v > length - n) {
+        return false;
+    }
+    fields = (size_t)v;
+    return true;
+}
+
+bool AESGCMRowFormat::Reader::next(Field &field) {
+    if (n >= length) {
+        return false;
+    }
+    unsigned char tag = in[n++];
+    field.type = (Type)(tag & ~NULL_FLAG);
+    field.is_null = (tag & NULL_FLAG) != 0;
+    field.data = NULL;
+    field.length = 0;
+    field.integer = 0;
+    field.real = 0;
+    if (field.type < STRING || field.type > BOOLEAN) {
+        return false;
+    }
+    if (field.is_null) {
+        return true;
+    }
+
+    uint64_t v;
+    switch (field.type) {
+        case STRING:
+            if (!getVarint(v) || v > length - n) {
+                return false;
+            }
+            field.data = in + n;
+            field.length = (size_t)v;
+            n += field.length;
+            return true;
+        case INTEGER:
+            if (!getVarint(v)) {
+                return false;
+            }
+            field.integer = (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+            return true;
+        case FLOAT:
+            if (length - n < sizeof(v)) {
+                return false;
+            }
+            v = 0;
+            for (size_t i = 0; i < sizeof(v); i++) {
+                v |= (uint64_t)in[n++] << (8 * i);
+            }
+            memcpy(&field.real, &v, sizeof(v));
+            return true;
+        case BOOLEAN:
+            if (n >= length || in[n] > 1) {
+                return false;
+            }
+            field.integer = in[n++];
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,116 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef AESGCMROWFORMAT_H_INCLUDED
+#define AESGCMROWFORMAT_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+// AESGCMRowFormat packs the values of several columns into the single
+// plaintext of a value written by AESGCMEncryptRow:
+//
+//   field count (LEB128) | field...
+//
+// where each field is a tag byte, the type of the column with NULL_FLAG set
+// for a NULL value, followed by the value unless it is NULL:
+//
+//   STRING   length (LEB128) | bytes
+//   INTEGER  zigzag LEB128 (small magnitudes take a single byte)
+//   FLOAT    IEEE 754 double, little endian
+//   BOOLEAN  0 or 1
+class AESGCMRowFormat {
+    public:
+        enum Type {
+            STRING = 1,
+            INTEGER = 2,
+            FLOAT = 3,
+            BOOLEAN = 4
+        };
+
+        static const unsigned char NULL_FLAG = 0x80;
+
+        // Field is a value read by Reader. data and length are set for
+        // STRING, integer for INTEGER and BOOLEAN, and real for FLOAT.
+        struct Field {
+            Type type;
+            bool is_null;
+            const unsigned char *data;
+            size_t length;
+            int64_t integer;
+            double real;
+        };
+
+        // Returns the number of bytes a LEB128 encoding of n takes.
+        static size_t varintLength(uint64_t n) {
+            size_t length = 1;
+            while (n >= 0x80) {
+                n >>= 7;
+                length++;
+            }
+            return length;
+        }
+
+        // Returns the longest encoding of a field of type, where a STRING is
+        // at most string_length bytes long.
+        static size_t maxFieldLength(Type type, size_t string_length);
+
+        // Writer appends fields to a buffer which has room for them, see
+        // maxFieldLength.
+        class Writer {
+            private:
+                unsigned char *out;
+                size_t n;
+
+                void putVarint(uint64_t v);
+
+            public:
+                explicit Writer(unsigned char *out): out(out), n(0) {}
+
+                // The number of bytes written so far.
+                size_t length() const { return n; }
+
+                void count(size_t fields) { putVarint(fields); }
+                void null(Type type) { out[n++] = type | NULL_FLAG; }
+                void string(const void *data, size_t length);
+                void integer(int64_t value);
+                void real(double value);
+                void boolean(bool value);
+        };
+
+        // Reader reads the fields of a packed row in order. Every read
+        // returns false if the row is malformed.
+        class Reader {
+            private:
+                const unsigned char *in;
+                size_t length;
+                size_t n;
+
+                bool getVarint(uint64_t &v);
+
+            public:
+                Reader(const unsigned char *in, size_t length): in(in), length(length), n(0) {}
+
+                bool count(size_t &fields);
+                bool next(Field &field);
+        };
+};
+
+#endif /* AESGCMROWFORMAT_H_INCLUDED */
@@ -0,0 +1,188 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMSIV.h"
+
+#include <sodium.h>
+#include <cstring>
+
+AESGCMSIV::AESGCMSIV() {
+    memset(round_keys, 0, sizeof(round_keys));
+    memset(h_powers, 0, sizeof(h_powers));
+    memset(nonce_block, 0, sizeof(nonce_block));
+}
+
+AESGCMSIV::~AESGCMSIV() {
+    sodium_memzero(round_keys, sizeof(round_keys));
+    sodium_memzero(h_powers, sizeof(h_powers));
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "AESGCMKernel.h"
+
+KERNEL void AESGCMSIV::init(const unsigned char key_generating_key[key_length],
+        const unsigned char nonce[nonce_length]) {
+    __m128i rk[15];
+    expandKey(key_generating_key, rk);
+
+    // Derived key block i is AES(LE32(i) || nonce), of which the first 8
+    // bytes are used: blocks 0-1 form the authentication key and blocks 2-5
+    // the encryption key.
+    __m128i blocks[6];
+    CRYPTO_ALIGN(16) unsigned char derived[6][16];
+    for (int i = 0; i < 6; i++) {
+        memset(derived[i], 0, 16);
+        derived[i][0] = (unsigned char)i;
+        memcpy(derived[i] + 4, nonce, nonce_length);
+        blocks[i] = _mm_load_si128((const __m128i *)derived[i]);
+    }
+    encryptBlocks(rk, blocks, 6);
+    for (int i = 0; i < 6; i++) {
+        _mm_store_si128((__m128i *)derived[i], blocks[i]);
+    }
+
+    unsigned char encryption_key[key_length];
+    for (int i = 0; i < 4; i++) {
+        memcpy(encryption_key + 8 * i, derived[2 + i], 8);
+    }
+    expandKey(encryption_key, (__m128i *)round_keys);
+
+    // POLYVAL with key H is GHASH with key mulX_GHASH(ByteReverse(H)), see
+    // RFC 8452, Appendix A.
+    unsigned char h[16];
+    for (int i = 0; i < 16; i++) {
+        h[i] = i < 8 ? derived[1][7 - i] : derived[0][15 - i];
+    }
+    unsigned char carry = h[15] & 1;
+    for (int i = 15; i > 0; i--) {
+        h[i] = (unsigned char)((h[i] >> 1) | (h[i - 1] << 7));
+    }
+    h[0] >>= 1;
+    if (carry) {
+        h[0] ^= 0xe1;
+    }
+
+    __m128i *hp = (__m128i *)h_powers;
+    hp[0] = bswap(_mm_loadu_si128((const __m128i *)h));
+    for (int i = 1; i < 8; i++) {
+        hp[i] = gfmul(hp[i - 1], hp[0]);
+    }
+
+    memset(nonce_block, 0, sizeof(nonce_block));
+    memcpy(nonce_block, nonce, nonce_length);
+
+    sodium_memzero(rk, sizeof(rk));
+    sodium_memzero(blocks, sizeof(blocks));
+    sodium_memzero(derived, sizeof(derived));
+    sodium_memzero(encryption_key, sizeof(encryption_key));
+    sodium_memzero(h, sizeof(h));
+}
+
+// Computes the tag of a message from its POLYVAL.
+KERNEL static inline __m128i computeTag(const __m128i *rk, __m128i s, __m128i nonce) {
+    s = _mm_xor_si128(s, nonce);
+    s = _mm_and_si128(s, _mm_set_epi32(0x7fffffff, -1, -1, -1));
+    encryptBlocks(rk, &s, 1);
+    return s;
+}
+
+// XORs the CTR keystream starting from the counter block derived from tag
+// into in, writing to out. The counter is the first 32 bits, little-endian.
+KERNEL static void applyCounter(const __m128i *rk, __m128i tag,
+        const unsigned char *in, unsigned char *out, size_t length) {
+    __m128i counter = _mm_or_si128(tag, _mm_set_epi32((int)0x80000000, 0, 0, 0));
+    __m128i keystream[8];
+    while (length > 0) {
+        size_t n = 0;
+        for (; n < 8 && n * 16 < length; n++) {
+            keystream[n] = counter;
+            counter = _mm_add_epi32(counter, _mm_set_epi32(0, 0, 0, 1));
+        }
+        encryptBlocks(rk, keystream, n);
+
+        size_t chunk = n * 16 < length ? n * 16 : length;
+        applyKeystream(keystream, in, out, chunk);
+        in += chunk;
+        out += chunk;
+        length -= chunk;
+    }
+}
+
+KERNEL void AESGCMSIV::encrypt(const unsigned char *ad_prefix, size_t ad_prefix_length,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char *in, size_t length,
+        unsigned char *out, unsigned char tag[tag_length]) const {
+    const __m128i *rk = (const __m128i *)round_keys;
+
+    POLYVAL polyval((const __m128i *)h_powers);
+    polyval.update(ad_prefix, ad_prefix_length, ad, ad_length);
+    polyval.update(in, length);
+    __m128i t = computeTag(rk, polyval.final(ad_prefix_length + ad_length, length),
+            _mm_load_si128((const __m128i *)nonce_block));
+
+    _mm_storeu_si128((__m128i *)tag, t);
+    applyCounter(rk, t, in, out, length);
+}
+
+KERNEL int AESGCMSIV::decrypt(const unsigned char *ad_prefix, size_t ad_prefix_length,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char *in, size_t length,
+        const unsigned char tag[tag_length], unsigned char *out) const {
+    const __m128i *rk = (const __m128i *)round_keys;
+    __m128i expected = _mm_loadu_si128((const __m128i *)tag);
+
+    applyCounter(rk, expected, in, out, length);
+
+    POLYVAL polyval((const __m128i *)h_powers);
+    polyval.update(ad_prefix, ad_prefix_length, ad, ad_length);
+    polyval.update(out, length);
+    __m128i t = computeTag(rk, polyval.final(ad_prefix_length + ad_length, length),
+            _mm_load_si128((const __m128i *)nonce_block));
+    __m128i diff = _mm_xor_si128(t, expected);
+
+    if (!_mm_testz_si128(diff, diff)) {
+        memset(out, 0, length);
+        return -1;
+    }
+    return 0;
+}
+
+#else
+
+void AESGCMSIV::init(const unsigned char key_generating_key[key_length],
+        const unsigned char nonce[nonce_length]) {
+}
+
+void AESGCMSIV::encrypt(const unsigned char *ad_prefix, size_t ad_prefix_length,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char *in, size_t length,
+        unsigned char *out, unsigned char tag[tag_length]) const {
+}
+
+int AESGCMSIV::decrypt(const unsigned char *ad_prefix, size_t ad_prefix_length,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char *in, size_t length,
+        const unsigned char tag[tag_length], unsigned char *out) const {
+    return -1;
+}
+
+#endif
@@ -0,0 +1,78 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef AESGCMSIV_H_INCLUDED
+#define AESGCMSIV_H_INCLUDED
+
+#include <sodium.h>
+
+#include <stddef.h>
+
+// AESGCMSIV implements AES-256-GCM-SIV (RFC 8452) nonce-misuse-resistant
+// authenticated encryption for a single nonce, using AES-NI and PCLMULQDQ.
+// The message authentication and encryption keys derived from the
+// key-generating key and nonce are computed once by init, so encrypting a
+// message costs one POLYVAL pass, one AES block for the tag, and the CTR
+// keystream.
+//
+// The tag is computed from the plaintext and associated data alone, so with a
+// fixed nonce equal inputs produce equal outputs: AESGCMDeterministic relies
+// on this. Only isAvailable() hardware is supported, see
+// AESGCMMultiBuffer::isAvailable.
+class AESGCMSIV {
+    public:
+        static const size_t key_length = 32;
+        static const size_t nonce_length = 12;
+        static const size_t tag_length = 16;
+
+        AESGCMSIV();
+        ~AESGCMSIV();
+
+        // Derives the keys for nonce from key_generating_key. Must be called
+        // before encrypt or decrypt.
+        void init(const unsigned char key_generating_key[key_length],
+                const unsigned char nonce[nonce_length]);
+
+        // Encrypts length bytes of in to out, and writes the tag. The
+        // associated data is ad_prefix || ad, where ad_prefix is at most 16
+        // bytes long.
+        void encrypt(const unsigned char *ad_prefix, size_t ad_prefix_length,
+                const unsigned char *ad, size_t ad_length,
+                const unsigned char *in, size_t length,
+                unsigned char *out, unsigned char tag[tag_length]) const;
+
+        // Decrypts length bytes of in to out and verifies tag. Returns 0 if
+        // verified, or -1 otherwise in which case out is zeroed.
+        int decrypt(const unsigned char *ad_prefix, size_t ad_prefix_length,
+                const unsigned char *ad, size_t ad_length,
+                const unsigned char *in, size_t length,
+                const unsigned char tag[tag_length], unsigned char *out) const;
+
+    private:
+        // Expanded AES256 round keys of the message encryption key.
+        CRYPTO_ALIGN(16) unsigned char round_keys[15][16];
+        // H^1 through H^8 of the message authentication key, in the form
+        // used by POLYVAL (see AESGCMKernel.h).
+        CRYPTO_ALIGN(16) unsigned char h_powers[8][16];
+        CRYPTO_ALIGN(16) unsigned char nonce_block[16];
+};
+
+#endif /* AESGCMSIV_H_INCLUDED */
@@ -0,0 +1,676 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMFilter.h"
+#include "AESGCMFunction.h"
+#include "AESGCMNonce.h"
+
+#include <Vertica.h>
+#include <sodium.h>
+#include <cstring>
+#include <vector>
+
+using namespace Vertica;
+
+// AESGCMSegmented is the base of the scalar functions for LONG VARCHAR and
+// LONG VARBINARY values: the LONG overloads of AESGCM_Encrypt and
+// AESGCM_Decrypt (AESGCMEncryptLong and AESGCMDecryptLong), and
+// AESGCMDecryptRange.
+//
+// A long value is encrypted in the format of a stream written by
+// AESGCMEncryptFilter (see AESGCMStreamHeader): a 22 byte header recording the
+// key ID, segment size and nonce of the first segment, followed by segments of
+// SEGMENT_SIZE_PARAM bytes of plaintext each with its own tag, the last
+// shorter than the rest (possibly empty). The nonce of each segment is that
+// of the first plus its index. The associated data of each segment is the
+// header, a byte which is 1 for the last segment and 0 otherwise, and the
+// associated data of the value, if any; a value without associated data can
+// therefore also be decrypted by AESGCMDecryptFilter.
+//
+// Since every segment is authenticated on its own, a range of the plaintext
+// is decrypted by decrypting only the segments covering it, see
+// AESGCMDecryptRange.
+class AESGCMSegmented: public AESGCMFunction {
+    protected:
+        // Segments are not encrypted as a batch, so the associated data of
+        // the value is prefixed with the stream header and last segment flag
+        // once per value into ad_scratch.
+        static const size_t segment_ad_prefix_length = AESGCMStreamHeader::length + 1;
+
+        // The decoded stream header of the current value.
+        AESGCMStreamHeader stream_header;
+        const AESGCMKey *stream_key;
+
+        // The number of bytes of plaintext of the current value, and the
+        // index of its last segment.
+        size_t plaintext_length;
+        size_t last_segment;
+
+        // Storage for a partial segment decrypted by decryptSegment.
+        std::vector<unsigned char> segment_scratch;
+
+        // Writes the associated data of the segments of a value, with
+        // header, to ad_scratch, returning its length.
+        size_t beginSegments(const unsigned char header[AESGCMStreamHeader::length],
+                const unsigned char *ad, size_t ad_length) {
+            ad_scratch.resize(segment_ad_prefix_length + ad_length);
+            memcpy(&ad_scratch[0], header, AESGCMStreamHeader::length);
+            ad_scratch[AESGCMStreamHeader::length] = 0;
+            if (ad_length > 0) {
+                memcpy(&ad_scratch[segment_ad_prefix_length], ad, ad_length);
+            }
+            return ad_scratch.size();
+        }
+
+        // Decodes the header and segment layout of value into stream_header,
+        // stream_key, plaintext_length and last_segment, reporting an error
+        // if it is not a segmented value or its key is unknown. Then prepares
+        // the associated data of its segments as beginSegments does.
+        void beginValue(const unsigned char *value, size_t value_length,
+                const unsigned char *ad, size_t ad_length) {
+            if (value_length < AESGCMStreamHeader::length + crypto_aead_aes256gcm_ABYTES ||
+                    !stream_header.decode(value) ||
+                    stream_header.segment_size < 1 ||
+                    stream_header.segment_size > AESGCMFilter::max_segment_size) {
+                vt_report_error(0, "Ciphertext in column '%s' is not a segmented value",
+                        column_name.c_str());
+            }
+
+            stream_key = keyring->find(stream_header.key_id);
+            if (stream_key == NULL) {
+                vt_report_error(0, "Ciphertext in column '%s' was encrypted with unknown key ID %u",
+                        column_name.c_str(), (unsigned int)stream_header.key_id);
+            }
+
+            // Every segment but the last holds segment_size bytes, and the
+            // last fewer.
+            size_t segment_size = stream_header.segment_size;
+            size_t body = value_length - AESGCMStreamHeader::length;
+            size_t whole = body / (segment_size + crypto_aead_aes256gcm_ABYTES);
+            size_t rest = body - whole * (segment_size + crypto_aead_aes256gcm_ABYTES);
+            if (rest < crypto_aead_aes256gcm_ABYTES) {
+                vt_report_error(0, "Ciphertext in column '%s' is truncated", column_name.c_str());
+            }
+            plaintext_length = whole * segment_size + rest - crypto_aead_aes256gcm_ABYTES;
+            last_segment = whole;
+
+            beginSegments(value, ad, ad_length);
+        }
+
+        // Decrypts and verifies segment index of the current value, writing
+        // the plaintext bytes [begin, end) of the segment to out. Reports an
+        // error if it fails to verify.
+        void decryptSegment(const unsigned char *value, size_t index,
+                size_t begin, size_t end, unsigned char *out) {
+            size_t segment_size = stream_header.segment_size;
+            size_t length = index == last_segment ?
+                plaintext_length - index * segment_size : segment_size;
+            const unsigned char *segment = value + AESGCMStreamHeader::length +
+                index * (segment_size + crypto_aead_aes256gcm_ABYTES);
+
+            unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES];
+            AESGCMNonce::add(stream_header.nonce, index, nonce);
+            ad_scratch[AESGCMStreamHeader::length] = index == last_segment ? 1 : 0;
+
+            // Whole segments are decrypted in place.
+            unsigned char *plaintext = out;
+            if (out == NULL || begin > 0 || end < length) {
+                segment_scratch.resize(length + 1);
+                plaintext = &segment_scratch[0];
+            }
+
+            int result;
+            {
+                AESGCMStopwatch crypto(&counters.crypto_ns);
+                result = stream_key->decrypt(engine,
+                        plaintext,
+                        segment, length + crypto_aead_aes256gcm_ABYTES,
+                        &ad_scratch[0], ad_scratch.size(),
+                        nonce);
+            }
+            if (result != 0) {
+                counters.auth_failures++;
+                vt_report_error(0, "Failed to verify ciphertext in column '%s'", column_name.c_str());
+            }
+
+            if (plaintext != out && end > begin) {
+                memcpy(out, plaintext + begin, end - begin);
+            }
+        }
+
+        // Decrypts the plaintext bytes [begin, end) of the current value to
+        // out, decrypting only the segments which cover them.
+        void decryptRange(const unsigned char *value, size_t begin, size_t end,
+                unsigned char *out) {
+            if (begin >= end) {
+                return;
+            }
+            size_t segment_size = stream_header.segment_size;
+            for (size_t index = begin / segment_size; index <= (end - 1) / segment_size; index++) {
+                size_t segment_begin = index * segment_size;
+                size_t from = begin > segment_begin ? begin - segment_begin : 0;
+                size_t to = end - segment_begin < segment_size ? end - segment_begin : segment_size;
+                decryptSegment(value, index, from, to, out);
+                out += to - from;
+            }
+            // The empty last segment of a value whose length is a multiple
+            // of the segment size is not covered by any range.
+        }
+
+    public:
+        // The default number of bytes of plaintext in each segment.
+        static const size_t default_segment_size = 4096;
+
+        // Returns the length of a segmented value of plaintext_length bytes.
+        static size_t segmentedLength(size_t plaintext_length, size_t segment_size) {
+            return AESGCMStreamHeader::length + plaintext_length +
+                (plaintext_length / segment_size + 1) * crypto_aead_aes256gcm_ABYTES;
+        }
+
+        // Returns the length of the longest plaintext of a segmented value of
+        // value_length bytes, with segments of at least 1 byte.
+        static size_t maxPlaintextLength(size_t value_length) {
+            size_t overhead = AESGCMStreamHeader::length + crypto_aead_aes256gcm_ABYTES;
+            return value_length > overhead ? value_length - overhead : 0;
+        }
+
+        AESGCMSegmented(): stream_key(NULL), plaintext_length(0), last_segment(0) {}
+};
+
+// AESGCMEncryptLong encrypts LONG VARCHAR values in segments, see
+// AESGCMSegmented. It is the counterpart to AESGCMDecryptLong and
+// AESGCMDecryptRange.
+//
+// The result column type is a LONG VARBINARY long enough for the segmented
+// value of the longest input value, see AESGCMEncryptLongFactory.
+class AESGCMEncryptLong: public AESGCMSegmented {
+    private:
+        size_t segment_size;
+
+        // The longest value the result column can hold.
+        size_t max_value_length;
+
+    public:
+        AESGCMEncryptLong(): segment_size(default_segment_size), max_value_length(0) {
+            stats_name = "AESGCM_EncryptLong";
+        }
+
+        // Returns the segment size set by SEGMENT_SIZE_PARAM, reporting an
+        // error if it is out of range.
+        static size_t segmentSize(ServerInterface &srvInterface) {
+            ParamReader paramReader = srvInterface.getParamReader();
+            if (!paramReader.containsParameter(SEGMENT_SIZE_PARAM)) {
+                return default_segment_size;
+            }
+            vint size = paramReader.getIntRef(SEGMENT_SIZE_PARAM);
+            if (size < 1 || size > (vint)AESGCMFilter::max_segment_size) {
+                vt_report_error(0, "Parameter \"" SEGMENT_SIZE_PARAM "\" must be between 1 and %zu",
+                        AESGCMFilter::max_segment_size);
+            }
+            return size;
+        }
+
+        // Returns the length of the result column type given the length of
+        // the value argument.
+        static size_t resultLength(size_t value_length, size_t segment_size) {
+            size_t length = segmentedLength(value_length, segment_size);
+            return length < VERTICA_LONG_MAX ? length : VERTICA_LONG_MAX;
+        }
+
+        virtual void setup(ServerInterface &srvInterface, const SizedColumnTypes &argTypes) {
+            AESGCMSegmented::setup(srvInterface, argTypes);
+            segment_size = segmentSize(srvInterface);
+            max_value_length = resultLength(argTypes.getColumnType(0).getStringLength(),
+                    segment_size);
+        }
+
+        virtual void processBlock(ServerInterface &srvInterface,
+                BlockReader &arg_reader,
+                BlockWriter &res_writer) {
+            if (arg_reader.getNumCols() < 1 || arg_reader.getNumCols() > 2) {
+                vt_report_error(0, "Function accepts either 1 or 2 arguments, but %zu provided",
+                        arg_reader.getNumCols());
+            }
+
+            const AESGCMKey *key = keyring->encryptionKey();
+            stream_header.key_id = keyring->encryptionKeyId();
+            stream_header.segment_size = segment_size;
+
+            AESGCMStopwatch process(&counters.process_ns);
+            counters.blocks++;
+
+            do {
+                counters.rows++;
+                if (arg_reader.isNull(0)) {
+                    counters.null_rows++;
+                    // Encrypting NULL returns NULL.
+                    res_writer.getStringRef().setNull();
+                    res_writer.next();
+                    continue;
+                }
+
+                VString plaintext = arg_reader.getStringRef(0);
+                const unsigned char *in = (const unsigned char *)plaintext.data();
+                size_t length = plaintext.length();
+
+                const unsigned char *associated_data = NULL;
+                size_t associated_data_length = 0;
+                if (arg_reader.getNumCols() > 1 && !arg_reader.isNull(1)) {
+                    VString ad = arg_reader.getStringRef(1);
+                    associated_data_length = ad.length();
+                    if (associated_data_length > 0) {
+                        associated_data = (unsigned char *)ad.data();
+                    }
+                }
+
+                size_t value_length = segmentedLength(length, segment_size);
+                if (value_length > max_value_length) {
+                    vt_report_error(0,
+                            "Ciphertext of column '%s' is too long (%zu) expected at most %zu; use a larger segment_size",
+                            column_name.c_str(), value_length, max_value_length);
+                }
+
+                // Reserve a nonce for each segment of the value.
+                size_t segments = length / segment_size + 1;
+                AESGCMNonce::reserve(segments, stream_header.nonce);
+
+                VString &ciphertext = res_writer.getStringRef();
+                ciphertext.alloc(value_length);
+                counters.bytes_in += length;
+                counters.bytes_out += value_length;
+
+                unsigned char *out = (unsigned char *)ciphertext.data();
+                stream_header.encode(out);
+                beginSegments(out, associated_data, associated_data_length);
+                out += AESGCMStreamHeader::length;
+
+                unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES];
+                memcpy(nonce, stream_header.nonce, sizeof(nonce));
+
+                AESGCMStopwatch crypto(&counters.crypto_ns);
+                for (size_t index = 0; index < segments; index++) {
+                    size_t segment_length = index + 1 == segments ?
+                        length - index * segment_size : segment_size;
+                    ad_scratch[AESGCMStreamHeader::length] = index + 1 == segments ? 1 : 0;
+                    key->encrypt(engine,
+                            out,
+                            in, segment_length,
+                            &ad_scratch[0], ad_scratch.size(),
+                            nonce);
+                    in += segment_length;
+                    out += segment_length + crypto_aead_aes256gcm_ABYTES;
+                    sodium_increment(nonce, crypto_aead_aes256gcm_NPUBBYTES);
+                }
+
+                res_writer.next();
+            } while (arg_reader.next());
+        }
+};
+
+// AESGCMDecryptLong decrypts segmented values written by AESGCMEncryptLong,
+// authenticating every segment.
+//
+// The result column type is always a LONG VARCHAR(X), where given an input
+// column LONG VARBINARY(Y), X = Y - 38. See AESGCMDecryptLongFactory.
+class AESGCMDecryptLong: public AESGCMSegmented {
+    public:
+        AESGCMDecryptLong() {
+            stats_name = "AESGCM_DecryptLong";
+        }
+
+        virtual void processBlock(ServerInterface &srvInterface,
+                BlockReader &arg_reader,
+                BlockWriter &res_writer) {
+            if (arg_reader.getNumCols() < 1 || arg_reader.getNumCols() > 2) {
+                vt_report_error(0, "Function accepts either 1 or 2 arguments, but %zu provided",
+                        arg_reader.getNumCols());
+            }
+
+            AESGCMStopwatch process(&counters.process_ns);
+            counters.blocks++;
+
+            do {
+                counters.rows++;
+                if (arg_reader.isNull(0)) {
+                    counters.null_rows++;
+                    // Decrypting NULL returns NULL.
+                    res_writer.getStringRef().setNull();
+                    res_writer.next();
+                    continue;
+                }
+
+                VString ciphertext = arg_reader.getStringRef(0);
+                const unsigned char *value = (const unsigned char *)ciphertext.data();
+                counters.bytes_in += ciphertext.length();
+
+                const unsigned char *associated_data = NULL;
+                size_t associated_data_length = 0;
+                if (arg_reader.getNumCols() > 1 && !arg_reader.isNull(1)) {
+                    VString ad = arg_reader.getStringRef(1);
+                    associated_data_length = ad.length();
+                    if (associated_data_length > 0) {
+                        associated_data = (unsigned char *)ad.data();
+                    }
+                }
+
+                beginValue(value, ciphertext.length(), associated_data, associated_data_length);
+
+                VString &plaintext = res_writer.getStringRef();
+                plaintext.alloc(plaintext_length);
+                counters.bytes_out += plaintext_length;
+
+                decryptRange(value, 0, plaintext_length, (unsigned char *)plaintext.data());
+                if (plaintext_length % stream_header.segment_size == 0) {
+                    // Verify the empty last segment, so that a value
+                    // truncated at a segment boundary is detected.
+                    decryptSegment(value, last_segment, 0, 0, NULL);
+                }
+
+                res_writer.next();
+            } while (arg_reader.next());
+        }
+};
+
+// AESGCMDecryptRange decrypts the bytes of segmented values written by
+// AESGCMEncryptLong from a zero-based offset, up to a length, authenticating
+// and decrypting only the segments covering them. The range is clipped to the
+// plaintext, as SUBSTR does. Modifications of the value outside of the
+// segments covering the range are therefore not detected.
+//
+// The result column type is always a LONG VARCHAR(X), where given an input
+// column LONG VARBINARY(Y), X = Y - 38. See AESGCMDecryptRangeFactory.
+class AESGCMDecryptRange: public AESGCMSegmented {
+    public:
+        AESGCMDecryptRange() {
+            stats_name = "AESGCM_DecryptRange";
+        }
+
+        virtual void setup(ServerInterface &srvInterface, const SizedColumnTypes &argTypes) {
+            ad_column = 3;
+            AESGCMSegmented::setup(srvInterface, argTypes);
+        }
+
+        virtual void processBlock(ServerInterface &srvInterface,
+                BlockReader &arg_reader,
+                BlockWriter &res_writer) {
+            if (arg_reader.getNumCols() < 3 || arg_reader.getNumCols() > 4) {
+                vt_report_error(0, "Function accepts either 3 or 4 arguments, but %zu provided",
+                        arg_reader.getNumCols());
+            }
+
+            AESGCMStopwatch process(&counters.process_ns);
+            counters.blocks++;
+
+            do {
+                counters.rows++;
+                if (arg_reader.isNull(0) || arg_reader.isNull(1) || arg_reader.isNull(2)) {
+                    counters.null_rows++;
+                    // Decrypting NULL, or a NULL range, returns NULL.
+                    res_writer.getStringRef().setNull();
+                    res_writer.next();
+                    continue;
+                }
+
+                vint offset = arg_reader.getIntRef(1);
+                vint length = arg_reader.getIntRef(2);
+                if (offset < 0 || length < 0) {
+                    vt_report_error(0, "Range offset and length must not be negative");
+                }
+
+                VString ciphertext = arg_reader.getStringRef(0);
+                const unsigned char *value = (const unsigned char *)ciphertext.data();
+                counters.bytes_in += ciphertext.length();
+
+                const unsigned char *associated_data = NULL;
+                size_t associated_data_length = 0;
+                if (arg_reader.getNumCols() > 3 && !arg_reader.isNull(3)) {
+                    VString ad = arg_reader.getStringRef(3);
+                    associated_data_length = ad.length();
+                    if (associated_data_length > 0) {
+                        associated_data = (unsigned char *)ad.data();
+                    }
+                }
+
+                beginValue(value, ciphertext.length(), associated_data, associated_data_length);
+
+                size_t begin = (uint64_t)offset < plaintext_length ? offset : plaintext_length;
+                size_t end = (uint64_t)length < plaintext_length - begin ?
+                    begin + length : plaintext_length;
+
+                VString &plaintext = res_writer.getStringRef();
+                plaintext.alloc(end - begin);
+                counters.bytes_out += end - begin;
+
+                decryptRange(value, begin, end, (unsigned char *)plaintext.data());
+
+                res_writer.next();
+            } while (arg_reader.next());
+        }
+};
+
+// Exposes a scalar function taking as input LONG VARCHAR and producing LONG
+// VARBINARY, as an overload of AESGCM_Encrypt. See AESGCMEncryptLong.
+class AESGCMEncryptLongFactory: public AESGCMFunctionFactory {
+    public:
+        AESGCMEncryptLongFactory() {
+            // For some given arguments, the results yielded are unique for
+            // the duration of the statement. The nonce generated should be
+            // different each invocation within a statement.
+            vol = VOLATILE;
+        }
+
+        virtual void getParameterType(ServerInterface &srvInterface,
+                SizedColumnTypes &parameterTypes) {
+            addKeyParameter(parameterTypes);
+            addEngineParameter(parameterTypes);
+
+            static const SizedColumnTypes::Properties segment_size_props(
+                    true, // Visible
+                    false, // Required
+                    false, // Can be NULL
+                    "Number of plaintext bytes in each authenticated segment of a value (default 4096)." // Comment
+                );
+            parameterTypes.addInt(SEGMENT_SIZE_PARAM, segment_size_props);
+        }
+
+        virtual ScalarFunction *createScalarFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMEncryptLong);
+        }
+
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addLongVarchar();
+            returnType.addLongVarbinary();
+        }
+
+        virtual void getReturnType(ServerInterface &server,
+                const SizedColumnTypes &argTypes,
+                SizedColumnTypes &returnType) {
+            const VerticaType &t = argTypes.getColumnType(0);
+            returnType.addLongVarbinary(AESGCMEncryptLong::resultLength(t.getStringLength(),
+                        AESGCMEncryptLong::segmentSize(server)));
+        }
+};
+
+RegisterFactory(AESGCMEncryptLongFactory);
+
+// Exposes a scalar function taking as input LONG VARCHAR as well as VARCHAR
+// associated data and producing LONG VARBINARY. See AESGCMEncryptLong.
+class AESGCMEncryptLongWithVarcharADFactory: public AESGCMEncryptLongFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addLongVarchar();
+            argTypes.addVarchar();
+            returnType.addLongVarbinary();
+        }
+};
+
+RegisterFactory(AESGCMEncryptLongWithVarcharADFactory);
+
+// Exposes a scalar function taking as input LONG VARCHAR as well as VARBINARY
+// associated data and producing LONG VARBINARY. See AESGCMEncryptLong.
+class AESGCMEncryptLongWithVarbinaryADFactory: public AESGCMEncryptLongFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addLongVarchar();
+            argTypes.addVarbinary();
+            returnType.addLongVarbinary();
+        }
+};
+
+RegisterFactory(AESGCMEncryptLongWithVarbinaryADFactory);
+
+// AESGCMDecryptSegmentedFactory provides the metainformation common to the
+// factories of AESGCMDecryptLong and AESGCMDecryptRange.
+class AESGCMDecryptSegmentedFactory: public AESGCMFunctionFactory {
+    public:
+        AESGCMDecryptSegmentedFactory() {
+            // For some given arguments, the results yielded are the same for
+            // the duration of the statement. For example the encryption keys
+            // could change between statements.
+            vol = STABLE;
+        }
+
+        virtual void getParameterType(ServerInterface &srvInterface,
+                SizedColumnTypes &parameterTypes) {
+            addKeyParameter(parameterTypes);
+            addEngineParameter(parameterTypes);
+        }
+
+        virtual void getReturnType(ServerInterface &server,
+                const SizedColumnTypes &argTypes,
+                SizedColumnTypes &returnType) {
+            size_t length = AESGCMSegmented::maxPlaintextLength(
+                    argTypes.getColumnType(0).getStringLength());
+            // Length of a string in a return type must be greater than zero.
+            returnType.addLongVarchar(length > 0 ? length : 1);
+        }
+};
+
+// Exposes a scalar function taking as input LONG VARBINARY and producing LONG
+// VARCHAR, as an overload of AESGCM_Decrypt. See AESGCMDecryptLong.
+class AESGCMDecryptLongFactory: public AESGCMDecryptSegmentedFactory {
+    public:
+        virtual ScalarFunction *createScalarFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMDecryptLong);
+        }
+
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addLongVarbinary();
+            returnType.addLongVarchar();
+        }
+};
+
+RegisterFactory(AESGCMDecryptLongFactory);
+
+// Exposes a scalar function taking as input LONG VARBINARY as well as VARCHAR
+// associated data and producing LONG VARCHAR. See AESGCMDecryptLong.
+class AESGCMDecryptLongWithVarcharADFactory: public AESGCMDecryptLongFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addLongVarbinary();
+            argTypes.addVarchar();
+            returnType.addLongVarchar();
+        }
+};
+
+RegisterFactory(AESGCMDecryptLongWithVarcharADFactory);
+
+// Exposes a scalar function taking as input LONG VARBINARY as well as
+// VARBINARY associated data and producing LONG VARCHAR. See
+// AESGCMDecryptLong.
+class AESGCMDecryptLongWithVarbinaryADFactory: public AESGCMDecryptLongFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addLongVarbinary();
+            argTypes.addVarbinary();
+            returnType.addLongVarchar();
+        }
+};
+
+RegisterFactory(AESGCMDecryptLongWithVarbinaryADFactory);
+
+// Exposes a scalar function taking as input LONG VARBINARY and INTEGER offset
+// and length and producing LONG VARCHAR. See AESGCMDecryptRange.
+class AESGCMDecryptRangeFactory: public AESGCMDecryptSegmentedFactory {
+    public:
+        virtual ScalarFunction *createScalarFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMDecryptRange);
+        }
+
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addLongVarbinary();
+            argTypes.addInt();
+            argTypes.addInt();
+            returnType.addLongVarchar();
+        }
+};
+
+RegisterFactory(AESGCMDecryptRangeFactory);
+
+// Exposes a scalar function taking as input LONG VARBINARY, INTEGER offset
+// and length as well as VARCHAR associated data and producing LONG VARCHAR.
+// See AESGCMDecryptRange.
+class AESGCMDecryptRangeWithVarcharADFactory: public AESGCMDecryptRangeFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addLongVarbinary();
+            argTypes.addInt();
+            argTypes.addInt();
+            argTypes.addVarchar();
+            returnType.addLongVarchar();
+        }
+};
+
+RegisterFactory(AESGCMDecryptRangeWithVarcharADFactory);
+
+// Exposes a scalar function taking as input LONG VARBINARY, INTEGER offset
+// and length as well as VARBINARY associated data and producing LONG VARCHAR.
+// See AESGCMDecryptRange.
+class AESGCMDecryptRangeWithVarbinaryADFactory: public AESGCMDecryptRangeFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addLongVarbinary();
+            argTypes.addInt();
+            argTypes.addInt();
+            argTypes.addVarbinary();
+            returnType.addLongVarchar();
+        }
+};
+
+RegisterFactory(AESGCMDecryptRangeWithVarbinaryADFactory);
@@ -0,0 +1,120 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMStats.h"
+
+#include <algorithm>
+#include <map>
+#include <pthread.h>
+#include <time.h>
+#include <utility>
+
+AESGCMCounters::AESGCMCounters()
+    : blocks(0), rows(0), null_rows(0), bytes_in(0), bytes_out(0),
+      process_ns(0), crypto_ns(0), auth_failures(0), single_calls(0),
+      sampled_calls(0), sampled_ns(0), sample_state(1) {}
+
+void AESGCMCounters::add(const AESGCMCounters &other) {
+    blocks += other.blocks;
+    rows += other.rows;
+    null_rows += other.null_rows;
+    bytes_in += other.bytes_in;
+    bytes_out += other.bytes_out;
+    process_ns += other.process_ns;
+    crypto_ns = cryptoNs() + other.cryptoNs();
+    auth_failures += other.auth_failures;
+    single_calls += other.single_calls;
+    sampled_calls = 0;
+    sampled_ns = 0;
+}
+
+void AESGCMCounters::addSingle(Timing timing, uint64_t ns) {
+    if (timing == TIMED) {
+        crypto_ns += ns;
+        return;
+    }
+    if (sampled_calls > 0 && ns / outlier_factor > sampled_ns / sampled_calls) {
+        ns = sampled_ns / sampled_calls;
+    }
+    sampled_ns += ns;
+    sampled_calls++;
+}
+
+uint64_t AESGCMStopwatch::now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint64_t clock_cost;
+static pthread_once_t clock_cost_once = PTHREAD_ONCE_INIT;
+
+// Sets clock_cost to the median interval between two consecutive reads.
+static void calibrateClockCost() {
+    uint64_t intervals[63];
+    for (size_t i = 0; i < 63; i++) {
+        uint64_t start = AESGCMStopwatch::now();
+        intervals[i] = AESGCMStopwatch::now() - start;
+    }
+    std::nth_element(intervals, intervals + 31, intervals + 63);
+    clock_cost = intervals[31];
+}
+
+uint64_t AESGCMStopwatch::since(uint64_t start) {
+    uint64_t elapsed = now() - start;
+    pthread_once(&clock_cost_once, calibrateClockCost);
+    return elapsed > clock_cost ? elapsed - clock_cost : 0;
+}
+
+typedef std::map<std::pair<std::string, std::string>, AESGCMStats::Entry> StatsMap;
+
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static StatsMap stats;
+
+// Holds stats_mutex for the lifetime of the object.
+class StatsLock {
+    public:
+        StatsLock() { pthread_mutex_lock(&stats_mutex); }
+        ~StatsLock() { pthread_mutex_unlock(&stats_mutex); }
+};
+
+void AESGCMStats::record(const std::string &function, const std::string &key_path,
+        const AESGCMCounters &counters) {
+    StatsLock lock;
+    std::pair<StatsMap::iterator, bool> inserted = stats.insert(
+            std::make_pair(std::make_pair(function, key_path), Entry()));
+    Entry &entry = inserted.first->second;
+    if (inserted.second) {
+        entry.function = function;
+        entry.key_path = key_path;
+        entry.instances = 0;
+    }
+    entry.instances++;
+    entry.counters.add(counters);
+}
+
+void AESGCMStats::snapshot(std::vector<Entry> &entries) {
+    StatsLock lock;
+    entries.clear();
+    for (StatsMap::const_iterator it = stats.begin(); it != stats.end(); ++it) {
+        entries.push_back(it->second);
+    }
+}
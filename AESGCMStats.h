@@ -0,0 +1,181 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef AESGCMSTATS_H_INCLUDED
+#define AESGCMSTATS_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+// AESGCMCounters are the hot path counters of a function instance. They are
+// plain integers updated by the thread calling processBlock, so keeping them
+// costs a few additions per row and two clock reads per block or batch.
+//
+// Reading the clock costs about as much as encrypting a short value, so
+// values encrypted or decrypted one at a time are sampled: the first and one
+// in every sample_interval, chosen pseudorandomly so that the first rows of
+// blocks are not favoured, are timed, and the mean time of the sampled calls
+// is counted for each of single_calls. Once that mean is at least
+// min_timed_ns, reading the clock is cheap in comparison and every value is
+// timed. See AESGCMSampleStopwatch.
+struct AESGCMCounters {
+    static const unsigned int sample_interval = 16;
+    static const uint64_t min_timed_ns = 1000;
+
+    // A sample longer than outlier_factor times the mean of those before it,
+    // such as a call interrupted by the scheduler, is counted as the mean so
+    // that the interruption is not multiplied by sample_interval.
+    static const unsigned int outlier_factor = 8;
+
+    // How the encryption or decryption of a single value is timed.
+    enum Timing { UNTIMED, TIMED, SAMPLED };
+
+    uint64_t blocks;
+    uint64_t rows; // including NULL rows
+    uint64_t null_rows;
+    uint64_t bytes_in; // of the value argument
+    uint64_t bytes_out; // of results
+    // Time spent in processBlock, and the part of it spent in encryption or
+    // decryption calls other than sampled values (see cryptoNs). When a block
+    // is split across threads, the time the calling thread waits for them is
+    // counted as crypto time.
+    uint64_t process_ns;
+    uint64_t crypto_ns;
+    uint64_t auth_failures;
+    uint64_t single_calls; // values processed one at a time, but not TIMED
+    uint64_t sampled_calls; // of single_calls, those timed
+    uint64_t sampled_ns;
+    uint32_t sample_state;
+
+    AESGCMCounters();
+
+    // Adds other to the counters, settling the estimated time of the single
+    // values of both into crypto_ns.
+    void add(const AESGCMCounters &other);
+
+    // Returns the time spent in encryption or decryption calls, with the
+    // time of single values estimated from those sampled.
+    uint64_t cryptoNs() const {
+        return crypto_ns + (sampled_calls == 0 ? 0 :
+                (uint64_t)((double)sampled_ns * single_calls / sampled_calls));
+    }
+
+    // Returns the time spent in processBlock outside of encryption or
+    // decryption calls.
+    uint64_t loopNs() const { return process_ns - cryptoNs(); }
+
+    // Returns how to time the encryption or decryption of the next single
+    // value.
+    Timing sample() {
+        if (sampled_calls > 0 && sampled_ns >= min_timed_ns * sampled_calls) {
+            return TIMED;
+        }
+        single_calls++;
+        sample_state = sample_state * 1103515245 + 12345;
+        return sampled_calls == 0 || (sample_state >> 16) % sample_interval == 0 ?
+            SAMPLED : UNTIMED;
+    }
+
+    // Adds the time of a single value timed as returned by sample.
+    void addSingle(Timing timing, uint64_t ns);
+};
+
+// AESGCMStopwatch adds the time between its construction and destruction to
+// a counter, so that the time is counted even if vt_report_error throws. The
+// cost of reading the clock is not counted. A NULL counter disables it
+// without reading the clock.
+class AESGCMStopwatch {
+    public:
+        explicit AESGCMStopwatch(uint64_t *ns)
+            : ns(ns), start(ns != NULL ? now() : 0) {}
+
+        ~AESGCMStopwatch() {
+            if (ns != NULL) {
+                *ns += since(start);
+            }
+        }
+
+        // Returns the CLOCK_MONOTONIC time in nanoseconds.
+        static uint64_t now();
+
+        // Returns the time since start, a time returned by now, less the
+        // cost of reading the clock (calibrated once per process).
+        static uint64_t since(uint64_t start);
+
+    private:
+        uint64_t *ns;
+        uint64_t start;
+
+        AESGCMStopwatch(const AESGCMStopwatch &);
+        AESGCMStopwatch &operator=(const AESGCMStopwatch &);
+};
+
+// AESGCMSampleStopwatch times the encryption or decryption of a single value
+// into counters between its construction and destruction, when
+// AESGCMCounters::sample says so. NULL counters disable it.
+class AESGCMSampleStopwatch {
+    public:
+        explicit AESGCMSampleStopwatch(AESGCMCounters *counters)
+            : counters(counters),
+              timing(counters != NULL ? counters->sample() : AESGCMCounters::UNTIMED),
+              start(timing != AESGCMCounters::UNTIMED ? AESGCMStopwatch::now() : 0) {}
+
+        ~AESGCMSampleStopwatch() {
+            if (timing != AESGCMCounters::UNTIMED) {
+                counters->addSingle(timing, AESGCMStopwatch::since(start));
+            }
+        }
+
+    private:
+        AESGCMCounters *counters;
+        AESGCMCounters::Timing timing;
+        uint64_t start;
+
+        AESGCMSampleStopwatch(const AESGCMSampleStopwatch &);
+        AESGCMSampleStopwatch &operator=(const AESGCMSampleStopwatch &);
+};
+
+// AESGCMStats is a process-wide, thread-safe registry of the counters of
+// function instances which have been destroyed, summed by function name and
+// key path.
+class AESGCMStats {
+    public:
+        struct Entry {
+            std::string function;
+            std::string key_path;
+            uint64_t instances;
+            AESGCMCounters counters;
+        };
+
+        // Adds the counters of an instance of function using the key at
+        // key_path.
+        static void record(const std::string &function, const std::string &key_path,
+                const AESGCMCounters &counters);
+
+        // Replaces entries with the registry, ordered by function name and
+        // key path.
+        static void snapshot(std::vector<Entry> &entries);
+};
+
+#endif /* AESGCMSTATS_H_INCLUDED */
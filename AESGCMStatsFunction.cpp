@@ -0,0 +1,114 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMFunction.h"
+#include "AESGCMStats.h"
+
+#include <Vertica.h>
+
+#include <string>
+#include <vector>
+
+using namespace Vertica;
+
+// The length of the longest function name recorded in AESGCMStats.
+#define MAX_STATS_FUNCTION 32
+
+// AESGCMStatsFunction provides a Vertica transform function which returns
+// the counters AESGCMEncrypt and AESGCMDecrypt instances have recorded in
+// AESGCMStats on the node evaluating it, one row per function and key path:
+//
+//   SELECT AESGCM_Stats() OVER ();
+//   SELECT AESGCM_Stats() OVER (PARTITION NODES);
+//
+// loop_ns is the time spent in processBlock outside of encryption or
+// decryption calls, such as reading arguments and writing results.
+class AESGCMStatsFunction: public TransformFunction {
+    public:
+        virtual void processPartition(ServerInterface &srvInterface,
+                PartitionReader &input_reader,
+                PartitionWriter &output_writer) {
+            std::vector<AESGCMStats::Entry> entries;
+            AESGCMStats::snapshot(entries);
+
+            std::string node_name = srvInterface.getCurrentNodeName();
+            for (size_t i = 0; i < entries.size(); i++) {
+                const AESGCMStats::Entry &entry = entries[i];
+                const AESGCMCounters &counters = entry.counters;
+                output_writer.getStringRef(0).copy(node_name.data(), node_name.size());
+                output_writer.getStringRef(1).copy(entry.function.data(), entry.function.size());
+                output_writer.getStringRef(2).copy(entry.key_path.data(), entry.key_path.size());
+                output_writer.setInt(3, (vint)entry.instances);
+                output_writer.setInt(4, (vint)counters.blocks);
+                output_writer.setInt(5, (vint)counters.rows);
+                output_writer.setInt(6, (vint)counters.null_rows);
+                output_writer.setInt(7, (vint)counters.bytes_in);
+                output_writer.setInt(8, (vint)counters.bytes_out);
+                output_writer.setInt(9, (vint)counters.cryptoNs());
+                output_writer.setInt(10, (vint)counters.loopNs());
+                output_writer.setInt(11, (vint)counters.auth_failures);
+                output_writer.next();
+            }
+        }
+};
+
+// Exposes a transform function taking no arguments and producing a row of
+// counters per function and key path. See AESGCMStatsFunction.
+class AESGCMStatsFactory: public TransformFunctionFactory {
+    public:
+        AESGCMStatsFactory() {
+            vol = VOLATILE;
+        }
+
+        virtual TransformFunction *createTransformFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMStatsFunction);
+        }
+
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            returnType.addVarchar();
+            returnType.addVarchar();
+            returnType.addVarchar();
+            for (int i = 0; i < 9; i++) {
+                returnType.addInt();
+            }
+        }
+
+        virtual void getReturnType(ServerInterface &server,
+                const SizedColumnTypes &argTypes,
+                SizedColumnTypes &returnType) {
+            returnType.addVarchar(128, "node_name");
+            returnType.addVarchar(MAX_STATS_FUNCTION, "function_name");
+            returnType.addVarchar(MAX_KEY_PATH, "key_path");
+            returnType.addInt("instances");
+            returnType.addInt("blocks");
+            returnType.addInt("row_count");
+            returnType.addInt("null_count");
+            returnType.addInt("bytes_in");
+            returnType.addInt("bytes_out");
+            returnType.addInt("crypto_ns");
+            returnType.addInt("loop_ns");
+            returnType.addInt("auth_failures");
+        }
+};
+
+RegisterFactory(AESGCMStatsFactory);
@@ -0,0 +1,635 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMFunction.h"
+#include "AESGCMNonce.h"
+#include "AESGCMTenantKeys.h"
+
+#include <Vertica.h>
+#include <sodium.h>
+#include <cstring>
+
+using namespace Vertica;
+
+// AESGCMTenantFunction is the base of AESGCMEncryptForTenant and
+// AESGCMDecryptForTenant, which encrypt each row under the subkey of its
+// tenant, derived from the key (or keyring key) named by KEY_PATH_PARAM (see
+// AESGCMKey::deriveTenantKey). The tenant ID is the first argument, followed
+// by the value and the optional associated data.
+//
+// Values have the same format as those written by AESGCMEncrypt: a keyring
+// with key IDs prefixes them with an AESGCMHeader naming the key the subkey
+// was derived from, and headerless values are decrypted with subkeys of the
+// keyring's legacy key.
+//
+// Subkeys are kept expanded in an AESGCMTenantKeys cache of TENANT_KEYS_PARAM
+// entries per instance, so only the first row of a tenant in a scan (or the
+// first after it was evicted) pays for derivation and key expansion. Runs of
+// rows of a tenant are encrypted and decrypted in batches as with a single
+// key; a change of tenant ends the batch.
+class AESGCMTenantFunction: public AESGCMFunction {
+    protected:
+        AESGCMTenantKeys tenant_keys;
+
+        // Returns the subkey under master of the tenant of the current row,
+        // reporting an error if its tenant ID is NULL.
+        const AESGCMKey *tenantKey(const AESGCMKey *master, BlockReader &arg_reader) {
+            if (arg_reader.isNull(0)) {
+                vt_report_error(0, "Tenant ID for column '%s' is NULL", column_name.c_str());
+            }
+            VString tenant_id = arg_reader.getStringRef(0);
+            return tenant_keys.find(master,
+                    (const unsigned char *)tenant_id.data(), tenant_id.length());
+        }
+
+        // Reads the associated data of the current row, if any.
+        void readAssociatedData(BlockReader &arg_reader,
+                const unsigned char *&ad, size_t &ad_length) const {
+            ad = NULL;
+            ad_length = 0;
+            if (arg_reader.getNumCols() > ad_column && !arg_reader.isNull(ad_column)) {
+                VString associated_data = arg_reader.getStringRef(ad_column);
+                ad_length = associated_data.length();
+                if (ad_length > 0) {
+                    ad = (const unsigned char *)associated_data.data();
+                }
+            }
+        }
+
+        void checkArguments(BlockReader &arg_reader) const {
+            if (arg_reader.getNumCols() < 2 || arg_reader.getNumCols() > 3) {
+                vt_report_error(0, "Function accepts either 2 or 3 arguments, but %zu provided",
+                        arg_reader.getNumCols());
+            }
+        }
+
+    public:
+        virtual void setup(ServerInterface &srvInterface, const SizedColumnTypes &argTypes) {
+            value_column = 1;
+            ad_column = 2;
+            AESGCMFunction::setup(srvInterface, argTypes);
+
+            size_t capacity = AESGCMTenantKeys::default_capacity;
+            ParamReader paramReader = srvInterface.getParamReader();
+            if (paramReader.containsParameter(TENANT_KEYS_PARAM)) {
+                vint n = paramReader.getIntRef(TENANT_KEYS_PARAM);
+                if (n < (vint)AESGCMTenantKeys::min_capacity ||
+                        n > (vint)AESGCMTenantKeys::max_capacity) {
+                    vt_report_error(0, "Parameter \"" TENANT_KEYS_PARAM "\" must be between %zu and %zu",
+                            AESGCMTenantKeys::min_capacity, AESGCMTenantKeys::max_capacity);
+                }
+                capacity = n;
+            }
+            tenant_keys.reset(capacity, engine);
+        }
+
+        virtual void destroy(ServerInterface &srvInterface, const SizedColumnTypes &argTypes) {
+            if (stats_name != NULL && counters.blocks > 0) {
+                srvInterface.log("%s key=%s tenant_key_misses=%zu",
+                        stats_name, key_path.c_str(), tenant_keys.misses());
+            }
+            AESGCMFunction::destroy(srvInterface, argTypes);
+        }
+};
+
+// AESGCMEncryptForTenant encrypts VARCHAR values under the subkeys of their
+// tenants, see AESGCMTenantFunction. It is the counterpart to
+// AESGCMDecryptForTenant.
+//
+// The result column type is always a VARBINARY(X), where given an input column
+// VARCHAR(Y), X = Y + 28, or Y + 31 with a keyring. See
+// AESGCMEncryptForTenantFactory.
+class AESGCMEncryptForTenant: public AESGCMTenantFunction {
+    private:
+        AESGCMMessage batch[AESGCMMultiBuffer::max_messages];
+        size_t batch_size;
+        const AESGCMKey *batch_key;
+
+        void flush() {
+            if (batch_size > 0) {
+                AESGCMStopwatch crypto(&counters.crypto_ns);
+                batch_key->multi_buffer.encrypt(batch, batch_size);
+                batch_size = 0;
+            }
+        }
+
+    public:
+        AESGCMEncryptForTenant(): batch_size(0), batch_key(NULL) {
+            stats_name = "AESGCM_EncryptForTenant";
+        }
+
+        virtual void processBlock(ServerInterface &srvInterface,
+                BlockReader &arg_reader,
+                BlockWriter &res_writer) {
+            checkArguments(arg_reader);
+
+            // Reserve a nonce for each row of this call. The nonce is
+            // incremented after each encrypt.
+            unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES];
+            AESGCMNonce::reserve(arg_reader.getNumRows(), nonce);
+
+            const AESGCMKey *master = keyring->encryptionKey();
+            AESGCMHeader header;
+            if (keyring->hasKeyIds()) {
+                header.flags |= AESGCMHeader::KEY_ID;
+                header.key_id = keyring->encryptionKeyId();
+            }
+            unsigned char header_bytes[AESGCMHeader::max_length];
+            size_t header_length = header.encode(header_bytes);
+
+            AESGCMStopwatch process(&counters.process_ns);
+            counters.blocks++;
+
+            // Short values of consecutive rows of a tenant are queued and
+            // encrypted together once the batch is full or the tenant
+            // changes. The input and output strings of a block remain valid
+            // for the duration of processBlock.
+            batch_size = 0;
+
+            do {
+                counters.rows++;
+                if (arg_reader.isNull(1)) {
+                    counters.null_rows++;
+                    // Encrypting NULL returns NULL.
+                    res_writer.getStringRef().setNull();
+                    res_writer.next();
+                    continue;
+                }
+
+                const AESGCMKey *key = tenantKey(master, arg_reader);
+                if (key != batch_key) {
+                    flush();
+                }
+                batch_key = key;
+
+                VString plaintext = arg_reader.getStringRef(1);
+                const unsigned char *in = (const unsigned char *)plaintext.data();
+                size_t length = plaintext.length();
+
+                const unsigned char *associated_data = NULL;
+                size_t associated_data_length = 0;
+                readAssociatedData(arg_reader, associated_data, associated_data_length);
+
+                VString &nonce_and_ciphertext = res_writer.getStringRef();
+                nonce_and_ciphertext.alloc(header_length + length + overhead);
+                counters.bytes_in += length;
+                counters.bytes_out += header_length + length + overhead;
+
+                unsigned char *out = (unsigned char *)nonce_and_ciphertext.data();
+                memcpy(out, header_bytes, header_length);
+                memcpy(out + header_length, nonce, sizeof(nonce));
+                const unsigned char *row_nonce = out + header_length;
+                unsigned char *ciphertext = out + header_length + crypto_aead_aes256gcm_NPUBBYTES;
+
+                if (use_multi_buffer && length <= multi_buffer_length) {
+                    AESGCMMessage &message = batch[batch_size++];
+                    message.nonce = row_nonce;
+                    message.in = in;
+                    message.length = length;
+                    message.ad_prefix = out;
+                    message.ad_prefix_length = header_length;
+                    message.ad = associated_data;
+                    message.ad_length = associated_data_length;
+                    message.out = ciphertext;
+                    message.tag = ciphertext + length;
+                    if (batch_size == AESGCMMultiBuffer::max_messages) {
+                        flush();
+                    }
+                } else {
+                    AESGCMSampleStopwatch crypto(&counters);
+                    key->encrypt(engine,
+                            ciphertext,
+                            in, length,
+                            prefixAssociatedData(ad_scratch, out, header_length,
+                                associated_data, associated_data_length),
+                            header_length + associated_data_length,
+                            row_nonce);
+                }
+
+                sodium_increment(nonce, crypto_aead_aes256gcm_NPUBBYTES);
+
+                res_writer.next();
+            } while (arg_reader.next());
+
+            flush();
+        }
+};
+
+// AESGCMDecryptForTenant decrypts values written by AESGCMEncryptForTenant
+// with the subkeys of their tenants, see AESGCMTenantFunction. A value fails
+// to verify if it is decrypted for any tenant other than the one it was
+// encrypted for.
+//
+// The result column type is always a VARCHAR(X), where given an input column
+// VARBINARY(Y), X = Y - 28. See AESGCMDecryptForTenantFactory.
+class AESGCMDecryptForTenant: public AESGCMTenantFunction {
+    private:
+        // PendingRow is a row of the block waiting on a batch to be
+        // decrypted. NULL rows are queued as well so that rows are written in
+        // order once the batch is flushed.
+        struct PendingRow {
+            const unsigned char *value; // NULL for a NULL row
+            size_t value_length;
+            const unsigned char *ad;
+            size_t ad_length;
+            const unsigned char *tenant_id;
+            size_t tenant_id_length;
+            size_t message; // index into batch
+        };
+
+        static const size_t max_pending = 4 * AESGCMMultiBuffer::max_messages;
+
+        PendingRow pending[max_pending];
+        size_t pending_size;
+
+        // Batched values are decrypted into scratch and copied to their row
+        // once verified, since whether a value has a header (and so the
+        // length of its plaintext) is only known after verification.
+        AESGCMMessage batch[AESGCMMultiBuffer::max_messages];
+        size_t batch_size;
+        const AESGCMKey *batch_key;
+        unsigned char scratch[AESGCMMultiBuffer::max_messages][AESGCMMultiBuffer::max_length];
+
+        // Decrypts value with the subkeys of tenant_id as
+        // AESGCMFunction::decryptValue does with keys. Returns 0 and sets
+        // out_length if the value was verified, or -1 otherwise.
+        int decryptTenantValue(const unsigned char *value, size_t value_length,
+                const unsigned char *ad, size_t ad_length,
+                const unsigned char *tenant_id, size_t tenant_id_length,
+                unsigned char *out, size_t &out_length) {
+            AESGCMHeader header;
+            size_t header_length = header.decode(value, value_length);
+            const AESGCMKey *master = header_length > 0 ? findKey(header) : NULL;
+            if (master != NULL && value_length >= header_length + overhead) {
+                const AESGCMKey *key = tenant_keys.find(master, tenant_id, tenant_id_length);
+                const unsigned char *nonce = value + header_length;
+                if (key->decrypt(engine,
+                            out,
+                            nonce + crypto_aead_aes256gcm_NPUBBYTES,
+                            value_length - header_length - crypto_aead_aes256gcm_NPUBBYTES,
+                            prefixAssociatedData(ad_scratch, value, header_length, ad, ad_length),
+                            header_length + ad_length,
+                            nonce) == 0) {
+                    out_length = value_length - header_length - overhead;
+                    return 0;
+                }
+            }
+
+            out_length = 0;
+            const AESGCMKey *key = tenant_keys.find(keyring->legacyKey(),
+                    tenant_id, tenant_id_length);
+            if (key->decrypt(engine,
+                        out,
+                        value + crypto_aead_aes256gcm_NPUBBYTES,
+                        value_length - crypto_aead_aes256gcm_NPUBBYTES,
+                        ad, ad_length,
+                        value) != 0) {
+                return -1;
+            }
+            out_length = value_length - overhead;
+            return 0;
+        }
+
+        // Decrypts value into the current row, reporting an error if it
+        // fails to verify.
+        void decryptRow(const PendingRow &row, BlockWriter &res_writer) {
+            // Allocate for the longest interpretation of the value, then
+            // trim to the plaintext actually written.
+            VString &plaintext = res_writer.getStringRef();
+            plaintext.alloc(row.value_length - overhead);
+
+            size_t plaintext_length = 0;
+            int result;
+            {
+                AESGCMSampleStopwatch crypto(&counters);
+                result = decryptTenantValue(row.value, row.value_length, row.ad, row.ad_length,
+                        row.tenant_id, row.tenant_id_length,
+                        (unsigned char *)plaintext.data(), plaintext_length);
+            }
+            if (result != 0) {
+                counters.auth_failures++;
+                vt_report_error(0, "Failed to verify ciphertext in column '%s'", column_name.c_str());
+            }
+
+            plaintext.alloc(plaintext_length);
+            counters.bytes_out += plaintext_length;
+        }
+
+        // Queues row behind any pending rows, adding its value to the batch
+        // if it is short enough. Returns false if it is not, in which case
+        // it must be decrypted with decryptRow.
+        bool queue(const PendingRow &row, BlockWriter &res_writer) {
+            if (row.value != NULL) {
+                AESGCMHeader header;
+                size_t header_length = header.decode(row.value, row.value_length);
+                const AESGCMKey *master = header_length > 0 ? findKey(header) : keyring->legacyKey();
+                if (master == NULL || row.value_length < header_length + overhead ||
+                        row.value_length - header_length - overhead > multi_buffer_length) {
+                    return false;
+                }
+
+                const AESGCMKey *key = tenant_keys.find(master,
+                        row.tenant_id, row.tenant_id_length);
+                if (batch_size > 0 && key != batch_key) {
+                    flush(res_writer);
+                    // Rows decrypted one at a time by flush may have evicted
+                    // the key.
+                    key = tenant_keys.find(master, row.tenant_id, row.tenant_id_length);
+                }
+                batch_key = key;
+
+                size_t length = row.value_length - header_length - overhead;
+                const unsigned char *nonce = row.value + header_length;
+
+                AESGCMMessage &message = batch[batch_size];
+                message.nonce = nonce;
+                message.in = nonce + crypto_aead_aes256gcm_NPUBBYTES;
+                message.length = length;
+                message.ad_prefix = row.value;
+                message.ad_prefix_length = header_length;
+                message.ad = row.ad;
+                message.ad_length = row.ad_length;
+                message.out = scratch[batch_size];
+                message.tag = (unsigned char *)message.in + length;
+            }
+
+            PendingRow &queued = pending[pending_size++];
+            queued = row;
+            queued.message = batch_size;
+            if (row.value != NULL) {
+                batch_size++;
+            }
+
+            if (batch_size == AESGCMMultiBuffer::max_messages || pending_size == max_pending) {
+                flush(res_writer);
+            }
+            return true;
+        }
+
+        // Decrypts the pending batch and writes the pending rows.
+        void flush(BlockWriter &res_writer) {
+            if (batch_size > 0) {
+                AESGCMStopwatch crypto(&counters.crypto_ns);
+                batch_key->multi_buffer.decrypt(batch, batch_size);
+            }
+
+            for (size_t i = 0; i < pending_size; i++) {
+                const PendingRow &row = pending[i];
+                if (row.value == NULL) {
+                    // Decrypting NULL returns NULL.
+                    res_writer.getStringRef().setNull();
+                } else if (batch[row.message].result == 0) {
+                    const AESGCMMessage &message = batch[row.message];
+                    VString &plaintext = res_writer.getStringRef();
+                    plaintext.alloc(message.length);
+                    memcpy((unsigned char *)plaintext.data(), message.out, message.length);
+                    counters.bytes_out += message.length;
+                } else {
+                    // The value may be headerless but look like it has a
+                    // header.
+                    decryptRow(row, res_writer);
+                }
+                res_writer.next();
+            }
+
+            pending_size = 0;
+            batch_size = 0;
+        }
+
+    public:
+        AESGCMDecryptForTenant(): pending_size(0), batch_size(0), batch_key(NULL) {
+            stats_name = "AESGCM_DecryptForTenant";
+        }
+
+        virtual void processBlock(ServerInterface &srvInterface,
+                BlockReader &arg_reader,
+                BlockWriter &res_writer) {
+            checkArguments(arg_reader);
+
+            AESGCMStopwatch process(&counters.process_ns);
+            counters.blocks++;
+
+            // Short values of consecutive rows of a tenant are queued and
+            // decrypted together once the batch is full or the tenant
+            // changes. The input strings of a block remain valid for the
+            // duration of processBlock.
+            pending_size = 0;
+            batch_size = 0;
+
+            do {
+                PendingRow row = {NULL, 0, NULL, 0, NULL, 0, 0};
+
+                counters.rows++;
+                if (arg_reader.isNull(1)) {
+                    counters.null_rows++;
+                } else {
+                    if (arg_reader.isNull(0)) {
+                        vt_report_error(0, "Tenant ID for column '%s' is NULL",
+                                column_name.c_str());
+                    }
+                    VString tenant_id = arg_reader.getStringRef(0);
+                    row.tenant_id = (const unsigned char *)tenant_id.data();
+                    row.tenant_id_length = tenant_id.length();
+
+                    VString nonce_and_ciphertext = arg_reader.getStringRef(1);
+                    row.value = (const unsigned char *)nonce_and_ciphertext.data();
+                    row.value_length = nonce_and_ciphertext.length();
+                    counters.bytes_in += row.value_length;
+                    if (row.value_length < (size_t)overhead) {
+                        vt_report_error(0,
+                                "Ciphertext in column '%s' is too short (%zu) expected at least %zu",
+                                column_name.c_str(),
+                                row.value_length,
+                                overhead);
+                    }
+
+                    readAssociatedData(arg_reader, row.ad, row.ad_length);
+                }
+
+                if ((use_multi_buffer || row.value == NULL) && queue(row, res_writer)) {
+                    continue;
+                }
+
+                flush(res_writer);
+                decryptRow(row, res_writer);
+                res_writer.next();
+            } while (arg_reader.next());
+
+            flush(res_writer);
+        }
+};
+
+// AESGCMTenantFunctionFactory provides the parameters common to the factories
+// of AESGCMEncryptForTenant and AESGCMDecryptForTenant.
+class AESGCMTenantFunctionFactory: public AESGCMFunctionFactory {
+    public:
+        virtual void getParameterType(ServerInterface &srvInterface,
+                SizedColumnTypes &parameterTypes) {
+            addKeyParameter(parameterTypes);
+            addEngineParameter(parameterTypes);
+            addMultiBufferParameter(parameterTypes);
+
+            static const SizedColumnTypes::Properties tenant_keys_props(
+                    true, // Visible
+                    false, // Required
+                    false, // Can be NULL
+                    "Number of expanded tenant subkeys each instance keeps (default 64)." // Comment
+                );
+            parameterTypes.addInt(TENANT_KEYS_PARAM, tenant_keys_props);
+        }
+};
+
+// Exposes a scalar function taking as input a VARCHAR tenant ID and VARCHAR
+// and producing VARBINARY. See AESGCMEncryptForTenant.
+class AESGCMEncryptForTenantFactory: public AESGCMTenantFunctionFactory {
+    public:
+        AESGCMEncryptForTenantFactory() {
+            // For some given arguments, the results yielded are unique for
+            // the duration of the statement. The nonce generated should be
+            // different each invocation within a statement.
+            vol = VOLATILE;
+        }
+
+        virtual ScalarFunction *createScalarFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMEncryptForTenant);
+        }
+
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarchar();
+            argTypes.addVarchar();
+            returnType.addVarbinary();
+        }
+
+        virtual void getReturnType(ServerInterface &server,
+                const SizedColumnTypes &argTypes,
+                SizedColumnTypes &returnType) {
+            const VerticaType &t = argTypes.getColumnType(1);
+            returnType.addVarbinary(t.getStringLength() + AESGCMEncryptForTenant::overhead +
+                    headerLength(server, 0));
+        }
+};
+
+RegisterFactory(AESGCMEncryptForTenantFactory);
+
+// Exposes a scalar function taking as input a VARCHAR tenant ID and VARCHAR
+// as well as VARCHAR associated data and producing VARBINARY. See
+// AESGCMEncryptForTenant.
+class AESGCMEncryptForTenantWithVarcharADFactory: public AESGCMEncryptForTenantFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarchar();
+            argTypes.addVarchar();
+            argTypes.addVarchar();
+            returnType.addVarbinary();
+        }
+};
+
+RegisterFactory(AESGCMEncryptForTenantWithVarcharADFactory);
+
+// Exposes a scalar function taking as input a VARCHAR tenant ID and VARCHAR
+// as well as VARBINARY associated data and producing VARBINARY. See
+// AESGCMEncryptForTenant.
+class AESGCMEncryptForTenantWithVarbinaryADFactory: public AESGCMEncryptForTenantFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarchar();
+            argTypes.addVarchar();
+            argTypes.addVarbinary();
+            returnType.addVarbinary();
+        }
+};
+
+RegisterFactory(AESGCMEncryptForTenantWithVarbinaryADFactory);
+
+// Exposes a scalar function taking as input a VARCHAR tenant ID and VARBINARY
+// and producing VARCHAR. See AESGCMDecryptForTenant.
+class AESGCMDecryptForTenantFactory: public AESGCMTenantFunctionFactory {
+    public:
+        AESGCMDecryptForTenantFactory() {
+            // For some given arguments, the results yielded are the same for
+            // the duration of the statement. For example the encryption keys
+            // could change between statements.
+            vol = STABLE;
+        }
+
+        virtual ScalarFunction *createScalarFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMDecryptForTenant);
+        }
+
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarchar();
+            argTypes.addVarbinary();
+            returnType.addVarchar();
+        }
+
+        virtual void getReturnType(ServerInterface &server,
+                const SizedColumnTypes &argTypes,
+                SizedColumnTypes &returnType) {
+            const VerticaType &t = argTypes.getColumnType(1);
+            int length = t.getStringLength() - AESGCMDecryptForTenant::overhead;
+            // Length of a string in a return type must be greater than zero.
+            returnType.addVarchar(length > 0 ? length : 1);
+        }
+};
+
+RegisterFactory(AESGCMDecryptForTenantFactory);
+
+// Exposes a scalar function taking as input a VARCHAR tenant ID and VARBINARY
+// as well as VARCHAR associated data and producing VARCHAR. See
+// AESGCMDecryptForTenant.
+class AESGCMDecryptForTenantWithVarcharADFactory: public AESGCMDecryptForTenantFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarchar();
+            argTypes.addVarbinary();
+            argTypes.addVarchar();
+            returnType.addVarchar();
+        }
+};
+
+RegisterFactory(AESGCMDecryptForTenantWithVarcharADFactory);
+
+// Exposes a scalar function taking as input a VARCHAR tenant ID and VARBINARY
+// as well as VARBINARY associated data and producing VARCHAR. See
+// AESGCMDecryptForTenant.
+class AESGCMDecryptForTenantWithVarbinaryADFactory: public AESGCMDecryptForTenantFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarchar();
+            argTypes.addVarbinary();
+            argTypes.addVarbinary();
+            returnType.addVarchar();
+        }
+};
+
+RegisterFactory(AESGCMDecryptForTenantWithVarbinaryADFactory);
@@ -0,0 +1,114 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMTenantKeys.h"
+
+#include <cstring>
+
+AESGCMTenantKeys::AESGCMTenantKeys(size_t capacity, AESGCMEngine::Type engine)
+    : head(NULL), tail(NULL), capacity(capacity), engine(engine), miss_count(0) {}
+
+AESGCMTenantKeys::~AESGCMTenantKeys() {
+    clear();
+}
+
+void AESGCMTenantKeys::reset(size_t capacity, AESGCMEngine::Type engine) {
+    clear();
+    this->capacity = capacity;
+    this->engine = engine;
+}
+
+void AESGCMTenantKeys::clear() {
+    for (EntryMap::iterator it = entries.begin(); it != entries.end(); ++it) {
+        delete it->second;
+    }
+    entries.clear();
+    head = NULL;
+    tail = NULL;
+}
+
+void AESGCMTenantKeys::touch(Entry *entry) {
+    if (entry == head) {
+        return;
+    }
+
+    // Unlink.
+    if (entry->prev != NULL) {
+        entry->prev->next = entry->next;
+    }
+    if (entry->next != NULL) {
+        entry->next->prev = entry->prev;
+    }
+    if (entry == tail) {
+        tail = entry->prev;
+    }
+
+    entry->prev = NULL;
+    entry->next = head;
+    if (head != NULL) {
+        head->prev = entry;
+    }
+    head = entry;
+    if (tail == NULL) {
+        tail = entry;
+    }
+}
+
+const AESGCMKey *AESGCMTenantKeys::find(const AESGCMKey *master,
+        const unsigned char *tenant_id, size_t tenant_id_length) {
+    // Consecutive rows usually belong to the same tenant.
+    if (head != NULL && head->id.first == master &&
+            head->id.second.length() == tenant_id_length &&
+            (tenant_id_length == 0 ||
+             memcmp(head->id.second.data(), tenant_id, tenant_id_length) == 0)) {
+        return &head->key;
+    }
+
+    EntryId id(master, std::string((const char *)tenant_id, tenant_id_length));
+    EntryMap::iterator it = entries.find(id);
+    if (it != entries.end()) {
+        touch(it->second);
+        return &it->second->key;
+    }
+
+    Entry *entry;
+    if (entries.size() < capacity) {
+        entry = new Entry();
+        entry->prev = NULL;
+        entry->next = NULL;
+    } else {
+        // Reuse the least recently used entry, which is not the head since
+        // the capacity is at least 2.
+        entry = tail;
+        entries.erase(entry->id);
+    }
+    entry->id = id;
+
+    unsigned char subkey[crypto_aead_aes256gcm_KEYBYTES];
+    master->deriveTenantKey(tenant_id, tenant_id_length, subkey);
+    entry->key.initGCM(subkey, engine);
+    sodium_memzero(subkey, sizeof(subkey));
+    miss_count++;
+
+    entries[id] = entry;
+    touch(entry);
+    return &entry->key;
+}
@@ -0,0 +1,97 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef AESGCMTENANTKEYS_H_INCLUDED
+#define AESGCMTENANTKEYS_H_INCLUDED
+
+#include "AESGCMKeyring.h"
+
+#include <map>
+#include <string>
+#include <utility>
+
+// AESGCMTenantKeys is a bounded cache of the expanded subkeys of tenants (see
+// AESGCMKey::deriveTenantKey), owned by a single function instance. When it
+// is full, the least recently used subkey is evicted and its storage reused
+// for the next, so a scan over many interleaved tenants derives and expands
+// each subkey once for as long as it remains in use.
+//
+// Subkeys are expanded with AESGCMKey::initGCM for a single engine, and may
+// only be used for AES-GCM with it.
+//
+// The key returned by the last call to find is never evicted by the next, so
+// a batch of messages may be pending on it while the key of the next row is
+// looked up.
+class AESGCMTenantKeys {
+    public:
+        static const size_t default_capacity = 64;
+        static const size_t min_capacity = 2;
+        static const size_t max_capacity = 4096;
+
+        explicit AESGCMTenantKeys(size_t capacity = default_capacity,
+                AESGCMEngine::Type engine = AESGCMEngine::detect());
+        ~AESGCMTenantKeys();
+
+        // Sets the number of subkeys kept, between min_capacity and
+        // max_capacity, and the engine they are expanded for, evicting every
+        // subkey.
+        void reset(size_t capacity, AESGCMEngine::Type engine);
+
+        // Returns the subkey of the tenant with the given ID under master,
+        // deriving and expanding it if it is not cached. The key remains
+        // valid until it is evicted, after at least one more call.
+        const AESGCMKey *find(const AESGCMKey *master,
+                const unsigned char *tenant_id, size_t tenant_id_length);
+
+        // The number of subkeys derived and expanded since construction.
+        size_t misses() const { return miss_count; }
+
+    private:
+        typedef std::pair<const AESGCMKey *, std::string> EntryId;
+
+        // Entry is a cached subkey, linked into the list of entries from the
+        // most to the least recently used.
+        struct Entry {
+            AESGCMKey key;
+            EntryId id;
+            Entry *prev;
+            Entry *next;
+        };
+
+        typedef std::map<EntryId, Entry *> EntryMap;
+
+        EntryMap entries;
+        Entry *head; // most recently used
+        Entry *tail; // least recently used
+        size_t capacity;
+        AESGCMEngine::Type engine;
+        size_t miss_count;
+
+        // Moves entry to the head of the list.
+        void touch(Entry *entry);
+
+        void clear();
+
+        AESGCMTenantKeys(const AESGCMTenantKeys &);
+        AESGCMTenantKeys &operator=(const AESGCMTenantKeys &);
+};
+
+#endif /* AESGCMTENANTKEYS_H_INCLUDED */
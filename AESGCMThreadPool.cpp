@@ -0,0 +1,117 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMThreadPool.h"
+
+#include <algorithm>
+#include <deque>
+#include <pthread.h>
+#include <unistd.h>
+
+// Job is a single call to AESGCMThreadPool::run. It lives on the stack of the
+// caller, and is in the queue while it has indices which have not been taken.
+struct Job {
+    AESGCMThreadPool::Task task;
+    void *arg;
+    size_t count;
+    size_t next; // the next index to be taken
+    size_t done; // the number of indices completed
+};
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+static std::deque<Job *> queue;
+
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static size_t pool_size = 1;
+
+// Takes the next index of job, removing it from the queue once all indices
+// have been taken, and runs it. pool_mutex must be held, and is released
+// while the task runs.
+static void runNext(Job *job) {
+    size_t index = job->next++;
+    if (job->next == job->count) {
+        queue.erase(std::find(queue.begin(), queue.end(), job));
+    }
+
+    pthread_mutex_unlock(&pool_mutex);
+    job->task(job->arg, index);
+    pthread_mutex_lock(&pool_mutex);
+
+    if (++job->done == job->count) {
+        pthread_cond_broadcast(&done_cond);
+    }
+}
+
+static void *worker(void *) {
+    pthread_mutex_lock(&pool_mutex);
+    for (;;) {
+        while (queue.empty()) {
+            pthread_cond_wait(&work_cond, &pool_mutex);
+        }
+        runNext(queue.front());
+    }
+    return NULL;
+}
+
+static void startWorkers() {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t workers = cpus > 1 ? cpus - 1 : 0;
+    workers = std::min(workers, AESGCMThreadPool::max_threads - 1);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    for (size_t i = 0; i < workers; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, &attr, worker, NULL) == 0) {
+            pool_size++;
+        }
+    }
+    pthread_attr_destroy(&attr);
+}
+
+size_t AESGCMThreadPool::size() {
+    pthread_once(&pool_once, startWorkers);
+    return pool_size;
+}
+
+void AESGCMThreadPool::run(Task task, void *arg, size_t count) {
+    if (count == 0) {
+        return;
+    }
+    pthread_once(&pool_once, startWorkers);
+
+    Job job = {task, arg, count, 0, 0};
+
+    pthread_mutex_lock(&pool_mutex);
+    queue.push_back(&job);
+    pthread_cond_broadcast(&work_cond);
+
+    while (job.next < job.count) {
+        runNext(&job);
+    }
+    while (job.done < job.count) {
+        pthread_cond_wait(&done_cond, &pool_mutex);
+    }
+    pthread_mutex_unlock(&pool_mutex);
+}
@@ -0,0 +1,53 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef AESGCMTHREADPOOL_H_INCLUDED
+#define AESGCMTHREADPOOL_H_INCLUDED
+
+#include <stddef.h>
+
+// AESGCMThreadPool is a small, fixed, process-wide pool of worker threads used
+// to split large blocks across cores. The workers are started on first use
+// and live for the lifetime of the process, with one fewer worker than there
+// are online CPUs since the calling thread works as well.
+//
+// Tasks run on threads unknown to Vertica, so they must not call into the
+// Vertica SDK (including vt_report_error) or throw; errors should be recorded
+// and reported by the caller once run returns.
+class AESGCMThreadPool {
+    public:
+        typedef void (*Task)(void *arg, size_t index);
+
+        // The maximum number of threads, including the caller, working on a
+        // single call to run.
+        static const size_t max_threads = 16;
+
+        // Returns the number of threads, including the caller, which may work
+        // on a single call to run.
+        static size_t size();
+
+        // Runs task(arg, i) for each i in [0, count), on the calling thread
+        // and any idle workers, and returns once all have completed. Calls
+        // from several threads may run concurrently.
+        static void run(Task task, void *arg, size_t count);
+};
+
+#endif /* AESGCMTHREADPOOL_H_INCLUDED */
@@ -0,0 +1,347 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMFunction.h"
+
+#include <Vertica.h>
+#include <sodium.h>
+#include <vector>
+
+using namespace Vertica;
+
+// AESGCMVerify provides a Vertica Scalar Function which checks that values
+// written by AESGCMEncrypt are authentic, without decrypting them. It returns
+// true for values which AESGCMDecrypt would decrypt given the same key and
+// associated data, and false otherwise (including values too short to be
+// ciphertext), so a single bad row does not abort the scan.
+//
+// When the CPU supports it, only the GHASH of the associated data and
+// ciphertext and the encrypted tag mask are computed (see
+// AESGCMMultiBuffer::verify), and values are verified together in batches.
+// With the VAES engines only values up to a measured length are (384 bytes
+// with VAES512, 1024 with VAES256), as decrypting longer ones with
+// AESGCMWide costs less than hashing them 128 bits at a time. Otherwise values
+// are decrypted into scratch space owned by the instance, which is wiped
+// after each. Nothing is allocated per row.
+class AESGCMVerify: public AESGCMFunction {
+    private:
+        // PendingRow is a row of the block waiting on a batch to be verified.
+        // Rows whose result is already known are queued as well so that rows
+        // are written in order once the batch is flushed.
+        struct PendingRow {
+            const unsigned char *value; // NULL for a NULL row
+            size_t value_length;
+            const unsigned char *ad;
+            size_t ad_length;
+            int message; // index into batch, or -1 if result is known
+            vbool result;
+        };
+
+        static const size_t max_pending = 4 * AESGCMMultiBuffer::max_messages;
+
+        // The longest plaintexts whose tags are verified with
+        // AESGCMMultiBuffer with each VAES engine; longer values are
+        // decrypted with AESGCMWide, which is faster from there on, as
+        // measured with microbench.
+        static const size_t max_vaes256_ghash_length = 1024;
+        static const size_t max_vaes512_ghash_length = 384;
+
+        PendingRow pending[max_pending];
+        size_t pending_size;
+
+        AESGCMMessage batch[AESGCMMultiBuffer::max_messages];
+        size_t batch_size;
+        const AESGCMKey *batch_key;
+
+        // Tags are verified with AESGCMMultiBuffer rather than by
+        // decryption.
+        bool use_ghash;
+
+        // Decryption output for values which are not verified with
+        // AESGCMMultiBuffer.
+        std::vector<unsigned char> plaintext_scratch;
+
+        // Returns whether the tag of a value with a plaintext of length bytes
+        // is verified with AESGCMMultiBuffer: always when use_ghash is set,
+        // but with the VAES engines only up to their maximum length.
+        bool ghashVerifies(size_t length) const {
+            if (!use_ghash) {
+                return false;
+            }
+            switch (engine) {
+                case AESGCMEngine::VAES256:
+                    return length <= max_vaes256_ghash_length;
+                case AESGCMEngine::VAES512:
+                    return length <= max_vaes512_ghash_length;
+                default:
+                    return true;
+            }
+        }
+
+        // Fills message with the header (or headerless, if header_length is
+        // 0) interpretation of value. value must be at least header_length +
+        // overhead bytes long.
+        static void setMessage(AESGCMMessage &message,
+                const unsigned char *value, size_t value_length, size_t header_length,
+                const unsigned char *ad, size_t ad_length) {
+            size_t length = value_length - header_length - overhead;
+            const unsigned char *nonce = value + header_length;
+            message.nonce = nonce;
+            message.in = nonce + crypto_aead_aes256gcm_NPUBBYTES;
+            message.length = length;
+            message.ad_prefix = value;
+            message.ad_prefix_length = header_length;
+            message.ad = ad;
+            message.ad_length = ad_length;
+            message.out = NULL;
+            message.tag = (unsigned char *)message.in + length;
+        }
+
+        // Returns whether value verifies, trying it with a header and then
+        // as headerless as decryptValue does. value must be at least overhead
+        // bytes long. Only AES-GCM is verified without decrypting, see
+        // ghashVerifies.
+        bool verifyValue(const unsigned char *value, size_t value_length,
+                const unsigned char *ad, size_t ad_length) {
+            AESGCMHeader header;
+            size_t header_length = header.decode(value, value_length);
+            if (!ghashVerifies(value_length - overhead) ||
+                    (header.flags & AESGCMHeader::ALGORITHM)) {
+                size_t plaintext_length = 0;
+                plaintext_scratch.resize(value_length - overhead + 1);
+                bool verified = decryptValue(value, value_length, ad, ad_length,
+                        &plaintext_scratch[0], plaintext_length, ad_scratch) == 0;
+                // The plaintext is not returned, so it is not kept either.
+                sodium_memzero(&plaintext_scratch[0], plaintext_scratch.size());
+                return verified;
+            }
+
+            AESGCMMessage message;
+            const AESGCMKey *key = header_length > 0 ? findKey(header) : NULL;
+            if (key != NULL && value_length >= header_length + overhead) {
+                setMessage(message, value, value_length, header_length, ad, ad_length);
+                key->multi_buffer.verify(&message, 1);
+                if (message.result == 0) {
+                    return true;
+                }
+            }
+
+            setMessage(message, value, value_length, 0, ad, ad_length);
+            keyring->legacyKey()->multi_buffer.verify(&message, 1);
+            return message.result == 0;
+        }
+
+        // Queues a row behind any pending rows. A non-NULL value which is at
+        // least overhead bytes long is added to the batch, unless it names
+        // an algorithm other than AES-GCM or is too long for ghashVerifies,
+        // in which case it is verified now.
+        void queue(const unsigned char *value, size_t value_length,
+                const unsigned char *ad, size_t ad_length,
+                BlockWriter &res_writer) {
+            int message = -1;
+            vbool result = value == NULL ? vbool_null : vbool_false;
+
+            if (value != NULL && value_length >= (size_t)overhead) {
+                AESGCMHeader header;
+                size_t header_length = header.decode(value, value_length);
+                const AESGCMKey *key = header_length > 0 ? findKey(header) : keyring->legacyKey();
+                if (key == NULL || value_length < header_length + overhead) {
+                    // Only the headerless interpretation is possible.
+                    key = keyring->legacyKey();
+                    header_length = 0;
+                }
+
+                if ((header_length > 0 && (header.flags & AESGCMHeader::ALGORITHM)) ||
+                        !ghashVerifies(value_length - header_length - overhead)) {
+                    result = verifyValue(value, value_length, ad, ad_length) ?
+                        vbool_true : vbool_false;
+                } else {
+                    if (batch_size > 0 && key != batch_key) {
+                        flush(res_writer);
+                    }
+                    batch_key = key;
+
+                    setMessage(batch[batch_size], value, value_length, header_length, ad, ad_length);
+                    message = batch_size++;
+                }
+            }
+
+            PendingRow &row = pending[pending_size++];
+            row.value = value;
+            row.value_length = value_length;
+            row.ad = ad;
+            row.ad_length = ad_length;
+            row.message = message;
+            row.result = result;
+
+            if (batch_size == AESGCMMultiBuffer::max_messages || pending_size == max_pending) {
+                flush(res_writer);
+            }
+        }
+
+        // Verifies the pending batch and writes the pending rows.
+        void flush(BlockWriter &res_writer) {
+            if (batch_size > 0) {
+                batch_key->multi_buffer.verify(batch, batch_size);
+            }
+
+            for (size_t i = 0; i < pending_size; i++) {
+                const PendingRow &row = pending[i];
+                vbool result = row.result;
+                if (row.message >= 0) {
+                    // The value may be headerless but look like it has a
+                    // header.
+                    result = batch[row.message].result == 0 ||
+                        (batch[row.message].ad_prefix_length > 0 &&
+                         verifyValue(row.value, row.value_length, row.ad, row.ad_length)) ?
+                        vbool_true : vbool_false;
+                }
+                res_writer.setBool(result);
+                res_writer.next();
+            }
+
+            pending_size = 0;
+            batch_size = 0;
+        }
+
+    public:
+        AESGCMVerify(): pending_size(0), batch_size(0), batch_key(NULL), use_ghash(false) {}
+
+        virtual void setup(ServerInterface &srvInterface, const SizedColumnTypes &argTypes) {
+            AESGCMFunction::setup(srvInterface, argTypes);
+            use_ghash = engine >= AESGCMEngine::AESNI;
+        }
+
+        virtual void processBlock(ServerInterface &srvInterface,
+                BlockReader &arg_reader,
+                BlockWriter &res_writer) {
+            if (arg_reader.getNumCols() < 1 || arg_reader.getNumCols() > 2) {
+                vt_report_error(0, "Function accepts either 1 or 2 arguments, but %zu provided",
+                        arg_reader.getNumCols());
+            }
+
+            // Values are queued and verified together once the batch is
+            // full. The input strings of a block remain valid for the
+            // duration of processBlock.
+            pending_size = 0;
+            batch_size = 0;
+
+            do {
+                const unsigned char *value = NULL;
+                size_t value_length = 0;
+                if (!arg_reader.isNull(0)) {
+                    VString nonce_and_ciphertext = arg_reader.getStringRef(0);
+                    value = (unsigned char *)nonce_and_ciphertext.data();
+                    value_length = nonce_and_ciphertext.length();
+                }
+
+                const unsigned char *associated_data = NULL;
+                size_t associated_data_length = 0;
+                if (arg_reader.getNumCols() > 1 && !arg_reader.isNull(1)) {
+                    VString ad = arg_reader.getStringRef(1);
+                    associated_data_length = ad.length();
+                    if (associated_data_length > 0) {
+                        associated_data = (unsigned char *)ad.data();
+                    }
+                }
+
+                if (use_multi_buffer) {
+                    queue(value, value_length, associated_data, associated_data_length,
+                            res_writer);
+                    continue;
+                }
+
+                if (value == NULL) {
+                    // Verifying NULL returns NULL.
+                    res_writer.setBool(vbool_null);
+                } else {
+                    res_writer.setBool(value_length >= (size_t)overhead &&
+                            verifyValue(value, value_length,
+                                associated_data, associated_data_length) ?
+                            vbool_true : vbool_false);
+                }
+                res_writer.next();
+            } while (arg_reader.next());
+
+            flush(res_writer);
+        }
+};
+
+// Exposes a scalar function taking as input VARBINARY and producing BOOLEAN.
+// See AESGCMVerify.
+class AESGCMVerifyFactory: public AESGCMFunctionFactory {
+    public:
+        AESGCMVerifyFactory() {
+            // For some given arguments, the results yielded are the same for
+            // the duration of the statement. For example the encryption keys
+            // could change between statements.
+            vol = STABLE;
+        }
+
+        virtual ScalarFunction *createScalarFunction(ServerInterface &server) {
+            return vt_createFuncObj(server.allocator, AESGCMVerify);
+        }
+
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarbinary();
+            returnType.addBool();
+        }
+
+        virtual void getReturnType(ServerInterface &server,
+                const SizedColumnTypes &argTypes,
+                SizedColumnTypes &returnType) {
+            returnType.addBool();
+        }
+};
+
+RegisterFactory(AESGCMVerifyFactory);
+
+// Exposes a scalar function taking as input VARBINARY as well as VARCHAR
+// associated data and producing BOOLEAN. See AESGCMVerify.
+class AESGCMVerifyWithVarcharADFactory: public AESGCMVerifyFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarbinary();
+            argTypes.addVarchar();
+            returnType.addBool();
+        }
+};
+
+RegisterFactory(AESGCMVerifyWithVarcharADFactory);
+
+// Exposes a scalar function taking as input VARBINARY as well as VARBINARY
+// associated data and producing BOOLEAN. See AESGCMVerify.
+class AESGCMVerifyWithVarbinaryADFactory: public AESGCMVerifyFactory {
+    public:
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) {
+            argTypes.addVarbinary();
+            argTypes.addVarbinary();
+            returnType.addBool();
+        }
+};
+
+RegisterFactory(AESGCMVerifyWithVarbinaryADFactory);
@@ -0,0 +1,87 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMWide.h"
+
+#include <sodium.h>
+#include <cstring>
+
+AESGCMWide::AESGCMWide() {
+    memset(round_keys, 0, sizeof(round_keys));
+    memset(h_powers, 0, sizeof(h_powers));
+}
+
+AESGCMWide::~AESGCMWide() {
+    sodium_memzero(round_keys, sizeof(round_keys));
+    sodium_memzero(h_powers, sizeof(h_powers));
+}
+
+void AESGCMWide::encrypt(Width width, unsigned char *out, const unsigned char *in, size_t length,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES]) const {
+    if (width == ZMM) {
+        crypt512(false, out, in, length, ad, ad_length, nonce, out + length);
+    } else {
+        crypt256(false, out, in, length, ad, ad_length, nonce, out + length);
+    }
+}
+
+int AESGCMWide::decrypt(Width width, unsigned char *out, const unsigned char *in, size_t length,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES]) const {
+    unsigned char tag[crypto_aead_aes256gcm_ABYTES];
+    if (width == ZMM) {
+        crypt512(true, out, in, length, ad, ad_length, nonce, tag);
+    } else {
+        crypt256(true, out, in, length, ad, ad_length, nonce, tag);
+    }
+    if (crypto_verify_16(tag, in + length) != 0) {
+        sodium_memzero(out, length);
+        return -1;
+    }
+    return 0;
+}
+
+#if AESGCM_WIDE
+
+#include "AESGCMKernel.h"
+
+KERNEL void AESGCMWide::init(const unsigned char key[crypto_aead_aes256gcm_KEYBYTES]) {
+    __m128i *rk = (__m128i *)round_keys;
+    expandKey(key, rk);
+
+    __m128i h = _mm_setzero_si128();
+    encryptBlocks(rk, &h, 1);
+    h = bswap(h);
+
+    __m128i *hp = (__m128i *)h_powers;
+    hp[15] = h;
+    for (int i = 14; i >= 0; i--) {
+        hp[i] = gfmul(hp[i + 1], h);
+    }
+}
+
+#else
+
+void AESGCMWide::init(const unsigned char key[crypto_aead_aes256gcm_KEYBYTES]) {
+}
+
+#endif
@@ -0,0 +1,95 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef AESGCMWIDE_H_INCLUDED
+#define AESGCMWIDE_H_INCLUDED
+
+#include <sodium.h>
+
+#include <stddef.h>
+
+// The VAES and VPCLMULQDQ intrinsics need GCC 8 or later.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && \
+    (defined(__clang__) || __GNUC__ >= 8)
+#   define AESGCM_WIDE 1
+#else
+#   define AESGCM_WIDE 0
+#endif
+
+// AESGCMWide encrypts and decrypts single AES256-GCM messages with the VAES
+// and VPCLMULQDQ extensions, which apply AESENC and PCLMULQDQ to each 128-bit
+// lane of a 256-bit (AVX2) or 512-bit (AVX-512) register. Each iteration
+// encrypts four registers of counter blocks (8 or 16 blocks) and folds the
+// GHASH of the ciphertext into the running hash with a single reduction,
+// using a precomputed vector of powers of H for each register. Results are
+// byte-for-byte identical to libsodium's AES256-GCM.
+//
+// The width is chosen per call, so that an engine (see AESGCMEngine) can be
+// lowered without expanding the key again; the caller must check that the
+// CPU supports it.
+class AESGCMWide {
+    public:
+        enum Width {
+            YMM, // 256-bit registers, AVX2
+            ZMM // 512-bit registers, AVX-512
+        };
+
+        AESGCMWide();
+        ~AESGCMWide();
+
+        // Expands the key with AES-NI. Must be called before encrypt or
+        // decrypt, and only when AESGCMMultiBuffer::isAvailable().
+        void init(const unsigned char key[crypto_aead_aes256gcm_KEYBYTES]);
+
+        // Encrypts length bytes of in to out, followed by the tag, as
+        // crypto_aead_aes256gcm_encrypt_afternm.
+        void encrypt(Width width, unsigned char *out, const unsigned char *in, size_t length,
+                const unsigned char *ad, size_t ad_length,
+                const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES]) const;
+
+        // Verifies and decrypts in, length bytes of ciphertext followed by
+        // the tag, to out, as crypto_aead_aes256gcm_decrypt_afternm. Returns 0
+        // if verified, or -1 otherwise in which case out is zeroed.
+        int decrypt(Width width, unsigned char *out, const unsigned char *in, size_t length,
+                const unsigned char *ad, size_t ad_length,
+                const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES]) const;
+
+    private:
+        // Expanded AES256 round keys.
+        CRYPTO_ALIGN(16) unsigned char round_keys[15][16];
+        // H^16 down to H^1 in the byte-reflected form used for GHASH, so that
+        // the powers for the last n blocks of a chunk are contiguous.
+        CRYPTO_ALIGN(16) unsigned char h_powers[16][16];
+
+        // Encrypts or decrypts length bytes of in to out and writes the tag
+        // of the ciphertext, with 256-bit (AESGCMWide256.cpp) or 512-bit
+        // (AESGCMWide512.cpp) registers.
+        void crypt256(bool decrypting, unsigned char *out, const unsigned char *in, size_t length,
+                const unsigned char *ad, size_t ad_length,
+                const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES],
+                unsigned char tag[crypto_aead_aes256gcm_ABYTES]) const;
+        void crypt512(bool decrypting, unsigned char *out, const unsigned char *in, size_t length,
+                const unsigned char *ad, size_t ad_length,
+                const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES],
+                unsigned char tag[crypto_aead_aes256gcm_ABYTES]) const;
+};
+
+#endif /* AESGCMWIDE_H_INCLUDED */
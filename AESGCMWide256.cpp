@@ -0,0 +1,84 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMWide.h"
+
+#if AESGCM_WIDE
+
+#include <immintrin.h>
+
+#pragma GCC push_options
+#pragma GCC target("avx2,vaes,vpclmulqdq,aes,pclmul,ssse3,sse4.1")
+
+// Ymm is the 256-bit register type for wideCrypt: two blocks per register.
+struct Ymm {
+    typedef __m256i Register;
+    static const size_t lanes = 2;
+
+    static inline __m256i broadcast(__m128i x) { return _mm256_broadcastsi128_si256(x); }
+    static inline __m256i low(__m128i x) { return _mm256_inserti128_si256(_mm256_setzero_si256(), x, 0); }
+    static inline __m256i load(const __m128i *p) { return _mm256_loadu_si256((const __m256i *)p); }
+    static inline __m256i loadu(const unsigned char *p) { return _mm256_loadu_si256((const __m256i *)p); }
+    static inline void storeu(unsigned char *p, __m256i x) { _mm256_storeu_si256((__m256i *)p, x); }
+    static inline __m256i xor_(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+    static inline __m256i add32(__m256i a, __m256i b) { return _mm256_add_epi32(a, b); }
+    static inline __m256i laneCounters(int base) { return _mm256_set_epi32(0, 0, 0, base + 1, 0, 0, 0, base); }
+    static inline __m256i sameCounters(int n) { return _mm256_set_epi32(0, 0, 0, n, 0, 0, 0, n); }
+    static inline __m256i aesenc(__m256i a, __m256i k) { return _mm256_aesenc_epi128(a, k); }
+    static inline __m256i aesenclast(__m256i a, __m256i k) { return _mm256_aesenclast_epi128(a, k); }
+    static inline __m256i clmul00(__m256i a, __m256i b) { return _mm256_clmulepi64_epi128(a, b, 0x00); }
+    static inline __m256i clmul01(__m256i a, __m256i b) { return _mm256_clmulepi64_epi128(a, b, 0x01); }
+    static inline __m256i clmul10(__m256i a, __m256i b) { return _mm256_clmulepi64_epi128(a, b, 0x10); }
+    static inline __m256i clmul11(__m256i a, __m256i b) { return _mm256_clmulepi64_epi128(a, b, 0x11); }
+
+    static inline __m256i bswap(__m256i x) {
+        return _mm256_shuffle_epi8(x, _mm256_set_epi8(
+                    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    }
+
+    // XORs the lanes together.
+    static inline __m128i fold(__m256i x) {
+        return _mm_xor_si128(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+    }
+};
+
+#include "AESGCMWideKernel.h"
+
+void AESGCMWide::crypt256(bool decrypting, unsigned char *out, const unsigned char *in, size_t length,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES],
+        unsigned char tag[crypto_aead_aes256gcm_ABYTES]) const {
+    wideCrypt<Ymm>((const __m128i *)round_keys, (const __m128i *)h_powers, decrypting,
+            out, in, length, ad, ad_length, nonce, tag);
+}
+
+#pragma GCC pop_options
+
+#else
+
+void AESGCMWide::crypt256(bool decrypting, unsigned char *out, const unsigned char *in, size_t length,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES],
+        unsigned char tag[crypto_aead_aes256gcm_ABYTES]) const {
+}
+
+#endif
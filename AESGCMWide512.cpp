@@ -0,0 +1,93 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "AESGCMWide.h"
+
+#if AESGCM_WIDE
+
+#include <immintrin.h>
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw,avx2,vaes,vpclmulqdq,aes,pclmul,ssse3,sse4.1")
+
+// Zmm is the 512-bit register type for wideCrypt: four blocks per register.
+struct Zmm {
+    typedef __m512i Register;
+    static const size_t lanes = 4;
+
+    static inline __m512i broadcast(__m128i x) { return _mm512_maskz_broadcast_i32x4(0xffff, x); }
+    static inline __m512i low(__m128i x) { return _mm512_inserti32x4(_mm512_setzero_si512(), x, 0); }
+    static inline __m512i load(const __m128i *p) { return _mm512_loadu_si512((const void *)p); }
+    static inline __m512i loadu(const unsigned char *p) { return _mm512_loadu_si512((const void *)p); }
+    static inline void storeu(unsigned char *p, __m512i x) { _mm512_storeu_si512((void *)p, x); }
+    static inline __m512i xor_(__m512i a, __m512i b) { return _mm512_xor_si512(a, b); }
+    static inline __m512i add32(__m512i a, __m512i b) { return _mm512_add_epi32(a, b); }
+    static inline __m512i aesenc(__m512i a, __m512i k) { return _mm512_aesenc_epi128(a, k); }
+    static inline __m512i aesenclast(__m512i a, __m512i k) { return _mm512_aesenclast_epi128(a, k); }
+    static inline __m512i clmul00(__m512i a, __m512i b) { return _mm512_clmulepi64_epi128(a, b, 0x00); }
+    static inline __m512i clmul01(__m512i a, __m512i b) { return _mm512_clmulepi64_epi128(a, b, 0x01); }
+    static inline __m512i clmul10(__m512i a, __m512i b) { return _mm512_clmulepi64_epi128(a, b, 0x10); }
+    static inline __m512i clmul11(__m512i a, __m512i b) { return _mm512_clmulepi64_epi128(a, b, 0x11); }
+
+    static inline __m512i laneCounters(int base) {
+        return _mm512_set_epi32(0, 0, 0, base + 3, 0, 0, 0, base + 2,
+                0, 0, 0, base + 1, 0, 0, 0, base);
+    }
+
+    static inline __m512i sameCounters(int n) {
+        return _mm512_set_epi32(0, 0, 0, n, 0, 0, 0, n, 0, 0, 0, n, 0, 0, 0, n);
+    }
+
+    static inline __m512i bswap(__m512i x) {
+        return _mm512_shuffle_epi8(x, broadcast(
+                    _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)));
+    }
+
+    // XORs the lanes together. The masked forms avoid GCC's
+    // -Wmaybe-uninitialized false positives for the unmasked extracts.
+    static inline __m128i fold(__m512i x) {
+        __m256i y = _mm256_xor_si256(_mm512_maskz_extracti64x4_epi64(0xff, x, 0),
+                _mm512_maskz_extracti64x4_epi64(0xff, x, 1));
+        return _mm_xor_si128(_mm256_castsi256_si128(y), _mm256_extracti128_si256(y, 1));
+    }
+};
+
+#include "AESGCMWideKernel.h"
+
+void AESGCMWide::crypt512(bool decrypting, unsigned char *out, const unsigned char *in, size_t length,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES],
+        unsigned char tag[crypto_aead_aes256gcm_ABYTES]) const {
+    wideCrypt<Zmm>((const __m128i *)round_keys, (const __m128i *)h_powers, decrypting,
+            out, in, length, ad, ad_length, nonce, tag);
+}
+
+#pragma GCC pop_options
+
+#else
+
+void AESGCMWide::crypt512(bool decrypting, unsigned char *out, const unsigned char *in, size_t length,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES],
+        unsigned char tag[crypto_aead_aes256gcm_ABYTES]) const {
+}
+
+#endif
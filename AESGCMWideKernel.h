@@ -0,0 +1,182 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef AESGCMWIDEKERNEL_H_INCLUDED
+#define AESGCMWIDEKERNEL_H_INCLUDED
+
+// AESGCMWideKernel.h holds the body of AESGCMWide::crypt256 and crypt512,
+// written against a register type V which provides the operations below on
+// each of its V::lanes 128-bit lanes. It is included by AESGCMWide256.cpp and
+// AESGCMWide512.cpp after defining V, under a target pragma enabling the
+// instructions V uses.
+
+#include "AESGCMKernel.h"
+
+// Folds length bytes of data into the GHASH y, sixteen blocks per reduction.
+// hp is H^16 down to H^1.
+KERNEL static inline __m128i ghashChunks(__m128i y, const __m128i *hp,
+        const unsigned char *data, size_t length) {
+    while (length > 0) {
+        size_t chunk = length < 256 ? length : 256;
+        size_t n = (chunk + 15) / 16;
+        const __m128i *h = hp + 16 - n;
+        __m128i lo = _mm_setzero_si128(), mid = _mm_setzero_si128(), hi = _mm_setzero_si128();
+        for (size_t i = 0; i < n; i++) {
+            size_t block = chunk - i * 16 < 16 ? chunk - i * 16 : 16;
+            __m128i x = bswap(loadPartial(data + i * 16, block));
+            if (i == 0) {
+                x = _mm_xor_si128(x, y);
+            }
+            clmulAccumulate(x, h[i], lo, mid, hi);
+        }
+        y = reduce(lo, mid, hi);
+        data += chunk;
+        length -= chunk;
+    }
+    return y;
+}
+
+template <class V>
+static inline void wideCrypt(const __m128i *rk, const __m128i *hp, bool decrypting,
+        unsigned char *out, const unsigned char *in, size_t length,
+        const unsigned char *ad, size_t ad_length,
+        const unsigned char nonce[crypto_aead_aes256gcm_NPUBBYTES],
+        unsigned char tag[crypto_aead_aes256gcm_ABYTES]) {
+    typedef typename V::Register R;
+    static const size_t stride = 4 * V::lanes * 16;
+
+    CRYPTO_ALIGN(16) unsigned char j0[16] = {0};
+    memcpy(j0, nonce, crypto_aead_aes256gcm_NPUBBYTES);
+    j0[15] = 1;
+    __m128i mask = _mm_load_si128((const __m128i *)j0);
+    encryptBlocks(rk, &mask, 1);
+
+    __m128i y = ghashChunks(_mm_setzero_si128(), hp, ad, ad_length);
+
+    size_t offset = 0;
+    if (length >= stride) {
+        R keys[15];
+        for (int r = 0; r < 15; r++) {
+            keys[r] = V::broadcast(rk[r]);
+        }
+        // The powers of H for each register of a stride, highest first.
+        R h0 = V::load(hp + 16 - 4 * V::lanes);
+        R h1 = V::load(hp + 16 - 3 * V::lanes);
+        R h2 = V::load(hp + 16 - 2 * V::lanes);
+        R h3 = V::load(hp + 16 - 1 * V::lanes);
+
+        // Counters are kept byte-reflected, so that the 32-bit block counter
+        // is the low word of each lane and is incremented with an add.
+        R ctr = V::add32(V::broadcast(bswap(_mm_load_si128((const __m128i *)j0))),
+                V::laneCounters(1));
+        R step = V::sameCounters(V::lanes);
+
+        for (; offset + stride <= length; offset += stride) {
+            R c0 = ctr;
+            R c1 = V::add32(c0, step);
+            R c2 = V::add32(c1, step);
+            R c3 = V::add32(c2, step);
+            ctr = V::add32(c3, step);
+
+            R b0 = V::xor_(V::bswap(c0), keys[0]);
+            R b1 = V::xor_(V::bswap(c1), keys[0]);
+            R b2 = V::xor_(V::bswap(c2), keys[0]);
+            R b3 = V::xor_(V::bswap(c3), keys[0]);
+            for (int r = 1; r < 14; r++) {
+                b0 = V::aesenc(b0, keys[r]);
+                b1 = V::aesenc(b1, keys[r]);
+                b2 = V::aesenc(b2, keys[r]);
+                b3 = V::aesenc(b3, keys[r]);
+            }
+            b0 = V::aesenclast(b0, keys[14]);
+            b1 = V::aesenclast(b1, keys[14]);
+            b2 = V::aesenclast(b2, keys[14]);
+            b3 = V::aesenclast(b3, keys[14]);
+
+            const unsigned char *src = in + offset;
+            unsigned char *dst = out + offset;
+            R x0 = V::loadu(src);
+            R x1 = V::loadu(src + V::lanes * 16);
+            R x2 = V::loadu(src + V::lanes * 32);
+            R x3 = V::loadu(src + V::lanes * 48);
+            b0 = V::xor_(b0, x0);
+            b1 = V::xor_(b1, x1);
+            b2 = V::xor_(b2, x2);
+            b3 = V::xor_(b3, x3);
+            V::storeu(dst, b0);
+            V::storeu(dst + V::lanes * 16, b1);
+            V::storeu(dst + V::lanes * 32, b2);
+            V::storeu(dst + V::lanes * 48, b3);
+
+            // Hash the ciphertext: the input when decrypting, the output when
+            // encrypting.
+            if (!decrypting) {
+                x0 = b0;
+                x1 = b1;
+                x2 = b2;
+                x3 = b3;
+            }
+            x0 = V::xor_(V::bswap(x0), V::low(y));
+            x1 = V::bswap(x1);
+            x2 = V::bswap(x2);
+            x3 = V::bswap(x3);
+            R lo = V::xor_(V::xor_(V::clmul00(x0, h0), V::clmul00(x1, h1)),
+                    V::xor_(V::clmul00(x2, h2), V::clmul00(x3, h3)));
+            R hi = V::xor_(V::xor_(V::clmul11(x0, h0), V::clmul11(x1, h1)),
+                    V::xor_(V::clmul11(x2, h2), V::clmul11(x3, h3)));
+            R mid = V::xor_(V::xor_(V::clmul01(x0, h0), V::clmul01(x1, h1)),
+                    V::xor_(V::clmul01(x2, h2), V::clmul01(x3, h3)));
+            mid = V::xor_(mid, V::xor_(V::xor_(V::clmul10(x0, h0), V::clmul10(x1, h1)),
+                    V::xor_(V::clmul10(x2, h2), V::clmul10(x3, h3))));
+            y = reduce(V::fold(lo), V::fold(mid), V::fold(hi));
+        }
+        // The remainder and the tag are computed with SSE code, which stalls
+        // on the upper halves of the wide registers unless they are cleared.
+        _mm256_zeroupper();
+    }
+
+    // The remainder, less than a stride, with 128-bit registers.
+    size_t rest = length - offset;
+    if (rest > 0) {
+        __m128i blocks[4 * V::lanes];
+        size_t n = (rest + 15) / 16;
+        unsigned int counter = (unsigned int)(2 + offset / 16);
+        __m128i base = _mm_load_si128((const __m128i *)j0);
+        for (size_t i = 0; i < n; i++) {
+            blocks[i] = _mm_insert_epi32(base, (int)__builtin_bswap32(counter + (unsigned int)i), 3);
+        }
+        encryptBlocks(rk, blocks, n);
+        if (decrypting) {
+            y = ghashChunks(y, hp, in + offset, rest);
+            applyKeystream(blocks, in + offset, out + offset, rest);
+        } else {
+            applyKeystream(blocks, in + offset, out + offset, rest);
+            y = ghashChunks(y, hp, out + offset, rest);
+        }
+        sodium_memzero(blocks, sizeof(blocks));
+    }
+
+    __m128i lengths = _mm_set_epi64x((long long)ad_length * 8, (long long)length * 8);
+    y = gfmul(_mm_xor_si128(y, lengths), hp[15]);
+    _mm_storeu_si128((__m128i *)tag, _mm_xor_si128(bswap(y), mask));
+}
+
+#endif /* AESGCMWIDEKERNEL_H_INCLUDED */
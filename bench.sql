@@ -0,0 +1,278 @@
+\set libfile '\''`pwd`'/aesgcm.so\''
+
+-- Install the library with a benchmark prefix.
+CREATE OR REPLACE LIBRARY BENCH_AESGCM AS :libfile;
+CREATE OR REPLACE FUNCTION BENCH_AESGCM_Decrypt AS LANGUAGE 'C++' NAME 'AESGCMDecryptFactory' LIBRARY BENCH_AESGCM;
+CREATE OR REPLACE FUNCTION BENCH_AESGCM_Decrypt AS LANGUAGE 'C++' NAME 'AESGCMDecryptWithVarcharADFactory' LIBRARY BENCH_AESGCM;
+CREATE OR REPLACE FUNCTION BENCH_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptFactory' LIBRARY BENCH_AESGCM;
+CREATE OR REPLACE FUNCTION BENCH_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptWithVarcharADFactory' LIBRARY BENCH_AESGCM;
+
+-- Global variables. :rows is set by `make bench' (BENCH_ROWS), e.g.
+-- vsql -v rows=10000000 -f bench.sql.
+\set keyfile '\''`pwd`'/test-key.hex\''
+
+-- Benchmark harness variables. Each benchmark prints a header row naming it
+-- and counting the rows of :table, then runs SELECT :expression FROM :table
+-- with \timing on. parse-bench.sh turns the timings into rows/s.
+\set bench_header 'SELECT ''BENCHMARK'' AS benchmark, :description AS description, COUNT(*) AS rows FROM :table'
+
+-- Tables left behind by an interrupted run.
+DROP TABLE IF EXISTS bench_aesgcm_numbers;
+DROP TABLE IF EXISTS bench_aesgcm_short;
+DROP TABLE IF EXISTS bench_aesgcm_short_encrypted;
+DROP TABLE IF EXISTS bench_aesgcm_short_nulls;
+DROP TABLE IF EXISTS bench_aesgcm_short_nulls_encrypted;
+DROP TABLE IF EXISTS bench_aesgcm_medium;
+DROP TABLE IF EXISTS bench_aesgcm_medium_encrypted;
+DROP TABLE IF EXISTS bench_aesgcm_long;
+DROP TABLE IF EXISTS bench_aesgcm_long_encrypted;
+DROP TABLE IF EXISTS bench_aesgcm_wide;
+DROP TABLE IF EXISTS bench_aesgcm_wide_encrypted;
+
+-- Tables. Values are hex digits of deterministic lengths, so runs are
+-- comparable; every table but long has :rows rows.
+--
+--   short        8 to 64 bytes, no NULLs, with associated data.
+--   short_nulls  8 to 64 bytes, half NULL, without associated data.
+--   medium       64 to 512 bytes, 10% NULL, with associated data.
+--   long         512 to 4096 bytes, 10% NULL, without associated data,
+--                :rows / 10 rows.
+--   wide         four columns (24, 16, 64 and 256 bytes) encrypted
+--                separately, as in a table with several sensitive columns.
+CREATE TABLE bench_aesgcm_numbers AS
+    SELECT DATEDIFF('second', '2000-01-01 00:00:00'::TIMESTAMP, ts) AS n FROM (
+        SELECT '2000-01-01 00:00:00'::TIMESTAMP AS t
+        UNION ALL
+        SELECT '2000-01-01 00:00:00'::TIMESTAMP + (:rows - 1) * INTERVAL '1 second'
+    ) AS bounds TIMESERIES ts AS '1 second' OVER (ORDER BY t);
+
+CREATE TABLE bench_aesgcm_short AS
+    SELECT n,
+        SUBSTR(REPEAT(MD5(n::VARCHAR), 2), 1, 8 + HASH(n) % 57)::VARCHAR(64) AS v,
+        ('tenant:' || n % 1000)::VARCHAR(16) AS ad
+    FROM bench_aesgcm_numbers;
+
+CREATE TABLE bench_aesgcm_short_nulls AS
+    SELECT n,
+        CASE WHEN HASH(n) % 2 = 0 THEN NULL
+            ELSE SUBSTR(REPEAT(MD5(n::VARCHAR), 2), 1, 8 + HASH(n, 1) % 57) END::VARCHAR(64) AS v
+    FROM bench_aesgcm_numbers;
+
+CREATE TABLE bench_aesgcm_medium AS
+    SELECT n,
+        CASE WHEN HASH(n) % 10 = 0 THEN NULL
+            ELSE SUBSTR(REPEAT(MD5(n::VARCHAR), 16), 1, 64 + HASH(n, 1) % 449) END::VARCHAR(512) AS v,
+        ('tenant:' || n % 1000)::VARCHAR(16) AS ad
+    FROM bench_aesgcm_numbers;
+
+CREATE TABLE bench_aesgcm_long AS
+    SELECT n,
+        CASE WHEN HASH(n) % 10 = 0 THEN NULL
+            ELSE SUBSTR(REPEAT(MD5(n::VARCHAR), 128), 1, 512 + HASH(n, 1) % 3585) END::VARCHAR(4096) AS v
+    FROM bench_aesgcm_numbers
+    WHERE n < :rows / 10;
+
+CREATE TABLE bench_aesgcm_wide AS
+    SELECT n,
+        SUBSTR(MD5(n::VARCHAR), 1, 24)::VARCHAR(24) AS email,
+        SUBSTR(MD5((n + 1)::VARCHAR), 1, 16)::VARCHAR(16) AS name,
+        REPEAT(MD5((n + 2)::VARCHAR), 2)::VARCHAR(64) AS address,
+        REPEAT(MD5((n + 3)::VARCHAR), 8)::VARCHAR(256) AS note
+    FROM bench_aesgcm_numbers;
+
+-- Ciphertexts of each table, for the decryption benchmarks.
+CREATE TABLE bench_aesgcm_short_encrypted AS
+    SELECT n, BENCH_AESGCM_Encrypt(v, ad USING PARAMETERS key=:keyfile) AS v, ad FROM bench_aesgcm_short;
+CREATE TABLE bench_aesgcm_short_nulls_encrypted AS
+    SELECT n, BENCH_AESGCM_Encrypt(v USING PARAMETERS key=:keyfile) AS v FROM bench_aesgcm_short_nulls;
+CREATE TABLE bench_aesgcm_medium_encrypted AS
+    SELECT n, BENCH_AESGCM_Encrypt(v, ad USING PARAMETERS key=:keyfile) AS v, ad FROM bench_aesgcm_medium;
+CREATE TABLE bench_aesgcm_long_encrypted AS
+    SELECT n, BENCH_AESGCM_Encrypt(v USING PARAMETERS key=:keyfile) AS v FROM bench_aesgcm_long;
+CREATE TABLE bench_aesgcm_wide_encrypted AS
+    SELECT n,
+        BENCH_AESGCM_Encrypt(email USING PARAMETERS key=:keyfile) AS email,
+        BENCH_AESGCM_Encrypt(name USING PARAMETERS key=:keyfile) AS name,
+        BENCH_AESGCM_Encrypt(address USING PARAMETERS key=:keyfile) AS address,
+        BENCH_AESGCM_Encrypt(note USING PARAMETERS key=:keyfile) AS note
+    FROM bench_aesgcm_wide;
+
+-- Short values with associated data.
+\set table 'bench_aesgcm_short'
+
+\set description '\'scan short values\''
+\set expression  'SUM(LENGTH(v))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+\set description '\'encrypt short values with AD\''
+\set expression  'SUM(LENGTH(BENCH_AESGCM_Encrypt(v, ad USING PARAMETERS key=:keyfile)))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+\set description '\'encrypt then decrypt short values with AD\''
+\set expression  'SUM(LENGTH(BENCH_AESGCM_Decrypt(BENCH_AESGCM_Encrypt(v, ad USING PARAMETERS key=:keyfile), ad USING PARAMETERS key=:keyfile)))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+\set table 'bench_aesgcm_short_encrypted'
+
+\set description '\'decrypt short values with AD\''
+\set expression  'SUM(LENGTH(BENCH_AESGCM_Decrypt(v, ad USING PARAMETERS key=:keyfile)))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+-- Short values, half of them NULL, without associated data.
+\set table 'bench_aesgcm_short_nulls'
+
+\set description '\'encrypt short values, half NULL\''
+\set expression  'SUM(LENGTH(BENCH_AESGCM_Encrypt(v USING PARAMETERS key=:keyfile)))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+\set description '\'encrypt then decrypt short values, half NULL\''
+\set expression  'SUM(LENGTH(BENCH_AESGCM_Decrypt(BENCH_AESGCM_Encrypt(v USING PARAMETERS key=:keyfile) USING PARAMETERS key=:keyfile)))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+\set table 'bench_aesgcm_short_nulls_encrypted'
+
+\set description '\'decrypt short values, half NULL\''
+\set expression  'SUM(LENGTH(BENCH_AESGCM_Decrypt(v USING PARAMETERS key=:keyfile)))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+-- Medium values with associated data.
+\set table 'bench_aesgcm_medium'
+
+\set description '\'scan medium values\''
+\set expression  'SUM(LENGTH(v))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+\set description '\'encrypt medium values with AD\''
+\set expression  'SUM(LENGTH(BENCH_AESGCM_Encrypt(v, ad USING PARAMETERS key=:keyfile)))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+\set description '\'encrypt then decrypt medium values with AD\''
+\set expression  'SUM(LENGTH(BENCH_AESGCM_Decrypt(BENCH_AESGCM_Encrypt(v, ad USING PARAMETERS key=:keyfile), ad USING PARAMETERS key=:keyfile)))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+\set table 'bench_aesgcm_medium_encrypted'
+
+\set description '\'decrypt medium values with AD\''
+\set expression  'SUM(LENGTH(BENCH_AESGCM_Decrypt(v, ad USING PARAMETERS key=:keyfile)))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+\set description '\'decrypt medium values with AD, 4 threads\''
+\set expression  'SUM(LENGTH(BENCH_AESGCM_Decrypt(v, ad USING PARAMETERS key=:keyfile, threads=4)))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+-- Long values without associated data.
+\set table 'bench_aesgcm_long'
+
+\set description '\'scan long values\''
+\set expression  'SUM(LENGTH(v))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+\set description '\'encrypt long values\''
+\set expression  'SUM(LENGTH(BENCH_AESGCM_Encrypt(v USING PARAMETERS key=:keyfile)))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+\set description '\'encrypt then decrypt long values\''
+\set expression  'SUM(LENGTH(BENCH_AESGCM_Decrypt(BENCH_AESGCM_Encrypt(v USING PARAMETERS key=:keyfile) USING PARAMETERS key=:keyfile)))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+\set table 'bench_aesgcm_long_encrypted'
+
+\set description '\'decrypt long values\''
+\set expression  'SUM(LENGTH(BENCH_AESGCM_Decrypt(v USING PARAMETERS key=:keyfile)))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+-- A plan reading four columns, in plaintext and encrypted separately.
+\set table 'bench_aesgcm_wide'
+
+\set description '\'scan four plaintext columns\''
+\set expression  'SUM(LENGTH(email) + LENGTH(name) + LENGTH(address) + LENGTH(note))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+\set description '\'encrypt four columns\''
+\set expression  'SUM(LENGTH(BENCH_AESGCM_Encrypt(email USING PARAMETERS key=:keyfile)) + LENGTH(BENCH_AESGCM_Encrypt(name USING PARAMETERS key=:keyfile)) + LENGTH(BENCH_AESGCM_Encrypt(address USING PARAMETERS key=:keyfile)) + LENGTH(BENCH_AESGCM_Encrypt(note USING PARAMETERS key=:keyfile)))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+\set table 'bench_aesgcm_wide_encrypted'
+
+\set description '\'decrypt one of four encrypted columns\''
+\set expression  'SUM(LENGTH(BENCH_AESGCM_Decrypt(email USING PARAMETERS key=:keyfile)))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+\set description '\'decrypt four encrypted columns\''
+\set expression  'SUM(LENGTH(BENCH_AESGCM_Decrypt(email USING PARAMETERS key=:keyfile)) + LENGTH(BENCH_AESGCM_Decrypt(name USING PARAMETERS key=:keyfile)) + LENGTH(BENCH_AESGCM_Decrypt(address USING PARAMETERS key=:keyfile)) + LENGTH(BENCH_AESGCM_Decrypt(note USING PARAMETERS key=:keyfile)))'
+:bench_header;
+\timing
+SELECT :expression FROM :table;
+\timing
+
+DROP TABLE bench_aesgcm_numbers;
+DROP TABLE bench_aesgcm_short;
+DROP TABLE bench_aesgcm_short_encrypted;
+DROP TABLE bench_aesgcm_short_nulls;
+DROP TABLE bench_aesgcm_short_nulls_encrypted;
+DROP TABLE bench_aesgcm_medium;
+DROP TABLE bench_aesgcm_medium_encrypted;
+DROP TABLE bench_aesgcm_long;
+DROP TABLE bench_aesgcm_long_encrypted;
+DROP TABLE bench_aesgcm_wide;
+DROP TABLE bench_aesgcm_wide_encrypted;
+
+-- Uninstall the benchmark-prefix library.
+DROP LIBRARY BENCH_AESGCM CASCADE;
@@ -6,6 +6,87 @@ CREATE OR REPLACE LIBRARY AESGCM AS :libfile;
 CREATE OR REPLACE FUNCTION AESGCM_Decrypt AS LANGUAGE 'C++' NAME 'AESGCMDecryptFactory' LIBRARY AESGCM;
 CREATE OR REPLACE FUNCTION AESGCM_Decrypt AS LANGUAGE 'C++' NAME 'AESGCMDecryptWithVarcharADFactory' LIBRARY AESGCM;
 CREATE OR REPLACE FUNCTION AESGCM_Decrypt AS LANGUAGE 'C++' NAME 'AESGCMDecryptWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Decrypt AS LANGUAGE 'C++' NAME 'AESGCMDecryptLongFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Decrypt AS LANGUAGE 'C++' NAME 'AESGCMDecryptLongWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Decrypt AS LANGUAGE 'C++' NAME 'AESGCMDecryptLongWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptBase64 AS LANGUAGE 'C++' NAME 'AESGCMDecryptBase64Factory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptBase64 AS LANGUAGE 'C++' NAME 'AESGCMDecryptBase64WithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptBase64 AS LANGUAGE 'C++' NAME 'AESGCMDecryptBase64WithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptDate AS LANGUAGE 'C++' NAME 'AESGCMDecryptDateFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptDate AS LANGUAGE 'C++' NAME 'AESGCMDecryptDateWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptDate AS LANGUAGE 'C++' NAME 'AESGCMDecryptDateWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptDeterministic AS LANGUAGE 'C++' NAME 'AESGCMDecryptDeterministicFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptDeterministic AS LANGUAGE 'C++' NAME 'AESGCMDecryptDeterministicWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptDeterministic AS LANGUAGE 'C++' NAME 'AESGCMDecryptDeterministicWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptEquals AS LANGUAGE 'C++' NAME 'AESGCMDecryptEqualsFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptEquals AS LANGUAGE 'C++' NAME 'AESGCMDecryptEqualsWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptEquals AS LANGUAGE 'C++' NAME 'AESGCMDecryptEqualsWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptFloat AS LANGUAGE 'C++' NAME 'AESGCMDecryptFloatFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptFloat AS LANGUAGE 'C++' NAME 'AESGCMDecryptFloatWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptFloat AS LANGUAGE 'C++' NAME 'AESGCMDecryptFloatWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptForTenant AS LANGUAGE 'C++' NAME 'AESGCMDecryptForTenantFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptForTenant AS LANGUAGE 'C++' NAME 'AESGCMDecryptForTenantWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptForTenant AS LANGUAGE 'C++' NAME 'AESGCMDecryptForTenantWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptHex AS LANGUAGE 'C++' NAME 'AESGCMDecryptHexFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptHex AS LANGUAGE 'C++' NAME 'AESGCMDecryptHexWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptHex AS LANGUAGE 'C++' NAME 'AESGCMDecryptHexWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptInt AS LANGUAGE 'C++' NAME 'AESGCMDecryptIntFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptInt AS LANGUAGE 'C++' NAME 'AESGCMDecryptIntWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptInt AS LANGUAGE 'C++' NAME 'AESGCMDecryptIntWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptNumeric AS LANGUAGE 'C++' NAME 'AESGCMDecryptNumericFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptNumeric AS LANGUAGE 'C++' NAME 'AESGCMDecryptNumericWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptNumeric AS LANGUAGE 'C++' NAME 'AESGCMDecryptNumericWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptRange AS LANGUAGE 'C++' NAME 'AESGCMDecryptRangeFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptRange AS LANGUAGE 'C++' NAME 'AESGCMDecryptRangeWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptRange AS LANGUAGE 'C++' NAME 'AESGCMDecryptRangeWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE TRANSFORM FUNCTION AESGCM_DecryptRow AS LANGUAGE 'C++' NAME 'AESGCMDecryptRowFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptStartsWith AS LANGUAGE 'C++' NAME 'AESGCMDecryptStartsWithFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptStartsWith AS LANGUAGE 'C++' NAME 'AESGCMDecryptStartsWithWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptStartsWith AS LANGUAGE 'C++' NAME 'AESGCMDecryptStartsWithWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptTimestamp AS LANGUAGE 'C++' NAME 'AESGCMDecryptTimestampFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptTimestamp AS LANGUAGE 'C++' NAME 'AESGCMDecryptTimestampWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_DecryptTimestamp AS LANGUAGE 'C++' NAME 'AESGCMDecryptTimestampWithVarbinaryADFactory' LIBRARY AESGCM;
 CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptFactory' LIBRARY AESGCM;
 CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptWithVarcharADFactory' LIBRARY AESGCM;
 CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptIntFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptIntWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptIntWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptFloatFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptFloatWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptFloatWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptDateFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptDateWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptDateWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptTimestampFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptTimestampWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptTimestampWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptNumericFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptNumericWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptNumericWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptLongFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptLongWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptLongWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_EncryptBase64 AS LANGUAGE 'C++' NAME 'AESGCMEncryptBase64Factory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_EncryptBase64 AS LANGUAGE 'C++' NAME 'AESGCMEncryptBase64WithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_EncryptBase64 AS LANGUAGE 'C++' NAME 'AESGCMEncryptBase64WithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_EncryptDeterministic AS LANGUAGE 'C++' NAME 'AESGCMEncryptDeterministicFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_EncryptDeterministic AS LANGUAGE 'C++' NAME 'AESGCMEncryptDeterministicWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_EncryptDeterministic AS LANGUAGE 'C++' NAME 'AESGCMEncryptDeterministicWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_EncryptForTenant AS LANGUAGE 'C++' NAME 'AESGCMEncryptForTenantFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_EncryptForTenant AS LANGUAGE 'C++' NAME 'AESGCMEncryptForTenantWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_EncryptForTenant AS LANGUAGE 'C++' NAME 'AESGCMEncryptForTenantWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_EncryptHex AS LANGUAGE 'C++' NAME 'AESGCMEncryptHexFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_EncryptHex AS LANGUAGE 'C++' NAME 'AESGCMEncryptHexWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_EncryptHex AS LANGUAGE 'C++' NAME 'AESGCMEncryptHexWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_EncryptRow AS LANGUAGE 'C++' NAME 'AESGCMEncryptRowFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Engine AS LANGUAGE 'C++' NAME 'AESGCMEngineFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Reencrypt AS LANGUAGE 'C++' NAME 'AESGCMReencryptFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Reencrypt AS LANGUAGE 'C++' NAME 'AESGCMReencryptWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Reencrypt AS LANGUAGE 'C++' NAME 'AESGCMReencryptWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE TRANSFORM FUNCTION AESGCM_Stats AS LANGUAGE 'C++' NAME 'AESGCMStatsFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Verify AS LANGUAGE 'C++' NAME 'AESGCMVerifyFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Verify AS LANGUAGE 'C++' NAME 'AESGCMVerifyWithVarcharADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FUNCTION AESGCM_Verify AS LANGUAGE 'C++' NAME 'AESGCMVerifyWithVarbinaryADFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FILTER AESGCM_DecryptFilter AS LANGUAGE 'C++' NAME 'AESGCMDecryptFilterFactory' LIBRARY AESGCM;
+CREATE OR REPLACE FILTER AESGCM_EncryptFilter AS LANGUAGE 'C++' NAME 'AESGCMEncryptFilterFactory' LIBRARY AESGCM;
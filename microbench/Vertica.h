@@ -0,0 +1,541 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// A minimal stand-in for the subset of the Vertica SDK used by this UDx. It
+// allows the function classes to be compiled and driven outside of a Vertica
+// server by the microbenchmark (see microbench.cpp). Only the members the UDx
+// actually uses are provided, and their semantics are simplified: there is a
+// single block per processBlock call and allocations are plain heap
+// allocations.
+//
+// This header is found before the real SDK's Vertica.h only when building the
+// microbench target; it is never linked into aesgcm.so.
+
+#ifndef MICROBENCH_VERTICA_H_INCLUDED
+#define MICROBENCH_VERTICA_H_INCLUDED
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Vertica {
+
+typedef size_t vsize;
+typedef int64_t vint;
+typedef double vfloat;
+typedef uint8_t vbool;
+
+const vbool vbool_false = 0;
+const vbool vbool_true = 1;
+const vbool vbool_null = 2;
+
+typedef vint DateADT;
+typedef vint TimestampADT;
+
+// NULL INTEGER, DATE and TIMESTAMP values are the smallest vint, and NULL
+// FLOAT values a NaN.
+const vint vint_null = (vint)0x8000000000000000ULL;
+const vfloat vfloat_null = std::numeric_limits<vfloat>::quiet_NaN();
+
+// VNumeric is a view of the 64-bit words of a NUMERIC value.
+struct VNumeric {
+    uint64_t *words;
+
+    void setNull() { words[0] = 0x8000000000000000ULL; }
+};
+
+enum volatility {
+    DEFAULT_VOLATILITY,
+    VOLATILE,
+    IMMUTABLE,
+    STABLE
+};
+
+// The exception thrown by vt_report_error. Vertica turns this into an ERROR
+// for the statement; the microbenchmark treats it as fatal.
+class UDxException: public std::runtime_error {
+    public:
+        UDxException(int errcode, const std::string &message)
+            : std::runtime_error(message), errcode(errcode) {}
+        int errcode;
+};
+
+inline std::string vt_format(const char *fmt, ...) {
+    char buf[1024];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    return buf;
+}
+
+#define vt_report_error(errcode, args...) \
+    throw ::Vertica::UDxException(errcode, ::Vertica::vt_format(args))
+
+#define vt_createFuncObj(allocator, type, args...) new type(args)
+
+// VString is a (pointer, length) view of string data. Strings handed out by
+// BlockWriter point at a fixed-size slot sized from the return type.
+class VString {
+    private:
+        char *ptr;
+        vsize len;
+        vsize capacity;
+        bool null;
+
+    public:
+        VString(): ptr(NULL), len(0), capacity(0), null(true) {}
+        VString(char *ptr, vsize len, vsize capacity)
+            : ptr(ptr), len(len), capacity(capacity), null(false) {}
+
+        const char *data() const { return ptr; }
+        char *data() { return ptr; }
+        vsize length() const { return len; }
+        bool isNull() const { return null; }
+        void setNull() { null = true; len = 0; }
+        std::string str() const { return std::string(ptr, len); }
+
+        void alloc(vsize length) {
+            if (length > capacity) {
+                vt_report_error(0, "VString::alloc(%zu) exceeds column width %zu",
+                        length, capacity);
+            }
+            len = length;
+            null = false;
+        }
+
+        void copy(const char *src, vsize length) {
+            alloc(length);
+            memcpy(ptr, src, length);
+        }
+};
+
+enum BaseType {
+    BoolType,
+    IntType,
+    FloatType,
+    DateType,
+    TimestampType,
+    NumericType,
+    VarcharType,
+    VarbinaryType,
+    LongVarcharType,
+    LongVarbinaryType
+};
+
+class VerticaType {
+    private:
+        BaseType base;
+        int32_t string_length;
+        int32_t precision;
+        int32_t scale;
+
+    public:
+        VerticaType(BaseType base, int32_t string_length,
+                int32_t precision = 0, int32_t scale = 0)
+            : base(base), string_length(string_length), precision(precision), scale(scale) {}
+
+        int32_t getStringLength() const { return string_length; }
+        int32_t getNumericPrecision() const { return precision; }
+        int32_t getNumericScale() const { return scale; }
+        bool isVarchar() const { return base == VarcharType; }
+        bool isVarbinary() const { return base == VarbinaryType; }
+        bool isLongVarchar() const { return base == LongVarcharType; }
+        bool isLongVarbinary() const { return base == LongVarbinaryType; }
+        bool isStringType() const {
+            return base == VarcharType || base == VarbinaryType ||
+                base == LongVarcharType || base == LongVarbinaryType;
+        }
+        bool isInt() const { return base == IntType; }
+        bool isFloat() const { return base == FloatType; }
+        bool isBool() const { return base == BoolType; }
+};
+
+class ColumnTypes {
+    private:
+        std::vector<BaseType> types;
+
+    public:
+        void addVarchar() { types.push_back(VarcharType); }
+        void addVarbinary() { types.push_back(VarbinaryType); }
+        void addLongVarchar() { types.push_back(LongVarcharType); }
+        void addLongVarbinary() { types.push_back(LongVarbinaryType); }
+        void addBool() { types.push_back(BoolType); }
+        void addInt() { types.push_back(IntType); }
+        void addFloat() { types.push_back(FloatType); }
+        void addDate() { types.push_back(DateType); }
+        void addTimestamp() { types.push_back(TimestampType); }
+        void addNumeric() { types.push_back(NumericType); }
+        // Polymorphic functions declare a single argument of any type; the
+        // stand-in does not check arguments against the prototype.
+        void addAny() {}
+        size_t getColumnCount() const { return types.size(); }
+        BaseType getColumnType(size_t i) const { return types[i]; }
+};
+
+class SizedColumnTypes {
+    public:
+        struct Properties {
+            Properties(bool visible = true, bool required = false,
+                    bool canBeNull = true, const std::string &comment = "")
+                : visible(visible), required(required), canBeNull(canBeNull),
+                  comment(comment) {}
+            bool visible;
+            bool required;
+            bool canBeNull;
+            std::string comment;
+        };
+
+    private:
+        std::vector<VerticaType> types;
+        std::vector<std::string> names;
+
+    public:
+        void addVarchar(int32_t length, const std::string &name = "",
+                Properties props = Properties()) {
+            types.push_back(VerticaType(VarcharType, length));
+            names.push_back(name);
+        }
+
+        void addVarbinary(int32_t length, const std::string &name = "",
+                Properties props = Properties()) {
+            types.push_back(VerticaType(VarbinaryType, length));
+            names.push_back(name);
+        }
+
+        void addLongVarchar(int32_t length, const std::string &name = "",
+                Properties props = Properties()) {
+            types.push_back(VerticaType(LongVarcharType, length));
+            names.push_back(name);
+        }
+
+        void addLongVarbinary(int32_t length, const std::string &name = "",
+                Properties props = Properties()) {
+            types.push_back(VerticaType(LongVarbinaryType, length));
+            names.push_back(name);
+        }
+
+        // A BOOLEAN occupies a single byte slot in a block.
+        void addBool(const std::string &name = "", Properties props = Properties()) {
+            types.push_back(VerticaType(BoolType, sizeof(vbool)));
+            names.push_back(name);
+        }
+
+        void addInt(const std::string &name = "", Properties props = Properties()) {
+            types.push_back(VerticaType(IntType, 0));
+            names.push_back(name);
+        }
+
+        void addFloat(const std::string &name = "", Properties props = Properties()) {
+            types.push_back(VerticaType(FloatType, 0));
+            names.push_back(name);
+        }
+
+        void addDate(const std::string &name = "", Properties props = Properties()) {
+            types.push_back(VerticaType(DateType, 0));
+            names.push_back(name);
+        }
+
+        void addTimestamp(int32_t precision, const std::string &name = "",
+                Properties props = Properties()) {
+            types.push_back(VerticaType(TimestampType, 0, precision));
+            names.push_back(name);
+        }
+
+        void addNumeric(int32_t precision, int32_t scale, const std::string &name = "",
+                Properties props = Properties()) {
+            types.push_back(VerticaType(NumericType, 0, precision, scale));
+            names.push_back(name);
+        }
+
+        size_t getColumnCount() const { return types.size(); }
+        const VerticaType &getColumnType(size_t i) const { return types[i]; }
+        const std::string &getColumnName(size_t i) const { return names[i]; }
+};
+
+class ParamReader {
+    private:
+        std::map<std::string, std::string> params;
+
+    public:
+        void setParameter(const std::string &name, const std::string &value) {
+            params[name] = value;
+        }
+
+        bool containsParameter(const std::string &name) const {
+            return params.find(name) != params.end();
+        }
+
+        VString getStringRef(const std::string &name) {
+            std::map<std::string, std::string>::iterator it = params.find(name);
+            if (it == params.end()) {
+                vt_report_error(0, "Parameter \"%s\" not found", name.c_str());
+            }
+            return VString(&it->second[0], it->second.length(), it->second.length());
+        }
+
+        vbool getBoolRef(const std::string &name) {
+            std::string value = getStringRef(name).str();
+            return value == "true" ? vbool_true : value == "false" ? vbool_false : vbool_null;
+        }
+
+        vint getIntRef(const std::string &name) {
+            return strtoll(getStringRef(name).str().c_str(), NULL, 10);
+        }
+};
+
+struct VTAllocator {};
+
+class ServerInterface {
+    private:
+        ParamReader params;
+
+    public:
+        VTAllocator *allocator;
+
+        ServerInterface(): allocator(NULL) {}
+
+        ParamReader &getParamReader() { return params; }
+
+        void log(const char *fmt, ...) {
+            va_list ap;
+            va_start(ap, fmt);
+            vfprintf(stderr, fmt, ap);
+            va_end(ap);
+            fputc('\n', stderr);
+        }
+};
+
+struct VResources {
+    VResources(): nFileHandles(0), scratchMemory(0) {}
+    int nFileHandles;
+    vint scratchMemory;
+};
+
+// BlockReader iterates over rows of borrowed columns. A NULL data pointer
+// marks a NULL value; the data of an INTEGER, FLOAT or BOOLEAN value points
+// at a vint, vfloat or vbool.
+class BlockReader {
+    public:
+        struct Column {
+            std::vector<const char *> data;
+            std::vector<vsize> lengths;
+        };
+
+    private:
+        const std::vector<Column> &columns;
+        size_t begin;
+        size_t end;
+        size_t row;
+        VNumeric numeric;
+
+    public:
+        BlockReader(const std::vector<Column> &columns, size_t begin, size_t end)
+            : columns(columns), begin(begin), end(end), row(begin) {}
+
+        size_t getNumCols() const { return columns.size(); }
+        size_t getNumRows() const { return end - begin; }
+
+        bool isNull(size_t col) const { return columns[col].data[row] == NULL; }
+
+        const VString getStringRef(size_t col) const {
+            return VString((char *)columns[col].data[row],
+                    columns[col].lengths[row], columns[col].lengths[row]);
+        }
+
+        const vint &getIntRef(size_t col) const {
+            return *(const vint *)columns[col].data[row];
+        }
+
+        const vfloat &getFloatRef(size_t col) const {
+            return *(const vfloat *)columns[col].data[row];
+        }
+
+        const vbool &getBoolRef(size_t col) const {
+            return *(const vbool *)columns[col].data[row];
+        }
+
+        const DateADT &getDateRef(size_t col) const {
+            return *(const DateADT *)columns[col].data[row];
+        }
+
+        const TimestampADT &getTimestampRef(size_t col) const {
+            return *(const TimestampADT *)columns[col].data[row];
+        }
+
+        // The words of a NUMERIC are stored in place of the string.
+        const VNumeric &getNumericRef(size_t col) {
+            numeric.words = (uint64_t *)columns[col].data[row];
+            return numeric;
+        }
+
+        bool next() { return ++row < end; }
+};
+
+// BlockWriter writes rows into fixed-width slots of a caller-owned buffer.
+class BlockWriter {
+    private:
+        std::vector<char> &buffer;
+        std::vector<VString> &values;
+        vsize width;
+        size_t row;
+        VNumeric numeric;
+
+    public:
+        BlockWriter(std::vector<char> &buffer, std::vector<VString> &values, vsize width)
+            : buffer(buffer), values(values), width(width), row(0) {
+            values[0] = VString(&buffer[0], 0, width);
+        }
+
+        VString &getStringRef() { return values[row]; }
+
+        void setBool(vbool value) { buffer[row * width] = (char)value; }
+
+        // Fixed-width values are written to the start of their row's slot.
+        void setInt(vint value) { memcpy(&buffer[row * width], &value, sizeof(value)); }
+        void setFloat(vfloat value) { memcpy(&buffer[row * width], &value, sizeof(value)); }
+        void setDate(DateADT value) { setInt(value); }
+        void setTimestamp(TimestampADT value) { setInt(value); }
+
+        VNumeric &getNumericRef() {
+            numeric.words = (uint64_t *)&buffer[row * width];
+            return numeric;
+        }
+
+        void next() {
+            if (++row < values.size()) {
+                values[row] = VString(&buffer[row * width], 0, width);
+            }
+        }
+};
+
+class ScalarFunction {
+    public:
+        virtual ~ScalarFunction() {}
+        virtual void setup(ServerInterface &srvInterface,
+                const SizedColumnTypes &argTypes) {}
+        virtual void destroy(ServerInterface &srvInterface,
+                const SizedColumnTypes &argTypes) {}
+        virtual void processBlock(ServerInterface &srvInterface,
+                BlockReader &arg_reader,
+                BlockWriter &res_writer) = 0;
+};
+
+class UDXFactory {
+    public:
+        virtual ~UDXFactory() {}
+};
+
+class ScalarFunctionFactory: public UDXFactory {
+    public:
+        ScalarFunctionFactory(): vol(DEFAULT_VOLATILITY), strict(false) {}
+
+        volatility vol;
+        bool strict;
+
+        virtual ScalarFunction *createScalarFunction(ServerInterface &server) = 0;
+        virtual void getPrototype(ServerInterface &server,
+                ColumnTypes &argTypes,
+                ColumnTypes &returnType) = 0;
+        virtual void getReturnType(ServerInterface &server,
+                const SizedColumnTypes &argTypes,
+                SizedColumnTypes &returnType) = 0;
+        virtual void getParameterType(ServerInterface &srvInterface,
+                SizedColumnTypes &parameterTypes) {}
+        virtual void getPerInstanceResources(ServerInterface &srvInterface,
+                VResources &res) {}
+};
+
+// DataBuffer is a window onto a buffer of the stream passed through a
+// UDFilter; offset is advanced past the bytes consumed or produced.
+struct DataBuffer {
+    char *buf;
+    size_t size;
+    size_t offset;
+};
+
+enum InputState {
+    OK,
+    END_OF_FILE
+};
+
+enum StreamState {
+    DONE,
+    INPUT_NEEDED,
+    OUTPUT_NEEDED
+};
+
+class PlanContext {};
+
+class UDFilter {
+    public:
+        virtual ~UDFilter() {}
+        virtual void setup(ServerInterface &srvInterface) {}
+        virtual void destroy(ServerInterface &srvInterface) {}
+        virtual StreamState process(ServerInterface &srvInterface,
+                DataBuffer &input,
+                InputState input_state,
+                DataBuffer &output) = 0;
+};
+
+class FilterFactory: public UDXFactory {
+    public:
+        virtual void plan(ServerInterface &srvInterface, PlanContext &planCtxt) {}
+        virtual UDFilter *prepare(ServerInterface &srvInterface, PlanContext &planCtxt) = 0;
+        virtual void getParameterType(ServerInterface &srvInterface,
+                SizedColumnTypes &parameterTypes) {}
+        virtual void getPerInstanceResources(ServerInterface &srvInterface,
+                VResources &res) {}
+};
+
+// Factories registered with RegisterFactory are looked up by class name.
+typedef UDXFactory *(*FactoryCreator)();
+
+inline std::map<std::string, FactoryCreator> &getFactoryRegistry() {
+    static std::map<std::string, FactoryCreator> registry;
+    return registry;
+}
+
+inline UDXFactory *createFactory(const std::string &name) {
+    std::map<std::string, FactoryCreator>::iterator it = getFactoryRegistry().find(name);
+    return it == getFactoryRegistry().end() ? NULL : it->second();
+}
+
+struct FactoryRegistrar {
+    FactoryRegistrar(const char *name, FactoryCreator creator) {
+        getFactoryRegistry()[name] = creator;
+    }
+};
+
+} // namespace Vertica
+
+#define RegisterFactory(FACTORY) \
+    static ::Vertica::UDXFactory *create_##FACTORY() { return new FACTORY(); } \
+    static ::Vertica::FactoryRegistrar register_##FACTORY(#FACTORY, create_##FACTORY)
+
+#endif /* MICROBENCH_VERTICA_H_INCLUDED */
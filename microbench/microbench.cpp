@@ -0,0 +1,642 @@
+// Copyright (c) 2016 Uber Technologies, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// A standalone microbenchmark for the AESGCM_Encrypt, AESGCM_Decrypt,
+// AESGCM_Verify, AESGCM_DecryptEquals, AESGCM_Reencrypt and deterministic
+// encryption scalar functions. The registered factories are instantiated against the
+// stand-in SDK in microbench/Vertica.h and processBlock is driven over
+// synthetic blocks, so no Vertica server is required.
+//
+// For each configuration (operation, value length, NULL ratio, associated
+// data) the throughput is reported as rows/s, plaintext MB/s and
+// cycles/byte. The AESGCMMultiBuffer batch kernel is then compared with the
+// single-value path of the engine for each length a value can be batched
+// at. The streaming filters are then measured for several segment
+// sizes, reported as plaintext GB/s and cycles/byte on a single core. Cycles
+// are measured with the time stamp counter where available, which ticks at
+// the nominal (not turbo) frequency.
+
+#include "../AESGCMKeyring.h"
+#include "../AESGCMMultiBuffer.h"
+
+#include <Vertica.h>
+#include <sodium.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t cycles() { return __rdtsc(); }
+#else
+static inline uint64_t cycles() { return 0; }
+#endif
+
+using namespace Vertica;
+
+// Approximates the amount of data Vertica hands to a single processBlock
+// call.
+#define BLOCK_BYTES (1 << 20)
+#define MAX_BLOCK_ROWS 4096
+#define AD_LENGTH 16
+#define STREAM_BYTES (16 << 20)
+
+// The threads parameter passed to the scalar functions.
+static std::string threads = "1";
+
+// The engine parameter passed to the functions and filters, if not empty.
+static std::string engine;
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Block holds the input columns for one synthetic block along with the
+// backing storage they point to.
+struct Block {
+    std::vector<BlockReader::Column> columns;
+    std::vector<std::string> storage;
+    size_t rows;
+    size_t bytes; // non-NULL bytes in column 0
+};
+
+// Output holds the fixed-width slots written by BlockWriter.
+struct Output {
+    std::vector<char> buffer;
+    std::vector<VString> values;
+    vsize width;
+
+    void reset(size_t rows, vsize w) {
+        width = w;
+        buffer.resize(rows * width + 1);
+        values.assign(rows, VString());
+    }
+};
+
+struct Config {
+    size_t length;
+    double null_ratio;
+    bool with_ad;
+    bool multi_buffer;
+};
+
+struct Result {
+    double seconds;
+    uint64_t cycles;
+    uint64_t rows;
+    uint64_t bytes;
+};
+
+// Instance bundles a function instance with the server interface and
+// argument types it was set up with.
+struct Instance {
+    ServerInterface server;
+    ScalarFunctionFactory *factory;
+    ScalarFunction *function;
+    SizedColumnTypes arg_types;
+    SizedColumnTypes return_type;
+
+    Instance(const std::string &factory_name, const std::string &key_path,
+            const SizedColumnTypes &args, bool multi_buffer)
+        : factory(NULL), function(NULL), arg_types(args) {
+        factory = dynamic_cast<ScalarFunctionFactory *>(createFactory(factory_name));
+        if (factory == NULL) {
+            fprintf(stderr, "Factory %s is not registered\n", factory_name.c_str());
+            exit(1);
+        }
+        server.getParamReader().setParameter("key", key_path);
+        server.getParamReader().setParameter("multi_buffer", multi_buffer ? "true" : "false");
+        server.getParamReader().setParameter("threads", threads);
+        if (!engine.empty()) {
+            server.getParamReader().setParameter("engine", engine);
+        }
+        factory->getReturnType(server, arg_types, return_type);
+        function = factory->createScalarFunction(server);
+        function->setup(server, arg_types);
+    }
+
+    ~Instance() {
+        function->destroy(server, arg_types);
+        delete function;
+        delete factory;
+    }
+
+    void process(const Block &block, Output &out) {
+        out.reset(block.rows, return_type.getColumnType(0).getStringLength());
+        BlockReader reader(block.columns, 0, block.rows);
+        BlockWriter writer(out.buffer, out.values, out.width);
+        function->processBlock(server, reader, writer);
+    }
+};
+
+// FilterInstance bundles a UDFilter with the server interface it was
+// prepared with.
+struct FilterInstance {
+    ServerInterface server;
+    FilterFactory *factory;
+    UDFilter *filter;
+
+    FilterInstance(const std::string &factory_name, const std::string &key_path,
+            size_t segment_size)
+        : factory(NULL), filter(NULL) {
+        factory = dynamic_cast<FilterFactory *>(createFactory(factory_name));
+        if (factory == NULL) {
+            fprintf(stderr, "Factory %s is not registered\n", factory_name.c_str());
+            exit(1);
+        }
+        char segment_size_str[32];
+        snprintf(segment_size_str, sizeof(segment_size_str), "%zu", segment_size);
+        server.getParamReader().setParameter("key", key_path);
+        server.getParamReader().setParameter("segment_size", segment_size_str);
+        if (!engine.empty()) {
+            server.getParamReader().setParameter("engine", engine);
+        }
+        PlanContext plan_context;
+        filter = factory->prepare(server, plan_context);
+    }
+
+    ~FilterInstance() {
+        delete filter;
+        delete factory;
+    }
+
+    // Streams input through the filter in buffers of BLOCK_BYTES, as COPY
+    // does. The output is appended to out unless it is NULL.
+    void process(const std::string &input, std::string *out) {
+        std::vector<char> output_buffer(BLOCK_BYTES);
+        size_t pos = 0;
+
+        filter->setup(server);
+        for (;;) {
+            size_t n = input.size() - pos < BLOCK_BYTES ? input.size() - pos : BLOCK_BYTES;
+            DataBuffer in = {(char *)input.data() + pos, n, 0};
+            DataBuffer o = {&output_buffer[0], output_buffer.size(), 0};
+            InputState input_state = pos + n == input.size() ? END_OF_FILE : OK;
+
+            StreamState state = filter->process(server, in, input_state, o);
+            pos += in.offset;
+            if (out != NULL) {
+                out->append(&output_buffer[0], o.offset);
+            }
+            if (state == DONE) {
+                break;
+            }
+        }
+        filter->destroy(server);
+    }
+};
+
+static std::string randomString(size_t length) {
+    std::string s(length, '\0');
+    randombytes_buf(&s[0], length);
+    return s;
+}
+
+// makePlaintextBlock creates a block of VARCHAR values of the given length
+// where roughly null_ratio of the values are NULL.
+static void makePlaintextBlock(const Config &config, Block &block) {
+    size_t rows = BLOCK_BYTES / (config.length + 1);
+    if (rows < 1) rows = 1;
+    if (rows > MAX_BLOCK_ROWS) rows = MAX_BLOCK_ROWS;
+
+    block.rows = rows;
+    block.bytes = 0;
+    block.columns.assign(config.with_ad ? 2 : 1, BlockReader::Column());
+    block.storage.resize(rows * block.columns.size());
+
+    for (size_t row = 0; row < rows; row++) {
+        bool null = randombytes_uniform(1000000) < config.null_ratio * 1000000;
+        for (size_t col = 0; col < block.columns.size(); col++) {
+            std::string &s = block.storage[row * block.columns.size() + col];
+            s = randomString(col == 0 ? config.length : AD_LENGTH);
+            bool col_null = col == 0 && null;
+            block.columns[col].data.push_back(col_null ? NULL : s.data());
+            block.columns[col].lengths.push_back(col_null ? 0 : s.length());
+        }
+        if (!null) {
+            block.bytes += config.length;
+        }
+    }
+}
+
+// makeCiphertextBlock replaces column 0 of a plaintext block with its
+// encryption, so that the block can be used as input for decryption.
+static void makeCiphertextBlock(Instance &encrypt, const Block &plaintext, Block &ciphertext) {
+    Output out;
+    encrypt.process(plaintext, out);
+
+    ciphertext = plaintext;
+    for (size_t row = 0; row < ciphertext.rows; row++) {
+        std::string &s = ciphertext.storage[row * ciphertext.columns.size()];
+        if (out.values[row].isNull()) {
+            ciphertext.columns[0].data[row] = NULL;
+            ciphertext.columns[0].lengths[row] = 0;
+        } else {
+            s = out.values[row].str();
+            ciphertext.columns[0].data[row] = s.data();
+            ciphertext.columns[0].lengths[row] = s.length();
+        }
+    }
+    // Column pointers into storage were invalidated by the copy.
+    for (size_t row = 0; row < ciphertext.rows; row++) {
+        for (size_t col = 1; col < ciphertext.columns.size(); col++) {
+            ciphertext.columns[col].data[row] =
+                ciphertext.storage[row * ciphertext.columns.size() + col].data();
+        }
+    }
+}
+
+// makeCompareBlock inserts the plaintext of a ciphertext block as column 1,
+// so that every value matches when compared with AESGCM_DecryptEquals. The
+// columns point into the storage of both blocks.
+static void makeCompareBlock(const Block &ciphertext, const Block &plaintext, Block &compare) {
+    compare.columns = ciphertext.columns;
+    compare.columns.insert(compare.columns.begin() + 1, plaintext.columns[0]);
+    compare.rows = ciphertext.rows;
+    compare.bytes = ciphertext.bytes;
+}
+
+static Result run(Instance &instance, const Block &block, double min_seconds) {
+    Output out;
+    Result result = {0, 0, 0, 0};
+
+    // Warm up.
+    instance.process(block, out);
+
+    double start = now();
+    uint64_t start_cycles = cycles();
+    do {
+        instance.process(block, out);
+        result.rows += block.rows;
+        result.bytes += block.bytes;
+        result.seconds = now() - start;
+    } while (result.seconds < min_seconds);
+    result.cycles = cycles() - start_cycles;
+
+    return result;
+}
+
+static Result runStream(FilterInstance &instance, const std::string &input,
+        size_t plaintext_bytes, double min_seconds) {
+    Result result = {0, 0, 0, 0};
+
+    // Warm up.
+    instance.process(input, NULL);
+
+    double start = now();
+    uint64_t start_cycles = cycles();
+    do {
+        instance.process(input, NULL);
+        result.bytes += plaintext_bytes;
+        result.seconds = now() - start;
+    } while (result.seconds < min_seconds);
+    result.cycles = cycles() - start_cycles;
+
+    return result;
+}
+
+static void reportStream(const char *op, size_t segment_size, const Result &r) {
+    printf("%-8s %9zu %10.2f %9.2f\n",
+            op, segment_size,
+            r.bytes / r.seconds / 1e9,
+            r.bytes > 0 ? (double)r.cycles / r.bytes : 0.0);
+}
+
+static void report(const char *op, const Config &config, const Result &r) {
+    printf("%-8s %6zu %6.2f %3s %5s %12.0f %10.1f %9.2f\n",
+            op, config.length, config.null_ratio, config.with_ad ? "yes" : "no",
+            config.multi_buffer ? "batch" : "row",
+            r.rows / r.seconds,
+            r.bytes / r.seconds / 1e6,
+            r.bytes > 0 ? (double)r.cycles / r.bytes : 0.0);
+}
+
+static SizedColumnTypes argTypes(BaseType value_type, const Config &config) {
+    size_t width = config.length + 28;
+    SizedColumnTypes args;
+    if (value_type == VarcharType) {
+        args.addVarchar(config.length, "value");
+    } else {
+        args.addVarbinary(width, "value");
+    }
+    if (config.with_ad) {
+        args.addVarbinary(AD_LENGTH, "ad");
+    }
+    return args;
+}
+
+static SizedColumnTypes compareArgTypes(const Config &config) {
+    SizedColumnTypes args;
+    args.addVarbinary(config.length + 28, "value");
+    args.addVarchar(config.length, "pattern");
+    if (config.with_ad) {
+        args.addVarbinary(AD_LENGTH, "ad");
+    }
+    return args;
+}
+
+// Measures how many function instances can be set up and destroyed per
+// second, which is dominated by reading and expanding the key.
+static double setupRate(const std::string &key_path, double min_seconds) {
+    Config config = {16, 0, false, true};
+    uint64_t count = 0;
+    double start = now(), elapsed;
+    do {
+        Instance instance("AESGCMEncryptFactory", key_path,
+                argTypes(VarcharType, config), config.multi_buffer);
+        count++;
+        elapsed = now() - start;
+    } while (elapsed < min_seconds);
+    return count / elapsed;
+}
+
+// Returns the engine the functions use, as reported by AESGCM_Engine().
+static std::string engineName() {
+    Block block;
+    block.rows = 1;
+    block.bytes = 0;
+    Instance instance("AESGCMEngineFactory", "", SizedColumnTypes(), false);
+    Output out;
+    instance.process(block, out);
+    return out.values[0].str();
+}
+
+// Measures length bytes of plaintext per message through the batch kernel,
+// eight messages per call, and through the single-value path of engine, in
+// plaintext MB/s. messages are encrypted to begin with; when decrypting,
+// their ciphertexts are decrypted instead.
+static void runCrossover(const AESGCMKey &key, AESGCMEngine::Type engine,
+        AESGCMMessage *messages, bool decrypt, double min_seconds,
+        double &batch_mbps, double &single_mbps) {
+    size_t length = messages[0].length;
+    uint64_t bytes = 0;
+    double start = now(), elapsed;
+    do {
+        if (decrypt) {
+            key.multi_buffer.decrypt(messages, AESGCMMultiBuffer::max_messages);
+        } else {
+            key.multi_buffer.encrypt(messages, AESGCMMultiBuffer::max_messages);
+        }
+        bytes += length * AESGCMMultiBuffer::max_messages;
+        elapsed = now() - start;
+    } while (elapsed < min_seconds);
+    batch_mbps = bytes / elapsed / 1e6;
+
+    std::vector<unsigned char> out(length + crypto_aead_aes256gcm_ABYTES);
+    bytes = 0;
+    start = now();
+    do {
+        for (size_t i = 0; i < AESGCMMultiBuffer::max_messages; i++) {
+            const AESGCMMessage &m = messages[i];
+            if (decrypt) {
+                key.decrypt(engine, &out[0], m.in, length + crypto_aead_aes256gcm_ABYTES,
+                        NULL, 0, m.nonce);
+            } else {
+                key.encrypt(engine, &out[0], m.in, length, NULL, 0, m.nonce);
+            }
+        }
+        bytes += length * AESGCMMultiBuffer::max_messages;
+        elapsed = now() - start;
+    } while (elapsed < min_seconds);
+    single_mbps = bytes / elapsed / 1e6;
+}
+
+// Reports the batch kernel against the single-value path of the engine in
+// use for each length a value can be batched at, along with the path the
+// functions take (see AESGCMFunction::multi_buffer_length).
+static void reportCrossover(double min_seconds) {
+    AESGCMEngine::Type selected = AESGCMEngine::detect();
+    AESGCMEngine::Type requested;
+    if (!engine.empty() && AESGCMEngine::parse(engine.c_str(), requested) &&
+            requested < selected) {
+        selected = requested;
+    }
+    if (selected < AESGCMEngine::AESNI) {
+        return;
+    }
+    size_t cutoff = selected >= AESGCMEngine::VAES256 ?
+        AESGCMMultiBuffer::max_wide_length : AESGCMMultiBuffer::max_length;
+
+    unsigned char key_bytes[crypto_aead_aes256gcm_KEYBYTES];
+    randombytes_buf(key_bytes, sizeof(key_bytes));
+    AESGCMKey *key = new AESGCMKey();
+    key->init(key_bytes);
+
+    static const size_t lengths[] = {16, 32, 64, 128, 192, 256, 512, 1024};
+    static const size_t stride = AESGCMMultiBuffer::max_length + crypto_aead_aes256gcm_ABYTES;
+    std::vector<unsigned char> plaintext(AESGCMMultiBuffer::max_messages * stride);
+    std::vector<unsigned char> ciphertext(plaintext.size());
+    std::vector<unsigned char> decrypted(plaintext.size());
+    unsigned char nonces[AESGCMMultiBuffer::max_messages][crypto_aead_aes256gcm_NPUBBYTES];
+    randombytes_buf(&plaintext[0], plaintext.size());
+    randombytes_buf(nonces, sizeof(nonces));
+
+    printf("\n%-9s %6s %10s %10s %6s\n", "crossover", "length", "batch", "single", "path");
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+        AESGCMMessage encrypt[AESGCMMultiBuffer::max_messages];
+        AESGCMMessage decrypt[AESGCMMultiBuffer::max_messages];
+        for (size_t i = 0; i < AESGCMMultiBuffer::max_messages; i++) {
+            AESGCMMessage m = {
+                nonces[i], &plaintext[i * stride], lengths[l], NULL, 0, NULL, 0,
+                &ciphertext[i * stride], &ciphertext[i * stride] + lengths[l], 0
+            };
+            encrypt[i] = m;
+            decrypt[i] = m;
+            decrypt[i].in = m.out;
+            decrypt[i].out = &decrypted[i * stride];
+        }
+        key->multi_buffer.encrypt(encrypt, AESGCMMultiBuffer::max_messages);
+
+        const char *path = lengths[l] <= cutoff ? "batch" : "row";
+        double batch_mbps, single_mbps;
+        runCrossover(*key, selected, encrypt, false, min_seconds, batch_mbps, single_mbps);
+        printf("%-9s %6zu %10.1f %10.1f %6s\n", "encrypt", lengths[l], batch_mbps, single_mbps, path);
+        runCrossover(*key, selected, decrypt, true, min_seconds, batch_mbps, single_mbps);
+        printf("%-9s %6zu %10.1f %10.1f %6s\n", "decrypt", lengths[l], batch_mbps, single_mbps, path);
+    }
+
+    delete key;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [-t seconds] [-j threads] [-e engine]\n", argv0);
+    fprintf(stderr, "   -t seconds   Minimum time to run each configuration (default 0.25).\n");
+    fprintf(stderr, "   -j threads   Threads used by the scalar functions for each block (default 1).\n");
+    fprintf(stderr, "   -e engine    Limits the engine to bitsliced, aesni, vaes256 or vaes512\n");
+    fprintf(stderr, "                (default: the best the CPU supports).\n");
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    double min_seconds = 0.25;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:j:e:")) != -1) {
+        switch (opt) {
+            case 't':
+                min_seconds = atof(optarg);
+                break;
+            case 'j':
+                threads = optarg;
+                break;
+            case 'e':
+                engine = optarg;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    if (sodium_init() < 0) {
+        fprintf(stderr, "Failed to initialize libsodium\n");
+        return 1;
+    }
+
+    // Write a random key to a temporary file for the function instances.
+    char key_path[] = "/tmp/aesgcm-microbench-key.XXXXXX";
+    int fd = mkstemp(key_path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    unsigned char key[crypto_aead_aes256gcm_KEYBYTES];
+    char key_hex[sizeof(key) * 2 + 1];
+    randombytes_buf(key, sizeof(key));
+    sodium_bin2hex(key_hex, sizeof(key_hex), key, sizeof(key));
+    if (write(fd, key_hex, strlen(key_hex)) != (ssize_t)strlen(key_hex)) {
+        perror("write");
+        return 1;
+    }
+    close(fd);
+
+    static const size_t lengths[] = {16, 32, 64, 128, 256, 1024, 4096, 16384, 65000};
+    static const double null_ratios[] = {0.0, 0.5};
+    static const bool with_ads[] = {false, true};
+    static const bool multi_buffers[] = {false, true};
+
+    int status = 0;
+    try {
+        printf("engine: %s\n", engineName().c_str());
+        printf("setup: %.0f instances/s\n\n", setupRate(key_path, min_seconds));
+    } catch (const UDxException &e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        unlink(key_path);
+        return 1;
+    }
+
+    printf("%-8s %6s %6s %3s %5s %12s %10s %9s\n",
+            "op", "length", "nulls", "ad", "path", "rows/s", "MB/s", "cycles/B");
+
+    try {
+        for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+            for (size_t n = 0; n < sizeof(null_ratios) / sizeof(null_ratios[0]); n++) {
+                for (size_t a = 0; a < sizeof(with_ads) / sizeof(with_ads[0]); a++) {
+                    for (size_t m = 0; m < sizeof(multi_buffers) / sizeof(multi_buffers[0]); m++) {
+                        Config config = {lengths[l], null_ratios[n], with_ads[a], multi_buffers[m]};
+
+                        // Values longer than the batch limit always take the
+                        // per-row path.
+                        if (config.multi_buffer && config.length > AESGCMMultiBuffer::max_length) {
+                            continue;
+                        }
+
+                        Instance encrypt(config.with_ad ?
+                                    "AESGCMEncryptWithVarbinaryADFactory" : "AESGCMEncryptFactory",
+                                key_path, argTypes(VarcharType, config), config.multi_buffer);
+                        Instance decrypt(config.with_ad ?
+                                    "AESGCMDecryptWithVarbinaryADFactory" : "AESGCMDecryptFactory",
+                                key_path, argTypes(VarbinaryType, config), config.multi_buffer);
+                        Instance verify(config.with_ad ?
+                                    "AESGCMVerifyWithVarbinaryADFactory" : "AESGCMVerifyFactory",
+                                key_path, argTypes(VarbinaryType, config), config.multi_buffer);
+                        Instance reencrypt(config.with_ad ?
+                                    "AESGCMReencryptWithVarbinaryADFactory" : "AESGCMReencryptFactory",
+                                key_path, argTypes(VarbinaryType, config), config.multi_buffer);
+                        Instance equals(config.with_ad ?
+                                    "AESGCMDecryptEqualsWithVarbinaryADFactory" :
+                                    "AESGCMDecryptEqualsFactory",
+                                key_path, compareArgTypes(config), config.multi_buffer);
+
+                        Block plaintext, ciphertext, compare;
+                        makePlaintextBlock(config, plaintext);
+                        makeCiphertextBlock(encrypt, plaintext, ciphertext);
+                        makeCompareBlock(ciphertext, plaintext, compare);
+
+                        report("encrypt", config, run(encrypt, plaintext, min_seconds));
+                        report("decrypt", config, run(decrypt, ciphertext, min_seconds));
+                        report("verify", config, run(verify, ciphertext, min_seconds));
+                        report("dec-eq", config, run(equals, compare, min_seconds));
+                        report("reencr", config, run(reencrypt, ciphertext, min_seconds));
+
+                        // Deterministic encryption has no batched path.
+                        if (!config.multi_buffer) {
+                            Instance encrypt_det(config.with_ad ?
+                                        "AESGCMEncryptDeterministicWithVarbinaryADFactory" :
+                                        "AESGCMEncryptDeterministicFactory",
+                                    key_path, argTypes(VarcharType, config), false);
+                            Instance decrypt_det(config.with_ad ?
+                                        "AESGCMDecryptDeterministicWithVarbinaryADFactory" :
+                                        "AESGCMDecryptDeterministicFactory",
+                                    key_path, argTypes(VarbinaryType, config), false);
+
+                            Block ciphertext_det;
+                            makeCiphertextBlock(encrypt_det, plaintext, ciphertext_det);
+
+                            report("enc-det", config, run(encrypt_det, plaintext, min_seconds));
+                            report("dec-det", config, run(decrypt_det, ciphertext_det, min_seconds));
+                        }
+                    }
+                }
+            }
+        }
+
+        reportCrossover(min_seconds);
+
+        static const size_t segment_sizes[] = {4096, 65536, 1048576};
+        std::string plaintext = randomString(STREAM_BYTES);
+
+        printf("\n%-8s %9s %10s %9s\n", "stream", "segment", "GB/s", "cycles/B");
+        for (size_t s = 0; s < sizeof(segment_sizes) / sizeof(segment_sizes[0]); s++) {
+            FilterInstance encrypt("AESGCMEncryptFilterFactory", key_path, segment_sizes[s]);
+            FilterInstance decrypt("AESGCMDecryptFilterFactory", key_path, segment_sizes[s]);
+
+            std::string ciphertext;
+            encrypt.process(plaintext, &ciphertext);
+
+            reportStream("encrypt", segment_sizes[s],
+                    runStream(encrypt, plaintext, plaintext.size(), min_seconds));
+            reportStream("decrypt", segment_sizes[s],
+                    runStream(decrypt, ciphertext, plaintext.size(), min_seconds));
+        }
+    } catch (const UDxException &e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        status = 1;
+    }
+
+    unlink(key_path);
+    return status;
+}
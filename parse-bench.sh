@@ -0,0 +1,119 @@
+#!/bin/sh
+# Copyright (c) 2016 Uber Technologies, Inc.
+# 
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+# 
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+# 
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+
+# A simple script to parse the output of bench.sql during `make bench'. Prints
+# the throughput of each benchmark in rows/s and compares it with the baseline
+# file given as the first argument, which holds lines of
+#
+#   description|rows/s
+#
+# as written to the optional second argument. Exits successfully only if no
+# benchmark is more than BENCH_TOLERANCE percent (default 10) slower than its
+# baseline. Benchmarks missing from the baseline are reported but not
+# compared.
+
+baseline="$1"
+results="$2"
+tolerance="${BENCH_TOLERANCE:-10}"
+
+bench_count=0
+line_count=0
+regression_count=0
+description=
+rows=
+
+if [ -n "$results" ]; then
+    echo "# description|rows/s, written by parse-bench.sh" >"$results"
+fi
+
+# Prints the milliseconds of a \timing line, i.e. the last "<number> ms" of
+# "Time: First fetch (1 row): 1.234 ms. All rows formatted: 1.250 ms".
+timing_ms() {
+    echo "$1" | sed -n 's/.* \([0-9][0-9.]*\) ms.*$/\1/p'
+}
+
+while IFS='|' read benchmark rest; do
+    line_count=$(($line_count + 1))
+
+    case "$benchmark" in
+        BENCHMARK)
+            if [ -n "$description" ]; then
+                echo "No timing for benchmark \"$description\" at line $line_count"
+                exit 1
+            fi
+            description="${rest%|*}"
+            rows="${rest##*|}"
+            continue
+            ;;
+        *ERROR*)
+            echo "Unexpected error at line $line_count"
+            echo "$benchmark${rest:+|$rest}"
+            exit 1
+            ;;
+        Time:*)
+            if [ -z "$description" ]; then
+                continue
+            fi
+            ;;
+        *)
+            continue
+            ;;
+    esac
+
+    ms=$(timing_ms "$benchmark")
+    if [ -z "$ms" ]; then
+        echo "Unexpected timing output at line $line_count"
+        echo "$benchmark"
+        exit 1
+    fi
+
+    bench_count=$(($bench_count + 1))
+    echo "Benchmark $bench_count: $description"
+
+    rate=$(awk -v rows="$rows" -v ms="$ms" 'BEGIN { printf "%.0f", (ms > 0 ? rows * 1000 / ms : 0) }')
+    echo "    $rows rows in $ms ms: $rate rows/s"
+    if [ -n "$results" ]; then
+        echo "$description|$rate" >>"$results"
+    fi
+
+    expected=
+    if [ -f "$baseline" ]; then
+        expected=$(awk -F'|' -v d="$description" '$1 == d { print $2 }' "$baseline")
+    fi
+    if [ -z "$expected" ]; then
+        echo "    NO BASELINE"
+    elif awk -v rate="$rate" -v expected="$expected" -v tolerance="$tolerance" \
+            'BEGIN { exit !(rate < expected * (100 - tolerance) / 100) }'; then
+        echo "    REGRESSION"
+        echo "    Baseline: $expected rows/s"
+        regression_count=$(($regression_count + 1))
+    else
+        echo "    PASS"
+    fi
+
+    description=
+    rows=
+done
+
+echo "$bench_count benchmarks were run."
+echo "$regression_count benchmarks were more than $tolerance% slower than the baseline."
+
+exit $regression_count
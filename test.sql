@@ -5,17 +5,105 @@ CREATE OR REPLACE LIBRARY TEST_AESGCM AS :libfile;
 CREATE OR REPLACE FUNCTION TEST_AESGCM_Decrypt AS LANGUAGE 'C++' NAME 'AESGCMDecryptFactory' LIBRARY TEST_AESGCM;
 CREATE OR REPLACE FUNCTION TEST_AESGCM_Decrypt AS LANGUAGE 'C++' NAME 'AESGCMDecryptWithVarcharADFactory' LIBRARY TEST_AESGCM;
 CREATE OR REPLACE FUNCTION TEST_AESGCM_Decrypt AS LANGUAGE 'C++' NAME 'AESGCMDecryptWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Decrypt AS LANGUAGE 'C++' NAME 'AESGCMDecryptLongFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Decrypt AS LANGUAGE 'C++' NAME 'AESGCMDecryptLongWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Decrypt AS LANGUAGE 'C++' NAME 'AESGCMDecryptLongWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptBase64 AS LANGUAGE 'C++' NAME 'AESGCMDecryptBase64Factory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptBase64 AS LANGUAGE 'C++' NAME 'AESGCMDecryptBase64WithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptBase64 AS LANGUAGE 'C++' NAME 'AESGCMDecryptBase64WithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptDate AS LANGUAGE 'C++' NAME 'AESGCMDecryptDateFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptDate AS LANGUAGE 'C++' NAME 'AESGCMDecryptDateWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptDate AS LANGUAGE 'C++' NAME 'AESGCMDecryptDateWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptDeterministic AS LANGUAGE 'C++' NAME 'AESGCMDecryptDeterministicFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptDeterministic AS LANGUAGE 'C++' NAME 'AESGCMDecryptDeterministicWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptDeterministic AS LANGUAGE 'C++' NAME 'AESGCMDecryptDeterministicWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptEquals AS LANGUAGE 'C++' NAME 'AESGCMDecryptEqualsFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptEquals AS LANGUAGE 'C++' NAME 'AESGCMDecryptEqualsWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptEquals AS LANGUAGE 'C++' NAME 'AESGCMDecryptEqualsWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptFloat AS LANGUAGE 'C++' NAME 'AESGCMDecryptFloatFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptFloat AS LANGUAGE 'C++' NAME 'AESGCMDecryptFloatWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptFloat AS LANGUAGE 'C++' NAME 'AESGCMDecryptFloatWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptForTenant AS LANGUAGE 'C++' NAME 'AESGCMDecryptForTenantFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptForTenant AS LANGUAGE 'C++' NAME 'AESGCMDecryptForTenantWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptForTenant AS LANGUAGE 'C++' NAME 'AESGCMDecryptForTenantWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptHex AS LANGUAGE 'C++' NAME 'AESGCMDecryptHexFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptHex AS LANGUAGE 'C++' NAME 'AESGCMDecryptHexWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptHex AS LANGUAGE 'C++' NAME 'AESGCMDecryptHexWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptInt AS LANGUAGE 'C++' NAME 'AESGCMDecryptIntFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptInt AS LANGUAGE 'C++' NAME 'AESGCMDecryptIntWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptInt AS LANGUAGE 'C++' NAME 'AESGCMDecryptIntWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptNumeric AS LANGUAGE 'C++' NAME 'AESGCMDecryptNumericFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptNumeric AS LANGUAGE 'C++' NAME 'AESGCMDecryptNumericWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptNumeric AS LANGUAGE 'C++' NAME 'AESGCMDecryptNumericWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptRange AS LANGUAGE 'C++' NAME 'AESGCMDecryptRangeFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptRange AS LANGUAGE 'C++' NAME 'AESGCMDecryptRangeWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptRange AS LANGUAGE 'C++' NAME 'AESGCMDecryptRangeWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE TRANSFORM FUNCTION TEST_AESGCM_DecryptRow AS LANGUAGE 'C++' NAME 'AESGCMDecryptRowFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptStartsWith AS LANGUAGE 'C++' NAME 'AESGCMDecryptStartsWithFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptStartsWith AS LANGUAGE 'C++' NAME 'AESGCMDecryptStartsWithWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptStartsWith AS LANGUAGE 'C++' NAME 'AESGCMDecryptStartsWithWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptTimestamp AS LANGUAGE 'C++' NAME 'AESGCMDecryptTimestampFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptTimestamp AS LANGUAGE 'C++' NAME 'AESGCMDecryptTimestampWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_DecryptTimestamp AS LANGUAGE 'C++' NAME 'AESGCMDecryptTimestampWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
 CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptFactory' LIBRARY TEST_AESGCM;
 CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptWithVarcharADFactory' LIBRARY TEST_AESGCM;
 CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptIntFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptIntWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptIntWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptFloatFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptFloatWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptFloatWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptDateFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptDateWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptDateWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptTimestampFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptTimestampWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptTimestampWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptNumericFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptNumericWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptNumericWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptLongFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptLongWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEncryptLongWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_EncryptBase64 AS LANGUAGE 'C++' NAME 'AESGCMEncryptBase64Factory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_EncryptBase64 AS LANGUAGE 'C++' NAME 'AESGCMEncryptBase64WithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_EncryptBase64 AS LANGUAGE 'C++' NAME 'AESGCMEncryptBase64WithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_EncryptDeterministic AS LANGUAGE 'C++' NAME 'AESGCMEncryptDeterministicFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_EncryptDeterministic AS LANGUAGE 'C++' NAME 'AESGCMEncryptDeterministicWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_EncryptDeterministic AS LANGUAGE 'C++' NAME 'AESGCMEncryptDeterministicWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_EncryptForTenant AS LANGUAGE 'C++' NAME 'AESGCMEncryptForTenantFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_EncryptForTenant AS LANGUAGE 'C++' NAME 'AESGCMEncryptForTenantWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_EncryptForTenant AS LANGUAGE 'C++' NAME 'AESGCMEncryptForTenantWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_EncryptHex AS LANGUAGE 'C++' NAME 'AESGCMEncryptHexFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_EncryptHex AS LANGUAGE 'C++' NAME 'AESGCMEncryptHexWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_EncryptHex AS LANGUAGE 'C++' NAME 'AESGCMEncryptHexWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_EncryptRow AS LANGUAGE 'C++' NAME 'AESGCMEncryptRowFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Engine AS LANGUAGE 'C++' NAME 'AESGCMEngineFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Reencrypt AS LANGUAGE 'C++' NAME 'AESGCMReencryptFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Reencrypt AS LANGUAGE 'C++' NAME 'AESGCMReencryptWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Reencrypt AS LANGUAGE 'C++' NAME 'AESGCMReencryptWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE TRANSFORM FUNCTION TEST_AESGCM_Stats AS LANGUAGE 'C++' NAME 'AESGCMStatsFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Verify AS LANGUAGE 'C++' NAME 'AESGCMVerifyFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Verify AS LANGUAGE 'C++' NAME 'AESGCMVerifyWithVarcharADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FUNCTION TEST_AESGCM_Verify AS LANGUAGE 'C++' NAME 'AESGCMVerifyWithVarbinaryADFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FILTER TEST_AESGCM_DecryptFilter AS LANGUAGE 'C++' NAME 'AESGCMDecryptFilterFactory' LIBRARY TEST_AESGCM;
+CREATE OR REPLACE FILTER TEST_AESGCM_EncryptFilter AS LANGUAGE 'C++' NAME 'AESGCMEncryptFilterFactory' LIBRARY TEST_AESGCM;
 
 -- Global variables.
 \set keyfile        '\''`pwd`'/test-key.hex\''
+\set keyring        '\''`pwd`'/test-keyring.txt\'' -- key 1 is the key in :keyfile, key 2 is used for encryption.
+\set keyfile_stats  '\''`pwd`'/./test-key.hex\'' -- :keyfile by another path, used only by the stats tests.
 \set plaintext      '\'hello\''
 \set ciphertext     'HEX_TO_BINARY(''0x30313233343536373839414215c760f2a1ba7ee1b4401f142642105137b10b25a0'')' -- :plaintext encrypted with :keyfile, nonce prefixed.
 \set aad            '\'length:5\'' -- example additional associated data for :plaintext.
 \set aad_bin        'HEX_TO_BINARY(''0x6c656e6774683a35'')' -- :aad in hexadecimal.
 \set ciphertext_aad 'HEX_TO_BINARY(''0x465efaf742f5e4d68d5188f3808aad3a140ed47210ad7a3886ad8ebf89defd8778'')' -- :plaintext encrypted with :keyfile and :aad (or :aad_binary), nonce prefixed.
+\set plaintext_long 'REPEAT(''The quick brown fox jumps over the lazy dog. '', 7)' -- 315 bytes, longer than a stride of every engine.
+\set aad_long       '\'length:315\''
+\set ciphertext_long 'HEX_TO_BINARY(''0x30313233343536373839414229ca69bebf92ba44ee4fe8b44505923898b57fe5317a344d1ff0fbda1ab7d64e293961b7b6f6a778b805e4d1e7862133e301ef7ac5869c6bace79e3661a0df21b4a9efcc2d264252d6e8193993e51f0c90d826a20bf3899c069e8c047f178aa6b1f71e9e41a8da989f7367e2d62b44ba7f0227ce00abe1e0a48c48e576496c8e68108c4dea38a37fbb86c6fd58706ac4e55444374a7d1e85e1a7d6b31c23c9cc2e5627b3ce7c249c1d4dc6c6300652ecc0d5c755596e6a8c017764eda6426cc4b63e8e007f8fa5538d173e1c179567c5fcbc4cea1f135aeb8664661813e96357189da9396f7e32af84748765d3ba0ee15b35f4706610ecc01d69a2042d054044f40786ea81dc4b6e174161aef7d23117ed90e20026d1ed68730b73407142df4529031564b0a4a335754c1fa4fd08aba6785e42f959c7742ece01853b0150a47917013174c3d6a62d3a99f9'')' -- :plaintext_long encrypted with :keyfile and :aad_long, nonce prefixed.
+\set ciphertext_compressed 'HEX_TO_BINARY(''0xae02303132333435363738394142c6a0f3809a8fb607f41ae3a541529e6a91ad69e53d60211d06a5f9dc0ce5994c242e61afbfe9fe34bd10fadfa3bd2e78e35d9ae5f689d36ef0a8b655fe2d45e8879194a5e3fd2b1767fa'')::VARBINARY(346)' -- :plaintext_long compressed and encrypted with :keyfile and :aad_long, with a header, as the type of AESGCM_Encrypt(:plaintext_long).
+\set ciphertext_aegis 'HEX_TO_BINARY(''0xae080130313233343536373839414243444546303132333435363738394142434445461fcf486aa8f040a223702ef05b6a07fcc668a9ea86634466cc6be6c91f27c146eea661ca71'')' -- :plaintext encrypted with :keyfile and algorithm aegis256, with a header, nonce prefixed.
 
 -- Test harness variables. Note that :expected should never fail to evaluate, otherwise tests are difficult to debug.
 \set test_header 'SELECT ''TESTCASE'' AS testcase, :description AS description, :expected AS expected, :error_expected AS error_expected'
@@ -104,12 +192,409 @@ CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEnc
 \set expected    ':plaintext'
 :run_test;
 
+\set description '\'batched encryption and per-row decryption are interchangeable\''
+\set expression  'TEST_AESGCM_Decrypt(TEST_AESGCM_Encrypt(:plaintext, :aad USING PARAMETERS key=:keyfile), :aad USING PARAMETERS key=:keyfile, multi_buffer=false)'
+\set expected    ':plaintext'
+:run_test;
+
+\set description '\'per-row encryption and batched decryption are interchangeable\''
+\set expression  'TEST_AESGCM_Decrypt(TEST_AESGCM_Encrypt(:plaintext, :aad USING PARAMETERS key=:keyfile, multi_buffer=false), :aad USING PARAMETERS key=:keyfile)'
+\set expected    ':plaintext'
+:run_test;
+
+\set description '\'keyring ciphertext has a key ID header\''
+\set expression  'LEFT(TO_HEX(TEST_AESGCM_Encrypt(:plaintext USING PARAMETERS key=:keyring)), 6)'
+\set expected    '\'ae0102\''
+:run_test;
+
+\set description '\'keyring ciphertext has expected length\''
+\set expression  'LENGTH(TEST_AESGCM_Encrypt(:plaintext USING PARAMETERS key=:keyring))'
+\set expected    'LENGTH(:plaintext) + 3 + 12 + 16'
+:run_test;
+
+\set description '\'nested encryption and decryption with a keyring\''
+\set expression  'TEST_AESGCM_Decrypt(TEST_AESGCM_Encrypt(:plaintext, :aad USING PARAMETERS key=:keyring), :aad USING PARAMETERS key=:keyring)'
+\set expected    ':plaintext'
+:run_test;
+
+\set description '\'per-row decryption with a keyring\''
+\set expression  'TEST_AESGCM_Decrypt(TEST_AESGCM_Encrypt(:plaintext USING PARAMETERS key=:keyring) USING PARAMETERS key=:keyring, multi_buffer=false)'
+\set expected    ':plaintext'
+:run_test;
+
+\set description '\'decrypting headerless ciphertext with a keyring uses the lowest key ID\''
+\set expression  'TEST_AESGCM_Decrypt(:ciphertext_aad, :aad USING PARAMETERS key=:keyring)'
+\set expected    ':plaintext'
+:run_test;
+
+\set description '\'verify ciphertext\''
+\set expression  'TEST_AESGCM_Verify(:ciphertext USING PARAMETERS key=:keyfile)'
+\set expected    'true'
+:run_test;
+
+\set description '\'verify ciphertext with associated data\''
+\set expression  'TEST_AESGCM_Verify(:ciphertext_aad, :aad_bin USING PARAMETERS key=:keyfile)'
+\set expected    'true'
+:run_test;
+
+\set description '\'verify ciphertext with the wrong associated data\''
+\set expression  'TEST_AESGCM_Verify(:ciphertext_aad, '''' USING PARAMETERS key=:keyfile)'
+\set expected    'false'
+:run_test;
+
+\set description '\'verify modified ciphertext\''
+\set expression  'TEST_AESGCM_Verify(OVERLAYB(:ciphertext, ''x'', 13) USING PARAMETERS key=:keyfile)'
+\set expected    'false'
+:run_test;
+
+\set description '\'verify ciphertext which is too short\''
+\set expression  'TEST_AESGCM_Verify(HEX_TO_BINARY(''0x3031'') USING PARAMETERS key=:keyfile)'
+\set expected    'false'
+:run_test;
+
+\set description '\'verifying NULL returns NULL\''
+\set expression  'TEST_AESGCM_Verify(NULL USING PARAMETERS key=:keyfile) IS NULL'
+\set expected    'true'
+:run_test;
+
+\set description '\'verify keyring ciphertext\''
+\set expression  'TEST_AESGCM_Verify(TEST_AESGCM_Encrypt(:plaintext, :aad USING PARAMETERS key=:keyring), :aad USING PARAMETERS key=:keyring)'
+\set expected    'true'
+:run_test;
+
+\set description '\'deterministic encryption of a known value\''
+\set expression  'TO_HEX(TEST_AESGCM_EncryptDeterministic(:plaintext USING PARAMETERS key=:keyfile))'
+\set expected    '\'50303adaf3a6fc16f03c108819be657066e17f4526\''
+:run_test;
+
+\set description '\'deterministic encryption of a known value with associated data\''
+\set expression  'TO_HEX(TEST_AESGCM_EncryptDeterministic(:plaintext, :aad USING PARAMETERS key=:keyfile))'
+\set expected    '\'ee17479fe16fb1f6bed875f7e4dd6502411c10b2c0\''
+:run_test;
+
+\set description '\'deterministic encryption of a known value with a keyring\''
+\set expression  'TO_HEX(TEST_AESGCM_EncryptDeterministic(:plaintext USING PARAMETERS key=:keyring))'
+\set expected    '\'ae0102d6dda1b0bb029473efc569466654cfd6d687e27d33\''
+:run_test;
+
+\set description '\'deterministic encryption of equal values is equal\''
+\set expression  'COUNT(DISTINCT TEST_AESGCM_EncryptDeterministic(v USING PARAMETERS key=:keyfile)) FROM (SELECT :plaintext AS v UNION ALL SELECT :plaintext UNION ALL SELECT ''other'') AS t'
+\set expected    '2'
+:run_test;
+
+\set description '\'nested deterministic encryption and decryption with associated data\''
+\set expression  'TEST_AESGCM_DecryptDeterministic(TEST_AESGCM_EncryptDeterministic(:plaintext, :aad USING PARAMETERS key=:keyring), :aad_bin USING PARAMETERS key=:keyring)'
+\set expected    ':plaintext'
+:run_test;
+
+\set description '\'decrypted value equals plaintext\''
+\set expression  'TEST_AESGCM_DecryptEquals(:ciphertext, :plaintext USING PARAMETERS key=:keyfile)'
+\set expected    'true'
+:run_test;
+
+\set description '\'decrypted value does not equal other value of the same length\''
+\set expression  'TEST_AESGCM_DecryptEquals(:ciphertext_aad, ''world'', :aad USING PARAMETERS key=:keyfile)'
+\set expected    'false'
+:run_test;
+
+\set description '\'decrypted value starts with prefix\''
+\set expression  'TEST_AESGCM_DecryptStartsWith(TEST_AESGCM_Encrypt(:plaintext, :aad USING PARAMETERS key=:keyring), ''he'', :aad_bin USING PARAMETERS key=:keyring)'
+\set expected    'true'
+:run_test;
+
+\set description '\'decrypted value does not start with a longer string, ignoring the associated data\''
+\set expression  'TEST_AESGCM_DecryptStartsWith(:ciphertext_aad, ''hello world'' USING PARAMETERS key=:keyfile)'
+\set expected    'false'
+:run_test;
+
+\set description '\'comparing with NULL returns NULL\''
+\set expression  'TEST_AESGCM_DecryptEquals(:ciphertext, NULL USING PARAMETERS key=:keyfile) IS NULL'
+\set expected    'true'
+:run_test;
+
+\set description '\'re-encrypt ciphertext from a key file to a keyring\''
+\set expression  'TEST_AESGCM_Decrypt(TEST_AESGCM_Reencrypt(:ciphertext USING PARAMETERS key=:keyfile, new_key=:keyring) USING PARAMETERS key=:keyring)'
+\set expected    ':plaintext'
+:run_test;
+
+\set description '\'re-encrypt ciphertext with the encryption key of its keyring\''
+\set expression  'LENGTH(TEST_AESGCM_Reencrypt(:ciphertext_aad, :aad_bin USING PARAMETERS key=:keyring))'
+\set expected    'LENGTH(:plaintext) + 3 + 12 + 16'
+:run_test;
+
+\set description '\'nested encryption and decryption with threads\''
+\set expression  'TEST_AESGCM_Decrypt(TEST_AESGCM_Encrypt(:plaintext, :aad USING PARAMETERS key=:keyring, threads=4), :aad USING PARAMETERS key=:keyring, threads=4)'
+\set expected    ':plaintext'
+:run_test;
+
+\set description '\'the engine is one of the known engines\''
+\set expression  'TEST_AESGCM_Engine() IN (''bitsliced'', ''aesni'', ''vaes256'', ''vaes512'')'
+\set expected    'true'
+:run_test;
+
+\set description '\'the engine can be limited to the bitsliced engine\''
+\set expression  'TEST_AESGCM_Engine() USING PARAMETERS engine=''bitsliced'''
+\set expected    '\'bitsliced\''
+:run_test;
+
+\set description '\'decrypting ciphertext with the bitsliced engine yields expected plaintext\''
+\set expression  'TEST_AESGCM_Decrypt(:ciphertext USING PARAMETERS key=:keyfile, multi_buffer=false, engine=''bitsliced'')'
+\set expected    ':plaintext'
+:run_test;
+
+\set description '\'decrypting long ciphertext with the bitsliced engine yields expected plaintext\''
+\set expression  'TEST_AESGCM_Decrypt(:ciphertext_long, :aad_long USING PARAMETERS key=:keyfile, engine=''bitsliced'')'
+\set expected    ':plaintext_long'
+:run_test;
+
+\set description '\'decrypting long ciphertext with the aesni engine yields expected plaintext\''
+\set expression  'TEST_AESGCM_Decrypt(:ciphertext_long, :aad_long USING PARAMETERS key=:keyfile, engine=''aesni'')'
+\set expected    ':plaintext_long'
+:run_test;
+
+\set description '\'decrypting long ciphertext with the vaes256 engine yields expected plaintext\''
+\set expression  'TEST_AESGCM_Decrypt(:ciphertext_long, :aad_long USING PARAMETERS key=:keyfile, engine=''vaes256'')'
+\set expected    ':plaintext_long'
+:run_test;
+
+\set description '\'decrypting long ciphertext with the vaes512 engine yields expected plaintext\''
+\set expression  'TEST_AESGCM_Decrypt(:ciphertext_long, :aad_long USING PARAMETERS key=:keyfile, engine=''vaes512'')'
+\set expected    ':plaintext_long'
+:run_test;
+
+\set description '\'encrypting with the bitsliced engine and decrypting with the best engine\''
+\set expression  'TEST_AESGCM_Decrypt(TEST_AESGCM_Encrypt(:plaintext_long, :aad USING PARAMETERS key=:keyring, engine=''bitsliced''), :aad USING PARAMETERS key=:keyring)'
+\set expected    ':plaintext_long'
+:run_test;
+
+\set description '\'encrypting with the best engine and decrypting with the bitsliced engine\''
+\set expression  'TEST_AESGCM_Decrypt(TEST_AESGCM_Encrypt(:plaintext_long, :aad USING PARAMETERS key=:keyring), :aad USING PARAMETERS key=:keyring, engine=''bitsliced'')'
+\set expected    ':plaintext_long'
+:run_test;
+
+\set description '\'compressing a repetitive value makes the ciphertext shorter than the plaintext\''
+\set expression  'LENGTH(TEST_AESGCM_Encrypt(:plaintext_long USING PARAMETERS key=:keyfile, compress=''lz4'')) < LENGTH(:plaintext_long)'
+\set expected    'true'
+:run_test;
+
+\set description '\'a value which does not compress is encrypted as is\''
+\set expression  'LENGTH(TEST_AESGCM_Encrypt(:plaintext USING PARAMETERS key=:keyfile, compress=''lz4''))'
+\set expected    'LENGTH(:plaintext) + 12 + 16'
+:run_test;
+
+\set description '\'decrypting compressed ciphertext yields expected plaintext\''
+\set expression  'TEST_AESGCM_Decrypt(:ciphertext_compressed, :aad_long USING PARAMETERS key=:keyfile)'
+\set expected    ':plaintext_long'
+:run_test;
+
+\set description '\'nested compressed encryption and decryption with a keyring\''
+\set expression  'TEST_AESGCM_Decrypt(TEST_AESGCM_Encrypt(:plaintext_long, :aad USING PARAMETERS key=:keyring, compress=''lz4''), :aad USING PARAMETERS key=:keyring)'
+\set expected    ':plaintext_long'
+:run_test;
+
+\set description '\'compressed ciphertext equals its plaintext\''
+\set expression  'TEST_AESGCM_DecryptEquals(:ciphertext_compressed, :plaintext_long, :aad_long USING PARAMETERS key=:keyfile)'
+\set expected    'true'
+:run_test;
+
+\set description '\'re-encrypted compressed ciphertext yields expected plaintext\''
+\set expression  'TEST_AESGCM_Decrypt(TEST_AESGCM_Reencrypt(:ciphertext_compressed, :aad_long USING PARAMETERS key=:keyfile, new_key=:keyring), :aad_long USING PARAMETERS key=:keyring)'
+\set expected    ':plaintext_long'
+:run_test;
+
+\set description '\'row ciphertext has expected length\''
+\set expression  'LENGTH(TEST_AESGCM_EncryptRow(:plaintext, :aad USING PARAMETERS key=:keyfile))'
+\set expected    '2 + 12 + 1 + (2 + LENGTH(:plaintext)) + (2 + LENGTH(:aad)) + 16' -- header, nonce, field count, fields, tag.
+:run_test;
+
+\set description '\'encrypt a row and decrypt its columns\''
+\set expression  'name = :plaintext AND age = 42 AND score = 1.5 AND ok FROM (SELECT TEST_AESGCM_DecryptRow(TEST_AESGCM_EncryptRow(:plaintext, 42, 1.5::FLOAT, true USING PARAMETERS key=:keyfile) USING PARAMETERS key=:keyfile, columns=''name VARCHAR(5), age INTEGER, score FLOAT, ok BOOLEAN'') OVER ()) AS packed'
+\set expected    'true'
+:run_test;
+
+\set description '\'decrypt a subset of the columns of a row\''
+\set expression  'score FROM (SELECT TEST_AESGCM_DecryptRow(TEST_AESGCM_EncryptRow(:plaintext, 42, 1.5::FLOAT USING PARAMETERS key=:keyring) USING PARAMETERS key=:keyring, columns=''-, -, score FLOAT'') OVER ()) AS packed'
+\set expected    '1.5'
+:run_test;
+
+\set description '\'encrypt a row with NULL columns\''
+\set expression  'name IS NULL AND age = 7 FROM (SELECT TEST_AESGCM_DecryptRow(TEST_AESGCM_EncryptRow(NULL::VARCHAR, 7 USING PARAMETERS key=:keyfile) USING PARAMETERS key=:keyfile, columns=''name VARCHAR(5), age INTEGER'') OVER ()) AS packed'
+\set expected    'true'
+:run_test;
+
+\set description '\'re-encrypted row yields expected columns\''
+\set expression  'name FROM (SELECT TEST_AESGCM_DecryptRow(TEST_AESGCM_Reencrypt(TEST_AESGCM_EncryptRow(:plaintext USING PARAMETERS key=:keyfile) USING PARAMETERS key=:keyfile, new_key=:keyring) USING PARAMETERS key=:keyring, columns=''name VARCHAR(5)'') OVER ()) AS packed'
+\set expected    ':plaintext'
+:run_test;
+
+\set description '\'integer ciphertext has expected length\''
+\set expression  'LENGTH(TEST_AESGCM_Encrypt(42 USING PARAMETERS key=:keyfile))'
+\set expected    '8 + 28' -- value, nonce and tag.
+:run_test;
+
+\set description '\'encrypt and decrypt an integer with associated data\''
+\set expression  'TEST_AESGCM_DecryptInt(TEST_AESGCM_Encrypt(-42, :aad USING PARAMETERS key=:keyfile), :aad USING PARAMETERS key=:keyfile)'
+\set expected    '-42'
+:run_test;
+
+\set description '\'encrypt and decrypt a float and a date\''
+\set expression  'TEST_AESGCM_DecryptFloat(TEST_AESGCM_Encrypt(1.5::FLOAT USING PARAMETERS key=:keyfile) USING PARAMETERS key=:keyfile) = 1.5 AND TEST_AESGCM_DecryptDate(TEST_AESGCM_Encrypt(''2016-02-29''::DATE USING PARAMETERS key=:keyfile) USING PARAMETERS key=:keyfile) = ''2016-02-29''::DATE'
+\set expected    'true'
+:run_test;
+
+\set description '\'encrypt and decrypt a timestamp with a keyring\''
+\set expression  'TEST_AESGCM_DecryptTimestamp(TEST_AESGCM_Encrypt(''2016-02-29 12:34:56.789012''::TIMESTAMP USING PARAMETERS key=:keyring) USING PARAMETERS key=:keyring)'
+\set expected    '''2016-02-29 12:34:56.789012''::TIMESTAMP'
+:run_test;
+
+\set description '\'encrypt and decrypt a numeric\''
+\set expression  'TEST_AESGCM_DecryptNumeric(TEST_AESGCM_Encrypt(-12345.67::NUMERIC(10,2) USING PARAMETERS key=:keyfile) USING PARAMETERS key=:keyfile, precision=10, scale=2)'
+\set expected    '-12345.67'
+:run_test;
+
+\set description '\'decrypt a numeric into a greater precision\''
+\set expression  'TEST_AESGCM_DecryptNumeric(TEST_AESGCM_Encrypt(-12345.67::NUMERIC(10,2) USING PARAMETERS key=:keyfile) USING PARAMETERS key=:keyfile, precision=37, scale=2)'
+\set expected    '-12345.67'
+:run_test;
+
+\set description '\'encrypting a NULL integer yields NULL\''
+\set expression  'TEST_AESGCM_DecryptInt(TEST_AESGCM_Encrypt(NULL::INTEGER USING PARAMETERS key=:keyfile) USING PARAMETERS key=:keyfile) IS NULL'
+\set expected    'true'
+:run_test;
+
+\set description '\'tenant ciphertext has expected length\''
+\set expression  'LENGTH(TEST_AESGCM_EncryptForTenant(''acme'', :plaintext USING PARAMETERS key=:keyfile))'
+\set expected    'LENGTH(:plaintext) + 28' -- nonce and tag.
+:run_test;
+
+\set description '\'encrypt and decrypt for a tenant with associated data\''
+\set expression  'TEST_AESGCM_DecryptForTenant(''acme'', TEST_AESGCM_EncryptForTenant(''acme'', :plaintext, :aad USING PARAMETERS key=:keyfile), :aad USING PARAMETERS key=:keyfile)'
+\set expected    ':plaintext'
+:run_test;
+
+\set description '\'encrypt and decrypt for a tenant with a keyring\''
+\set expression  'TEST_AESGCM_DecryptForTenant(''acme'', TEST_AESGCM_EncryptForTenant(''acme'', :plaintext USING PARAMETERS key=:keyring) USING PARAMETERS key=:keyring)'
+\set expected    ':plaintext'
+:run_test;
+
+\set description '\'encrypt and decrypt interleaved tenants with fewer cached subkeys\''
+\set expression  'COUNT(*) FROM (SELECT TEST_AESGCM_DecryptForTenant(tenant, TEST_AESGCM_EncryptForTenant(tenant, :plaintext USING PARAMETERS key=:keyfile, tenant_keys=2) USING PARAMETERS key=:keyfile, tenant_keys=2) AS p FROM (SELECT ''a'' AS tenant UNION ALL SELECT ''b'' UNION ALL SELECT ''c'' UNION ALL SELECT ''a'') AS tenants) AS decrypted WHERE p = :plaintext'
+\set expected    '4'
+:run_test;
+
+\set description '\'tenant ciphertext does not verify under the master key\''
+\set expression  'TEST_AESGCM_Verify(TEST_AESGCM_EncryptForTenant(''acme'', :plaintext USING PARAMETERS key=:keyfile) USING PARAMETERS key=:keyfile)'
+\set expected    'false'
+:run_test;
+
+\set description '\'long ciphertext has expected length\''
+\set expression  'LENGTH(TEST_AESGCM_Encrypt(:plaintext_long::LONG VARCHAR USING PARAMETERS key=:keyfile, segment_size=100))'
+\set expected    '22 + 315 + 4 * 16' -- stream header, plaintext and a tag per segment.
+:run_test;
+
+\set description '\'encrypt and decrypt a long value with associated data\''
+\set expression  'TEST_AESGCM_Decrypt(TEST_AESGCM_Encrypt(:plaintext_long::LONG VARCHAR, :aad_long USING PARAMETERS key=:keyfile, segment_size=16), :aad_long USING PARAMETERS key=:keyfile) = :plaintext_long'
+\set expected    'true'
+:run_test;
+
+\set description '\'encrypt and decrypt a long value with a keyring\''
+\set expression  'TEST_AESGCM_Decrypt(TEST_AESGCM_Encrypt(:plaintext_long::LONG VARCHAR USING PARAMETERS key=:keyring) USING PARAMETERS key=:keyring) = :plaintext_long'
+\set expected    'true'
+:run_test;
+
+\set description '\'decrypt a range spanning segments of a long value\''
+\set expression  'TEST_AESGCM_DecryptRange(TEST_AESGCM_Encrypt(:plaintext_long::LONG VARCHAR USING PARAMETERS key=:keyfile, segment_size=8), 4, 15 USING PARAMETERS key=:keyfile)'
+\set expected    '''quick brown fox'''
+:run_test;
+
+\set description '\'decrypt a range past the end of a long value\''
+\set expression  'TEST_AESGCM_DecryptRange(TEST_AESGCM_Encrypt(:plaintext_long::LONG VARCHAR, :aad_long USING PARAMETERS key=:keyfile, segment_size=16), 310, 100, :aad_long USING PARAMETERS key=:keyfile)'
+\set expected    '''dog. '''
+:run_test;
+
+\set description '\'decrypt hexadecimal text of a ciphertext\''
+\set expression  'TEST_AESGCM_DecryptHex(TO_HEX(:ciphertext) USING PARAMETERS key=:keyfile)'
+\set expected    ':plaintext'
+:run_test;
+
+\set description '\'decrypt Base64 text of a ciphertext\''
+\set expression  'TEST_AESGCM_DecryptBase64(''MDEyMzQ1Njc4OUFCFcdg8qG6fuG0QB8UJkIQUTexCyWg'' USING PARAMETERS key=:keyfile)'
+\set expected    ':plaintext'
+:run_test;
+
+\set description '\'Base64 ciphertext has expected length\''
+\set expression  'LENGTH(TEST_AESGCM_EncryptBase64(:plaintext USING PARAMETERS key=:keyfile))'
+\set expected    '(5 + 28 + 2) / 3 * 4' -- :plaintext and overhead, in groups of 3 bytes to 4 characters.
+:run_test;
+
+\set description '\'hexadecimal ciphertext decodes to a ciphertext\''
+\set expression  'TEST_AESGCM_Decrypt(HEX_TO_BINARY(TEST_AESGCM_EncryptHex(:plaintext, :aad USING PARAMETERS key=:keyfile)), :aad USING PARAMETERS key=:keyfile)'
+\set expected    ':plaintext'
+:run_test;
+
+\set description '\'encrypt and decrypt Base64 with a keyring\''
+\set expression  'TEST_AESGCM_DecryptBase64(TEST_AESGCM_EncryptBase64(:plaintext_long, :aad_long USING PARAMETERS key=:keyring), :aad_long USING PARAMETERS key=:keyring) = :plaintext_long'
+\set expected    'true'
+:run_test;
+
+\set description '\'decrypt AEGIS-256 ciphertext\''
+\set expression  'TEST_AESGCM_Decrypt(:ciphertext_aegis USING PARAMETERS key=:keyfile)'
+\set expected    ':plaintext'
+:run_test;
+
+\set description '\'AEGIS-256 ciphertext has expected length\''
+\set expression  'LENGTH(TEST_AESGCM_Encrypt(:plaintext USING PARAMETERS key=:keyfile, algorithm=''aegis256''))'
+\set expected    'LENGTH(:plaintext) + 3 + 32 + 32' -- header, nonce and tag.
+:run_test;
+
+\set description '\'nested XChaCha20-Poly1305 encryption and decryption with a keyring\''
+\set expression  'TEST_AESGCM_Decrypt(TEST_AESGCM_Encrypt(:plaintext_long, :aad USING PARAMETERS key=:keyring, algorithm=''xchacha20poly1305''), :aad USING PARAMETERS key=:keyring)'
+\set expected    ':plaintext_long'
+:run_test;
+
+\set description '\'nested compressed AEGIS-256 encryption and decryption\''
+\set expression  'TEST_AESGCM_Decrypt(TEST_AESGCM_Encrypt(:plaintext_long, :aad_long USING PARAMETERS key=:keyfile, algorithm=''aegis256'', compress=''lz4''), :aad_long USING PARAMETERS key=:keyfile)'
+\set expected    ':plaintext_long'
+:run_test;
+
+\set description '\'AEGIS-256 ciphertext equals its plaintext\''
+\set expression  'TEST_AESGCM_DecryptEquals(:ciphertext_aegis, :plaintext USING PARAMETERS key=:keyfile)'
+\set expected    'true'
+:run_test;
+
+-- Load a file directly, and through the encryption and decryption filters.
+CREATE LOCAL TEMPORARY TABLE test_aesgcm_lines (line VARCHAR(200)) ON COMMIT PRESERVE ROWS;
+CREATE LOCAL TEMPORARY TABLE test_aesgcm_filtered_lines (line VARCHAR(200)) ON COMMIT PRESERVE ROWS;
+\o /dev/null
+COPY test_aesgcm_lines FROM :keyring;
+COPY test_aesgcm_filtered_lines FROM :keyring FILTER TEST_AESGCM_EncryptFilter(key=:keyring, segment_size=16) FILTER TEST_AESGCM_DecryptFilter(key=:keyring);
+\o
+
+\set description '\'streaming encryption and decryption filters round trip\''
+\set expression  'COUNT(*) FROM test_aesgcm_lines NATURAL JOIN test_aesgcm_filtered_lines'
+\set expected    '3'
+:run_test;
+
+\set description '\'stats count the rows decrypted with the key\''
+\set expression  'SUM(row_count) > 0 FROM (SELECT TEST_AESGCM_Stats() OVER ()) AS stats WHERE function_name = ''AESGCM_Decrypt'' AND key_path = :keyfile'
+\set expected    'true'
+:run_test;
+
+\o /dev/null
+SELECT TEST_AESGCM_Encrypt(value USING PARAMETERS key=:keyfile_stats) FROM (SELECT :plaintext AS value UNION ALL SELECT NULL UNION ALL SELECT :plaintext_long) AS t;
+\o
+
+\set description '\'stats count the bytes encrypted with the key\''
+\set expression  'SUM(bytes_out - bytes_in - 28 * (row_count - null_count)) FROM (SELECT TEST_AESGCM_Stats() OVER ()) AS stats WHERE function_name = ''AESGCM_Encrypt'' AND key_path = :keyfile_stats'
+\set expected    '0'
+:run_test;
+
 -- Negative test cases.
 \set error_expected 'true' -- all of these tests produce ERRORs.
 \set expected       'NULL' -- not used for negative tests.
 
-\set description '\'fail to encrypt a non-VARCHAR column\''
-\set expression  'TEST_AESGCM_Encrypt(42 USING PARAMETERS key=:keyfile)'
+\set description '\'fail to encrypt a column of an unsupported type\''
+\set expression  'TEST_AESGCM_Encrypt(true USING PARAMETERS key=:keyfile)'
 :run_test;
 
 \set description '\'fail to encrypt with no parameters specified\''
@@ -120,6 +605,14 @@ CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEnc
 \set expression  'TEST_AESGCM_Encrypt(:plaintext USING PARAMETERS key=''/dev/null'')'
 :run_test;
 
+\set description '\'fail to encrypt with too many threads\''
+\set expression  'TEST_AESGCM_Encrypt(:plaintext USING PARAMETERS key=:keyfile, threads=17)'
+:run_test;
+
+\set description '\'fail to encrypt with an unknown engine\''
+\set expression  'TEST_AESGCM_Encrypt(:plaintext USING PARAMETERS key=:keyfile, engine=''aes'')'
+:run_test;
+
 \set description '\'fail to decrypt a non-VARBINARY column\''
 \set expression  'TEST_AESGCM_Decrypt(42 USING PARAMETERS key=:keyfile)'
 :run_test;
@@ -152,5 +645,83 @@ CREATE OR REPLACE FUNCTION TEST_AESGCM_Encrypt AS LANGUAGE 'C++' NAME 'AESGCMEnc
 \set expression  'TEST_AESGCM_Decrypt(:ciphertext_aad, ''bad'' USING PARAMETERS key=:keyfile)'
 :run_test;
 
+\set description '\'fail to decrypt keyring ciphertext without the keyring\''
+\set expression  'TEST_AESGCM_Decrypt(TEST_AESGCM_Encrypt(:plaintext USING PARAMETERS key=:keyring) USING PARAMETERS key=:keyfile)'
+:run_test;
+
+\set description '\'fail to compare ciphertext with incorrect AAD\''
+\set expression  'TEST_AESGCM_DecryptEquals(:ciphertext_aad, :plaintext, ''bad'' USING PARAMETERS key=:keyfile)'
+:run_test;
+
+\set description '\'fail to re-encrypt ciphertext with incorrect AAD\''
+\set expression  'TEST_AESGCM_Reencrypt(:ciphertext_aad, ''bad'' USING PARAMETERS key=:keyfile, new_key=:keyring)'
+:run_test;
+
+\set description '\'fail to decrypt deterministic ciphertext with the wrong associated data\''
+\set expression  'TEST_AESGCM_DecryptDeterministic(TEST_AESGCM_EncryptDeterministic(:plaintext, :aad USING PARAMETERS key=:keyfile) USING PARAMETERS key=:keyfile)'
+:run_test;
+
+\set description '\'fail to encrypt with an unknown compression\''
+\set expression  'TEST_AESGCM_Encrypt(:plaintext USING PARAMETERS key=:keyfile, compress=''zstd'')'
+:run_test;
+
+\set description '\'fail to encrypt with an unknown algorithm\''
+\set expression  'TEST_AESGCM_Encrypt(:plaintext USING PARAMETERS key=:keyfile, algorithm=''chacha20'')'
+:run_test;
+
+\set description '\'fail to decrypt XChaCha20-Poly1305 ciphertext with incorrect AAD\''
+\set expression  'TEST_AESGCM_Decrypt(TEST_AESGCM_Encrypt(:plaintext, :aad USING PARAMETERS key=:keyfile, algorithm=''xchacha20poly1305''), ''bad'' USING PARAMETERS key=:keyfile)'
+:run_test;
+
+\set description '\'fail to decrypt a row column as the wrong type\''
+\set expression  'name FROM (SELECT TEST_AESGCM_DecryptRow(TEST_AESGCM_EncryptRow(:plaintext USING PARAMETERS key=:keyfile) USING PARAMETERS key=:keyfile, columns=''name INTEGER'') OVER ()) AS packed'
+:run_test;
+
+\set description '\'fail to decrypt ciphertext which is not a row\''
+\set expression  'name FROM (SELECT TEST_AESGCM_DecryptRow(:ciphertext USING PARAMETERS key=:keyfile, columns=''name VARCHAR(5)'') OVER ()) AS packed'
+:run_test;
+
+\set description '\'fail to decrypt a VARCHAR ciphertext as an integer\''
+\set expression  'TEST_AESGCM_DecryptInt(:ciphertext USING PARAMETERS key=:keyfile)'
+:run_test;
+
+\set description '\'fail to decrypt a numeric with a different scale\''
+\set expression  'TEST_AESGCM_DecryptNumeric(TEST_AESGCM_Encrypt(1.5::NUMERIC(10,2) USING PARAMETERS key=:keyfile) USING PARAMETERS key=:keyfile, precision=10, scale=3)'
+:run_test;
+
+\set description '\'fail to decrypt randomized ciphertext deterministically\''
+\set expression  'TEST_AESGCM_DecryptDeterministic(:ciphertext USING PARAMETERS key=:keyfile)'
+:run_test;
+
+\set description '\'fail to decrypt ciphertext for another tenant\''
+\set expression  'TEST_AESGCM_DecryptForTenant(''other'', TEST_AESGCM_EncryptForTenant(''acme'', :plaintext USING PARAMETERS key=:keyfile) USING PARAMETERS key=:keyfile)'
+:run_test;
+
+\set description '\'fail to encrypt for a tenant with too few cached subkeys\''
+\set expression  'TEST_AESGCM_EncryptForTenant(''acme'', :plaintext USING PARAMETERS key=:keyfile, tenant_keys=1)'
+:run_test;
+
+\set description '\'fail to decrypt a range of a value which is not segmented\''
+\set expression  'TEST_AESGCM_DecryptRange(:ciphertext_long::LONG VARBINARY, 0, 10 USING PARAMETERS key=:keyfile)'
+:run_test;
+
+\set description '\'fail to decrypt a range of a long value with incorrect AAD\''
+\set expression  'TEST_AESGCM_DecryptRange(TEST_AESGCM_Encrypt(:plaintext_long::LONG VARCHAR, :aad_long USING PARAMETERS key=:keyfile), 0, 10, ''bad'' USING PARAMETERS key=:keyfile)'
+:run_test;
+
+\set description '\'fail to decrypt text which is not Base64\''
+\set expression  'TEST_AESGCM_DecryptBase64(''MDEyMzQ1Njc4OUFCFcdg8qG6fuG0QB8UJkIQUTexCy-g'' USING PARAMETERS key=:keyfile)'
+:run_test;
+
+\set description '\'fail to decrypt hexadecimal text with incorrect AAD\''
+\set expression  'TEST_AESGCM_DecryptHex(TEST_AESGCM_EncryptHex(:plaintext, :aad USING PARAMETERS key=:keyfile), ''bad'' USING PARAMETERS key=:keyfile)'
+:run_test;
+
+\set description '\'fail to decrypt a stream which is not encrypted\''
+:test_header; COPY test_aesgcm_filtered_lines FROM :keyring FILTER TEST_AESGCM_DecryptFilter(key=:keyring);
+
+DROP TABLE test_aesgcm_lines;
+DROP TABLE test_aesgcm_filtered_lines;
+
 -- Uninstall the test-prefix library.
 DROP LIBRARY TEST_AESGCM CASCADE;